@@ -0,0 +1,237 @@
+/**
+ * @file  LineArray.cpp
+ *
+ * @brief Implementation of multi-line edits of the line array.
+ */
+
+#include "LineArray.h"
+#include <tchar.h>
+#include <cassert>
+#include <cstring>
+
+/**
+ * @brief Insert text to the lines.
+ * The first line of the text is appended to the start line, the following
+ * lines are inserted after it and the end of the start line is moved after
+ * the text. A trailing empty line is added if the text ends with EOL at
+ * the end of the array.
+ * @param [in,out] aLines Lines to insert the text to.
+ * @param [in] nLine Line to insert the text to.
+ * @param [in] nPos Position in the line to insert the text to.
+ * @param [in] pszText Text to insert.
+ * @param [in] cchText Length of the text.
+ * @param [out] nEndLine Line of the end of the inserted text.
+ * @param [out] nEndChar Position of the end of the inserted text.
+ * @param [out] nInsertedLines Number of lines added to the array.
+ */
+void LineArray::
+InsertText (std::vector<LineInfo> &aLines, int nLine, int nPos,
+    LPCTSTR pszText, int cchText, int &nEndLine, int &nEndChar, int &nInsertedLines)
+{
+  assert (nLine >= 0 && nLine < (int) aLines.size ());
+  assert (nPos >= 0 && nPos <= aLines[nLine].Length ());
+
+  // remove end of line (we'll put it back on afterwards)
+  const int nRestCount = aLines[nLine].FullLength () - nPos;
+  LineInfo tail;
+  if (nRestCount > 0)
+    {
+      tail.Create (aLines[nLine].GetLine (nPos), nRestCount);
+      aLines[nLine].DeleteEnd (nPos);
+    }
+
+  // The first line of the new text is appended to the start line,
+  // all succeeding lines are collected to be inserted at once
+  std::vector<LineInfo> aNewLines;
+  bool bEol = false;
+  for (bool bFirst = true; ; bFirst = false)
+    {
+      int nTextPos = 0;
+      // advance to end of line
+      while (nTextPos < cchText && !LineInfo::IsEol (pszText[nTextPos]))
+        nTextPos++;
+      // advance after EOL of line
+      bEol = false;
+      if (nTextPos < cchText)
+        {
+          bEol = true;
+          LPCTSTR eol = &pszText[nTextPos];
+          nTextPos++;
+          if (nTextPos < cchText && LineInfo::IsDosEol (eol))
+            nTextPos++;
+        }
+
+      if (bFirst)
+        {
+          if (nTextPos > 0)
+            aLines[nLine].Append (pszText, nTextPos);
+        }
+      else
+        {
+          LineInfo line;
+          line.Create (pszText, nTextPos);
+          aNewLines.push_back (line);
+        }
+
+      if (nTextPos == cchText)
+        break;
+      pszText += nTextPos;
+      cchText -= nTextPos;
+    }
+
+  LineInfo &lastLine = aNewLines.empty () ? aLines[nLine] : aNewLines.back ();
+  if (bEol)
+    {
+      nEndLine = nLine + (int) aNewLines.size () + 1;
+      nEndChar = 0;
+    }
+  else
+    {
+      nEndLine = nLine + (int) aNewLines.size ();
+      nEndChar = lastLine.Length ();
+    }
+
+  // now we have to reattach the tail
+  if (nRestCount > 0)
+    {
+      if (bEol)
+        {
+          aNewLines.push_back (tail);
+        }
+      else
+        {
+          lastLine.Append (tail.GetLine (), nRestCount);
+          tail.Clear ();
+        }
+    }
+
+  InsertLines (aLines, nLine + 1, aNewLines);
+  nInsertedLines = (int) aNewLines.size ();
+
+  if (nEndLine == (int) aLines.size ())
+    {
+      // We left cursor after last screen line
+      // which is an illegal cursor position
+      // so manufacture a new trailing line
+      LineInfo line;
+      line.CreateEmpty ();
+      aLines.push_back (line);
+      nInsertedLines++;
+    }
+}
+
+/**
+ * @brief Delete text from the lines.
+ * The end of the end line is appended to the start line and the lines
+ * after the start line up to the end line are removed at once.
+ * @param [in,out] aLines Lines to delete the text from.
+ * @param [in] nStartLine Starting line for the deletion.
+ * @param [in] nStartChar Starting char position for the deletion.
+ * @param [in] nEndLine Ending line for the deletion.
+ * @param [in] nEndChar Ending char position for the deletion.
+ */
+void LineArray::
+DeleteText (std::vector<LineInfo> &aLines, int nStartLine, int nStartChar,
+    int nEndLine, int nEndChar)
+{
+  assert (nStartLine >= 0 && nStartLine <= nEndLine && nEndLine < (int) aLines.size ());
+
+  if (nStartLine == nEndLine)
+    {
+      // delete part of one line
+      aLines[nStartLine].Delete (nStartChar, nEndChar);
+      return;
+    }
+
+  const LineInfo &endLine = aLines[nEndLine];
+  const int nRestCount = endLine.FullLength () - nEndChar;
+  const DWORD dwFlags = endLine.m_dwFlags;
+
+  aLines[nStartLine].DeleteEnd (nStartChar);
+  if (nRestCount > 0)
+    aLines[nStartLine].Append (endLine.GetLine (nEndChar), nRestCount);
+  if (nStartChar == 0)
+    aLines[nStartLine].m_dwFlags = dwFlags;
+
+  DeleteLines (aLines, nStartLine + 1, nEndLine - nStartLine);
+}
+
+/**
+ * @brief Insert lines in one operation.
+ * @param [in,out] aLines Lines to insert to.
+ * @param [in] nPosition Index of the first inserted line.
+ * @param [in] aNewLines Lines to insert, the array takes over their data.
+ */
+void LineArray::
+InsertLines (std::vector<LineInfo> &aLines, int nPosition, const std::vector<LineInfo> &aNewLines)
+{
+  assert (nPosition >= 0 && nPosition <= (int) aLines.size ());
+  aLines.insert (aLines.begin () + nPosition, aNewLines.begin (), aNewLines.end ());
+}
+
+/**
+ * @brief Delete lines in one operation.
+ * @param [in,out] aLines Lines to delete from.
+ * @param [in] nLine First line to delete.
+ * @param [in] nCount Number of lines to delete.
+ */
+void LineArray::
+DeleteLines (std::vector<LineInfo> &aLines, int nLine, int nCount)
+{
+  assert (nLine >= 0 && nCount >= 0 && nLine + nCount <= (int) aLines.size ());
+  for (int ic = 0; ic < nCount; ic++)
+    aLines[nLine + ic].Clear ();
+  std::vector<LineInfo>::iterator iterBegin = aLines.begin () + nLine;
+  aLines.erase (iterBegin, iterBegin + nCount);
+}
+
+/**
+ * @brief Copy text of a range of lines.
+ * Call first with NULL buffer to get the length of the text, then with a
+ * buffer of that length. No terminating zero is added.
+ * @param [in] aLines Lines to copy the text from.
+ * @param [in] nStartLine Starting line of the text.
+ * @param [in] nStartChar Starting char position of the text.
+ * @param [in] nEndLine Ending line of the text.
+ * @param [in] nEndChar Ending char position of the text.
+ * @param [out] pszBuf Buffer for the text, or NULL to only count the length.
+ * @param [in] pszEol EOL to use, or NULL to copy the EOLs of the lines.
+ * @param [in] bEolAtEnd Add pszEol also after the ending line?
+ * @param [in] dwSkipFlags Lines having any of these flags are not copied.
+ * @return Length of the text in characters.
+ */
+int LineArray::
+GetText (const std::vector<LineInfo> &aLines, int nStartLine, int nStartChar,
+    int nEndLine, int nEndChar, LPTSTR pszBuf, LPCTSTR pszEol /*= NULL*/,
+    bool bEolAtEnd /*= false*/, DWORD dwSkipFlags /*= 0*/)
+{
+  assert (nStartLine >= 0 && nEndLine < (int) aLines.size ());
+
+  const int nEolLength = pszEol ? (int) _tcslen (pszEol) : 0;
+  int nLength = 0;
+  for (int i = nStartLine; i <= nEndLine; i++)
+    {
+      const LineInfo &li = aLines[i];
+      if (li.m_dwFlags & dwSkipFlags)
+        continue;
+
+      const int nBegin = (i == nStartLine) ? nStartChar : 0;
+      int nEnd;
+      if (i == nEndLine)
+        nEnd = nEndChar;
+      else
+        nEnd = pszEol ? li.Length () : li.FullLength ();
+      const int nCount = nEnd - nBegin;
+      if (pszBuf != NULL && nCount > 0)
+        memcpy (pszBuf + nLength, li.GetLine (nBegin), sizeof (TCHAR) * nCount);
+      nLength += nCount;
+
+      if (pszEol && (i != nEndLine || bEolAtEnd))
+        {
+          if (pszBuf != NULL)
+            memcpy (pszBuf + nLength, pszEol, sizeof (TCHAR) * nEolLength);
+          nLength += nEolLength;
+        }
+    }
+  return nLength;
+}
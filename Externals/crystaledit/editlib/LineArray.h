@@ -0,0 +1,34 @@
+/**
+ * @file  LineArray.h
+ *
+ * @brief Declaration of multi-line edits of the line array.
+ */
+
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include "LineInfo.h"
+
+/**
+ * @brief Multi-line insertion and deletion in the line array of a text buffer.
+ *
+ * The new lines of an insertion are built first and spliced into the array
+ * in one operation, and deleted lines are removed in one operation, so the
+ * lines after the edit are moved once instead of once per line. Views and
+ * undo are not handled here, the text buffer updates them once per edit.
+ * GetText() copies a range of lines to a buffer of exactly the needed size
+ * when called first without a buffer to get the size.
+ */
+namespace LineArray
+{
+void InsertText (std::vector<LineInfo> &aLines, int nLine, int nPos,
+    LPCTSTR pszText, int cchText, int &nEndLine, int &nEndChar, int &nInsertedLines);
+void DeleteText (std::vector<LineInfo> &aLines, int nStartLine, int nStartChar,
+    int nEndLine, int nEndChar);
+void InsertLines (std::vector<LineInfo> &aLines, int nPosition, const std::vector<LineInfo> &aNewLines);
+void DeleteLines (std::vector<LineInfo> &aLines, int nLine, int nCount);
+int GetText (const std::vector<LineInfo> &aLines, int nStartLine, int nStartChar,
+    int nEndLine, int nEndChar, LPTSTR pszBuf, LPCTSTR pszEol = NULL,
+    bool bEolAtEnd = false, DWORD dwSkipFlags = 0);
+}
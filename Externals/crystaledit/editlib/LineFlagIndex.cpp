@@ -0,0 +1,180 @@
+/**
+ * @file  LineFlagIndex.cpp
+ *
+ * @brief Implementation of LineFlagIndex class.
+ */
+
+#include "LineFlagIndex.h"
+#include <algorithm>
+#include <cassert>
+
+/**
+ * @brief Constructor.
+ * @param [in] dwIndexedFlags Flags to keep in the index.
+ */
+LineFlagIndex::LineFlagIndex (DWORD dwIndexedFlags)
+: m_dwIndexedFlags (dwIndexedFlags)
+, m_bValid (false)
+{
+}
+
+/**
+ * @brief Mark the index outdated, it is rebuilt on the next lookup.
+ * Call after changing the lines in a way not told to the index.
+ */
+void LineFlagIndex::
+Invalidate ()
+{
+  if (!m_bValid)
+    return;
+  m_bValid = false;
+  for (int nBit = 0; nBit < 32; nBit++)
+    m_aFlagLines[nBit].clear ();
+}
+
+/**
+ * @brief Update the index for changed flags of a line.
+ * @param [in] nLine Line whose flags changed.
+ * @param [in] dwOldFlags Flags of the line before the change.
+ * @param [in] dwNewFlags Flags of the line after the change.
+ */
+void LineFlagIndex::
+SetLineFlags (int nLine, DWORD dwOldFlags, DWORD dwNewFlags)
+{
+  if (!m_bValid)
+    return;
+  DWORD dwChanged = (dwOldFlags ^ dwNewFlags) & m_dwIndexedFlags;
+  for (int nBit = 0; dwChanged != 0; nBit++, dwChanged >>= 1)
+    {
+      if ((dwChanged & 1) == 0)
+        continue;
+      std::vector<int> &aLines = m_aFlagLines[nBit];
+      std::vector<int>::iterator it = std::lower_bound (aLines.begin (), aLines.end (), nLine);
+      const bool bFound = (it != aLines.end () && *it == nLine);
+      const bool bSet = (dwNewFlags & (1UL << nBit)) != 0;
+      if (bFound == bSet)
+        {
+          // The index is out of sync with the lines
+          assert (false);
+          Invalidate ();
+          return;
+        }
+      if (bSet)
+        aLines.insert (it, nLine);
+      else
+        aLines.erase (it);
+    }
+}
+
+/**
+ * @brief Update the index for inserted lines without flags.
+ * @param [in] nLine Index of the first inserted line.
+ * @param [in] nCount Number of inserted lines.
+ */
+void LineFlagIndex::
+InsertLines (int nLine, int nCount)
+{
+  if (!m_bValid || nCount == 0)
+    return;
+  for (int nBit = 0; nBit < 32; nBit++)
+    {
+      std::vector<int> &aLines = m_aFlagLines[nBit];
+      std::vector<int>::iterator it = std::lower_bound (aLines.begin (), aLines.end (), nLine);
+      for (; it != aLines.end (); ++it)
+        *it += nCount;
+    }
+}
+
+/**
+ * @brief Update the index for deleted lines.
+ * @param [in] nLine Index of the first deleted line.
+ * @param [in] nCount Number of deleted lines.
+ */
+void LineFlagIndex::
+DeleteLines (int nLine, int nCount)
+{
+  if (!m_bValid || nCount == 0)
+    return;
+  for (int nBit = 0; nBit < 32; nBit++)
+    {
+      std::vector<int> &aLines = m_aFlagLines[nBit];
+      std::vector<int>::iterator first = std::lower_bound (aLines.begin (), aLines.end (), nLine);
+      std::vector<int>::iterator last = std::lower_bound (first, aLines.end (), nLine + nCount);
+      for (std::vector<int>::iterator it = last; it != aLines.end (); ++it)
+        *it -= nCount;
+      aLines.erase (first, last);
+    }
+}
+
+/**
+ * @brief Find the first line at or after a line having any of the flags.
+ * @param [in] aLines Lines of the buffer, used to rebuild an outdated index.
+ * @param [in] dwFlag Indexed flags to look for.
+ * @param [in] nLine Line to start from.
+ * @return Found line, or -1 if none.
+ */
+int LineFlagIndex::
+FindNextLine (const std::vector<LineInfo> &aLines, DWORD dwFlag, int nLine) const
+{
+  assert (IsIndexed (dwFlag));
+  if (!m_bValid)
+    Rebuild (aLines);
+  int nFound = -1;
+  for (int nBit = 0; dwFlag != 0; nBit++, dwFlag >>= 1)
+    {
+      if ((dwFlag & 1) == 0)
+        continue;
+      const std::vector<int> &aFlagLines = m_aFlagLines[nBit];
+      std::vector<int>::const_iterator it = std::lower_bound (aFlagLines.begin (), aFlagLines.end (), nLine);
+      if (it != aFlagLines.end () && (nFound == -1 || *it < nFound))
+        nFound = *it;
+    }
+  return nFound;
+}
+
+/**
+ * @brief Find the last line at or before a line having any of the flags.
+ * @param [in] aLines Lines of the buffer, used to rebuild an outdated index.
+ * @param [in] dwFlag Indexed flags to look for.
+ * @param [in] nLine Line to start from.
+ * @return Found line, or -1 if none.
+ */
+int LineFlagIndex::
+FindPrevLine (const std::vector<LineInfo> &aLines, DWORD dwFlag, int nLine) const
+{
+  assert (IsIndexed (dwFlag));
+  if (!m_bValid)
+    Rebuild (aLines);
+  int nFound = -1;
+  for (int nBit = 0; dwFlag != 0; nBit++, dwFlag >>= 1)
+    {
+      if ((dwFlag & 1) == 0)
+        continue;
+      const std::vector<int> &aFlagLines = m_aFlagLines[nBit];
+      std::vector<int>::const_iterator it = std::upper_bound (aFlagLines.begin (), aFlagLines.end (), nLine);
+      if (it != aFlagLines.begin () && *(it - 1) > nFound)
+        nFound = *(it - 1);
+    }
+  return nFound;
+}
+
+/**
+ * @brief Rebuild the index from the flags of the lines.
+ */
+void LineFlagIndex::
+Rebuild (const std::vector<LineInfo> &aLines) const
+{
+  for (int nBit = 0; nBit < 32; nBit++)
+    m_aFlagLines[nBit].clear ();
+  const int nSize = (int) aLines.size ();
+  for (int L = 0; L < nSize; L++)
+    {
+      DWORD dwFlags = aLines[L].m_dwFlags & m_dwIndexedFlags;
+      for (int nBit = 0; dwFlags != 0; nBit++, dwFlags >>= 1)
+        {
+          if (dwFlags & 1)
+            m_aFlagLines[nBit].push_back (L);
+        }
+    }
+  m_bValid = true;
+}
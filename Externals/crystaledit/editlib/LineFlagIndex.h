@@ -0,0 +1,45 @@
+/**
+ * @file  LineFlagIndex.h
+ *
+ * @brief Declaration of LineFlagIndex class.
+ */
+
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include "LineInfo.h"
+
+/**
+ * @brief Index of the lines having marker flags.
+ *
+ * Marker flags (bookmarks, execution point, breakpoints) are set on few
+ * lines, so for each indexed flag the lines having it are kept in a sorted
+ * array. Flags set on one line only, like numbered bookmarks, are then a
+ * lookup of the single entry instead of a scan of all lines. The text
+ * buffer updates the index when it sets flags and inserts or deletes lines.
+ * Bulk changes of the lines invalidate the index and it is rebuilt from the
+ * lines on the next lookup.
+ */
+class LineFlagIndex
+  {
+public:
+    explicit LineFlagIndex (DWORD dwIndexedFlags);
+
+    /** @brief Are all the flags indexed? */
+    bool IsIndexed (DWORD dwFlag) const
+      { return dwFlag != 0 && (dwFlag & ~m_dwIndexedFlags) == 0; }
+    void Invalidate ();
+    void SetLineFlags (int nLine, DWORD dwOldFlags, DWORD dwNewFlags);
+    void InsertLines (int nLine, int nCount);
+    void DeleteLines (int nLine, int nCount);
+    int FindNextLine (const std::vector<LineInfo> &aLines, DWORD dwFlag, int nLine) const;
+    int FindPrevLine (const std::vector<LineInfo> &aLines, DWORD dwFlag, int nLine) const;
+
+private:
+    void Rebuild (const std::vector<LineInfo> &aLines) const;
+
+    DWORD m_dwIndexedFlags; /**< Flags kept in the index. */
+    mutable bool m_bValid; /**< Does the index match the lines? */
+    mutable std::vector<int> m_aFlagLines[32]; /**< Sorted lines for each flag bit. */
+  };
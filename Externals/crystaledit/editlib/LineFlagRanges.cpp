@@ -0,0 +1,228 @@
+/**
+ * @file  LineFlagRanges.cpp
+ *
+ * @brief Implementation of LineFlagRanges class.
+ */
+
+#include "LineFlagRanges.h"
+#include <vector>
+#include <climits>
+#include <cassert>
+
+/**
+ * @brief Constructor.
+ * @param [in] dwRangeFlags Flags to keep as ranges.
+ */
+LineFlagRanges::LineFlagRanges (DWORD dwRangeFlags)
+: m_dwRangeFlags (dwRangeFlags)
+{
+  ResetCache ();
+}
+
+/**
+ * @brief Change the flags kept as ranges.
+ * Only allowed while no flags are set.
+ * @param [in] dwRangeFlags Flags to keep as ranges.
+ */
+void LineFlagRanges::
+SetRangeFlags (DWORD dwRangeFlags)
+{
+  assert (m_runs.empty ());
+  m_dwRangeFlags = dwRangeFlags;
+}
+
+/**
+ * @brief Clear the flags of all lines.
+ */
+void LineFlagRanges::
+Clear ()
+{
+  m_runs.clear ();
+  ResetCache ();
+}
+
+/**
+ * @brief Get the flags of a line.
+ * @param [in] nLine Line whose flags to get.
+ * @return Flags of the line.
+ */
+DWORD LineFlagRanges::
+GetLineFlags (int nLine) const
+{
+  if (nLine >= m_nCachedBegin && nLine < m_nCachedEnd)
+    return m_dwCachedFlags;
+
+  RunMap::const_iterator it = m_runs.upper_bound (nLine);
+  m_nCachedEnd = (it != m_runs.end ()) ? it->first : INT_MAX;
+  if (it == m_runs.begin ())
+    {
+      m_nCachedBegin = INT_MIN;
+      m_dwCachedFlags = 0;
+    }
+  else
+    {
+      --it;
+      m_nCachedBegin = it->first;
+      m_dwCachedFlags = it->second;
+    }
+  return m_dwCachedFlags;
+}
+
+/**
+ * @brief Get the end of the run of lines having the same flags as a line.
+ * @param [in] nLine Line in the run.
+ * @return First line after @p nLine whose flags differ, INT_MAX if none.
+ */
+int LineFlagRanges::
+GetRunEnd (int nLine) const
+{
+  GetLineFlags (nLine);
+  return m_nCachedEnd;
+}
+
+/**
+ * @brief Set the flags of a range of lines.
+ * @param [in] nStartLine First line of the range.
+ * @param [in] nEndLine Last line of the range.
+ * @param [in] dwMask Flags to change, other flags are kept.
+ * @param [in] dwFlags New values of the flags in @p dwMask.
+ */
+void LineFlagRanges::
+SetLineFlags (int nStartLine, int nEndLine, DWORD dwMask, DWORD dwFlags)
+{
+  dwMask &= m_dwRangeFlags;
+  if (nStartLine > nEndLine || dwMask == 0)
+    return;
+  ResetCache ();
+  RunMap::iterator first = Split (nStartLine);
+  RunMap::iterator last = Split (nEndLine + 1);
+  for (RunMap::iterator it = first; it != last; ++it)
+    it->second = (it->second & ~dwMask) | (dwFlags & dwMask);
+  Merge (nStartLine, nEndLine + 1);
+}
+
+/**
+ * @brief Move the runs for inserted lines without flags.
+ * @param [in] nLine Index of the first inserted line.
+ * @param [in] nCount Number of inserted lines.
+ */
+void LineFlagRanges::
+InsertLines (int nLine, int nCount)
+{
+  if (nCount <= 0)
+    return;
+  const DWORD dwFlags = GetLineFlags (nLine);
+  ResetCache ();
+  Shift (nLine, nCount);
+  m_runs[nLine] = 0;
+  m_runs.insert (RunMap::value_type (nLine + nCount, dwFlags));
+  Merge (nLine, nLine + nCount);
+}
+
+/**
+ * @brief Move the runs for deleted lines.
+ * @param [in] nLine Index of the first deleted line.
+ * @param [in] nCount Number of deleted lines.
+ */
+void LineFlagRanges::
+DeleteLines (int nLine, int nCount)
+{
+  if (nCount <= 0)
+    return;
+  const DWORD dwFlags = GetLineFlags (nLine + nCount);
+  ResetCache ();
+  m_runs.erase (m_runs.lower_bound (nLine), m_runs.upper_bound (nLine + nCount));
+  Shift (nLine + nCount + 1, -nCount);
+  m_runs[nLine] = dwFlags;
+  Merge (nLine, nLine + 1);
+}
+
+/**
+ * @brief Find the first line at or after a line having any of the flags.
+ * @param [in] dwFlag Flags to look for.
+ * @param [in] nLine Line to start from.
+ * @return Found line, or -1 if none.
+ */
+int LineFlagRanges::
+FindNextLine (DWORD dwFlag, int nLine) const
+{
+  if (GetLineFlags (nLine) & dwFlag)
+    return nLine;
+  for (RunMap::const_iterator it = m_runs.upper_bound (nLine); it != m_runs.end (); ++it)
+    {
+      if (it->second & dwFlag)
+        return it->first;
+    }
+  return -1;
+}
+
+/**
+ * @brief Start a run at a line.
+ * @param [in] nLine First line of the run.
+ * @return The run starting at @p nLine, having the flags of the line.
+ */
+LineFlagRanges::RunMap::iterator LineFlagRanges::
+Split (int nLine)
+{
+  RunMap::iterator it = m_runs.upper_bound (nLine);
+  DWORD dwFlags = 0;
+  if (it != m_runs.begin ())
+    {
+      RunMap::iterator prev = it;
+      --prev;
+      if (prev->first == nLine)
+        return prev;
+      dwFlags = prev->second;
+    }
+  return m_runs.insert (it, RunMap::value_type (nLine, dwFlags));
+}
+
+/**
+ * @brief Remove the runs having the same flags as the run before them.
+ * @param [in] nFirstLine First line of the first run to check.
+ * @param [in] nLastLine First line of the last run to check.
+ */
+void LineFlagRanges::
+Merge (int nFirstLine, int nLastLine)
+{
+  RunMap::iterator it = m_runs.lower_bound (nFirstLine);
+  DWORD dwPrevFlags = 0;
+  if (it != m_runs.begin ())
+    {
+      RunMap::iterator prev = it;
+      dwPrevFlags = (--prev)->second;
+    }
+  while (it != m_runs.end () && it->first <= nLastLine)
+    {
+      if (it->second == dwPrevFlags)
+        it = m_runs.erase (it);
+      else
+        dwPrevFlags = (it++)->second;
+    }
+}
+
+/**
+ * @brief Move the runs starting at or after a line.
+ * @param [in] nLine First line of the runs to move.
+ * @param [in] nDelta Number of lines to move the runs by.
+ */
+void LineFlagRanges::
+Shift (int nLine, int nDelta)
+{
+  RunMap::iterator first = m_runs.lower_bound (nLine);
+  std::vector<std::pair<int, DWORD> > aRuns (first, m_runs.end ());
+  m_runs.erase (first, m_runs.end ());
+  for (size_t i = 0; i < aRuns.size (); i++)
+    m_runs.insert (m_runs.end (), RunMap::value_type (aRuns[i].first + nDelta, aRuns[i].second));
+}
+
+/**
+ * @brief Forget the last looked up run after the runs changed.
+ */
+void LineFlagRanges::
+ResetCache () const
+{
+  m_nCachedBegin = 0;
+  m_nCachedEnd = 0;
+  m_dwCachedFlags = 0;
+}
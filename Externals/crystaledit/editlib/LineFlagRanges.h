@@ -0,0 +1,53 @@
+/**
+ * @file  LineFlagRanges.h
+ *
+ * @brief Declaration of LineFlagRanges class.
+ */
+
+#pragma once
+
+#include <windows.h>
+#include <map>
+
+/**
+ * @brief Flags set on ranges of lines.
+ *
+ * Diff and visibility flags are set on whole blocks of lines, so instead
+ * of writing them into every line they are kept as runs of lines having
+ * the same flags. A run is stored by its first line and lines before the
+ * first run have no flags. Setting the flags of a range costs O(log n) in
+ * the number of runs, whatever the number of lines, and the flags of a
+ * line are found with one lookup. The lookup of the previous call is kept,
+ * so drawing and scanning consecutive lines does not search again. The
+ * text buffer moves the runs when it inserts or deletes lines.
+ */
+class LineFlagRanges
+  {
+public:
+    explicit LineFlagRanges (DWORD dwRangeFlags);
+
+    /** @brief Get the flags kept as ranges. */
+    DWORD GetRangeFlags () const { return m_dwRangeFlags; }
+    void SetRangeFlags (DWORD dwRangeFlags);
+    void Clear ();
+    DWORD GetLineFlags (int nLine) const;
+    int GetRunEnd (int nLine) const;
+    void SetLineFlags (int nStartLine, int nEndLine, DWORD dwMask, DWORD dwFlags);
+    void InsertLines (int nLine, int nCount);
+    void DeleteLines (int nLine, int nCount);
+    int FindNextLine (DWORD dwFlag, int nLine) const;
+
+private:
+    typedef std::map<int, DWORD> RunMap;
+
+    RunMap::iterator Split (int nLine);
+    void Merge (int nFirstLine, int nLastLine);
+    void Shift (int nLine, int nDelta);
+    void ResetCache () const;
+
+    DWORD m_dwRangeFlags; /**< Flags kept as ranges. */
+    RunMap m_runs; /**< Flags of the runs by their first line. */
+    mutable int m_nCachedBegin; /**< First line of the last run looked up. */
+    mutable int m_nCachedEnd; /**< Line after the last run looked up. */
+    mutable DWORD m_dwCachedFlags; /**< Flags of the last run looked up. */
+  };
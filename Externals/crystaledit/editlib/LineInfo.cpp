@@ -6,12 +6,35 @@
 // ID line follows -- this is updated by SVN
 // $Id: LineInfo.cpp 5738 2008-08-05 20:30:02Z kimmov $
 
-#include "stdafx.h"
+#include <windows.h>
+#include <tchar.h>
+#include <cassert>
 #include "LineInfo.h"
+#include "MemoryStats.h"
 
-#ifdef _DEBUG
-#define new DEBUG_NEW
-#endif
+/**
+ * @brief Allocate a line buffer and count it to the memory stats.
+ * @param [in] nMax Buffer size in characters.
+ */
+static TCHAR *AllocLineBuffer(int nMax)
+{
+  TCHAR *pcLine = new TCHAR[nMax];
+  MemoryStats::Allocated(MemoryStats::TEXTBUFFER_LINES, nMax * sizeof(TCHAR));
+  return pcLine;
+}
+
+/**
+ * @brief Free a line buffer allocated with AllocLineBuffer().
+ * @param [in] pcLine Buffer to free, can be NULL.
+ * @param [in] nMax Buffer size in characters.
+ */
+static void FreeLineBuffer(TCHAR *pcLine, int nMax)
+{
+  if (pcLine == NULL)
+    return;
+  delete[] pcLine;
+  MemoryStats::Freed(MemoryStats::TEXTBUFFER_LINES, nMax * sizeof(TCHAR));
+}
 
 /**
  @brief Constructor.
@@ -34,7 +57,7 @@ void LineInfo::Clear()
 {
   if (m_pcLine != NULL)
     {
-      delete[] m_pcLine;
+      FreeLineBuffer(m_pcLine, m_nMax);
       m_pcLine = NULL;
       m_nLength = 0;
       m_nMax = 0;
@@ -52,7 +75,7 @@ void LineInfo::FreeBuffer()
 {
   if (m_pcLine != NULL)
     {
-      delete[] m_pcLine;
+      FreeLineBuffer(m_pcLine, m_nMax);
       m_pcLine = NULL;
       m_nLength = 0;
       m_nMax = 0;
@@ -73,12 +96,11 @@ void LineInfo::Create(LPCTSTR pszLine, int nLength)
       return;
     }
 
+  FreeLineBuffer(m_pcLine, m_nMax);
   m_nLength = nLength;
   m_nMax = ALIGN_BUF_SIZE (m_nLength + 1);
-  ASSERT (m_nMax >= m_nLength + 1);
-  if (m_pcLine != NULL)
-    delete[] m_pcLine;
-  m_pcLine = new TCHAR[m_nMax];
+  assert (m_nMax >= m_nLength + 1);
+  m_pcLine = AllocLineBuffer(m_nMax);
   ZeroMemory(m_pcLine, m_nMax * sizeof(TCHAR));
   const DWORD dwLen = sizeof (TCHAR) * m_nLength;
   CopyMemory (m_pcLine, pszLine, dwLen);
@@ -98,12 +120,11 @@ void LineInfo::Create(LPCTSTR pszLine, int nLength)
  */
 void LineInfo::CreateEmpty()
 {
+  FreeLineBuffer(m_pcLine, m_nMax);
   m_nLength = 0;
   m_nEolChars = 0;
   m_nMax = ALIGN_BUF_SIZE (m_nLength + 1);
-  if (m_pcLine != NULL)
-    delete [] m_pcLine;
-  m_pcLine = new TCHAR[m_nMax];
+  m_pcLine = AllocLineBuffer(m_nMax);
   ZeroMemory(m_pcLine, m_nMax * sizeof(TCHAR));
 }
 
@@ -117,13 +138,14 @@ void LineInfo::Append(LPCTSTR pszChars, int nLength)
   int nBufNeeded = m_nLength + nLength + 1;
   if (nBufNeeded > m_nMax)
     {
-      m_nMax = ALIGN_BUF_SIZE (nBufNeeded);
-      ASSERT (m_nMax >= m_nLength + nLength);
-      TCHAR *pcNewBuf = new TCHAR[m_nMax];
+      int nNewMax = ALIGN_BUF_SIZE (nBufNeeded);
+      assert (nNewMax >= m_nLength + nLength);
+      TCHAR *pcNewBuf = AllocLineBuffer(nNewMax);
       if (FullLength() > 0)
         memcpy (pcNewBuf, m_pcLine, sizeof (TCHAR) * (FullLength() + 1));
-      delete[] m_pcLine;
+      FreeLineBuffer(m_pcLine, m_nMax);
       m_pcLine = pcNewBuf;
+      m_nMax = nNewMax;
     }
 
   memcpy (m_pcLine + m_nLength, pszChars, sizeof (TCHAR) * nLength);
@@ -140,7 +162,7 @@ void LineInfo::Append(LPCTSTR pszChars, int nLength)
        m_nEolChars = 1;
       }
    m_nLength -= m_nEolChars;
-   ASSERT (m_nLength + m_nEolChars <= m_nMax);
+   assert (m_nLength + m_nEolChars <= m_nMax);
 }
 
 /**
@@ -184,13 +206,14 @@ bool LineInfo::ChangeEol(LPCTSTR lpEOL)
   int nBufNeeded = m_nLength + nNewEolChars+1;
   if (nBufNeeded > m_nMax)
     {
-      m_nMax = ALIGN_BUF_SIZE (nBufNeeded);
-      ASSERT (m_nMax >= nBufNeeded);
-      TCHAR *pcNewBuf = new TCHAR[m_nMax];
+      int nNewMax = ALIGN_BUF_SIZE (nBufNeeded);
+      assert (nNewMax >= nBufNeeded);
+      TCHAR *pcNewBuf = AllocLineBuffer(nNewMax);
       if (FullLength() > 0)
         memcpy (pcNewBuf, m_pcLine, sizeof (TCHAR) * (FullLength() + 1));
-      delete[] m_pcLine;
+      FreeLineBuffer(m_pcLine, m_nMax);
       m_pcLine = pcNewBuf;
+      m_nMax = nNewMax;
     }
   
   // copy also the 0 to zero-terminate the line
@@ -234,9 +257,9 @@ void LineInfo::DeleteEnd(int nStartChar)
  */
 void LineInfo::CopyFrom(const LineInfo &li)
 {
-  if (m_pcLine != NULL)
-    delete [] m_pcLine;
-  m_pcLine = new TCHAR[li.m_nMax];
+  FreeLineBuffer(m_pcLine, m_nMax);
+  m_pcLine = AllocLineBuffer(li.m_nMax);
+  m_nMax = li.m_nMax;
   memcpy(m_pcLine, li.m_pcLine, li.m_nMax * sizeof(TCHAR));
 }
 
@@ -0,0 +1,205 @@
+/** 
+ * @file  TextBlockCache.cpp
+ *
+ * @brief Implementation of TextBlockCache class.
+ */
+
+#include "TextBlockCache.h"
+#include <cassert>
+#include "SyntaxColors.h"
+
+/**
+ * @brief Constructor.
+ * @param [in] nCapacity Number of lines cached, rounded up to a power of two.
+ */
+TextBlockCache::TextBlockCache (int nCapacity)
+: m_dwGeneration (1)
+{
+  int nSize = 1;
+  while (nSize < nCapacity)
+    nSize <<= 1;
+  m_entries.resize (nSize);
+  for (size_t i = 0; i < m_entries.size (); ++i)
+    {
+      m_entries[i].m_nLineIndex = -1;
+      m_entries[i].m_dwGeneration = 0;
+    }
+}
+
+/**
+ * @brief Return the cached blocks of the line.
+ * @param [in] nLineIndex Index of the line.
+ * @param [in] dwCookie Parse cookie of the line above.
+ * @param [in] dwStamp State the additional blocks depend on.
+ * @param [out] nBlocks Number of blocks.
+ * @param [out] dwNextCookie Parse cookie of the line.
+ * @return The blocks, or NULL if the line is not cached. Valid until the
+ * next call to Store().
+ */
+const TextBlockCache::TEXTBLOCK *TextBlockCache::
+Lookup (int nLineIndex, DWORD dwCookie, DWORD dwStamp, int &nBlocks, DWORD &dwNextCookie) const
+{
+  const ENTRY &entry = m_entries[nLineIndex & (m_entries.size () - 1)];
+  if (entry.m_nLineIndex != nLineIndex || entry.m_dwGeneration != m_dwGeneration ||
+      entry.m_dwCookie != dwCookie || entry.m_dwStamp != dwStamp)
+    return NULL;
+  nBlocks = static_cast<int> (entry.m_blocks.size ());
+  dwNextCookie = entry.m_dwNextCookie;
+  return &entry.m_blocks[0];
+}
+
+/**
+ * @brief Store the blocks of the line, replacing the line sharing its slot.
+ * @return The stored copy of the blocks, valid until the next call to Store().
+ */
+const TextBlockCache::TEXTBLOCK *TextBlockCache::
+Store (int nLineIndex, DWORD dwCookie, DWORD dwStamp, DWORD dwNextCookie, const TEXTBLOCK *pBuf, int nBlocks)
+{
+  assert (nBlocks > 0);
+  ENTRY &entry = m_entries[nLineIndex & (m_entries.size () - 1)];
+  entry.m_nLineIndex = nLineIndex;
+  entry.m_dwGeneration = m_dwGeneration;
+  entry.m_dwCookie = dwCookie;
+  entry.m_dwStamp = dwStamp;
+  entry.m_dwNextCookie = dwNextCookie;
+  entry.m_blocks.assign (pBuf, pBuf + nBlocks);
+  return &entry.m_blocks[0];
+}
+
+/**
+ * @brief Invalidate the cached blocks of lines.
+ * @param [in] nLineIndex1 The index of the first line to invalidate.
+ * @param [in] nLineIndex2 The index of the last line to invalidate, -1 to
+ * invalidate all lines from nLineIndex1 to the end.
+ */
+void TextBlockCache::
+Invalidate (int nLineIndex1, int nLineIndex2)
+{
+  if (nLineIndex2 != -1 && nLineIndex1 > nLineIndex2)
+    {
+      int nStorage = nLineIndex1;
+      nLineIndex1 = nLineIndex2;
+      nLineIndex2 = nStorage;
+    }
+  if (nLineIndex1 <= 0 && nLineIndex2 == -1)
+    {
+      InvalidateAll ();
+      return;
+    }
+  for (size_t i = 0; i < m_entries.size (); ++i)
+    {
+      int nLineIndex = m_entries[i].m_nLineIndex;
+      if (nLineIndex >= nLineIndex1 && (nLineIndex2 == -1 || nLineIndex <= nLineIndex2))
+        m_entries[i].m_nLineIndex = -1;
+    }
+}
+
+/**
+ * @brief Invalidate the cached blocks of all lines.
+ */
+void TextBlockCache::
+InvalidateAll ()
+{
+  if (++m_dwGeneration == 0)
+    {
+      // Generation wrapped, entries of the first generation would be valid again
+      for (size_t i = 0; i < m_entries.size (); ++i)
+        m_entries[i].m_nLineIndex = -1;
+      m_dwGeneration = 1;
+    }
+}
+
+/**
+ * @brief Return a scratch buffer for parsing and merging blocks.
+ * The buffer is kept and reused by the following calls.
+ * @param [in] nBuffer Index of the buffer, 0 or 1.
+ * @param [in] nSize Number of blocks needed.
+ */
+TextBlockCache::TEXTBLOCK *TextBlockCache::
+GetBuffer (int nBuffer, int nSize)
+{
+  std::vector<TEXTBLOCK> &buffer = m_buffers[nBuffer];
+  if (buffer.size () < static_cast<size_t> (nSize))
+    buffer.resize (nSize);
+  return &buffer[0];
+}
+
+/**
+ * @brief Merge additional blocks to the syntax blocks of a line.
+ * Colors of additional blocks override the syntax colors unless they are
+ * COLORINDEX_NONE. Consecutive blocks with the same colors are joined.
+ * @param [in] pBuf1 Syntax blocks.
+ * @param [in] pBuf2 Additional blocks.
+ * @param [out] pMergedBuf Merged blocks, room for nBlocks1 + nBlocks2 blocks.
+ * @return Number of merged blocks.
+ */
+int TextBlockCache::
+MergeTextBlocks (const TEXTBLOCK *pBuf1, int nBlocks1, const TEXTBLOCK *pBuf2,
+     int nBlocks2, TEXTBLOCK *pMergedBuf)
+{
+  int i, j, k;
+
+  for (i = 0, j = 0, k = 0; ; k++)
+    {
+      if (i >= nBlocks1 && j >= nBlocks2)
+        {
+          break;
+        }
+      else if ((i < nBlocks1 && j < nBlocks2) &&
+          (pBuf1[i].m_nCharPos == pBuf2[j].m_nCharPos))
+        {
+          pMergedBuf[k].m_nCharPos = pBuf2[j].m_nCharPos;
+          if (pBuf2[j].m_nColorIndex == COLORINDEX_NONE)
+            pMergedBuf[k].m_nColorIndex = pBuf1[i].m_nColorIndex;
+          else
+            pMergedBuf[k].m_nColorIndex = pBuf2[j].m_nColorIndex;
+          if (pBuf2[j].m_nBgColorIndex == COLORINDEX_NONE)
+            pMergedBuf[k].m_nBgColorIndex = pBuf1[i].m_nBgColorIndex;
+          else
+            pMergedBuf[k].m_nBgColorIndex = pBuf2[j].m_nBgColorIndex;
+          i++;
+          j++;
+        }
+      else if (j >= nBlocks2 || (i < nBlocks1 &&
+          pBuf1[i].m_nCharPos < pBuf2[j].m_nCharPos))
+        {
+          pMergedBuf[k].m_nCharPos = pBuf1[i].m_nCharPos;
+          if (nBlocks2 == 0 || pBuf2[j - 1].m_nColorIndex == COLORINDEX_NONE)
+            pMergedBuf[k].m_nColorIndex = pBuf1[i].m_nColorIndex;
+          else
+            pMergedBuf[k].m_nColorIndex = pBuf2[j - 1].m_nColorIndex;
+          if (nBlocks2 == 0 || pBuf2[j - 1].m_nBgColorIndex == COLORINDEX_NONE)
+            pMergedBuf[k].m_nBgColorIndex = pBuf1[i].m_nBgColorIndex;
+          else
+            pMergedBuf[k].m_nBgColorIndex = pBuf2[j - 1].m_nBgColorIndex;
+          i++;
+        }
+      else if (i >= nBlocks1 || (j < nBlocks2 && pBuf1[i].m_nCharPos > pBuf2[j].m_nCharPos))
+        {
+          pMergedBuf[k].m_nCharPos = pBuf2[j].m_nCharPos;
+          if (i > 0 && pBuf2[j].m_nColorIndex == COLORINDEX_NONE)
+            pMergedBuf[k].m_nColorIndex = pBuf1[i - 1].m_nColorIndex;
+          else
+            pMergedBuf[k].m_nColorIndex = pBuf2[j].m_nColorIndex;
+          if (i > 0 && pBuf2[j].m_nBgColorIndex == COLORINDEX_NONE)
+            pMergedBuf[k].m_nBgColorIndex = pBuf1[i - 1].m_nBgColorIndex;
+          else
+            pMergedBuf[k].m_nBgColorIndex = pBuf2[j].m_nBgColorIndex;
+          j++;
+        }
+    }
+
+  j = 0;
+  for (i = 0; i < k; ++i)
+    {
+      if (i == 0 ||
+          (pMergedBuf[i - 1].m_nColorIndex   != pMergedBuf[i].m_nColorIndex ||
+           pMergedBuf[i - 1].m_nBgColorIndex != pMergedBuf[i].m_nBgColorIndex))
+        {
+          pMergedBuf[j] = pMergedBuf[i];
+          ++j;
+        }
+    }
+
+  return j;
+}
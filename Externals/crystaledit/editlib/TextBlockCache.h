@@ -0,0 +1,69 @@
+/** 
+ * @file  TextBlockCache.h
+ *
+ * @brief Declaration file for TextBlockCache class
+ */
+
+#ifndef _TEXT_BLOCK_CACHE_H_
+#define _TEXT_BLOCK_CACHE_H_
+
+#include <Windows.h>
+#include <vector>
+
+/**
+ * @brief Cache of parsed and merged text blocks of lines.
+ *
+ * Painting a line needs its syntax blocks merged with the additional
+ * (e.g. word difference) blocks. These stay the same as long as the line,
+ * the parse cookie of the line above it and the state the additional blocks
+ * depend on stay the same, so the merged blocks are kept for the most
+ * recently painted lines.
+ *
+ * The cache is direct mapped by line index, so consecutive lines never
+ * evict each other and the memory used is bounded. Block arrays of evicted
+ * lines are reused for new lines.
+ */
+class TextBlockCache
+{
+public:
+  /** @brief Start of text painted with given colors */
+  struct TEXTBLOCK
+    {
+      int m_nCharPos;
+      int m_nColorIndex;
+      int m_nBgColorIndex;
+    };
+
+  static const int DefaultCapacity = 512; /**< Lines cached, power of two */
+
+  explicit TextBlockCache (int nCapacity = DefaultCapacity);
+
+  const TEXTBLOCK *Lookup (int nLineIndex, DWORD dwCookie, DWORD dwStamp,
+      int &nBlocks, DWORD &dwNextCookie) const;
+  const TEXTBLOCK *Store (int nLineIndex, DWORD dwCookie, DWORD dwStamp,
+      DWORD dwNextCookie, const TEXTBLOCK *pBuf, int nBlocks);
+  void Invalidate (int nLineIndex1, int nLineIndex2);
+  void InvalidateAll ();
+  TEXTBLOCK *GetBuffer (int nBuffer, int nSize);
+
+  static int MergeTextBlocks (const TEXTBLOCK *pBuf1, int nBlocks1,
+      const TEXTBLOCK *pBuf2, int nBlocks2, TEXTBLOCK *pMergedBuf);
+
+private:
+  /** @brief Merged blocks of one line */
+  struct ENTRY
+    {
+      int m_nLineIndex; /**< Cached line, -1 if none */
+      DWORD m_dwGeneration; /**< Generation the entry was stored in */
+      DWORD m_dwCookie; /**< Parse cookie of the line above */
+      DWORD m_dwStamp; /**< State of additional blocks */
+      DWORD m_dwNextCookie; /**< Parse cookie of the line */
+      std::vector<TEXTBLOCK> m_blocks;
+    };
+
+  std::vector<ENTRY> m_entries;
+  DWORD m_dwGeneration; /**< Incremented to invalidate all entries */
+  std::vector<TEXTBLOCK> m_buffers[2]; /**< Scratch buffers for parsing */
+};
+
+#endif // _TEXT_BLOCK_CACHE_H_
@@ -8,6 +8,7 @@
 
 #include "stdafx.h"
 #include "UndoRecord.h"
+#include "MemoryStats.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -37,6 +38,7 @@ SetText (LPCTSTR pszText, int nLength)
   if (nLength != 1)
     {
       m_pszText = (TextBuffer *)malloc(sizeof(TextBuffer) + nLength * sizeof(TCHAR));
+      MemoryStats::Allocated(MemoryStats::UNDO_BUFFERS, sizeof(TextBuffer) + nLength * sizeof(TCHAR));
       m_pszText->size = nLength;
       memcpy(m_pszText->data, pszText, nLength * sizeof(TCHAR));
       m_pszText->data[nLength] = _T('?'); // debug sentinel
@@ -54,6 +56,9 @@ FreeText ()
   // Check if m_pszText is a pointer by removing bits having
   // possible char value
   if (((INT_PTR)m_pszText >> 16) != 0)
-    free(m_pszText);
+    {
+      MemoryStats::Freed(MemoryStats::UNDO_BUFFERS, sizeof(TextBuffer) + m_pszText->size * sizeof(TCHAR));
+      free(m_pszText);
+    }
   m_pszText = NULL;
 }
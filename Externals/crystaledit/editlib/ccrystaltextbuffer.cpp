@@ -67,6 +67,8 @@
 #include <malloc.h>
 #include "editcmd.h"
 #include "LineInfo.h"
+#include "LineArray.h"
+#include "LineFlagIndex.h"
 #include "UndoRecord.h"
 #include "ccrystaltextbuffer.h"
 #include "ccrystaltextview.h"
@@ -149,6 +151,8 @@ RecalcPoint (CPoint & ptPoint)
 IMPLEMENT_DYNCREATE (CCrystalTextBuffer, CCmdTarget)
 
 CCrystalTextBuffer::CCrystalTextBuffer ()
+: m_LineFlagIndex (LF_MARKER_FLAGS)
+, m_LineFlagRanges (LF_INVISIBLE)
 {
   m_bInit = false;
   m_bReadOnly = false;
@@ -202,6 +206,8 @@ void CCrystalTextBuffer::InsertLine (LPCTSTR pszLine, int nLength /*= -1*/ ,
   // insert all lines in one pass
   std::vector<LineInfo>::iterator iter = m_aLines.begin() + nPosition;
   m_aLines.insert(iter, nCount, line);
+  m_LineFlagIndex.InsertLines (nPosition, nCount);
+  m_LineFlagRanges.InsertLines (nPosition, nCount);
 
   // create text data for lines after the first one
   for (int ic = 1; ic < nCount; ic++) 
@@ -258,9 +264,13 @@ AppendLine (int nLineIndex, LPCTSTR pszChars, int nLength /*= -1*/ )
  *     l=40  lines[10] = lines[40]
  *     l=41  lines[11] = lines[41]
  *     l=42  lines[12] = lines[42]
+ *
+ * NB: Flags kept as ranges stay at their line numbers, set them after
+ * the lines are moved
  */
 void CCrystalTextBuffer::MoveLine(int line1, int line2, int newline1)
 {
+	m_LineFlagIndex.Invalidate ();
 	int ldiff = newline1 - line1;
 	if (ldiff > 0) {
 		for (int l = line2; l >= line1; l--)
@@ -274,6 +284,8 @@ void CCrystalTextBuffer::MoveLine(int line1, int line2, int newline1)
 
 void CCrystalTextBuffer::SetEmptyLine (int nPosition, int nCount /*= 1*/ )
 {
+  m_LineFlagIndex.Invalidate ();
+  m_LineFlagRanges.SetLineFlags (nPosition, nPosition + nCount - 1, m_LineFlagRanges.GetRangeFlags (), 0);
   for (int i = 0; i < nCount; i++) 
     {
       LineInfo li;
@@ -294,6 +306,8 @@ FreeAll ()
       ++iter;
     }
   m_aLines.clear();
+  m_LineFlagIndex.Invalidate ();
+  m_LineFlagRanges.Clear ();
 
   // Undo buffer will be cleared by its destructor
 
@@ -722,7 +736,7 @@ GetLineFlags (int nLine) const
   ASSERT (m_bInit);             //  Text buffer not yet initialized.
   //  You must call InitNew() or LoadFromFile() first!
 
-  return m_aLines[nLine].m_dwFlags;
+  return m_aLines[nLine].m_dwFlags | m_LineFlagRanges.GetLineFlags (nLine);
 }
 
 /** 
@@ -760,11 +774,16 @@ FlagToIndex (DWORD dwFlag)
 int CCrystalTextBuffer::
 FindLineWithFlag (DWORD dwFlag) const
 {
-  const size_t nSize = m_aLines.size();
-  for (size_t L = 0; L < nSize; L++)
+  if (m_LineFlagIndex.IsIndexed (dwFlag))
+    return m_LineFlagIndex.FindNextLine (m_aLines, dwFlag, 0);
+  if ((dwFlag & ~m_LineFlagRanges.GetRangeFlags ()) == 0)
+    return m_LineFlagRanges.FindNextLine (dwFlag, 0);
+
+  const int nSize = (int) m_aLines.size();
+  for (int L = 0; L < nSize; L++)
     {
-      if ((m_aLines[L].m_dwFlags & dwFlag) != 0)
-        return (int) L;
+      if ((GetLineFlags (L) & dwFlag) != 0)
+        return L;
     }
   return -1;
 }
@@ -805,7 +824,8 @@ SetLineFlag (int nLine, DWORD dwFlag, bool bSet, bool bRemoveFromPreviousLine /*
       bRemoveFromPreviousLine = false;
     }
 
-  DWORD dwNewFlags = m_aLines[nLine].m_dwFlags;
+  const DWORD dwOldFlags = GetLineFlags (nLine);
+  DWORD dwNewFlags = dwOldFlags;
   if (bSet)
   {
     if (dwFlag==0)
@@ -816,7 +836,7 @@ SetLineFlag (int nLine, DWORD dwFlag, bool bSet, bool bRemoveFromPreviousLine /*
   else
     dwNewFlags = dwNewFlags & ~dwFlag;
 
-  if (m_aLines[nLine].m_dwFlags != dwNewFlags)
+  if (dwOldFlags != dwNewFlags)
     {
       if (bRemoveFromPreviousLine)
         {
@@ -826,6 +846,8 @@ SetLineFlag (int nLine, DWORD dwFlag, bool bSet, bool bRemoveFromPreviousLine /*
               if (nPrevLine >= 0)
                 {
                   ASSERT ((m_aLines[nPrevLine].m_dwFlags & dwFlag) != 0);
+                  m_LineFlagIndex.SetLineFlags (nPrevLine, m_aLines[nPrevLine].m_dwFlags,
+                      m_aLines[nPrevLine].m_dwFlags & ~dwFlag);
                   m_aLines[nPrevLine].m_dwFlags &= ~dwFlag;
           if (bUpdate)
           UpdateViews (NULL, NULL, UPDATE_SINGLELINE | UPDATE_FLAGSONLY, nPrevLine);
@@ -837,12 +859,49 @@ SetLineFlag (int nLine, DWORD dwFlag, bool bSet, bool bRemoveFromPreviousLine /*
             }
         }
 
-      m_aLines[nLine].m_dwFlags = dwNewFlags;
+      const DWORD dwRangeFlags = m_LineFlagRanges.GetRangeFlags ();
+      m_LineFlagRanges.SetLineFlags (nLine, nLine, dwRangeFlags, dwNewFlags);
+      m_LineFlagIndex.SetLineFlags (nLine, m_aLines[nLine].m_dwFlags, dwNewFlags & ~dwRangeFlags);
+      m_aLines[nLine].m_dwFlags = dwNewFlags & ~dwRangeFlags;
       if (bUpdate)
       UpdateViews (NULL, NULL, UPDATE_SINGLELINE | UPDATE_FLAGSONLY, nLine);
     }
 }
 
+/**
+ * @brief Set or clear flags of a range of lines.
+ * Unlike SetLineFlag() the flags are not removed from other lines and the
+ * views are not updated. Flags kept as ranges are set in O(log n), only
+ * the other flags are written into each line.
+ * @param [in] nStartLine First line of the range.
+ * @param [in] nEndLine Last line of the range.
+ * @param [in] dwFlag Flags to set or clear.
+ * @param [in] bSet true to set the flags, false to clear them.
+ */
+void CCrystalTextBuffer::
+SetLineFlagRange (int nStartLine, int nEndLine, DWORD dwFlag, bool bSet)
+{
+  ASSERT (m_bInit);             //  Text buffer not yet initialized.
+  ASSERT (nStartLine >= 0 && nEndLine < (int) m_aLines.size ());
+
+  m_LineFlagRanges.SetLineFlags (nStartLine, nEndLine, dwFlag, bSet ? dwFlag : 0);
+  dwFlag &= ~m_LineFlagRanges.GetRangeFlags ();
+  if (dwFlag == 0)
+    return;
+  if (dwFlag & LF_MARKER_FLAGS)
+    m_LineFlagIndex.Invalidate ();
+  if (bSet)
+    {
+      for (int nLine = nStartLine; nLine <= nEndLine; nLine++)
+        m_aLines[nLine].m_dwFlags |= dwFlag;
+    }
+  else
+    {
+      for (int nLine = nStartLine; nLine <= nEndLine; nLine++)
+        m_aLines[nLine].m_dwFlags &= ~dwFlag;
+    }
+}
+
 
 /**
  * @brief Get text of specified line range (excluding ghost lines)
@@ -1024,25 +1083,16 @@ InternalDeleteText (CCrystalTextView * pSource, int nStartLine, int nStartChar,
   else
     {
       // delete multiple lines
-      const int nRestCount = m_aLines[nEndLine].FullLength() - nEndChar;
-      CString sTail(m_aLines[nEndLine].GetLine(nEndChar), nRestCount);
-      DWORD dwFlags = GetLineFlags (nEndLine);
-
-      const int nDelCount = nEndLine - nStartLine;
-      for (int L = nStartLine + 1; L <= nEndLine; L++)
-        m_aLines[L].Clear();
-      std::vector<LineInfo>::iterator iterBegin = m_aLines.begin() + nStartLine + 1;
-      std::vector<LineInfo>::iterator iterEnd = iterBegin + nDelCount;
-      m_aLines.erase(iterBegin, iterEnd);
-
-      //  nEndLine is no more valid
-      m_aLines[nStartLine].DeleteEnd(nStartChar);
-      if (nRestCount > 0)
+      if (nStartChar == 0)
         {
-          AppendLine (nStartLine, sTail, sTail.GetLength());
+          m_LineFlagIndex.SetLineFlags (nStartLine, m_aLines[nStartLine].m_dwFlags,
+              m_aLines[nEndLine].m_dwFlags);
+          m_LineFlagRanges.SetLineFlags (nStartLine, nStartLine, m_LineFlagRanges.GetRangeFlags (),
+              m_LineFlagRanges.GetLineFlags (nEndLine));
         }
-      if (nStartChar == 0)
-        m_aLines[nStartLine].m_dwFlags = dwFlags;
+      m_LineFlagIndex.DeleteLines (nStartLine + 1, nEndLine - nStartLine);
+      m_LineFlagRanges.DeleteLines (nStartLine + 1, nEndLine - nStartLine);
+      LineArray::DeleteText (m_aLines, nStartLine, nStartChar, nEndLine, nEndChar);
 
       if (pSource!=NULL)
         UpdateViews (pSource, &context, UPDATE_HORZRANGE | UPDATE_VERTRANGE, nStartLine);
@@ -1058,25 +1108,6 @@ InternalDeleteText (CCrystalTextView * pSource, int nStartLine, int nStartChar,
   return true;
 }
 
-// Remove the last [bytes] characters from specified line, and return them
-// (EOL characters are included)
-CString CCrystalTextBuffer::
-StripTail (int i, int bytes)
-{
-  LineInfo & li = m_aLines[i];
-  // Must at least take off the EOL characters
-  ASSERT(bytes >= li.FullLength() - li.Length());
-
-  const int offset = li.FullLength() - bytes;
-  // Must not take off more than exist
-  ASSERT(offset >= 0);
-
-  CString ret(li.GetLine(offset), bytes);
-  li.DeleteEnd(offset);
-  return ret;
-}
-
-
 /**
  * @brief Insert text to the buffer.
  * @param [in] pSource A view to which the text is added.
@@ -1111,87 +1142,12 @@ InternalInsertText (CCrystalTextView * pSource, int nLine, int nPos,
   nEndLine = 0;
   nEndChar = 0;
 
-  int nRestCount = GetFullLineLength(nLine) - nPos;
-  CString sTail;
-  if (nRestCount > 0)
-    {
-      // remove end of line (we'll put it back on afterwards)
-      sTail = StripTail(nLine, nRestCount);
-    }
-
-
+  // build all new lines first and insert them at once
   int nInsertedLines = 0;
-  int nCurrentLine = nLine;
-  int nTextPos;
-  for (;;)
-    {
-      int haseol = 0;
-      nTextPos = 0;
-      // advance to end of line
-      while (nTextPos < cchText && !LineInfo::IsEol(pszText[nTextPos]))
-        nTextPos++;
-      // advance after EOL of line
-      if (nTextPos < cchText)
-        {
-          haseol = 1;
-          LPCTSTR eol = &pszText[nTextPos];
-          nTextPos++;
-          if (nTextPos < cchText && LineInfo::IsDosEol(eol))
-            nTextPos++;
-        }
-
-      // The first line of the new text is appended to the start line
-      // All succeeding lines are inserted
-      if (nCurrentLine == nLine)
-        {
-          AppendLine (nLine, pszText, nTextPos);
-        }
-      else
-        {
-          InsertLine (pszText, nTextPos, nCurrentLine);
-          nInsertedLines ++;
-        }
-
-
-      if (nTextPos == cchText)
-        {
-          // we just finished our insert
-          // now we have to reattach the tail
-          if (haseol)
-            {
-              nEndLine = nCurrentLine+1;
-              nEndChar = 0;
-            }
-          else
-            {
-              nEndLine = nCurrentLine;
-              nEndChar = GetLineLength(nEndLine);
-            }
-          if (!sTail.IsEmpty())
-            {
-              if (haseol)
-              {
-                InsertLine(sTail, sTail.GetLength(), nEndLine);
-                nInsertedLines ++;
-              }
-              else
-                AppendLine (nEndLine, sTail, nRestCount);
-            }
-          if (nEndLine == GetLineCount())
-            {
-              // We left cursor after last screen line
-              // which is an illegal cursor position
-              // so manufacture a new trailing line
-              InsertLine(_T(""), 0);
-              nInsertedLines ++;
-            }
-          break;
-        }
-
-      ++nCurrentLine;
-      pszText += nTextPos;
-      cchText -= nTextPos;
-    }
+  LineArray::InsertText (m_aLines, nLine, nPos, pszText, cchText,
+      nEndLine, nEndChar, nInsertedLines);
+  m_LineFlagIndex.InsertLines (nLine + 1, nInsertedLines);
+  m_LineFlagRanges.InsertLines (nLine + 1, nInsertedLines);
 
   // Compute the context : all positions after context.m_ptBegin are
   // shifted accordingly to (context.m_ptEnd - context.m_ptBegin)
@@ -1263,7 +1219,7 @@ GetUndoActionCode (int & nAction, POSITION pos /*= NULL*/ ) const
 
   //  Advance to next undo group
   nPosition--;
-  std::vector<UndoRecord>::const_iterator iter = m_aUndoBuf.begin () + nPosition;
+  UndoRecordArray::const_iterator iter = m_aUndoBuf.begin () + nPosition;
   while (((*iter).m_dwFlags & UNDO_BEGINGROUP) == 0)
     {
       --iter;
@@ -1306,7 +1262,7 @@ GetRedoActionCode (int & nAction, POSITION pos /*= NULL*/ ) const
   nPosition++;
   if (nPosition < static_cast<intptr_t>(m_aUndoBuf.size ()))
     {
-      std::vector<UndoRecord>::const_iterator iter = m_aUndoBuf.begin () + nPosition;
+      UndoRecordArray::const_iterator iter = m_aUndoBuf.begin () + nPosition;
       while (iter != m_aUndoBuf.end () && ((*iter).m_dwFlags & UNDO_BEGINGROUP) == 0)
         {
           ++iter;
@@ -1844,59 +1800,33 @@ FlushUndoGroup (CCrystalTextView * pSource)
 int CCrystalTextBuffer::
 FindNextBookmarkLine (int nCurrentLine) const
 {
-  bool bWrapIt = true;
   DWORD dwFlags = GetLineFlags (nCurrentLine);
   if ((dwFlags & LF_BOOKMARKS) != 0)
     nCurrentLine++;
 
-  const size_t nSize = m_aLines.size ();
-  for (;;)
+  int nLine = m_LineFlagIndex.FindNextLine (m_aLines, LF_BOOKMARKS, nCurrentLine);
+  if (nLine < 0)
     {
-      while (nCurrentLine < nSize)
-        {
-          if ((m_aLines[nCurrentLine].m_dwFlags & LF_BOOKMARKS) != 0)
-            return nCurrentLine;
-          // Keep going
-          nCurrentLine++;
-        }
-      // End of text reached
-      if (!bWrapIt)
-        return -1;
-
       // Start from the beginning of text
-      bWrapIt = false;
-      nCurrentLine = 0;
+      nLine = m_LineFlagIndex.FindNextLine (m_aLines, LF_BOOKMARKS, 0);
     }
-  return -1;
+  return nLine;
 }
 
 int CCrystalTextBuffer::
 FindPrevBookmarkLine (int nCurrentLine) const
 {
-  bool bWrapIt = true;
   DWORD dwFlags = GetLineFlags (nCurrentLine);
   if ((dwFlags & LF_BOOKMARKS) != 0)
     nCurrentLine--;
 
-  const size_t nSize = m_aLines.size ();
-  for (;;)
+  int nLine = m_LineFlagIndex.FindPrevLine (m_aLines, LF_BOOKMARKS, nCurrentLine);
+  if (nLine < 0)
     {
-      while (nCurrentLine >= 0)
-        {
-          if ((m_aLines[nCurrentLine].m_dwFlags & LF_BOOKMARKS) != 0)
-            return nCurrentLine;
-          // Keep moving up
-          nCurrentLine--;
-        }
-      // Beginning of text reached
-      if (!bWrapIt)
-        return -1;
-
       // Start from the end of text
-      bWrapIt = false;
-      nCurrentLine = (int) (nSize - 1);
+      nLine = m_LineFlagIndex.FindPrevLine (m_aLines, LF_BOOKMARKS, (int) m_aLines.size () - 1);
     }
-  return -1;
+  return nLine;
 }
 
 bool CCrystalTextBuffer::
@@ -1953,11 +1883,9 @@ void CCrystalTextBuffer::RestoreLastChangePos(CPoint pt)
  */
 void CCrystalTextBuffer::DeleteLine(int line, int nCount /*=1*/)
 {
-  for (int ic = 0; ic < nCount; ic++)
-    m_aLines[line + ic].Clear();
-  std::vector<LineInfo>::iterator iterBegin = m_aLines.begin() + line;
-  std::vector<LineInfo>::iterator iterEnd = iterBegin + nCount;
-  m_aLines.erase(iterBegin, iterEnd);
+  m_LineFlagIndex.DeleteLines (line, nCount);
+  m_LineFlagRanges.DeleteLines (line, nCount);
+  LineArray::DeleteLines (m_aLines, line, nCount);
 }
 
 int CCrystalTextBuffer::GetTabSize() const
@@ -39,7 +39,10 @@
 
 #include <vector>
 #include "LineInfo.h"
+#include "LineFlagIndex.h"
+#include "LineFlagRanges.h"
 #include "UndoRecord.h"
+#include "MemoryStats.h"
 #include "ccrystaltextview.h"
 
 #ifndef __AFXTEMPL_H__
@@ -60,6 +63,10 @@ enum LINEFLAGS
 
 #define LF_BOOKMARK(id)     (LF_BOOKMARK_FIRST << id)
 
+//  Flags set on few lines, kept in the line flag index
+#define LF_MARKER_FLAGS     ((LF_BOOKMARK (10) - LF_BOOKMARK_FIRST) | LF_EXECUTION | LF_BREAKPOINT | \
+                             LF_COMPILATION_ERROR | LF_BOOKMARKS | LF_INVALID_BREAKPOINT)
+
 enum CRLFSTYLE
 {
   CRLF_STYLE_AUTOMATIC = -1,
@@ -155,9 +162,12 @@ public :
 
     //  Lines of text
     std::vector<LineInfo> m_aLines; /**< Text lines. */
+    LineFlagIndex m_LineFlagIndex; /**< Lines having marker flags. */
+    LineFlagRanges m_LineFlagRanges; /**< Flags set on ranges of lines. */
 
     //  Undo
-    std::vector<UndoRecord> m_aUndoBuf; /**< Undo records. */
+    typedef std::vector<UndoRecord, MemoryStats::Allocator<UndoRecord, MemoryStats::UNDO_BUFFERS> > UndoRecordArray;
+    UndoRecordArray m_aUndoBuf; /**< Undo records. */
     int m_nUndoPosition;
     int m_nSyncPosition;
     bool m_bUndoGroup, m_bUndoBeginGroup;
@@ -179,7 +189,6 @@ public :
     //  Implementation
     bool InternalInsertText (CCrystalTextView * pSource, int nLine, int nPos, LPCTSTR pszText, int cchText, int &nEndLine, int &nEndChar);
     bool InternalDeleteText (CCrystalTextView * pSource, int nStartLine, int nStartPos, int nEndLine, int nEndPos);
-    CString StripTail (int i, int bytes);
 
     //  [JRT] Support For Descriptions On Undo/Redo Actions
     virtual void AddUndoRecord (bool bInsert, const CPoint & ptStartPos, const CPoint & ptEndPos,
@@ -234,6 +243,7 @@ public :
     int GetLineWithFlag (DWORD dwFlag) const;
     void SetLineFlag (int nLine, DWORD dwFlag, bool bSet,
             bool bRemoveFromPreviousLine = true, bool bUpdate=true);
+    void SetLineFlagRange (int nStartLine, int nEndLine, DWORD dwFlag, bool bSet);
     void GetText (int nStartLine, int nStartChar, int nEndLine, int nEndChar,
             CString & text, LPCTSTR pszCRLF = NULL, bool bExcludeInvisibleLines = true) const;
     virtual void GetTextWithoutEmptys (int nStartLine, int nStartChar,
@@ -346,6 +346,7 @@ DoSetTextType (TextDefinition *def)
 {
   m_CurSourceDef = def;
   SetFlags (def->flags);
+  m_pTextBlockCache->InvalidateAll ();
 
 // Do not set these
 // EOL is determined from file, tabsize and viewtabs are
@@ -530,6 +531,7 @@ CCrystalTextView::CCrystalTextView ()
   //END SW
   m_ParseCookies = new vector<DWORD>;
   m_pnActualLineLength = new vector<int>;
+  m_pTextBlockCache = new TextBlockCache;
   ResetView ();
   SetTextType (SRC_PLAIN);
   m_bSingle = false; // needed to be set in descendat classes
@@ -591,6 +593,8 @@ CCrystalTextView::~CCrystalTextView ()
   ASSERT(m_pnActualLineLength);
   delete m_pnActualLineLength;
   m_pnActualLineLength = NULL;
+  delete m_pTextBlockCache;
+  m_pTextBlockCache = NULL;
   delete m_pIcons;
 }
 
@@ -1327,6 +1331,64 @@ GetAdditionalTextBlocks (int nLineIndex, TEXTBLOCK *&pBuf)
   return 0;
 }
 
+/**
+ * @brief Return the state GetAdditionalTextBlocks() depends on.
+ * Override this if the additional blocks of a line can change without
+ * InvalidateLineCache() being called for the line. The cached blocks of
+ * the line are not used when the returned value changes.
+ */
+DWORD CCrystalTextView::
+GetAdditionalTextBlocksStamp (int nLineIndex)
+{
+  return 0;
+}
+
+/**
+ * @brief Return the syntax blocks of the line merged with the additional blocks.
+ * The merged blocks are cached, so repainting a line does not parse it again.
+ * @param [in]  nLineIndex Index of line in view
+ * @param [out] nBlocks    Number of blocks
+ * @return The blocks, valid until the next call
+ */
+const CCrystalTextView::TEXTBLOCK *CCrystalTextView::
+GetTextBlocks (int nLineIndex, int &nBlocks)
+{
+  DWORD dwCookie = GetParseCookie (nLineIndex - 1);
+  DWORD dwStamp = GetAdditionalTextBlocksStamp (nLineIndex);
+  DWORD dwNextCookie;
+  const TEXTBLOCK *pCached = m_pTextBlockCache->Lookup (nLineIndex, dwCookie, dwStamp, nBlocks, dwNextCookie);
+  if (pCached != NULL)
+    {
+      (*m_ParseCookies)[nLineIndex] = dwNextCookie;
+      return pCached;
+    }
+
+  //  Parse the line
+  int nLength = GetViewableLineLength (nLineIndex);
+  TEXTBLOCK *pBuf = m_pTextBlockCache->GetBuffer (0, (nLength+1) * 3); // be aware of nLength == 0
+  nBlocks = 0;
+
+  // insert at least one textblock of normal color at the beginning
+  pBuf[0].m_nCharPos = 0;
+  pBuf[0].m_nColorIndex = COLORINDEX_NORMALTEXT;
+  pBuf[0].m_nBgColorIndex = COLORINDEX_BKGND;
+  nBlocks++;
+
+  dwNextCookie = ParseLine (dwCookie, nLineIndex, pBuf, nBlocks);
+  (*m_ParseCookies)[nLineIndex] = dwNextCookie;
+  ASSERT ((*m_ParseCookies)[nLineIndex] != - 1);
+
+  TEXTBLOCK *pAddedBuf;
+  int nAddedBlocks = GetAdditionalTextBlocks(nLineIndex, pAddedBuf);
+
+  TEXTBLOCK *pMergedBuf = m_pTextBlockCache->GetBuffer (1, nBlocks + nAddedBlocks);
+  nBlocks = TextBlockCache::MergeTextBlocks(pBuf, nBlocks, pAddedBuf, nAddedBlocks, pMergedBuf);
+
+  delete[] pAddedBuf;
+
+  return m_pTextBlockCache->Store (nLineIndex, dwCookie, dwStamp, dwNextCookie, pMergedBuf, nBlocks);
+}
+
 //BEGIN SW
 void CCrystalTextView::WrapLine( int nLineIndex, int nMaxLineWidth, int *anBreaks, int &nBreaks )
 {
@@ -1375,6 +1437,9 @@ void CCrystalTextView::WrapLineCached(
 
 void CCrystalTextView::InvalidateLineCache( int nLineIndex1, int nLineIndex2 /*= -1*/ )
 {
+  // invalidate cached text blocks
+  m_pTextBlockCache->Invalidate( nLineIndex1, nLineIndex2 );
+
   // invalidate cached sub line index
   InvalidateSubLineIndexCache( nLineIndex1 );
 
@@ -1438,7 +1503,7 @@ void CCrystalTextView::InvalidateScreenRect(bool bInvalidateView)
 }
 
 void CCrystalTextView::DrawScreenLine( CDC *pdc, CPoint &ptOrigin, const CRect &rcClip,
-         TEXTBLOCK *pBuf, int nBlocks, int &nActualItem, 
+         const TEXTBLOCK *pBuf, int nBlocks, int &nActualItem, 
          COLORREF crText, COLORREF crBkgnd, bool bDrawWhitespace,
          LPCTSTR pszChars, int nOffset, int nCount, int &nActualOffset, CPoint ptTextPos )
 {
@@ -1592,73 +1657,8 @@ int CCrystalTextView::
 MergeTextBlocks (TEXTBLOCK *pBuf1, int nBlocks1, TEXTBLOCK *pBuf2,
      int nBlocks2, TEXTBLOCK *&pMergedBuf)
 {
-  int i, j, k;
-
   pMergedBuf = new TEXTBLOCK[nBlocks1 + nBlocks2];
-
-  for (i = 0, j = 0, k = 0; ; k++)
-    {
-      if (i >= nBlocks1 && j >= nBlocks2)
-        {
-          break;
-        }
-      else if ((i < nBlocks1 && j < nBlocks2) &&
-          (pBuf1[i].m_nCharPos == pBuf2[j].m_nCharPos))
-        {
-          pMergedBuf[k].m_nCharPos = pBuf2[j].m_nCharPos;
-          if (pBuf2[j].m_nColorIndex == COLORINDEX_NONE)
-            pMergedBuf[k].m_nColorIndex = pBuf1[i].m_nColorIndex;
-          else
-            pMergedBuf[k].m_nColorIndex = pBuf2[j].m_nColorIndex;
-          if (pBuf2[j].m_nBgColorIndex == COLORINDEX_NONE)
-            pMergedBuf[k].m_nBgColorIndex = pBuf1[i].m_nBgColorIndex;
-          else
-            pMergedBuf[k].m_nBgColorIndex = pBuf2[j].m_nBgColorIndex;
-          i++;
-          j++;
-        }
-      else if (j >= nBlocks2 || (i < nBlocks1 &&
-          pBuf1[i].m_nCharPos < pBuf2[j].m_nCharPos))
-        {
-          pMergedBuf[k].m_nCharPos = pBuf1[i].m_nCharPos;
-          if (nBlocks2 == 0 || pBuf2[j - 1].m_nColorIndex == COLORINDEX_NONE)
-            pMergedBuf[k].m_nColorIndex = pBuf1[i].m_nColorIndex;
-          else
-            pMergedBuf[k].m_nColorIndex = pBuf2[j - 1].m_nColorIndex;
-          if (nBlocks2 == 0 || pBuf2[j - 1].m_nBgColorIndex == COLORINDEX_NONE)
-            pMergedBuf[k].m_nBgColorIndex = pBuf1[i].m_nBgColorIndex;
-          else
-            pMergedBuf[k].m_nBgColorIndex = pBuf2[j - 1].m_nBgColorIndex;
-          i++;
-        }
-      else if (i >= nBlocks1 || (j < nBlocks2 && pBuf1[i].m_nCharPos > pBuf2[j].m_nCharPos))
-        {
-          pMergedBuf[k].m_nCharPos = pBuf2[j].m_nCharPos;
-          if (i > 0 && pBuf2[j].m_nColorIndex == COLORINDEX_NONE)
-            pMergedBuf[k].m_nColorIndex = pBuf1[i - 1].m_nColorIndex;
-          else
-            pMergedBuf[k].m_nColorIndex = pBuf2[j].m_nColorIndex;
-          if (i > 0 && pBuf2[j].m_nBgColorIndex == COLORINDEX_NONE)
-            pMergedBuf[k].m_nBgColorIndex = pBuf1[i - 1].m_nBgColorIndex;
-          else
-            pMergedBuf[k].m_nBgColorIndex = pBuf2[j].m_nBgColorIndex;
-          j++;
-        }
-    }
-
-  j = 0;
-  for (i = 0; i < k; ++i)
-    {
-      if (i == 0 ||
-          (pMergedBuf[i - 1].m_nColorIndex   != pMergedBuf[i].m_nColorIndex ||
-           pMergedBuf[i - 1].m_nBgColorIndex != pMergedBuf[i].m_nBgColorIndex))
-        {
-          pMergedBuf[j] = pMergedBuf[i];
-          ++j;
-        }
-    }
-
-  return j;
+  return TextBlockCache::MergeTextBlocks (pBuf1, nBlocks1, pBuf2, nBlocks2, pMergedBuf);
 }
 
 void CCrystalTextView::
@@ -1683,30 +1683,8 @@ DrawSingleLine (CDC * pdc, const CRect & rc, int nLineIndex)
   LPCTSTR pszChars = GetLineChars (nLineIndex);
 
   //  Parse the line
-  DWORD dwCookie = GetParseCookie (nLineIndex - 1);
-  TEXTBLOCK *pBuf = new TEXTBLOCK[(nLength+1) * 3]; // be aware of nLength == 0
-  int nBlocks = 0;
-
-  // insert at least one textblock of normal color at the beginning
-  pBuf[0].m_nCharPos = 0;
-  pBuf[0].m_nColorIndex = COLORINDEX_NORMALTEXT;
-  pBuf[0].m_nBgColorIndex = COLORINDEX_BKGND;
-  nBlocks++;
-
-  (*m_ParseCookies)[nLineIndex] = ParseLine (dwCookie, nLineIndex, pBuf, nBlocks);
-  ASSERT ((*m_ParseCookies)[nLineIndex] != - 1);
-
-  TEXTBLOCK *pAddedBuf;
-  int nAddedBlocks = GetAdditionalTextBlocks(nLineIndex, pAddedBuf);
-
-  TEXTBLOCK *pMergedBuf;
-  int nMergedBlocks = MergeTextBlocks(pBuf, nBlocks, pAddedBuf, nAddedBlocks, pMergedBuf);
-
-  delete[] pBuf;
-  delete[] pAddedBuf;
-
-  pBuf = pMergedBuf;
-  nBlocks = nMergedBlocks;
+  int nBlocks;
+  const TEXTBLOCK *pBuf = GetTextBlocks (nLineIndex, nBlocks);
 
   int nActualItem = 0;
   int nActualOffset = 0;
@@ -1763,8 +1741,6 @@ DrawSingleLine (CDC * pdc, const CRect & rc, int nLineIndex)
         crText, crBkgnd, bDrawWhitespace,
         pszChars, 0, nLength, nActualOffset, CPoint(0, nLineIndex));
 
-  delete[] pBuf;
-
   // Draw empty sublines
   int nEmptySubLines = GetEmptySubLines(nLineIndex);
   if (nEmptySubLines > 0)
@@ -1975,30 +1951,8 @@ GetHTMLLine (int nLineIndex, LPCTSTR pszTag)
   GetLineColors (nLineIndex, crBkgnd, crText, bDrawWhitespace);
 
   //  Parse the line
-  DWORD dwCookie = GetParseCookie (nLineIndex - 1);
-  TEXTBLOCK *pBuf = new TEXTBLOCK[(nLength+1) * 3]; // be aware of nLength == 0
-  int nBlocks = 0;
-  // insert at least one textblock of normal color at the beginning
-  pBuf[0].m_nCharPos = 0;
-  pBuf[0].m_nColorIndex = COLORINDEX_NORMALTEXT;
-  pBuf[0].m_nBgColorIndex = COLORINDEX_BKGND;
-  nBlocks++;
-  (*m_ParseCookies)[nLineIndex] = ParseLine (dwCookie, nLineIndex, pBuf, nBlocks);
-  ASSERT ((*m_ParseCookies)[nLineIndex] != - 1);
-
-////////
-  TEXTBLOCK *pAddedBuf;
-  int nAddedBlocks = GetAdditionalTextBlocks(nLineIndex, pAddedBuf);
-
-  TEXTBLOCK *pMergedBuf;
-  int nMergedBlocks = MergeTextBlocks(pBuf, nBlocks, pAddedBuf, nAddedBlocks, pMergedBuf);
-
-  delete[] pBuf;
-  delete[] pAddedBuf;
-
-  pBuf = pMergedBuf;
-  nBlocks = nMergedBlocks;
-///////
+  int nBlocks;
+  const TEXTBLOCK *pBuf = GetTextBlocks (nLineIndex, nBlocks);
 
   CString strHTML;
   CString strExpanded;
@@ -2043,11 +1997,68 @@ GetHTMLLine (int nLineIndex, LPCTSTR pszTag)
   strHTML += pszTag;
   strHTML += _T(">");
 
-  delete[] pBuf;
-
   return strHTML;
 }
 
+/**
+ * @brief Retrieve the expanded text of the line and its colors
+ * The colors are resolved like GetHTMLAttribute() does, so the caller can
+ * render the line without accessing the view again.
+ * @param [in]  nLineIndex  Index of line in view
+ * @param [out] strText     The line with tabs expanded
+ * @param [out] blocks      Parts of strText in one color, may be empty
+ * @param [out] lineBlock   Colors of the line
+ */
+void CCrystalTextView::
+GetHTMLLineBlocks (int nLineIndex, CString &strText, std::vector<HTMLBLOCK> &blocks, HTMLBLOCK &lineBlock)
+{
+  ASSERT (nLineIndex >= -1 && nLineIndex < GetLineCount ());
+
+  int nLength = GetViewableLineLength (nLineIndex);
+  LPCTSTR pszChars = GetLineChars (nLineIndex);
+
+  //  Acquire the background color for the current line
+  bool bDrawWhitespace = false;
+  COLORREF crBkgnd, crText;
+  GetLineColors (nLineIndex, crBkgnd, crText, bDrawWhitespace);
+
+  //  Parse the line
+  int nBlocks;
+  const TEXTBLOCK *pBuf = GetTextBlocks (nLineIndex, nBlocks);
+
+  lineBlock.m_nCharPos = 0;
+  lineBlock.m_clrText = (crText == CLR_NONE) ? GetColor (COLORINDEX_NORMALTEXT) : crText;
+  lineBlock.m_clrBkgnd = (crBkgnd == CLR_NONE) ? GetColor (COLORINDEX_BKGND) : crBkgnd;
+  lineBlock.m_nColorIndex = (crText == CLR_NONE) ? COLORINDEX_NORMALTEXT : -1;
+  lineBlock.m_nBgColorIndex = (crBkgnd == CLR_NONE) ? COLORINDEX_BKGND : -1;
+  lineBlock.m_bBold = GetBold (COLORINDEX_NORMALTEXT);
+  lineBlock.m_bItalic = GetItalic (COLORINDEX_NORMALTEXT);
+
+  // Blocks are expanded one by one like GetHTMLLine() does
+  strText.Empty ();
+  blocks.clear ();
+  CString strExpanded;
+  for (int i = 0; i < nBlocks; i++)
+    {
+      int nCharPos = pBuf[i].m_nCharPos;
+      int nCount = (i < nBlocks - 1 ? pBuf[i + 1].m_nCharPos : nLength) - nCharPos;
+      ExpandChars (pszChars, nCharPos, nCount, strExpanded, 0);
+
+      int nColorIndex = pBuf[i].m_nColorIndex;
+      int nBgColorIndex = pBuf[i].m_nBgColorIndex;
+      HTMLBLOCK block;
+      block.m_nCharPos = strText.GetLength ();
+      block.m_nColorIndex = (crText == CLR_NONE || (nColorIndex & COLORINDEX_APPLYFORCE)) ? (nColorIndex & ~COLORINDEX_APPLYFORCE) : -1;
+      block.m_nBgColorIndex = (crBkgnd == CLR_NONE || (nBgColorIndex & COLORINDEX_APPLYFORCE)) ? (nBgColorIndex & ~COLORINDEX_APPLYFORCE) : -1;
+      block.m_clrText = (block.m_nColorIndex >= 0) ? GetColor (nColorIndex) : crText;
+      block.m_clrBkgnd = (block.m_nBgColorIndex >= 0) ? GetColor (nBgColorIndex) : crBkgnd;
+      block.m_bBold = GetBold (nColorIndex);
+      block.m_bItalic = GetItalic (nColorIndex);
+      blocks.push_back (block);
+      strText += strExpanded;
+    }
+}
+
 COLORREF CCrystalTextView::
 GetColor (int nColorIndex)
 {
@@ -4334,6 +4345,9 @@ UpdateView (CCrystalTextView * pSource, CUpdateContext * pContext,
   if ((dwFlags & UPDATE_SINGLELINE) != 0)
     {
       ASSERT (nLineIndex != -1);
+      //  Text blocks of the line must be rebuilt, the lines below are
+      //  rebuilt when their parse cookies change
+      m_pTextBlockCache->Invalidate (nLineIndex, nLineIndex);
       //  All text below this line should be reparsed
       const int cookiesSize = (int) m_ParseCookies->size();
       if (cookiesSize > 0)
@@ -5468,12 +5482,9 @@ OnClearAllBookmarks ()
 {
   if (m_pTextBuffer != NULL)
     {
-      int nLineCount = GetLineCount ();
-      for (int I = 0; I < nLineCount; I++)
-        {
-          if (m_pTextBuffer->GetLineFlags (I) & LF_BOOKMARKS)
-            m_pTextBuffer->SetLineFlag (I, LF_BOOKMARKS, false);
-        }
+      int nLine;
+      while ((nLine = m_pTextBuffer->GetLineWithFlag (LF_BOOKMARKS)) >= 0)
+        m_pTextBuffer->SetLineFlag (nLine, LF_BOOKMARKS, false, false);
       m_bBookmarkExist = false;
     }
 }
@@ -41,6 +41,7 @@
 #include <vector>
 #include "cregexp.h"
 #include "crystalparser.h"
+#include "TextBlockCache.h"
 
 ////////////////////////////////////////////////////////////////////////////
 // Forward class declarations
@@ -173,6 +174,13 @@ private:
     */
     std::vector<int> *m_pnActualLineLength;
 
+    /**
+    Parsed and merged text blocks of recently drawn lines.
+    Entries are keyed by the parse cookie of the line above, so lines below
+    an edit whose parse cookies change are not reused.
+    */
+    TextBlockCache *m_pTextBlockCache;
+
 protected:
     bool m_bPreparingToDrag;
     bool m_bDraggingText;
@@ -450,6 +458,7 @@ protected:
     //  Clipboard overridable
     virtual bool TextInClipboard ();
     virtual bool PutToClipboard (LPCTSTR pszText, int cchText, bool bColumnSelection = false);
+    bool PutDataToClipboard (HGLOBAL hData, SIZE_T cbData, bool bColumnSelection = false);
     virtual bool GetFromClipboard (CString & text, bool & bColumnSelection);
 
     //  Drag-n-drop overrideable
@@ -559,12 +568,7 @@ protected:
 	//END SW
 
     //  Syntax coloring overrides
-    struct TEXTBLOCK
-      {
-        int m_nCharPos;
-        int m_nColorIndex;
-		int m_nBgColorIndex;
-      };
+    typedef TextBlockCache::TEXTBLOCK TEXTBLOCK;
 
     virtual HINSTANCE GetResourceHandle ();
 
@@ -572,7 +576,7 @@ protected:
 	// function to draw a single screen line
 	// (a wrapped line can consist of many screen lines
 	virtual void DrawScreenLine( CDC *pdc, CPoint &ptOrigin, const CRect &rcClip,
-		TEXTBLOCK *pBuf, int nBlocks, int &nActualItem,
+		const TEXTBLOCK *pBuf, int nBlocks, int &nActualItem,
 		COLORREF crText, COLORREF crBkgnd, bool bDrawWhitespace,
 		LPCTSTR pszChars,
 		int nOffset, int nCount, int &nActualOffset, CPoint ptTextPos );
@@ -580,9 +584,24 @@ protected:
 
 	int MergeTextBlocks(TEXTBLOCK *pBuf1, int nBlocks1, TEXTBLOCK *pBuf2, int nBlocks2, TEXTBLOCK *&pBufMerged);
 	virtual int GetAdditionalTextBlocks (int nLineIndex, TEXTBLOCK *&pBuf);
+	virtual DWORD GetAdditionalTextBlocksStamp (int nLineIndex);
+	const TEXTBLOCK *GetTextBlocks (int nLineIndex, int &nBlocks);
 
 public:
+    /** @brief Part of an expanded line in one color, with colors resolved */
+    struct HTMLBLOCK
+      {
+        int m_nCharPos;
+        COLORREF m_clrText;
+        COLORREF m_clrBkgnd;
+        int m_nColorIndex; /**< Syntax color index of the text, -1 if line color */
+        int m_nBgColorIndex; /**< Syntax color index of the background, -1 if line color */
+        bool m_bBold;
+        bool m_bItalic;
+      };
+
 	virtual CString GetHTMLLine (int nLineIndex, LPCTSTR pszTag);
+	virtual void GetHTMLLineBlocks (int nLineIndex, CString &strText, std::vector<HTMLBLOCK> &blocks, HTMLBLOCK &lineBlock);
 	virtual CString GetHTMLStyles ();
 protected:
     virtual CString GetHTMLAttribute (int nColorIndex, int nBgColorIndex, COLORREF crText, COLORREF crBkgnd);
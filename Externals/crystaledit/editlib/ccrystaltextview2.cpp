@@ -1141,33 +1141,60 @@ PutToClipboard (LPCTSTR pszText, int cchText, bool bColumnSelection)
   if (pszText == NULL || cchText == 0)
     return false;
 
+  SIZE_T cbData = (cchText + 1) * sizeof(TCHAR);
+  HGLOBAL hData = GlobalAlloc (GMEM_MOVEABLE | GMEM_DDESHARE, cbData);
+  if (hData == NULL)
+    return false;
+  SIZE_T dwSize = GlobalSize(hData);
+  LPTSTR pszData = (LPTSTR)::GlobalLock (hData);
+  memcpy (pszData, pszText, cbData);
+  if (dwSize > cbData)
+      memset(reinterpret_cast<char *>(pszData) + cbData, 0, dwSize - cbData);
+  GlobalUnlock (hData);
+  return PutDataToClipboard (hData, cbData, bColumnSelection);
+}
+
+/**
+ * @brief Put zero-terminated text in global memory to the clipboard.
+ * The text is given to the clipboard as is, so callers can gather a large
+ * selection straight into the clipboard memory without a temporary copy.
+ * @param [in] hData Text in the clipboard text format, owned by the clipboard
+ * afterwards.
+ * @param [in] cbData Size of the text in bytes, including the terminating zero.
+ * @param [in] bColumnSelection Is the text a column selection?
+ * @return true if the text was put to the clipboard.
+ */
+bool CCrystalTextView::
+PutDataToClipboard (HGLOBAL hData, SIZE_T cbData, bool bColumnSelection)
+{
+  if (hData == NULL)
+    return false;
+  if (cbData <= sizeof(TCHAR))
+    {
+      GlobalFree (hData);
+      return false;
+    }
+
   CWaitCursor wc;
   bool bOK = false;
+  // the handle belongs to the clipboard once set, so get its size before
+  const bool bExactSize = GlobalSize (hData) == cbData;
   if (OpenClipboard ())
     {
       EmptyClipboard ();
-      SIZE_T cbData = (cchText + 1) * sizeof(TCHAR);
-      HGLOBAL hData = GlobalAlloc (GMEM_MOVEABLE | GMEM_DDESHARE, cbData);
-      if (hData != NULL)
+      UINT fmt = GetClipTcharTextFormat();
+      bOK = SetClipboardData (fmt, hData) != NULL;
+      if (bOK)
         {
-          SIZE_T dwSize = GlobalSize(hData);
-          LPTSTR pszData = (LPTSTR)::GlobalLock (hData);
-          memcpy (pszData, pszText, cbData);
-          if (dwSize > cbData)
-              memset(reinterpret_cast<char *>(pszData) + cbData, 0, dwSize - cbData);
-          GlobalUnlock (hData);
-          UINT fmt = GetClipTcharTextFormat();
-          bOK = SetClipboardData (fmt, hData) != NULL;
-          if (bOK)
-            {
-              if (bColumnSelection)
-                SetClipboardData (RegisterClipboardFormat (_T("MSDEVColumnSelect")), NULL);
-              if (dwSize == cbData)
-                SetClipboardData (RegisterClipboardFormat (_T("WinMergeClipboard")), NULL);
-            }
+          if (bColumnSelection)
+            SetClipboardData (RegisterClipboardFormat (_T("MSDEVColumnSelect")), NULL);
+          if (bExactSize)
+            SetClipboardData (RegisterClipboardFormat (_T("WinMergeClipboard")), NULL);
         }
       CloseClipboard ();
     }
+  if (!bOK)
+    GlobalFree (hData);
   return bOK;
 }
 
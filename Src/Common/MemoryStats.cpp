@@ -0,0 +1,129 @@
+/**
+ * @file  MemoryStats.cpp
+ *
+ * @brief Implementation of memory accounting for the big compare data structures.
+ */
+
+#include "MemoryStats.h"
+#include <atomic>
+#include <cassert>
+
+namespace MemoryStats
+{
+
+namespace
+{
+
+/** @brief Counters of one subsystem. */
+struct Counters
+{
+	std::atomic<long long> current; /**< Bytes allocated now */
+	std::atomic<long long> peak; /**< Highest current value since last reset */
+};
+
+Counters counters[SUBSYSTEM_COUNT];
+
+const TCHAR *const names[SUBSYSTEM_COUNT] =
+{
+	_T("DIFFITEM tree"),
+	_T("File names"),
+	_T("diffutils line tables"),
+	_T("Text buffer lines"),
+	_T("Undo buffers"),
+	_T("Word diff cache"),
+};
+
+}
+
+/**
+ * @brief Count bytes allocated by a subsystem.
+ * @param [in] subsystem Subsystem allocating the memory.
+ * @param [in] bytes Number of bytes allocated.
+ */
+void Allocated(Subsystem subsystem, size_t bytes)
+{
+	assert(subsystem >= 0 && subsystem < SUBSYSTEM_COUNT);
+	Counters& c = counters[subsystem];
+	long long current = c.current += static_cast<long long>(bytes);
+	long long peak = c.peak;
+	while (current > peak && !c.peak.compare_exchange_weak(peak, current))
+		;
+}
+
+/**
+ * @brief Count bytes freed by a subsystem.
+ * @param [in] subsystem Subsystem freeing the memory.
+ * @param [in] bytes Number of bytes freed.
+ */
+void Freed(Subsystem subsystem, size_t bytes)
+{
+	assert(subsystem >= 0 && subsystem < SUBSYSTEM_COUNT);
+	counters[subsystem].current -= static_cast<long long>(bytes);
+}
+
+/**
+ * @brief Return number of bytes a subsystem has allocated now.
+ */
+long long GetCurrent(Subsystem subsystem)
+{
+	return counters[subsystem].current;
+}
+
+/**
+ * @brief Return highest number of bytes a subsystem has had allocated
+ * since last call of ResetPeaks().
+ */
+long long GetPeak(Subsystem subsystem)
+{
+	return counters[subsystem].peak;
+}
+
+/**
+ * @brief Start tracking the peaks from current values.
+ */
+void ResetPeaks()
+{
+	for (int i = 0; i < SUBSYSTEM_COUNT; ++i)
+		counters[i].peak = counters[i].current.load();
+}
+
+/**
+ * @brief Return name of a subsystem for the dump.
+ */
+const TCHAR *GetName(Subsystem subsystem)
+{
+	return names[subsystem];
+}
+
+/**
+ * @brief Format a row of the text table, columns padded to fixed widths.
+ */
+static String FormatRow(const String& name, const String& current, const String& peak)
+{
+	String row = name;
+	row.resize(24, ' ');
+	row += String(current.length() < 16 ? 16 - current.length() : 0, ' ') + current;
+	row += String(peak.length() < 16 ? 16 - peak.length() : 0, ' ') + peak;
+	return row + _T("\r\n");
+}
+
+/**
+ * @brief Format current and peak bytes of all subsystems as a text table.
+ */
+String ToString()
+{
+	String text = FormatRow(_T("Subsystem"), _T("Current bytes"), _T("Peak bytes"));
+	long long totalCurrent = 0;
+	long long totalPeak = 0;
+	for (int i = 0; i < SUBSYSTEM_COUNT; ++i)
+	{
+		Subsystem subsystem = static_cast<Subsystem>(i);
+		text += FormatRow(GetName(subsystem), string_to_str(GetCurrent(subsystem)), string_to_str(GetPeak(subsystem)));
+		totalCurrent += GetCurrent(subsystem);
+		totalPeak += GetPeak(subsystem);
+	}
+	text += FormatRow(_T("Total"), string_to_str(totalCurrent), string_to_str(totalPeak));
+	return text;
+}
+
+}
@@ -0,0 +1,87 @@
+/**
+ * @file  MemoryStats.h
+ *
+ * @brief Declaration of memory accounting for the big compare data structures.
+ */
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "UnicodeString.h"
+
+/**
+ * @brief Bytes allocated by the data structures growing with the compared data.
+ *
+ * Each subsystem reports the bytes it allocates and frees, either explicitly
+ * or by using MemoryStats::Allocator for its containers. The counters are
+ * process wide and updated atomically, so they can be read while compare
+ * threads run. The peak is the highest current value since ResetPeaks().
+ */
+namespace MemoryStats
+{
+
+enum Subsystem
+{
+	DIFFITEMS,        /**< DIFFITEM tree of the folder compare */
+	FILENAMES,        /**< Flyweight file and folder names */
+	DIFFUTILS_LINES,  /**< diffutils line tables and equivalence classes */
+	TEXTBUFFER_LINES, /**< Line data of the text buffers */
+	UNDO_BUFFERS,     /**< Undo records of the text buffers */
+	WORDDIFF_CACHE,   /**< Cached word differences of the file compare */
+	SUBSYSTEM_COUNT
+};
+
+void Allocated(Subsystem subsystem, size_t bytes);
+void Freed(Subsystem subsystem, size_t bytes);
+long long GetCurrent(Subsystem subsystem);
+long long GetPeak(Subsystem subsystem);
+void ResetPeaks();
+const TCHAR *GetName(Subsystem subsystem);
+String ToString();
+
+/**
+ * @brief Standard allocator counting the allocated bytes to a subsystem.
+ */
+template <class T, Subsystem subsystem>
+class Allocator
+{
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <class U> struct rebind { typedef Allocator<U, subsystem> other; };
+
+	Allocator() {}
+	template <class U> Allocator(const Allocator<U, subsystem>&) {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+	size_type max_size() const { return static_cast<size_type>(-1) / sizeof(T); }
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		pointer p = static_cast<pointer>(::operator new(n * sizeof(T)));
+		Allocated(subsystem, n * sizeof(T));
+		return p;
+	}
+
+	void deallocate(pointer p, size_type n)
+	{
+		::operator delete(p);
+		Freed(subsystem, n * sizeof(T));
+	}
+
+	template <class U, class... Args> void construct(U *p, Args&&... args) { ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...); }
+	template <class U> void destroy(U *p) { p->~U(); }
+
+	template <class U> bool operator==(const Allocator<U, subsystem>&) const { return true; }
+	template <class U> bool operator!=(const Allocator<U, subsystem>&) const { return false; }
+};
+
+}
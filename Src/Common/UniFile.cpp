@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include <cassert>
 #include <memory>
 #include <cstdint>
+#include <cstring>
 #include <Poco/SharedMemory.h>
 #include <Poco/Exception.h>
 #include "UnicodeString.h"
@@ -425,6 +426,34 @@ static void RecordZero(UniFile::txtstats & txstats, int64_t offset)
 	++txstats.nzeros;
 }
 
+/**
+ * @brief Find the first CR, LF or zero byte.
+ * The bytes are checked a machine word at a time, as most bytes of a text
+ * line are none of them.
+ * @param [in] p First byte to check.
+ * @param [in] end End of bytes to check.
+ * @return Pointer to the byte found, or @p end if there is none.
+ */
+static unsigned char *FindEolOrZero(unsigned char *p, unsigned char *end)
+{
+	const size_t ones = ~static_cast<size_t>(0) / 0xFF;
+	const size_t highs = ones * 0x80;
+	while (static_cast<size_t>(end - p) >= sizeof(size_t))
+	{
+		size_t w;
+		memcpy(&w, p, sizeof(w));
+		const size_t cr = w ^ (ones * '\r');
+		const size_t lf = w ^ (ones * '\n');
+		// Some byte of x is zero if (x - ones) & ~x has the high bit of that byte set
+		if ((((w - ones) & ~w) | ((cr - ones) & ~cr) | ((lf - ones) & ~lf)) & highs)
+			break;
+		p += sizeof(w);
+	}
+	while (p < end && *p != '\r' && *p != '\n' && *p != 0)
+		++p;
+	return p;
+}
+
 /**
  * @brief Read one (DOS or UNIX or Mac) line.
  * @param [out] line Line read.
@@ -541,19 +570,19 @@ bool UniMemFile::ReadString(String & line, String & eol, bool * lossy)
 	if (m_unicoding == ucr::NONE)
 	{
 		bool eof = true;
-		unsigned char *eolptr = 0;
-		for (eolptr = m_current; (eolptr - m_base + (m_charsize - 1) < m_filesize); ++eolptr)
+		unsigned char *end = m_base + m_filesize - (m_charsize - 1);
+		unsigned char *eolptr = m_current;
+		// Zeros are counted while looking for the EOL
+		while ((eolptr = FindEolOrZero(eolptr, end)) < end)
 		{
 			if (*eolptr == '\n' || *eolptr == '\r')
 			{
 				eof = false;
 				break;
 			}
-			if (*eolptr == 0)
-			{
-				int64_t offset = (eolptr - m_base);
-				RecordZero(m_txtstats, offset);
-			}
+			int64_t offset = (eolptr - m_base);
+			RecordZero(m_txtstats, offset);
+			++eolptr;
 		}
 		bool success = ucr::maketstring(line, (const char *)m_current, eolptr-m_current, m_codepage, lossy);
 		if (!success)
@@ -165,6 +165,26 @@ ByteComparator::COMP_RESULT ByteComparator::CompareBuffers(
 	const char *orig0 = ptr0;
 	const char *orig1 = ptr1;
 
+	if (m_ignore_eol_diff && !m_ignore_blank_lines)
+	{
+		// Finish CR/LF pairs split by the end of the last buffers before
+		// skipping whitespace, otherwise the LF is taken for an end of line
+		// and the whitespace starting the next line on the other side
+		// is skipped as trailing whitespace
+		if (m_cr0 && ptr0 < end0)
+		{
+			if (*ptr0 == '\n')
+				++ptr0;
+			m_cr0 = false;
+		}
+		if (m_cr1 && ptr1 < end1)
+		{
+			if (*ptr1 == '\n')
+				++ptr1;
+			m_cr1 = false;
+		}
+	}
+
 	// cycle through buffer data performing actual comparison
 	while (true)
 	{
@@ -325,6 +345,12 @@ ByteComparator::COMP_RESULT ByteComparator::CompareBuffers(
 			}
 			else // don't skip blank lines, but still ignore eol difference
 			{
+				if ((ptr0 == end0 && !eof0) || (ptr1 == end1 && !eof1))
+				{
+					// Cannot tell if both sides have an end-of-line here,
+					// don't skip the end-of-line on the other side yet
+					goto need_more;
+				}
 				HandleSide0Eol((char **) &ptr0, end0, eof0);
 				HandleSide1Eol((char **) &ptr1, end1, eof1);
 
@@ -446,17 +472,6 @@ need_more:
 inline void ByteComparator::HandleSide0Eol(char **ptr, const char *end, bool eof)
 {
 	char * pbuf = *ptr;
-	if (m_cr0)
-	{
-		// finish split CR/LF pair on 0-side
-		if (pbuf < end && *pbuf == '\n')
-		{
-			// m_bol0 not used because m_ignore_eol_diff
-			++pbuf;
-		}
-		m_eol0 = true;
-		m_cr0 = false;
-	}
 	if (pbuf < end)
 	{
 		if (*pbuf == '\n')
@@ -499,17 +514,6 @@ inline void ByteComparator::HandleSide1Eol(char **ptr, const char *end, bool eof
 {
 	char * pbuf = *ptr;
 
-	if (m_cr1)
-	{
-		// finish split CR/LF pair on 1-side
-		if (pbuf < end && *pbuf == '\n')
-		{
-			// m_bol1 not used because m_ignore_eol_diff
-			++pbuf;
-		}
-		m_eol1 = true;
-		m_cr1 = false;
-	}
 	if (pbuf < end)
 	{
 		if (*pbuf == '\n')
@@ -36,6 +36,7 @@ static void CopyTextStats(const FileTextStats * stats, FileTextStats * myTextSta
  */
 ByteCompare::ByteCompare()
 		: m_pOptions(nullptr)
+		, m_bStopAfterFirstDiff(false)
 		, m_piAbortable(nullptr)
 		, m_inf(nullptr)
 {
@@ -55,9 +56,20 @@ ByteCompare::~ByteCompare()
  */
 bool ByteCompare::SetCompareOptions(const CompareOptions & options)
 {
-	m_pOptions.reset(new QuickCompareOptions(options));
-	if (m_pOptions.get() == NULL)
+	return SetCompareOptions(std::make_shared<const QuickCompareOptions>(options));
+}
+
+/**
+ * @brief Set compare options shared with other engines.
+ * @param [in] options Compare options, which must not change while in use.
+ * @return true if succeeded, false otherwise.
+ */
+bool ByteCompare::SetCompareOptions(const std::shared_ptr<const QuickCompareOptions> & options)
+{
+	if (!options)
 		return false;
+	if (options != m_pOptions)
+		m_pOptions = options;
 	return true;
 }
 
@@ -67,7 +79,7 @@ bool ByteCompare::SetCompareOptions(const CompareOptions & options)
  */
 void ByteCompare::SetAdditionalOptions(bool stopAfterFirstDiff)
 {
-	m_pOptions->m_bStopAfterFirstDiff = stopAfterFirstDiff;
+	m_bStopAfterFirstDiff = stopAfterFirstDiff;
 }
 
 /**
@@ -183,7 +195,7 @@ int ByteCompare::CompareFiles(FileLocation *location)
 				ptr0, ptr1, end0, end1, eof[0], eof[1], offset0, offset1);
 		if (result == ByteComparator::RESULT_DIFF)
 		{
-			if (m_pOptions->m_bStopAfterFirstDiff)
+			if (m_bStopAfterFirstDiff)
 			{
 				// By bailing out here
 				// we leave our text statistics incomplete
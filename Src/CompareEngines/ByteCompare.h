@@ -29,6 +29,7 @@ public:
 	~ByteCompare();
 
 	bool SetCompareOptions(const CompareOptions & options);
+	bool SetCompareOptions(const std::shared_ptr<const QuickCompareOptions> & options);
 	void SetAdditionalOptions(bool stopAfterFirstDiff);
 	void SetAbortable(const IAbortable * piAbortable);
 	void SetFileData(int items, file_data *data);
@@ -36,7 +37,8 @@ public:
 	void GetTextStats(int side, FileTextStats *stats) const;
 
 private:
-	std::unique_ptr<QuickCompareOptions> m_pOptions; /**< Compare options for diffutils. */
+	std::shared_ptr<const QuickCompareOptions> m_pOptions; /**< Compare options for diffutils. */
+	bool m_bStopAfterFirstDiff; /**< Optimize compare by stopping after first difference? */
 	IAbortable * m_piAbortable;
 	file_data * m_inf; /**< Compared files data (for diffutils). */
 	FileTextStats m_textStats[2];
@@ -36,6 +36,8 @@ DiffUtils::DiffUtils()
 		, m_ndiffs(0)
 		, m_ntrivialdiffs(0)
 		, m_codepage(0)
+		, m_bStopAfterFirstDiff(false)
+		, m_pFilterCommentsManager(nullptr)
 {
 }
 
@@ -54,11 +56,36 @@ DiffUtils::~DiffUtils()
  */
 bool DiffUtils::SetCompareOptions(const CompareOptions & options)
 {
-	m_pOptions.reset(new DiffutilsOptions((DiffutilsOptions&)options));
-	if (m_pOptions.get() == NULL)
+	return SetCompareOptions(std::make_shared<const DiffutilsOptions>((const DiffutilsOptions&)options));
+}
+
+/**
+ * @brief Set compare options shared with other engines.
+ * The options are not copied, and they are set to diffutils only when they
+ * are not the options this engine already set. So an engine comparing many
+ * files with the same options does the setup once. Diffutils options are
+ * per thread, so the engine must stay in one thread between compares.
+ * @param [in] options Compare options, which must not change while in use.
+ * @return true if succeeded, false otherwise.
+ */
+bool DiffUtils::SetCompareOptions(const std::shared_ptr<const DiffutilsOptions> & options)
+{
+	if (!options)
 		return false;
+	if (options == m_pOptions)
+		return true;
+	m_pOptions = options;
 
 	m_pOptions->SetToDiffUtils();
+
+	// Options used by the comment filter, set once here instead of for every diff block
+	DIFFOPTIONS diffoptions = {0};
+	diffoptions.nIgnoreWhitespace = m_pOptions->m_ignoreWhitespace;
+	diffoptions.bIgnoreBlankLines = m_pOptions->m_bIgnoreBlankLines;
+	diffoptions.bFilterCommentsLines = m_pOptions->m_filterCommentsLines;
+	diffoptions.bIgnoreCase = m_pOptions->m_bIgnoreCase;
+	diffoptions.bIgnoreEol = m_pOptions->m_bIgnoreEOLDifference;
+	m_pDiffWrapper->SetOptions(&diffoptions);
 	return true;
 }
 
@@ -80,8 +107,18 @@ void DiffUtils::SetFilterList(FilterList * list)
 	m_pFilterList = list;
 }
 
+/**
+ * @brief Set compare-type specific options.
+ * @param [in] stopAfterFirstDiff Do we stop compare after first found diff.
+ */
+void DiffUtils::SetAdditionalOptions(bool stopAfterFirstDiff)
+{
+	m_bStopAfterFirstDiff = stopAfterFirstDiff;
+}
+
 void DiffUtils::SetFilterCommentsManager(const FilterCommentsManager *pFilterCommentsManager)
 {
+	m_pFilterCommentsManager = pFilterCommentsManager;
 	m_pDiffWrapper->SetFilterCommentsManager(pFilterCommentsManager);
 }
 
@@ -106,9 +143,29 @@ int DiffUtils::diffutils_compare_files()
 	int bin_flag = 0;
 	int bin_file = 0; // bitmap for binary files
 
+	// Comment markers are looked up once for the file
+	const FilterCommentsSet *pFilterCommentsSet = NULL;
+	if (m_pOptions->m_filterCommentsLines && m_pFilterCommentsManager)
+	{
+		String LowerCaseExt = ucr::toTString(m_inf[0].name);
+		size_t PosOfDot = LowerCaseExt.rfind('.');
+		if (PosOfDot != String::npos)
+		{
+			LowerCaseExt.erase(0, PosOfDot + 1);
+			std::transform(LowerCaseExt.begin(), LowerCaseExt.end(), LowerCaseExt.begin(), ::tolower);
+			pFilterCommentsSet = m_pFilterCommentsManager->GetSetForFileType(LowerCaseExt);
+		}
+	}
+	const bool bRegExps = m_pFilterList && m_pFilterList->HasRegExps();
+
+	// When only the status is needed and no filter can turn a change into
+	// an ignored one, diffutils stops at the first differing line.
+	stop_after_first_change = m_bStopAfterFirstDiff && !pFilterCommentsSet && !bRegExps;
+
 	// Do the actual comparison (generating a change script)
 	struct change *script = NULL;
 	bool success = Diff2Files(&script, 0, &bin_flag, false, &bin_file);
+	stop_after_first_change = 0;
 	if (!success)
 	{
 		return DIFFCODE::FILE | DIFFCODE::TEXT | DIFFCODE::CMPERR;
@@ -119,21 +176,12 @@ int DiffUtils::diffutils_compare_files()
 	// (usually it is -1 at this point, for unknown)
 	m_ndiffs = 0;
 	m_ntrivialdiffs = 0;
+	bool bStopped = false;
 
 	if (script)
 	{
 		struct change *next = script;
 
-		String asLwrCaseExt;
-		String LowerCaseExt = ucr::toTString(m_inf[0].name);
-		size_t PosOfDot = LowerCaseExt.rfind('.');
-		if (PosOfDot != String::npos)
-		{
-			LowerCaseExt.erase(0, PosOfDot + 1);
-			std::transform(LowerCaseExt.begin(), LowerCaseExt.end(), LowerCaseExt.begin(), ::tolower);
-			asLwrCaseExt = LowerCaseExt;
-		}
-
 		while (next)
 		{
 			/* Find a set of changes that belong together.  */
@@ -163,7 +211,7 @@ int DiffUtils::diffutils_compare_files()
 					int QtyLinesLeft = (trans_b0 - trans_a0);
 					int QtyLinesRight = (trans_b1 - trans_a1);
 
-					if(m_pOptions->m_filterCommentsLines)
+					if(pFilterCommentsSet)
 					{
 						OP_TYPE op = OP_NONE;
 						if (!deletes && !inserts)
@@ -171,14 +219,7 @@ int DiffUtils::diffutils_compare_files()
 						else
 							op = OP_DIFF;
 
-						DIFFOPTIONS options = {0};
-						options.nIgnoreWhitespace = m_pOptions->m_ignoreWhitespace;
-						options.bIgnoreBlankLines = m_pOptions->m_bIgnoreBlankLines;
-						options.bFilterCommentsLines = m_pOptions->m_filterCommentsLines;
-						options.bIgnoreCase = m_pOptions->m_bIgnoreCase;
-						options.bIgnoreEol = m_pOptions->m_bIgnoreEOLDifference;
-						m_pDiffWrapper->SetOptions(&options);
-  						m_pDiffWrapper->PostFilter(thisob->line0, QtyLinesLeft+1, thisob->line1, QtyLinesRight+1, op, asLwrCaseExt);
+						m_pDiffWrapper->PostFilter(thisob->line0, QtyLinesLeft+1, thisob->line1, QtyLinesRight+1, op, *pFilterCommentsSet);
 						if(op == OP_TRIVIAL)
 						{
 							thisob->trivial = 1;
@@ -188,7 +229,7 @@ int DiffUtils::diffutils_compare_files()
 					// Match lines against regular expression filters
 					// Our strategy is that every line in both sides must
 					// match regexp before we mark difference as ignored.
-					if(m_pFilterList && m_pFilterList->HasRegExps())
+					if(bRegExps)
 					{
 						bool match2 = false;
 						bool match1 = RegExpFilter(thisob->line0, thisob->line0 + QtyLinesLeft, 0);
@@ -201,6 +242,13 @@ int DiffUtils::diffutils_compare_files()
 				}
 				/* Reconnect the script so it will all be freed properly.  */
 				end->link = next;
+
+				// The files differ, the rest of the hunks don't matter
+				if (m_bStopAfterFirstDiff && !thisob->trivial)
+				{
+					bStopped = true;
+					break;
+				}
 			}
 		}
 	}
@@ -223,6 +271,13 @@ int DiffUtils::diffutils_compare_files()
 			code = code & ~DIFFCODE::SAME | DIFFCODE::DIFF;
 	}
 
+	// Only the first difference was looked for, counts are not known
+	if (bStopped)
+	{
+		m_ndiffs = CDiffContext::DIFFS_UNKNOWN_QUICKCOMPARE;
+		m_ntrivialdiffs = CDiffContext::DIFFS_UNKNOWN_QUICKCOMPARE;
+	}
+
 	// diff_2_files set bin_flag to -1 if different binary
 	// diff_2_files set bin_flag to +1 if same binary
 
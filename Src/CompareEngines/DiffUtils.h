@@ -24,7 +24,8 @@ namespace CompareEngines
  * This class needs to have all its data as local copies, not as pointers
  * outside. Lifetime can vary certainly be different from unrelated classes.
  * Filters list being an exception - pcre structs are too complex to easily
- * copy so we'll only keep a pointer to external list.
+ * copy so we'll only keep a pointer to external list. Compare options are
+ * immutable and shared, the engine holds a reference keeping them alive.
  */
 class DiffUtils
 {
@@ -32,6 +33,7 @@ public:
 	DiffUtils();
 	~DiffUtils();
 	bool SetCompareOptions(const CompareOptions & options);
+	bool SetCompareOptions(const std::shared_ptr<const DiffutilsOptions> & options);
 	void SetFilterList(FilterList * list);
 	void SetFilterCommentsManager(const FilterCommentsManager *pFilterCommentsManager);
 	void ClearFilterList();
@@ -43,15 +45,18 @@ public:
 	bool Diff2Files(struct change ** diffs, int depth,
 			int * bin_status, bool bMovedBlocks, int * bin_file) const;
 	void SetCodepage(int codepage) { m_codepage = codepage; }
+	void SetAdditionalOptions(bool stopAfterFirstDiff);
 
 private:
-	std::unique_ptr<DiffutilsOptions> m_pOptions; /**< Compare options for diffutils. */
+	std::shared_ptr<const DiffutilsOptions> m_pOptions; /**< Compare options for diffutils. */
 	FilterList * m_pFilterList; /**< Filter list for line filters. */
 	file_data * m_inf; /**< Compared files data (for diffutils). */
 	int m_ndiffs; /**< Real diffs found. */
 	int m_ntrivialdiffs; /**< Ignored diffs found. */
 	int m_codepage; /**< Codepage used in line filter */
+	bool m_bStopAfterFirstDiff; /**< Only find whether the files differ */
 	std::unique_ptr<CDiffWrapper> m_pDiffWrapper;
+	const FilterCommentsManager * m_pFilterCommentsManager; /**< Shared comment marker sets. */
 };
 
 
@@ -0,0 +1,242 @@
+/**
+ * @file  TextPrecheck.cpp
+ *
+ * @brief Implementation file for TextPrecheck
+ */
+
+#include "TextPrecheck.h"
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#include "diff.h"
+
+namespace CompareEngines
+{
+
+/**
+ * @brief Default constructor.
+ */
+TextPrecheck::TextPrecheck()
+: m_bFailed(false)
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		m_desc[i] = -1;
+		m_begin[i] = m_end[i] = m_size[i] = 0;
+		m_eof[i] = false;
+	}
+}
+
+/**
+ * @brief Check if two opened files are the same with current diffutils options.
+ * Files are read from their current position, which is set back to the
+ * begin of the files afterwards for diffutils.
+ * @param [in] data File data of the files, having open descriptors.
+ * @return true if the files are the same, false if they differ or the
+ * check cannot tell.
+ */
+bool TextPrecheck::CompareFiles(file_data *data)
+{
+	// A file compared to itself is a unique item, its text stats are
+	// read by diffutils
+	if (data[0].desc == data[1].desc)
+		return false;
+
+	m_desc[0] = data[0].desc;
+	m_desc[1] = data[1].desc;
+	bool bSame = CompareLines();
+	for (int i = 0; i < 2; ++i)
+		lseek(m_desc[i], 0, SEEK_SET);
+	return bSame;
+}
+
+/**
+ * @brief Compare the files line by line until the first differing line.
+ */
+bool TextPrecheck::CompareLines()
+{
+	m_bFailed = false;
+	for (int i = 0; i < 2; ++i)
+	{
+		if (!Start(i))
+			return false;
+	}
+
+	while (true)
+	{
+		const char *line0 = NULL, *line1 = NULL;
+		size_t length0 = 0, length1 = 0;
+		bool bLine0 = NextLine(0, line0, length0);
+		bool bLine1 = NextLine(1, line1, length1);
+		if (!bLine0 || !bLine1)
+		{
+			// Files are the same only if both of them were read to the end
+			return !bLine0 && !bLine1 && !m_bFailed;
+		}
+		if (!lines_equivalent(line0, length0, line1, length1))
+			return false;
+	}
+}
+
+/**
+ * @brief Read the first buffer of a file and skip its UTF-8 BOM.
+ * @return false if the file is encoded in UCS-2 or UCS-4, or cannot be read.
+ */
+bool TextPrecheck::Start(int side)
+{
+	m_begin[side] = m_end[side] = m_size[side] = 0;
+	m_eof[side] = false;
+	m_textStats[side].clear();
+	if (!Read(side))
+		return false;
+
+	// The BOMs recognized by diffutils
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(&m_buff[side][0]);
+	size_t size = m_end[side];
+	if (size >= 2 && ((p[0] == 0xFF && p[1] == 0xFE) || (p[0] == 0xFE && p[1] == 0xFF)))
+		return false;
+	if (size >= 4 && p[0] == 0 && p[1] == 0 && p[2] == 0xFE && p[3] == 0xFF)
+		return false;
+	if (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+		m_begin[side] = 3;
+	return true;
+}
+
+/**
+ * @brief Read more data of a file after the unread lines.
+ * The read data is scanned for text stats, and EOLs are mapped like diffutils
+ * maps them. A CR at the end of the read data is scanned on the next read,
+ * as it may be the first byte of a CR/LF pair. A newline follows the data
+ * when the whole file has been read.
+ * @return false if the file is binary or cannot be read.
+ */
+bool TextPrecheck::Read(int side)
+{
+	std::vector<char>& buff = m_buff[side];
+
+	// Move the unread lines to the begin of the buffer
+	size_t nKeep = m_size[side] - m_begin[side];
+	if (nKeep > 0 && m_begin[side] > 0)
+		memmove(&buff[0], &buff[m_begin[side]], nKeep);
+	m_end[side] -= m_begin[side];
+	m_size[side] = nKeep;
+	m_begin[side] = 0;
+	if (buff.size() < nKeep + BufferSize + 1)
+		buff.resize(nKeep + BufferSize + 1);
+
+	int rtn = read(m_desc[side], &buff[m_size[side]], BufferSize);
+	if (rtn == -1)
+	{
+		m_bFailed = true;
+		return false;
+	}
+	if (rtn == 0)
+		m_eof[side] = true;
+	m_size[side] += rtn;
+
+	FileTextStats& stats = m_textStats[side];
+	size_t r = m_end[side], w = m_end[side];
+	const size_t size = m_size[side];
+	while (r < size)
+	{
+		char c = buff[r];
+		if (c == '\r')
+		{
+			if (r + 1 == size && !m_eof[side])
+				break;
+			if (r + 1 < size && buff[r + 1] == '\n')
+			{
+				++stats.ncrlfs;
+				if (!ignore_eol_diff)
+					buff[w++] = '\r';
+				buff[w++] = '\n';
+				r += 2;
+			}
+			else
+			{
+				++stats.ncrs;
+				buff[w++] = ignore_eol_diff ? '\n' : '\r';
+				++r;
+			}
+			continue;
+		}
+		if (c == '\n')
+			++stats.nlfs;
+		else if (c == 0)
+			++stats.nzeros;
+		buff[w++] = c;
+		++r;
+	}
+	if (stats.nzeros > 0)
+	{
+		m_bFailed = true;
+		return false;
+	}
+
+	// Keep the CR not scanned yet after the scanned data
+	if (r < size)
+		buff[w] = buff[r];
+	m_end[side] = w;
+	m_size[side] = w + (size - r);
+	if (m_eof[side])
+		buff[m_end[side]] = '\n';
+	return true;
+}
+
+/**
+ * @brief Get the next line of a file, reading more data when needed.
+ * @param [out] line Begin of the line, followed by a newline in buffer.
+ * @param [out] length Length of the line with its EOL, as diffutils sees it.
+ * @return true if a line was got, false at the end of file, or if the file
+ * is binary or cannot be read.
+ */
+bool TextPrecheck::NextLine(int side, const char *&line, size_t &length)
+{
+	while (true)
+	{
+		const char *begin = &m_buff[side][0] + m_begin[side];
+		const char *end = &m_buff[side][0] + m_end[side];
+		const char *lf = static_cast<const char *>(memchr(begin, '\n', end - begin));
+		const char *cr = ignore_eol_diff ? NULL :
+			static_cast<const char *>(memchr(begin, '\r', (lf ? lf : end) - begin));
+		// A CR not followed by LF ends a line. A CR at the end of the
+		// scanned data is not followed by LF.
+		const char *eol = (cr && cr + 1 != lf) ? cr : lf;
+		if (eol)
+		{
+			line = begin;
+			length = eol + 1 - begin;
+			m_begin[side] += length;
+			return true;
+		}
+		if (m_eof[side])
+		{
+			if (begin == end)
+				return false;
+			// Last line without EOL
+			line = begin;
+			length = end - begin;
+			m_begin[side] = m_end[side];
+			return true;
+		}
+		if (!Read(side))
+			return false;
+	}
+}
+
+/**
+ * @brief Return text statistics for last compare.
+ * The statistics are complete only if the files were found the same.
+ * @param [in] side For which file to return statistics.
+ * @param [out] stats Stats as asked.
+ */
+void TextPrecheck::GetTextStats(int side, FileTextStats *stats) const
+{
+	*stats = m_textStats[side];
+}
+
+} // namespace CompareEngines
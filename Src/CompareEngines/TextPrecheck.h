@@ -0,0 +1,55 @@
+/**
+ * @file  TextPrecheck.h
+ *
+ * @brief Declaration file for TextPrecheck
+ */
+#pragma once
+
+#include <vector>
+#include "FileTextStats.h"
+
+struct file_data;
+
+namespace CompareEngines
+{
+
+/**
+ * @brief Streaming check whether two text files are the same.
+ *
+ * Reads both files in parallel, one buffer at a time, and compares them line
+ * by line with the current diffutils options, so lines ignored to be the same
+ * are the lines diffutils puts in the same equivalence class. No line tables
+ * are built and the check stops at the first differing line. When the check
+ * tells the files are the same, full diffutils compare would find them the
+ * same without any differences. Otherwise the files must be compared with
+ * diffutils, as the check does not know about blank lines, comments and line
+ * filters. Binary files and non octet encoded Unicode files are never the
+ * same for the check.
+ */
+class TextPrecheck
+{
+public:
+	TextPrecheck();
+
+	bool CompareFiles(file_data *data);
+	void GetTextStats(int side, FileTextStats *stats) const;
+
+	static const size_t BufferSize = 64 * 1024; /**< Bytes read at once */
+
+private:
+	bool CompareLines();
+	bool Start(int side);
+	bool Read(int side);
+	bool NextLine(int side, const char *&line, size_t &length);
+
+	int m_desc[2]; /**< Descriptors of the files */
+	std::vector<char> m_buff[2]; /**< Buffered data of the files */
+	size_t m_begin[2]; /**< Start of the next line in buffer */
+	size_t m_end[2]; /**< End of the scanned data in buffer */
+	size_t m_size[2]; /**< End of the read data in buffer */
+	bool m_eof[2]; /**< Has the whole file been read? */
+	bool m_bFailed; /**< Was a file binary or unreadable? */
+	FileTextStats m_textStats[2];
+};
+
+} // namespace CompareEngines
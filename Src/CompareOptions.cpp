@@ -79,7 +79,6 @@ void CompareOptions::SetFromDiffOptions(const DIFFOPTIONS &options)
  * @brief Default constructor.
  */
 QuickCompareOptions::QuickCompareOptions()
-: m_bStopAfterFirstDiff(false)
 {
 
 }
@@ -123,7 +122,7 @@ void DiffutilsOptions::SetFromDiffOptions(const DIFFOPTIONS & options)
  * values and meanings, with fancy combinations? So not easy to setup. This
  * function maps our easier to handle compare options to diffutils globals.
  */
-void DiffutilsOptions::SetToDiffUtils()
+void DiffutilsOptions::SetToDiffUtils() const
 {
 	switch (m_outputStyle)
 	{
@@ -219,6 +218,5 @@ void DiffutilsOptions::GetAsDiffOptions(DIFFOPTIONS &options) const
 
 QuickCompareOptions::QuickCompareOptions(const CompareOptions& options)
 : CompareOptions(options)
-, m_bStopAfterFirstDiff(false)
 {
 }
@@ -102,7 +102,7 @@ public:
 	DiffutilsOptions();
 	explicit DiffutilsOptions(const CompareOptions& options);
 	DiffutilsOptions(const DiffutilsOptions& options);
-	void SetToDiffUtils();
+	void SetToDiffUtils() const;
 	void GetAsDiffOptions(DIFFOPTIONS &options) const;
 	virtual void SetFromDiffOptions(const DIFFOPTIONS & options);
 
@@ -113,14 +113,13 @@ public:
 
 /**
  * @brief Compare options used with Quick compare -method.
- * This class has some Quick Compare specifics in addition to general compare
- * options.
+ * This class is for Quick Compare specifics in addition to general compare
+ * options. Stopping after first difference is set to the engine instead,
+ * so the options can be shared by all compare threads.
  */
 class QuickCompareOptions : public CompareOptions
 {
 public:
 	QuickCompareOptions();
 	explicit QuickCompareOptions(const CompareOptions& options);
-
-	bool m_bStopAfterFirstDiff; /**< Optimize compare by stopping after first difference? */
 };
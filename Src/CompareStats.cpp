@@ -9,6 +9,7 @@
 #include <cstring>
 #include <Poco/ScopedLock.h>
 #include "DiffItem.h"
+#include "MemoryStats.h"
 
 using Poco::FastMutex;
 
@@ -110,6 +111,8 @@ void CompareStats::Reset()
 	m_nTotalItems = 0;
 	m_nComparedItems = 0;
 	m_bCompareDone = false;
+	FastMutex::ScopedLock lock(m_csProtect);
+	m_completedItems.clear();
 }
 
 /** 
@@ -118,9 +121,12 @@ void CompareStats::Reset()
  */
 void CompareStats::SetCompareState(CompareStats::CMP_STATE state)
 {
-	// New compare starting so reset ready status
+	// New compare starting so reset ready status and memory peaks
 	if (state == STATE_START)
+	{
 		m_bCompareDone = false;
+		MemoryStats::ResetPeaks();
+	}
 	// Compare ready
 	if (state == STATE_IDLE && m_state == STATE_COMPARE)
 		m_bCompareDone = true;
@@ -208,3 +214,26 @@ void CompareStats::Swap(int idx1, int idx2)
 	std::swap(m_counts[RESULT_LDIRUNIQUE + idx1], m_counts[RESULT_LDIRUNIQUE + idx2]);
 	std::swap(m_counts[RESULT_LDIRMISSING + idx1], m_counts[RESULT_LDIRMISSING + idx2]);
 }
+
+/**
+ * @brief Add an item whose compare is completed.
+ * The GUI gets the completed items in batches to show the results while
+ * the compare is running.
+ * @param [in] di Completed item.
+ */
+void CompareStats::AddCompletedItem(const DIFFITEM *di)
+{
+	FastMutex::ScopedLock lock(m_csProtect);
+	m_completedItems.push_back(di);
+}
+
+/**
+ * @brief Get the items completed since the previous call.
+ * @param [out] items Completed items, in the order they were completed.
+ */
+void CompareStats::GetCompletedItems(std::vector<const DIFFITEM *>& items)
+{
+	items.clear();
+	FastMutex::ScopedLock lock(m_csProtect);
+	items.swap(m_completedItems);
+}
@@ -93,6 +93,8 @@ public:
 	CompareStats::RESULT GetResultFromCode(unsigned diffcode) const;
 	void Swap(int idx1, int idx2);
 	int GetCompareDirs() const { return m_nDirs; }
+	void AddCompletedItem(const DIFFITEM *di);
+	void GetCompletedItems(std::vector<const DIFFITEM *>& items);
 
 private:
 	int m_counts[RESULT_COUNT]; /**< Table storing result counts */
@@ -109,5 +111,6 @@ private:
 		const DIFFITEM *m_pDiffItem;
 	};
 	std::vector<ThreadState> m_rgThreadState;
+	std::vector<const DIFFITEM *> m_completedItems; /**< Items completed since last GetCompletedItems() */
 
 };
@@ -25,7 +25,6 @@
  */ 
 
 #include "DiffContext.h"
-#include <Poco/ScopedLock.h>
 #include "CompareOptions.h"
 #include "version.h"
 #include "paths.h"
@@ -34,8 +33,6 @@
 #include "IAbortable.h"
 #include "DiffWrapper.h"
 
-using Poco::FastMutex;
-
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -64,6 +61,7 @@ CDiffContext::CDiffContext(const PathContext & paths, int compareMethod)
 , m_bWalkUniques(true)
 , m_bIgnoreReparsePoints(false)
 , m_bIgnoreCodepage(false)
+, m_bDetectMovedFiles(false)
 , m_iGuessEncodingType(0)
 , m_nQuickCompareLimit(0)
 , m_pFilterCommentsManager(nullptr)
@@ -101,13 +99,17 @@ void CDiffContext::UpdateStatusFromDisk(uintptr_t diffpos, int nIndex)
  * the disk. This updates info like date, size and attributes.
  * @param [in, out] di DIFFITEM to update.
  * @param [in] nIndex index to update
+ * @param [in] pFound File found by listing its folder, NULL to look up
+ *  the file by its path.
  * @return true if file exists
  */
-bool CDiffContext::UpdateInfoFromDiskHalf(DIFFITEM & di, int nIndex)
+bool CDiffContext::UpdateInfoFromDiskHalf(DIFFITEM & di, int nIndex, const DirItem * pFound)
 {
 	String filepath = paths::ConcatPath(paths::ConcatPath(m_paths[nIndex], di.diffFileInfo[nIndex].path), di.diffFileInfo[nIndex].filename);
 	DiffFileInfo & dfi = di.diffFileInfo[nIndex];
-	if (!dfi.Update(filepath))
+	if (pFound)
+		dfi.UpdateFromListing(*pFound);
+	else if (!dfi.Update(filepath))
 		return false;
 	UpdateVersion(di, nIndex);
 	dfi.encoding = GuessCodepageEncoding(filepath, m_iGuessEncodingType);
@@ -173,6 +175,10 @@ void CDiffContext::UpdateVersion(DIFFITEM & di, int nIndex) const
  * This function creates a compare options class that is specific for
  * main compare method. Compare options class is initialized from
  * given set of options.
+ * Both content and quick contents options are resolved here, as content
+ * compare switches to quick contents compare for big files. They are not
+ * changed until next call, so compare threads can share them without
+ * copying or locking.
  * @param [in] compareMethod Selected compare method.
  * @param [in] options Initial set of compare options.
  * @return true if creation succeeds.
@@ -187,6 +193,14 @@ bool CDiffContext::CreateCompareOptions(int compareMethod, const DIFFOPTIONS & o
 	else
 		return false;
 
+	std::shared_ptr<DiffutilsOptions> pContentCompareOptions(new DiffutilsOptions());
+	pContentCompareOptions->SetFromDiffOptions(options);
+	m_pContentCompareOptions = pContentCompareOptions;
+
+	std::shared_ptr<QuickCompareOptions> pQuickCompareOptions(new QuickCompareOptions());
+	pQuickCompareOptions->SetFromDiffOptions(options);
+	m_pQuickCompareOptions = pQuickCompareOptions;
+
 	m_nCompMethod = compareMethod;
 	if (GetCompareOptions(m_nCompMethod) == NULL)
 	{
@@ -210,34 +224,19 @@ bool CDiffContext::CreateCompareOptions(int compareMethod, const DIFFOPTIONS & o
  * comapare type. Not all compare options in general set are available for
  * some other compare type. And some options can have different values.
  * @param [in] compareMethod Compare method used.
- * @return Compare options class.
+ * @return Compare options class, NULL if compare method has no options
+ *  or CreateCompareOptions() has not been called.
  */
-CompareOptions * CDiffContext::GetCompareOptions(int compareMethod)
+const CompareOptions * CDiffContext::GetCompareOptions(int compareMethod) const
 {
-	FastMutex::ScopedLock lock(m_mutex);
-	CompareOptions *pCompareOptions = NULL;
-
-	// Otherwise we have to create new options
 	switch (compareMethod)
 	{
 	case CMP_CONTENT:
-		if (m_pContentCompareOptions)
-			return m_pContentCompareOptions.get();
-		m_pContentCompareOptions.reset(pCompareOptions = new DiffutilsOptions());
-		break;
-
+		return m_pContentCompareOptions.get();
 	case CMP_QUICK_CONTENT:
-		if (m_pQuickCompareOptions)
-			return m_pQuickCompareOptions.get();
-		m_pQuickCompareOptions.reset(pCompareOptions = new QuickCompareOptions());
-		break;
+		return m_pQuickCompareOptions.get();
 	}
-
-
-	if (pCompareOptions)
-		pCompareOptions->SetFromDiffOptions(*m_pOptions);
-
-	return pCompareOptions;
+	return NULL;
 }
 
 /** @brief Forward call to retrieve plugin info (winds up in DirDoc) */
@@ -22,6 +22,8 @@ class CompareStats;
 class IAbortable;
 class CDiffWrapper;
 class CompareOptions;
+class DiffutilsOptions;
+class QuickCompareOptions;
 struct DIFFOPTIONS;
 class FilterCommentsManager;
 
@@ -108,11 +110,15 @@ public:
 	//@}
 
 	// change an existing difference
-	bool UpdateInfoFromDiskHalf(DIFFITEM & di, int nIndex);
+	bool UpdateInfoFromDiskHalf(DIFFITEM & di, int nIndex, const DirItem * pFound = NULL);
 	void UpdateStatusFromDisk(uintptr_t diffpos, int nIndex);
 
 	bool CreateCompareOptions(int compareMethod, const DIFFOPTIONS & options);
-	CompareOptions * GetCompareOptions(int compareMethod);
+	const CompareOptions * GetCompareOptions(int compareMethod) const;
+	/** @brief Return content compare options shared by the compare threads. */
+	const std::shared_ptr<const DiffutilsOptions>& GetContentCompareOptions() const { return m_pContentCompareOptions; }
+	/** @brief Return quick contents compare options shared by the compare threads. */
+	const std::shared_ptr<const QuickCompareOptions>& GetQuickCompareOptions() const { return m_pQuickCompareOptions; }
 
 	// retrieve or manufacture plugin info for specified file comparison
 	void FetchPluginInfos(const String& filteredFilenames,
@@ -187,6 +193,7 @@ public:
 	bool m_bWalkUniques;
 	bool m_bIgnoreReparsePoints;
 	bool m_bIgnoreCodepage;
+	bool m_bDetectMovedFiles; /**< Link unique files renamed or moved to another folder? */
 
 	bool m_bRecursive; /**< Do we include subfolders to compare? */
 	bool m_bPluginsEnabled; /**< Are plugins enabled? */
@@ -203,9 +210,8 @@ private:
 	int m_nCompMethod;
 
 	std::unique_ptr<DIFFOPTIONS> m_pOptions; /**< Generalized compare options. */
-	std::unique_ptr<CompareOptions> m_pContentCompareOptions; /**< Per compare method compare options. */
-	std::unique_ptr<CompareOptions> m_pQuickCompareOptions;   /**< Per compare method compare options. */
+	std::shared_ptr<const DiffutilsOptions> m_pContentCompareOptions; /**< Per compare method compare options. */
+	std::shared_ptr<const QuickCompareOptions> m_pQuickCompareOptions;   /**< Per compare method compare options. */
 	PathContext m_paths; /**< (root) paths for this context */
 	IAbortable *m_piAbortable; /**< Interface for aborting the compare. */
-	Poco::FastMutex m_mutex;
 };
@@ -19,6 +19,7 @@
 #include "diff.h"
 #include "FileTransform.h"
 #include "unicoder.h"
+#include "MemoryStats.h"
 
 /**
  * @brief Simple initialization of DiffFileData
@@ -60,6 +61,21 @@ void DiffFileData::SetDisplayFilepaths(const String& szTrueFilepath1, const Stri
 }
 
 
+/**
+ * @brief Set text stats of an opened file, known before the compare.
+ * The compare then reports these stats instead of counting them again.
+ * @param [in] side Side of the file.
+ * @param [in] stats Stats of the whole file.
+ */
+void DiffFileData::SetTextStats(int side, const FileTextStats& stats)
+{
+	m_inf[side].count_crlfs = stats.ncrlfs;
+	m_inf[side].count_crs = stats.ncrs;
+	m_inf[side].count_lfs = stats.nlfs;
+	m_inf[side].count_zeros = stats.nzeros;
+	m_inf[side].known_text_stats = 1;
+}
+
 /** @brief Open file descriptors in the inf structure (return false if failure) */
 bool DiffFileData::DoOpenFiles()
 {
@@ -171,3 +187,15 @@ bool DiffFileData::Filepath_Transform(bool bForceUTF8,
 	}
 	return true;
 }
+
+/**
+ * @brief Count allocations of diffutils line tables to the memory stats.
+ * @param [in] bytes Bytes allocated, negative when freed.
+ */
+extern "C" void memory_stats_diffutils(long bytes)
+{
+	if (bytes > 0)
+		MemoryStats::Allocated(MemoryStats::DIFFUTILS_LINES, bytes);
+	else if (bytes < 0)
+		MemoryStats::Freed(MemoryStats::DIFFUTILS_LINES, -bytes);
+}
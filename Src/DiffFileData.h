@@ -32,6 +32,7 @@ struct DiffFileData
 	void Reset();
 	void Close() { Reset(); }
 	void SetDisplayFilepaths(const String& szTrueFilepath1, const String& szTrueFilepath2);
+	void SetTextStats(int side, const FileTextStats& stats);
 
 	bool Filepath_Transform(bool bForceUTF8, const FileTextEncoding & encoding, const String & filepath, String & filepathTransformed,
 		const String& filteredFilenames, PrediffingInfo * infoPrediffer);
@@ -6,15 +6,32 @@
 
 #include "DiffItem.h"
 #include "paths.h"
+#include "MemoryStats.h"
 
 DIFFITEM DIFFITEM::emptyitem;
 
 /** @brief DIFFITEM's destructor */
 DIFFITEM::~DIFFITEM()
 {
+	UnlinkMoved();
 	RemoveChildren();
 }
 
+/** @brief Allocate an item, counting it to the memory stats of the DIFFITEM tree */
+void *DIFFITEM::operator new(size_t size)
+{
+	void *p = ::operator new(size);
+	MemoryStats::Allocated(MemoryStats::DIFFITEMS, size);
+	return p;
+}
+
+/** @brief Free an item allocated with DIFFITEM::operator new */
+void DIFFITEM::operator delete(void *p, size_t size)
+{
+	::operator delete(p);
+	MemoryStats::Freed(MemoryStats::DIFFITEMS, size);
+}
+
 /** @brief Return path to left/right file, including all but file name */
 String DIFFITEM::getFilepath(int nIndex, const String &sRoot) const
 {
@@ -76,3 +93,29 @@ void DIFFITEM::Swap(int idx1, int idx2)
 			static_cast<DIFFITEM *>(p)->Swap(idx1, idx2);
 	}
 }
+
+/**
+ * @brief Link a unique item to the unique item of the other side having the same content.
+ * @param [in] pdi Item of the other side.
+ */
+void DIFFITEM::LinkMoved(DIFFITEM *pdi)
+{
+	UnlinkMoved();
+	pdi->UnlinkMoved();
+	movedItem = pdi;
+	pdi->movedItem = this;
+	diffcode.setMoved(true);
+	pdi->diffcode.setMoved(true);
+}
+
+/** @brief Remove the link between moved items, e.g. before the item is rescanned or deleted */
+void DIFFITEM::UnlinkMoved()
+{
+	if (movedItem)
+	{
+		movedItem->movedItem = NULL;
+		movedItem->diffcode.setMoved(false);
+		movedItem = NULL;
+		diffcode.setMoved(false);
+	}
+}
@@ -55,6 +55,7 @@ struct DIFFCODE
 		COMPAREFLAGS=0x7000, NOCMP=0x0000, SAME=0x1000, DIFF=0x2000, CMPERR=0x3000, CMPABORT=0x4000,
 		FILTERFLAGS=0x20000, INCLUDED=0x00000, SKIPPED=0x20000,
 		SCANFLAGS=0x100000, NEEDSCAN=0x100000,
+		MOVEDFLAGS=0x200000, MOVED=0x200000,
 	};
 
 	unsigned diffcode;
@@ -161,6 +162,9 @@ public:
 	void setBin() { Set(DIFFCODE::TEXTFLAGS, DIFFCODE::BIN); }
 	// rescan
 	bool isScanNeeded() const { return ((diffcode & DIFFCODE::SCANFLAGS) == DIFFCODE::NEEDSCAN); }
+	// unique file moved or renamed to a unique file of the other side
+	bool isMoved() const { return Check(diffcode, DIFFCODE::MOVEDFLAGS, DIFFCODE::MOVED); }
+	void setMoved(bool bMoved) { Set(DIFFCODE::MOVEDFLAGS, bMoved ? DIFFCODE::MOVED : 0); }
 
 	void swap(int idx1, int idx2)
 	{
@@ -195,12 +199,16 @@ struct DIFFITEM : ListEntry
 	int nidiffs; /**< Amount of ignored differences */
 	unsigned customFlags1; /**< Custom flags set 1 */
 	DIFFCODE diffcode; /**< Compare result */
+	DIFFITEM *movedItem; /**< Unique item of the other side with the same content, or NULL */
 
 	static DIFFITEM emptyitem; /**< singleton to represent a diffitem that doesn't have any data */
 
-	DIFFITEM() : parent(NULL), nidiffs(-1), nsdiffs(-1), customFlags1(0) { }
+	DIFFITEM() : parent(NULL), nidiffs(-1), nsdiffs(-1), customFlags1(0), movedItem(NULL) { }
 	~DIFFITEM();
 
+	static void *operator new(size_t size);
+	static void operator delete(void *p, size_t size);
+
 	bool isEmpty() const { return this == &emptyitem; }
 	String getFilepath(int nIndex, const String &sRoot) const;
 	String getLeftFilepath(const String &sLeftRoot) const;
@@ -210,4 +218,6 @@ struct DIFFITEM : ListEntry
 	bool HasChildren() const;
 	void RemoveChildren();
 	void Swap(int idx1, int idx2);
+	void LinkMoved(DIFFITEM *pdi);
+	void UnlinkMoved();
 };
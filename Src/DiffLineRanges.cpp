@@ -0,0 +1,118 @@
+/**
+ * @file  DiffLineRanges.cpp
+ *
+ * @brief Implementation file for DiffLineRanges
+ *
+ */
+
+#include "DiffLineRanges.h"
+#include <algorithm>
+#include "DiffList.h"
+
+namespace
+{
+
+/**
+ * @brief Append a range, merging it with the last range if they touch.
+ */
+void AppendRange(std::vector<DiffLineRanges::Range>& ranges, int nBegin, int nEnd)
+{
+	if (nBegin >= nEnd)
+		return;
+	if (!ranges.empty() && nBegin <= ranges.back().nEnd)
+	{
+		ranges.back().nEnd = (std::max)(ranges.back().nEnd, nEnd);
+		return;
+	}
+	DiffLineRanges::Range range = { nBegin, nEnd };
+	ranges.push_back(range);
+}
+
+}
+
+/**
+ * @brief Constructor.
+ */
+DiffLineRanges::DiffLineRanges()
+: m_nLineCount(0)
+{
+}
+
+/**
+ * @brief Build the ranges from the differences after PrimeTextBuffers().
+ * The lines of a difference are diff or ghost lines in the first file,
+ * except for ignored differences, where only the ghost lines are.
+ * @param [in] diffList Differences, with synchronized line numbers.
+ * @param [in] nLineCount Number of lines in the shortest buffer.
+ * @param [in] nContext Number of lines shown before and after differences,
+ * negative to show all lines.
+ */
+void DiffLineRanges::Build(const DiffList& diffList, int nLineCount, int nContext)
+{
+	std::vector<Range> diffRanges;
+	const int nDiffCount = diffList.GetSize();
+	diffRanges.reserve(nDiffCount);
+	for (int nDiff = 0; nDiff < nDiffCount; nDiff++)
+	{
+		const DIFFRANGE *dfi = diffList.DiffRangeAt(nDiff);
+		int nBegin = dfi->dbegin;
+		if (dfi->op == OP_TRIVIAL)
+		{
+			if (dfi->blank[0] == -1)
+				continue;
+			nBegin = dfi->blank[0];
+		}
+		AppendRange(diffRanges, (std::max)(nBegin, 0), (std::min)(dfi->dend + 1, nLineCount));
+	}
+	Build(diffRanges, nLineCount, nContext);
+}
+
+/**
+ * @brief Build the ranges from the diff line ranges.
+ * Each run of diff lines is shown with nContext lines before and after it.
+ * The context after a difference does not reach the last line, so the last
+ * line is shown only if it is a diff line itself.
+ * @param [in] diffRanges Sorted diff line ranges.
+ * @param [in] nLineCount Number of lines in the shortest buffer.
+ * @param [in] nContext Number of lines shown before and after differences,
+ * negative to show all lines.
+ */
+void DiffLineRanges::Build(const std::vector<Range>& diffRanges, int nLineCount, int nContext)
+{
+	m_nLineCount = nLineCount;
+	m_diffRanges.clear();
+	m_visibleRanges.clear();
+	for (size_t i = 0; i < diffRanges.size(); ++i)
+		AppendRange(m_diffRanges, (std::max)(diffRanges[i].nBegin, 0), (std::min)(diffRanges[i].nEnd, nLineCount));
+
+	if (nContext < 0)
+	{
+		AppendRange(m_visibleRanges, 0, nLineCount);
+		return;
+	}
+
+	for (size_t i = 0; i < m_diffRanges.size(); ++i)
+	{
+		const Range& range = m_diffRanges[i];
+		int nBegin = (std::max)(range.nBegin - nContext, 0);
+		int nEnd = (std::max)(range.nEnd, (std::min)(range.nEnd + nContext, nLineCount - 1));
+		AppendRange(m_visibleRanges, nBegin, nEnd);
+	}
+}
+
+/**
+ * @brief Return the ranges of lines hidden when identical lines are hidden.
+ */
+std::vector<DiffLineRanges::Range> DiffLineRanges::GetHiddenRanges() const
+{
+	std::vector<Range> hiddenRanges;
+	hiddenRanges.reserve(m_visibleRanges.size() + 1);
+	int nLine = 0;
+	for (size_t i = 0; i < m_visibleRanges.size(); ++i)
+	{
+		AppendRange(hiddenRanges, nLine, m_visibleRanges[i].nBegin);
+		nLine = m_visibleRanges[i].nEnd;
+	}
+	AppendRange(hiddenRanges, nLine, m_nLineCount);
+	return hiddenRanges;
+}
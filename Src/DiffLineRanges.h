@@ -0,0 +1,45 @@
+/**
+ * @file  DiffLineRanges.h
+ *
+ * @brief Declaration file for DiffLineRanges.
+ *
+ */
+#pragma once
+
+#include <vector>
+
+class DiffList;
+
+/**
+ * @brief Line ranges of differences and of the lines shown around them
+ * when identical lines are hidden.
+ *
+ * The ranges are built from the DiffList in time proportional to the
+ * number of differences, instead of testing the flags of every line.
+ * Line numbers are those of the text buffers after ghost lines have been
+ * added. CMergeDoc writes the line flags of the text buffers per range;
+ * the views still read the flags of each line.
+ */
+class DiffLineRanges
+{
+public:
+	/** @brief Lines from nBegin up to but not including nEnd */
+	struct Range
+	{
+		int nBegin;
+		int nEnd;
+	};
+
+	DiffLineRanges();
+	void Build(const DiffList& diffList, int nLineCount, int nContext);
+	void Build(const std::vector<Range>& diffRanges, int nLineCount, int nContext);
+	std::vector<Range> GetHiddenRanges() const;
+	const std::vector<Range>& GetDiffRanges() const { return m_diffRanges; }
+	const std::vector<Range>& GetVisibleRanges() const { return m_visibleRanges; }
+	int GetLineCount() const { return m_nLineCount; }
+
+private:
+	int m_nLineCount; /**< Lines covered by the ranges */
+	std::vector<Range> m_diffRanges; /**< Diff and ghost lines of the first file */
+	std::vector<Range> m_visibleRanges; /**< Diff lines and their context */
+};
@@ -21,6 +21,7 @@
 #include "FileTextEncoding.h"
 #include "codepage_detect.h"
 #include "TFile.h"
+#include "DiffTextLines.h"
 
 using Poco::Exception;
 
@@ -29,7 +30,6 @@ using Poco::Exception;
 #endif
 
 static bool IsTextFileStylePure(const UniMemFile::txtstats & stats);
-static void EscapeControlChars(String &s);
 static CRLFSTYLE GetTextFileStyle(const UniMemFile::txtstats & stats);
 
 /**
@@ -49,54 +49,6 @@ static bool IsTextFileStylePure(const UniMemFile::txtstats & stats)
 	return (nType <= 1);
 }
 
-/**
- * @brief Escape control characters.
- * @param [in,out] s Line of text excluding eol chars.
- *
- * @note Escape sequences follow the pattern
- * (leadin character, high nibble, low nibble, leadout character).
- * The leadin character is '\x0F'. The leadout character is a backslash.
- */
-static void EscapeControlChars(String &s)
-{
-	// Compute buffer length required for escaping
-	size_t n = s.length();
-	LPCTSTR q = s.c_str();
-	size_t i = n;
-	while (i)
-	{
-		TCHAR c = q[--i];
-		// Is it a control character in the range 0..31 except TAB?
-		if (!(c & ~_T('\x1F')) && c != _T('\t'))
-		{
-			n += 3; // Need 3 extra characters to escape
-		}
-	}
-	// Reallocate accordingly
-	i = s.length();
-	s.reserve(n + 1);
-	s.resize(n + 1);
-	LPTSTR p = &s[0];
-	// Copy/translate characters starting at end of string
-	while (i)
-	{
-		TCHAR c = p[--i];
-		// Is it a control character in the range 0..31 except TAB?
-		if (!(c & ~_T('\x1F')) && c != _T('\t'))
-		{
-			// Bitwise OR with 0x100 so _itot() will output 3 hex digits
-			_itot(0x100 | c, p + n - 4, 16);
-			// Replace terminating zero with leadout character
-			p[n - 1] = _T('\\');
-			// Prepare to replace 1st hex digit with leadin character
-			c = _T('\x0F');
-			n -= 3;
-		}
-		p[--n] = c;
-	}
-	s.resize(s.length() - 1);
-}
-
 /**
  * @brief Get file's EOL type.
  * @param [in] stats File's text stats.
@@ -134,6 +86,8 @@ CDiffTextBuffer::CDiffTextBuffer(CMergeDoc * pDoc, int pane)
 , m_unpackerSubcode(0)
 , m_bMixedEOL(false)
 {
+	// Diff flags are set on blocks of lines, keep them as ranges
+	m_LineFlagRanges.SetRangeFlags(LF_INVISIBLE | LF_DIFF | LF_TRIVIAL | LF_MOVED | LF_SNP);
 }
 
 /**
@@ -211,7 +165,7 @@ void CDiffTextBuffer::AddUndoRecord(bool bInsert, const CPoint & ptStartPos,
  */
 bool CDiffTextBuffer::FlagIsSet(UINT line, DWORD flag) const
 {
-	return ((m_aLines[line].m_dwFlags & flag) == flag);
+	return ((GetLineFlags(line) & flag) == flag);
 }
 
 /**
@@ -223,13 +177,10 @@ fine, so let's go on with it)
 */
 void CDiffTextBuffer::prepareForRescan()
 {
+	// Only the diff flags are kept as ranges, clear them first so
+	// removing the ghost lines does not have to move them
+	m_LineFlagRanges.Clear();
 	RemoveAllGhostLines();
-	for (int ct = GetLineCount() - 1; ct >= 0; --ct)
-	{
-		SetLineFlag(ct, 
-			LF_INVISIBLE | LF_DIFF | LF_TRIVIAL | LF_MOVED | LF_SNP,
-			false, false, false);
-	}
 }
 
 /** 
@@ -512,6 +463,8 @@ int CDiffTextBuffer::SaveToFile (const String& pszFileName,
 
 	if (bTempFile)
 	{
+		// no stale stats of the last temp file, even if the open fails
+		m_tempFileTextStats.clear();
 		bOpenSuccess = !!file.OpenCreate(pszFileName);
 	}
 	else
@@ -542,52 +495,9 @@ int CDiffTextBuffer::SaveToFile (const String& pszFileName,
 	file.WriteBom();
 
 	// line loop : get each real line and write it in the file
-	String sLine;
-	String sEol = GetStringEol(nCrlfStyle);
-	for (int line = nStartLine; line < nStartLine + nLines; ++line)
-	{
-		if (GetLineFlags(line) & LF_GHOST)
-			continue;
-
-		// get the characters of the line (excluding EOL)
-		if (GetLineLength(line) > 0)
-		{
-			int nLineLength = GetLineLength(line);
-			sLine.resize(0);
-			sLine.reserve(nLineLength + 4);
-			sLine.append(GetLineChars(line), nLineLength);
-		}
-		else
-			sLine = _T("");
-
-		if (bTempFile)
-			EscapeControlChars(sLine);
-		// last real line ?
-		int lastRealLine = ApparentLastRealLine();
-		if (line == lastRealLine || lastRealLine == -1 )
-		{
-			// last real line is never EOL terminated
-			ASSERT (_tcslen(GetLineEol(line)) == 0);
-			// write the line and exit loop
-			file.WriteString(sLine);
-			break;
-		}
-
-		// normal real line : append an EOL
-		if (nCrlfStyle == CRLF_STYLE_AUTOMATIC || nCrlfStyle == CRLF_STYLE_MIXED)
-		{
-			// either the EOL of the line (when preserve original EOL chars is on)
-			sLine += GetLineEol(line);
-		}
-		else
-		{
-			// or the default EOL for this file
-			sLine += sEol;
-		}
-
-		// write this line to the file (codeset or unicode conversions are done there
-		file.WriteString(sLine);
-	}
+	// (codeset or unicode conversions are done there)
+	WriteRealLines(nStartLine, nLines, nCrlfStyle, bTempFile,
+		[&file](const String& sLine) { file.WriteString(sLine); });
 	file.Close();
 
 	if (!bTempFile)
@@ -665,6 +575,49 @@ int CDiffTextBuffer::SaveToFile (const String& pszFileName,
 		return SAVE_FAILED;
 }
 
+/**
+ * @brief Pass the real lines of a range one by one as they are saved.
+ * See DiffTextLines::WriteRealLines(). For temp files the EOLs are added
+ * to m_tempFileTextStats, which the caller clears first.
+ * @param [in] nStartLine First line of the range.
+ * @param [in] nLines Number of lines in the range.
+ * @param [in] nCrlfStyle EOL style, original EOLs are kept if automatic or mixed.
+ * @param [in] bTempFile Are the lines for a temp file of the compare?
+ * @param [in] write Called with each line, EOL included.
+ */
+void CDiffTextBuffer::WriteRealLines(int nStartLine, int nLines, CRLFSTYLE nCrlfStyle,
+		bool bTempFile, const std::function<void(const String&)>& write)
+{
+	// either the EOL of the line (when preserve original EOL chars is on)
+	// or the default EOL for this file
+	String sEol = GetStringEol(nCrlfStyle);
+	LPCTSTR pszEol = NULL;
+	if (nCrlfStyle != CRLF_STYLE_AUTOMATIC && nCrlfStyle != CRLF_STYLE_MIXED)
+		pszEol = sEol.c_str();
+	DiffTextLines::WriteRealLines(m_aLines, nStartLine, nLines, ApparentLastRealLine(),
+		LF_GHOST, pszEol, bTempFile ? &m_tempFileTextStats : NULL, write);
+}
+
+/**
+ * @brief Get the text of the buffer as SaveToFile() writes it to a temp file.
+ * Lets the text be written and compared in another thread while the buffer
+ * is edited. The EOLs are counted in the stats of the temp file.
+ * @param [out] sText Real lines of the buffer, control chars escaped.
+ */
+void CDiffTextBuffer::GetTextForTempFile(String &sText)
+{
+	ASSERT (m_bInit);
+
+	CRLFSTYLE nCrlfStyle = CRLF_STYLE_AUTOMATIC;
+	if (!GetOptionsMgr()->GetBool(OPT_ALLOW_MIXED_EOL))
+		nCrlfStyle = GetCRLFMode();
+
+	sText.clear();
+	m_tempFileTextStats.clear();
+	WriteRealLines(0, GetLineCount(), nCrlfStyle, true,
+		[&sText](const String& sLine) { sText += sLine; });
+}
+
 /// Replace line (removing any eol, and only including one if in strText)
 void CDiffTextBuffer::ReplaceFullLines(CDiffTextBuffer& dbuf, CDiffTextBuffer& sbuf, CCrystalTextView * pSource, int nLineBegin, int nLineEnd, int nAction /*=CE_ACTION_UNKNOWN*/)
 {
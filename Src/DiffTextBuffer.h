@@ -5,8 +5,10 @@
  */
 #pragma once
 
+#include <functional>
 #include "GhostTextBuffer.h"
 #include "FileTextEncoding.h"
+#include "FileTextStats.h"
 
 class CMergedoc;
 class PackingInfo;
@@ -24,6 +26,7 @@ private :
 	String m_strTempPath; /**< Temporary files folder. */
 	int m_unpackerSubcode; /**< Plugin information. */
 	bool m_bMixedEOL; /**< EOL style of this buffer is mixed? */
+	FileTextStats m_tempFileTextStats; /**< Text stats of last saved temp file */
 
 	/** 
 	 * @brief Unicode encoding from ucr::UNICODESET.
@@ -37,6 +40,8 @@ private :
 	FileTextEncoding m_encoding;
 
 	bool FlagIsSet(UINT line, DWORD flag) const;
+	void WriteRealLines(int nStartLine, int nLines, CRLFSTYLE nCrlfStyle,
+		bool bTempFile, const std::function<void(const String&)>& write);
 
 public :
 	CDiffTextBuffer(CMergeDoc * pDoc, int pane);
@@ -55,6 +60,7 @@ public :
 	int SaveToFile (const String& pszFileName, bool bTempFile, String & sError,
 		PackingInfo * infoUnpacker = NULL, CRLFSTYLE nCrlfStyle = CRLF_STYLE_AUTOMATIC,
 		bool bClearModifiedFlag = TRUE, int nStartLine = 0, int nLines = -1);
+	void GetTextForTempFile(String &sText);
 	ucr::UNICODESET getUnicoding() const { return m_encoding.m_unicoding; }
 	void setUnicoding(ucr::UNICODESET value) { m_encoding.m_unicoding = value; }
 	int getCodepage() const { return m_encoding.m_codepage; }
@@ -65,6 +71,7 @@ public :
 	void setEncoding(const FileTextEncoding &encoding) { m_encoding = encoding; }
 	bool IsMixedEOL() const { return m_bMixedEOL; }
 	void SetMixedEOL(bool bMixed) { m_bMixedEOL = bMixed; }
+	const FileTextStats & GetTempFileTextStats() const { return m_tempFileTextStats; }
 
 	// If line has text (excluding eol), set strLine to text (excluding eol)
 	bool GetLine(int nLineIndex, CString &strLine) const;
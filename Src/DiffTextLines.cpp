@@ -0,0 +1,128 @@
+/**
+ * @file  DiffTextLines.cpp
+ *
+ * @brief Implementation file for DiffTextLines functions.
+ *
+ */
+
+#include "DiffTextLines.h"
+#include <cassert>
+#include <tchar.h>
+#include "FileTextStats.h"
+
+namespace DiffTextLines
+{
+
+/**
+ * @brief Escape control characters.
+ * @param [in,out] s Line of text excluding eol chars.
+ *
+ * @note Escape sequences follow the pattern
+ * (leadin character, high nibble, low nibble, leadout character).
+ * The leadin character is '\x0F'. The leadout character is a backslash.
+ */
+void EscapeControlChars(String &s)
+{
+	// Compute buffer length required for escaping
+	size_t n = s.length();
+	LPCTSTR q = s.c_str();
+	size_t i = n;
+	while (i)
+	{
+		TCHAR c = q[--i];
+		// Is it a control character in the range 0..31 except TAB?
+		if (!(c & ~_T('\x1F')) && c != _T('\t'))
+		{
+			n += 3; // Need 3 extra characters to escape
+		}
+	}
+	// Reallocate accordingly
+	i = s.length();
+	s.reserve(n + 1);
+	s.resize(n + 1);
+	LPTSTR p = &s[0];
+	// Copy/translate characters starting at end of string
+	while (i)
+	{
+		TCHAR c = p[--i];
+		// Is it a control character in the range 0..31 except TAB?
+		if (!(c & ~_T('\x1F')) && c != _T('\t'))
+		{
+			// Bitwise OR with 0x100 so _itot() will output 3 hex digits
+			_itot(0x100 | c, p + n - 4, 16);
+			// Replace terminating zero with leadout character
+			p[n - 1] = _T('\\');
+			// Prepare to replace 1st hex digit with leadin character
+			c = _T('\x0F');
+			n -= 3;
+		}
+		p[--n] = c;
+	}
+	s.resize(s.length() - 1);
+}
+
+/**
+ * @brief Pass the real lines of a range one by one as they are saved.
+ * Lines having any of @p dwSkipFlags (ghost lines) are skipped and the last
+ * real line is never EOL terminated. For temp files, control chars are
+ * escaped, so there are no zeros, and the EOLs are counted, so the compare
+ * does not need to scan the file for them.
+ * @param [in] aLines Lines of the buffer.
+ * @param [in] nStartLine First line to write.
+ * @param [in] nLines Number of lines to write.
+ * @param [in] nLastRealLine Last real line of the buffer, -1 if none.
+ * @param [in] dwSkipFlags Line flags of the lines not written.
+ * @param [in] pszEol EOL written after every line, NULL for the EOL of the line.
+ * @param [in,out] pTempFileStats Stats the EOLs of a temp file are added
+ * to, NULL when not writing a temp file.
+ * @param [in] write Function writing the line with its EOL.
+ */
+void WriteRealLines(const std::vector<LineInfo> &aLines, int nStartLine, int nLines,
+	int nLastRealLine, DWORD dwSkipFlags, LPCTSTR pszEol, FileTextStats *pTempFileStats,
+	const std::function<void(const String&)>& write)
+{
+	String sLine;
+	for (int line = nStartLine; line < nStartLine + nLines; ++line)
+	{
+		const LineInfo &li = aLines[line];
+		if (li.m_dwFlags & dwSkipFlags)
+			continue;
+
+		// get the characters of the line (excluding EOL)
+		if (li.Length() > 0)
+			sLine.assign(li.GetLine(), li.Length());
+		else
+			sLine.clear();
+
+		if (pTempFileStats)
+			EscapeControlChars(sLine);
+		// last real line ?
+		if (line == nLastRealLine || nLastRealLine == -1)
+		{
+			// last real line is never EOL terminated
+			assert(!li.HasEol());
+			// write the line and exit loop
+			write(sLine);
+			break;
+		}
+
+		// normal real line : append an EOL, either the EOL of the line
+		// (when preserve original EOL chars is on) or the default EOL
+		// for this file
+		LPCTSTR pszLineEol = pszEol ? pszEol : (li.HasEol() ? li.GetEol() : _T(""));
+		sLine += pszLineEol;
+		if (pTempFileStats)
+		{
+			if (pszLineEol[0] == '\r' && pszLineEol[1] == '\n')
+				++pTempFileStats->ncrlfs;
+			else if (pszLineEol[0] == '\r')
+				++pTempFileStats->ncrs;
+			else if (pszLineEol[0] == '\n')
+				++pTempFileStats->nlfs;
+		}
+
+		write(sLine);
+	}
+}
+
+}
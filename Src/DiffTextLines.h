@@ -0,0 +1,27 @@
+/**
+ * @file  DiffTextLines.h
+ *
+ * @brief Declaration of functions writing out the lines of a diff text buffer.
+ */
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include <functional>
+#include "LineInfo.h"
+#include "UnicodeString.h"
+
+struct FileTextStats;
+
+/**
+ * @brief Writing out the real lines of CDiffTextBuffer.
+ * These work on the lines only, so the files saved and the texts compared
+ * in the background are the same ones the tests check.
+ */
+namespace DiffTextLines
+{
+void EscapeControlChars(String &s);
+void WriteRealLines(const std::vector<LineInfo> &aLines, int nStartLine, int nLines,
+	int nLastRealLine, DWORD dwSkipFlags, LPCTSTR pszEol, FileTextStats *pTempFileStats,
+	const std::function<void(const String&)>& write);
+}
@@ -199,8 +199,14 @@ static void DiffThreadCompare(void *pParam)
 	if (myStruct->bOnlyRequested)
 		DirScan_CompareRequestedItems(myStruct, 0);
 	else
+	{
 		DirScan_CompareItems(myStruct, 0);
 
+		// Link unique files renamed or moved to another folder
+		if (myStruct->context->m_bDetectMovedFiles && !myStruct->context->ShouldAbort())
+			DirScan_DetectMovedItems(myStruct);
+	}
+
 	myStruct->context->m_pCompareStats->SetCompareState(CompareStats::STATE_IDLE);
 
 	// Send message to UI to update
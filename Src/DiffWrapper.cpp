@@ -87,6 +87,7 @@ CDiffWrapper::CDiffWrapper()
 , m_bPathsAreTemp(false)
 , m_pFilterList(nullptr)
 , m_bPluginsEnabled(false)
+, m_bTextStatsKnown(false)
 {
 	memset(&m_status, 0, sizeof(DIFFSTATUS));
 
@@ -322,15 +323,19 @@ bool CDiffWrapper::IsTrivialLine(const std::string &Line,
  * @param [in] target				- string to search
  * @param [in] marker				- marker to search for
  * @return Returns position of marker, or NULL if none is present
+ * @note An empty marker matches at the start of any non-empty string.
  */
-static const char *FindCommentMarker(const char *target, const char *marker)
+static const char *FindCommentMarker(const char *target, const std::string& marker)
 {
+	if (marker.empty())
+		return *target ? target : NULL;
+	const char first = marker[0];
+	const size_t marker_len = marker.size();
 	char prev = '\0';
 	char quote = '\0';
-	size_t marker_len = strlen(marker);
 	while (char c = *target)
 	{
-		if (quote == '\0' && strncmp(target, marker, marker_len) == 0)
+		if (quote == '\0' && c == first && strncmp(target, marker.c_str(), marker_len) == 0)
 			return target;
 		if ((prev != '\\') &&
 			(c == '"' || c == '\'') &&
@@ -378,7 +383,7 @@ static void ReplaceSpaces(std::string & str, const char *rep)
 */
 bool CDiffWrapper::PostFilter(int StartPos, int EndPos, int Direction,
 	int QtyLinesInBlock, OP_TYPE &Op, int FileNo,
-	FilterCommentsSet& filtercommentsset) const
+	const FilterCommentsSet& filtercommentsset) const
 {
 	if (Op == OP_TRIVIAL) //If already set to trivial, then exit.
 		return true;
@@ -396,9 +401,9 @@ bool CDiffWrapper::PostFilter(int StartPos, int EndPos, int Direction,
 		const char *LineStr = files[FileNo].linbuf[i];
 		std::string LineData(LineStr, linelen(LineStr, len));
 
-		const char * StartOfComment		= FindCommentMarker(LineData.c_str(), filtercommentsset.StartMarker.c_str());
-		const char * EndOfComment		= FindCommentMarker(LineData.c_str(), filtercommentsset.EndMarker.c_str());
-		const char * InLineComment		= FindCommentMarker(LineData.c_str(), filtercommentsset.InlineMarker.c_str());
+		const char * StartOfComment		= FindCommentMarker(LineData.c_str(), filtercommentsset.StartMarker);
+		const char * EndOfComment		= FindCommentMarker(LineData.c_str(), filtercommentsset.EndMarker);
+		const char * InLineComment		= FindCommentMarker(LineData.c_str(), filtercommentsset.InlineMarker);
 		//The following logic determines if the entire block is a comment block, and only marks it as trivial
 		//if all the changes are within a comment block.
 		if (Direction == -1)
@@ -495,22 +500,13 @@ bool CDiffWrapper::PostFilter(int StartPos, int EndPos, int Direction,
 @param [in]  LineNumberRight		- First line number to read from right file
 @param [in]  QtyLinesRight		- Number of lines in the block for right file
 @param [in,out]  Op				- This variable is set to trivial if block should be ignored.
-@param [in]  FileNameExt			- The file name extension.  Needs to be lower case string ("cpp", "java", "c")
+@param [in]  filtercommentsset	- Comment marker set of the file type, from FilterCommentsManager::GetSetForFileType()
 */
 void CDiffWrapper::PostFilter(int LineNumberLeft, int QtyLinesLeft, int LineNumberRight,
-	int QtyLinesRight, OP_TYPE &Op, const String& FileNameExt) const
+	int QtyLinesRight, OP_TYPE &Op, const FilterCommentsSet& filtercommentsset) const
 {
-	if (Op == OP_TRIVIAL || !m_pFilterCommentsManager)
-		return;
-	
-	//First we need to get lowercase file name extension
-	FilterCommentsSet filtercommentsset = m_pFilterCommentsManager->GetSetForFileType(FileNameExt);
-	if (filtercommentsset.StartMarker.empty() && 
-		filtercommentsset.EndMarker.empty() &&
-		filtercommentsset.InlineMarker.empty())
-	{
+	if (Op == OP_TRIVIAL)
 		return;
-	}
 
 	OP_TYPE LeftOp = OP_NONE;
 	OP_TYPE RightOp = OP_NONE;
@@ -568,10 +564,10 @@ void CDiffWrapper::PostFilter(int LineNumberLeft, int QtyLinesLeft, int LineNumb
 				bool bFirstLoop = true;
 				do {
 					//Lets remove block comments, and see if lines are equal
-					CommentStrLeftStart = FindCommentMarker(LineDataLeft.c_str(), filtercommentsset.StartMarker.c_str());
-					CommentStrLeftEnd = FindCommentMarker(LineDataLeft.c_str(), filtercommentsset.EndMarker.c_str());
-					CommentStrRightStart = FindCommentMarker(LineDataRight.c_str(), filtercommentsset.StartMarker.c_str());
-					CommentStrRightEnd = FindCommentMarker(LineDataRight.c_str(), filtercommentsset.EndMarker.c_str());
+					CommentStrLeftStart = FindCommentMarker(LineDataLeft.c_str(), filtercommentsset.StartMarker);
+					CommentStrLeftEnd = FindCommentMarker(LineDataLeft.c_str(), filtercommentsset.EndMarker);
+					CommentStrRightStart = FindCommentMarker(LineDataRight.c_str(), filtercommentsset.StartMarker);
+					CommentStrRightEnd = FindCommentMarker(LineDataRight.c_str(), filtercommentsset.EndMarker);
 					
 					if (CommentStrLeftStart != NULL && CommentStrLeftEnd != NULL && CommentStrLeftStart < CommentStrLeftEnd)
 						LineDataLeft.erase(CommentStrLeftStart - LineDataLeft.c_str(), CommentStrLeftEnd + filtercommentsset.EndMarker.size() - CommentStrLeftStart);
@@ -600,8 +596,8 @@ void CDiffWrapper::PostFilter(int LineNumberLeft, int QtyLinesLeft, int LineNumb
 			if (!filtercommentsset.InlineMarker.empty())
 			{
 				//Lets remove line comments
-				const char * CommentStrLeft = FindCommentMarker(LineDataLeft.c_str(), filtercommentsset.InlineMarker.c_str());
-				const char * CommentStrRight = FindCommentMarker(LineDataRight.c_str(), filtercommentsset.InlineMarker.c_str());
+				const char * CommentStrLeft = FindCommentMarker(LineDataLeft.c_str(), filtercommentsset.InlineMarker);
+				const char * CommentStrRight = FindCommentMarker(LineDataRight.c_str(), filtercommentsset.InlineMarker);
 
 				if (CommentStrLeft != NULL)
 					LineDataLeft.erase(CommentStrLeft - LineDataLeft.c_str());
@@ -654,6 +650,19 @@ void CDiffWrapper::SetPaths(const PathContext &files,
 {
 	m_files = files;
 	m_bPathsAreTemp = tempPaths;
+	m_bTextStatsKnown = false;
+}
+
+/**
+ * @brief Set text stats of the files to compare, when the caller knows them.
+ * The compare then needs not count the EOLs and zeros of the files again.
+ * The stats are forgotten when the paths are set.
+ * @param [in] stats Stats of each file set with SetPaths().
+ */
+void CDiffWrapper::SetTextStats(const FileTextStats stats[])
+{
+	std::copy(stats, stats + m_files.GetSize(), m_textStats);
+	m_bTextStatsKnown = true;
 }
 
 /**
@@ -728,6 +737,10 @@ bool CDiffWrapper::RunFileDiff()
 		}
 	}
 
+	// Prediffing changes the files, and so their text stats
+	bool bTextStatsKnown = m_bTextStatsKnown &&
+		!(m_bPluginsEnabled && !m_infoPrediffer->pluginName.empty());
+
 	struct change *script = NULL;
 	struct change *script10 = NULL;
 	struct change *script12 = NULL;
@@ -742,6 +755,11 @@ bool CDiffWrapper::RunFileDiff()
 		{
 			return false;
 		}
+		if (bTextStatsKnown)
+		{
+			diffdata.SetTextStats(0, m_textStats[0]);
+			diffdata.SetTextStats(1, m_textStats[1]);
+		}
 
 		// Compare the files, if no error was found.
 		// Last param (bin_file) is NULL since we don't
@@ -776,15 +794,29 @@ bool CDiffWrapper::RunFileDiff()
 		{
 			return false;
 		}
+		if (bTextStatsKnown)
+		{
+			diffdata10.SetTextStats(0, m_textStats[1]);
+			diffdata10.SetTextStats(1, m_textStats[0]);
+		}
 
+		// Keep line hashes so Make3wayDiff can compare file 0 and file 2 by them
+		keep_line_hashes = 1;
 		bRet = Diff2Files(&script10, &diffdata10, &bin_flag10, NULL);
 
 		if (!diffdata12.OpenFiles(strFileTemp[1], strFileTemp[2]))
 		{
+			keep_line_hashes = 0;
 			return false;
 		}
+		if (bTextStatsKnown)
+		{
+			diffdata12.SetTextStats(0, m_textStats[1]);
+			diffdata12.SetTextStats(1, m_textStats[2]);
+		}
 
 		bRet = Diff2Files(&script12, &diffdata12, &bin_flag12, NULL);
+		keep_line_hashes = 0;
 	}
 
 	// First determine what happened during comparison
@@ -1186,8 +1218,8 @@ CDiffWrapper::LoadWinMergeDiffsFromDiffUtilsScript(struct change * script, const
 	//Logic needed for Ignore comment option
 	DIFFOPTIONS options;
 	GetOptions(&options);
-	String asLwrCaseExt;
-	if (options.bFilterCommentsLines)
+	const FilterCommentsSet *pFilterCommentsSet = NULL;
+	if (options.bFilterCommentsLines && m_pFilterCommentsManager)
 	{
 		String LowerCaseExt = m_originalFile.GetLeft();
 		String::size_type PosOfDot = LowerCaseExt.rfind('.');
@@ -1195,7 +1227,7 @@ CDiffWrapper::LoadWinMergeDiffsFromDiffUtilsScript(struct change * script, const
 		{
 			LowerCaseExt.erase(0, PosOfDot + 1);
 			std::transform(LowerCaseExt.begin(), LowerCaseExt.end(), LowerCaseExt.begin(), ::tolower);
-			asLwrCaseExt = LowerCaseExt;
+			pFilterCommentsSet = m_pFilterCommentsManager->GetSetForFileType(LowerCaseExt);
 		}
 	}
 
@@ -1261,11 +1293,11 @@ CDiffWrapper::LoadWinMergeDiffsFromDiffUtilsScript(struct change * script, const
 					}
 				}
 
-				if (options.bFilterCommentsLines)
+				if (pFilterCommentsSet)
 				{
 					int QtyLinesLeft = (trans_b0 - trans_a0) + 1; //Determine quantity of lines in this block for left side
 					int QtyLinesRight = (trans_b1 - trans_a1) + 1;//Determine quantity of lines in this block for right side
-					PostFilter(thisob->line0, QtyLinesLeft, thisob->line1, QtyLinesRight, op, asLwrCaseExt);
+					PostFilter(thisob->line0, QtyLinesLeft, thisob->line1, QtyLinesRight, op, *pFilterCommentsSet);
 				}
 
 				if (m_pFilterList && m_pFilterList->HasRegExps())
@@ -1294,6 +1326,15 @@ CDiffWrapper::LoadWinMergeDiffsFromDiffUtilsScript(struct change * script, const
 	}
 }
 
+/**
+ * @brief Compare the lines of file 0 and file 2 in a three-way diff block.
+ *
+ * File 0 and file 2 were hashed by different compares (file 1 vs 0 and file 1
+ * vs 2), so their equivalence codes are not comparable, but their line hashes
+ * are when both compares kept them. Different hashes mean different lines, so
+ * most blocks are decided without touching the text. Equal hashes and lines
+ * in the identical prefix or suffix, which are not hashed, are compared by text.
+ */
 struct Comp02Functor
 {
 	Comp02Functor(const file_data * inf10, const file_data * inf12) :
@@ -1308,8 +1349,20 @@ struct Comp02Functor
 		int line2end = dr3.end[2];
 		if (line0end - line0 != line2end - line2)
 			return false;
-		const char **linbuf0 = inf10_[1].linbuf + inf10_[1].linbuf_base;
-		const char **linbuf2 = inf12_[1].linbuf + inf12_[1].linbuf_base;
+		const file_data &file0 = inf10_[1];
+		const file_data &file2 = inf12_[1];
+		if (file0.line_hashes != NULL && file2.line_hashes != NULL)
+		{
+			for (int i = 0; i < line0end - line0 + 1; ++i)
+			{
+				const unsigned *hash0 = LineHash(file0, line0 + i);
+				const unsigned *hash2 = LineHash(file2, line2 + i);
+				if (hash0 != NULL && hash2 != NULL && *hash0 != *hash2)
+					return false;
+			}
+		}
+		const char **linbuf0 = file0.linbuf + file0.linbuf_base;
+		const char **linbuf2 = file2.linbuf + file2.linbuf_base;
 		for (int i = 0; i < line0end - line0 + 1; ++i)
 		{
 			const size_t line0len = linbuf0[line0 + i + 1] - linbuf0[line0 + i];
@@ -1319,6 +1372,14 @@ struct Comp02Functor
 		}
 		return true;
 	}
+	/** @brief Return hash of a line, or NULL if the line was not hashed. */
+	static const unsigned *LineHash(const file_data &file, int line)
+	{
+		int hashed = line - file.prefix_lines;
+		if (hashed < 0 || hashed >= file.buffered_lines)
+			return NULL;
+		return &file.line_hashes[hashed];
+	}
 	const file_data *inf10_;
 	const file_data *inf12_;
 };
@@ -29,6 +29,7 @@
 #include "PathContext.h"
 #include "CompareOptions.h"
 #include "DiffList.h"
+#include "FileTextStats.h"
 #include "UnicodeString.h"
 
 class CDiffContext;
@@ -182,6 +183,7 @@ public:
 	void SetPaths(const PathContext &files, bool tempPaths);
 	void SetAlternativePaths(const PathContext &altPaths);
 	void SetCodepage(int codepage) { m_codepage = codepage; }
+	void SetTextStats(const FileTextStats stats[]);
 	bool RunFileDiff();
 	void GetDiffStatus(DIFFSTATUS *status) const;
 	void AddDiffRange(DiffList *pDiffList, unsigned begin0, unsigned end0, unsigned begin1, unsigned end1, OP_TYPE op);
@@ -201,9 +203,9 @@ public:
 	   const FilterCommentsSet& filtercommentsset) const;
 	bool PostFilter(int StartPos, int EndPos, int Direction,
 		int QtyLinesInBlock, OP_TYPE &Op, int FileNo,
-		FilterCommentsSet& filtercommentsset) const;
+		const FilterCommentsSet& filtercommentsset) const;
 	void PostFilter(int LineNumberLeft, int QtyLinesLeft, int LineNumberRight,
-		int QtyLinesRight, OP_TYPE &Op, const String& FileNameExt) const;
+		int QtyLinesRight, OP_TYPE &Op, const FilterCommentsSet& filtercommentsset) const;
 
 protected:
 	String FormatSwitchString() const;
@@ -242,4 +244,6 @@ private:
 	std::unique_ptr<MovedLines> m_pMovedLines[3];
 	const FilterCommentsManager* m_pFilterCommentsManager; /**< Comments filtering manager */
 	bool m_bPluginsEnabled; /**< Are plugins enabled? */
+	bool m_bTextStatsKnown; /**< Are text stats of compared files known? */
+	FileTextStats m_textStats[3]; /**< Known text stats of compared files */
 };
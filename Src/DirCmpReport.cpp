@@ -10,10 +10,12 @@
 #include <cassert>
 #include <sstream>
 #include <algorithm>
+#include <memory>
 #include <Poco/Base64Encoder.h>
 #include "locality.h"
 #include "DirCmpReport.h"
 #include "DirCmpReportDlg.h"
+#include "DirCmpReportRows.h"
 #include "paths.h"
 #include "unicoder.h"
 #include "IListCtrl.h"
@@ -61,6 +63,7 @@ static String EndEl(const String& elName)
  */
 DirCmpReport::DirCmpReport(const std::vector<String> & colRegKeys)
 : m_pList(NULL)
+, m_pRows(NULL)
 , m_pFile(NULL)
 , m_nColumns(0)
 , m_colRegKeys(colRegKeys)
@@ -114,6 +117,7 @@ static ULONG GetLength32(CFile const &f)
 }
 /**
  * @brief Generate report and save it to file.
+ * The listview must have been set with SetList().
  * @param [out] errStr Empty if succeeded, otherwise contains error message.
  * @return TRUE if report was created, FALSE if user canceled report.
  */
@@ -127,9 +131,15 @@ bool DirCmpReport::GenerateReport(String &errStr)
 	dlg.LoadSettings();
 	dlg.m_sReportFile = m_sReportFile;
 
+	std::unique_ptr<DirCmpReportRows> pListRows;
 	if (!m_sReportFile.empty() || dlg.DoModal() == IDOK) try
 	{
 		CWaitCursor waitstatus;
+		if (m_pRows == NULL)
+		{
+			pListRows.reset(new DirCmpReportRows(m_pList, m_nColumns, m_colRegKeys));
+			m_pRows = pListRows.get();
+		}
 		if (dlg.m_bCopyToClipboard)
 		{
 			if (!CWnd::GetSafeOwner()->OpenClipboard())
@@ -196,6 +206,8 @@ bool DirCmpReport::GenerateReport(String &errStr)
 		e->ReportError(MB_ICONSTOP);
 		e->Delete();
 	}
+	if (pListRows)
+		m_pRows = NULL;
 	m_pFile = NULL;
 	return bRet;
 }
@@ -206,6 +218,7 @@ bool DirCmpReport::GenerateReport(String &errStr)
  */
 void DirCmpReport::GenerateReport(REPORT_TYPE nReportType)
 {
+	m_pRows->SetReportType(nReportType);
 	switch (nReportType)
 	{
 	case REPORT_TYPE_SIMPLEHTML:
@@ -266,7 +279,7 @@ void DirCmpReport::GenerateHeader()
 	WriteString(_T("\n"));
 	for (int currCol = 0; currCol < m_nColumns; currCol++)
 	{
-		WriteString(m_pList->GetColumnName(currCol));
+		WriteString(m_pRows->GetColumnName(currCol));
 		// Add col-separator, but not after last column
 		if (currCol < m_nColumns - 1)
 			WriteString(m_sSeparator);
@@ -278,29 +291,8 @@ void DirCmpReport::GenerateHeader()
  */
 void DirCmpReport::GenerateContent()
 {
-	int nRows = m_pList->GetRowCount();
-
 	// Report:Detail. All currently displayed columns will be added
-	for (int currRow = 0; currRow < nRows; currRow++)
-	{
-		WriteString(_T("\n"));
-		for (int currCol = 0; currCol < m_nColumns; currCol++)
-		{
-			String value = m_pList->GetItemText(currRow, currCol);
-			if (value.find(m_sSeparator) != String::npos) {
-				WriteString(_T("\""));
-				WriteString(value);
-				WriteString(_T("\""));
-			}
-			else
-				WriteString(value);
-
-			// Add col-separator, but not after last column
-			if (currCol < m_nColumns - 1)
-				WriteString(m_sSeparator);
-		}
-	}
-
+	m_pRows->WriteRows([this](const String& text) { WriteString(text); });
 }
 
 /**
@@ -344,10 +336,12 @@ void DirCmpReport::GenerateHTMLHeader()
 
 	std::vector<bool> usedIcon(m_pList->GetIconCount());
 	int maxIndent = 0;
-	for (int i = 0; i < m_pList->GetRowCount(); ++i)
+	for (size_t i = 0; i < m_pRows->GetRowCount(); ++i)
 	{
-		usedIcon[m_pList->GetIconIndex(i)] = true;
-		maxIndent = (std::max)(m_pList->GetIndent(i), maxIndent);
+		const DirCmpReportRows::Row& row = m_pRows->GetRow(i);
+		if (row.nIconIndex >= 0 && row.nIconIndex < static_cast<int>(usedIcon.size()))
+			usedIcon[row.nIconIndex] = true;
+		maxIndent = (std::max)(row.nIndent, maxIndent);
 	}
 	for (int i = 0; i < m_pList->GetIconCount(); ++i)
 	{
@@ -383,7 +377,7 @@ void DirCmpReport::GenerateHTMLHeaderBodyPortion()
 	for (int currCol = 0; currCol < m_nColumns; currCol++)
 	{
 		WriteString(_T("<th>"));
-		WriteString(m_pList->GetColumnName(currCol));
+		WriteString(m_pRows->GetColumnName(currCol));
 		WriteString(_T("</th>"));
 	}
 	WriteString(_T("</tr>\n"));
@@ -407,7 +401,7 @@ void DirCmpReport::GenerateXmlHeader()
 	{
 		const String colEl = m_colRegKeys[currCol];
 		WriteString(BeginEl(colEl));
-		WriteString(m_pList->GetColumnName(currCol));
+		WriteString(m_pRows->GetColumnName(currCol));
 		WriteString(EndEl(colEl));
 	}
 	WriteString(EndEl(rowEl) + _T("\n"));
@@ -425,61 +419,21 @@ void DirCmpReport::GenerateXmlHtmlContent(bool xml)
 	if (!xml && m_bIncludeFileCmpReport && m_pFileCmpReport)
 		paths::CreateIfNeeded(sDestDir);
 
-	int nRows = m_pList->GetRowCount();
-
-	// Report:Detail. All currently displayed columns will be added
-	for (int currRow = 0; currRow < nRows; currRow++)
+	// Reports of the linked files are generated one by one, they open
+	// file compare windows
+	if (!xml && m_bIncludeFileCmpReport && m_pFileCmpReport)
 	{
-		String sLinkPath;
-		if (!xml && m_bIncludeFileCmpReport && m_pFileCmpReport)
-			(*m_pFileCmpReport)(REPORT_TYPE_SIMPLEHTML, m_pList, currRow, sDestDir, sLinkPath);
-
-		String rowEl = _T("tr");
-		if (xml)
+		for (size_t currRow = 0; currRow < m_pRows->GetRowCount(); currRow++)
 		{
-			rowEl = _T("filediff");
-			WriteString(BeginEl(rowEl));
+			DirCmpReportRows::Row& row = m_pRows->GetRow(currRow);
+			(*m_pFileCmpReport)(REPORT_TYPE_SIMPLEHTML, m_pList, static_cast<int>(currRow), sDestDir, row.sLinkPath);
 		}
-		else
-		{
-			COLORREF color = m_pList->GetBackColor(currRow);
-			String attr = string_format(_T("style='background-color: #%02x%02x%02x'"),
-				GetRValue(color), GetGValue(color), GetBValue(color));
-			WriteString(BeginEl(rowEl, attr));
-		}
-		for (int currCol = 0; currCol < m_nColumns; currCol++)
-		{
-			String colEl = _T("td");
-			if (xml)
-			{
-				colEl = m_colRegKeys[currCol];
-				WriteString(BeginEl(colEl));
-			}
-			else
-			{
-				if (currCol == 0)
-					WriteString(BeginEl(colEl, string_format(_T("class=\"icon%d indent%d\""), m_pList->GetIconIndex(currRow), m_pList->GetIndent(currRow))));
-				else
-					WriteString(BeginEl(colEl));
-			}
-			if (currCol == 0 && !sLinkPath.empty())
-			{
-				WriteString(_T("<a href=\""));
-				WriteString(sRelDestDir);
-				WriteString(_T("/"));
-				WriteString(sLinkPath);
-				WriteString(_T("\">"));
-				WriteString(m_pList->GetItemText(currRow, currCol));
-				WriteString(_T("</a>"));
-			}
-			else
-			{
-				WriteString(m_pList->GetItemText(currRow, currCol));
-			}
-			WriteString(EndEl(colEl));
-		}
-		WriteString(EndEl(rowEl) + _T("\n"));
+		m_pRows->SetLinkDir(sRelDestDir);
 	}
+
+	// Report:Detail. All currently displayed columns will be added
+	m_pRows->SetReportType(xml ? REPORT_TYPE_SIMPLEXML : REPORT_TYPE_SIMPLEHTML);
+	m_pRows->WriteRows([this](const String& text) { WriteString(text); });
 	if (!xml)
 		WriteString(_T("</table>\n</div>\n"));
 }
@@ -12,18 +12,21 @@
 #include "DirReportTypes.h"
 
 struct IListCtrl;
+class DirCmpReportRows;
 
 /**
  * @brief This class creates directory compare reports.
  *
- * This class creates a directory compare report. To make things easier
- * we read data from view's listview. Reading from listview avoids
- * re-formatting data and complex GUI for selecting what info to show in
- * reports. Downside is we only have data that is visible in GUI.
+ * This class creates a directory compare report. The rows are given as
+ * DirCmpReportRows, which formats the cells from the DIFFITEMs the same
+ * way the folder compare view does. Without the rows they are read from
+ * the view's listview. The listview is still used for the row icons and
+ * for linking the file compare reports.
  *
- * @todo We should read DIFFITEMs from CDirDoc and format data to better
- * fit for reporting. Duplicating formatting and sorting code should be
- * avoided.
+ * A listview is always needed, so reports are generated only from a
+ * folder compare view. The rows are the ones the view shows, in its sort
+ * order, and a report file given on the command line is generated by the
+ * view when the compare completes, also with -noninteractive.
  */
 
 struct IFileCmpReport
@@ -37,6 +40,7 @@ public:
 
 	explicit DirCmpReport(const std::vector<String>& colRegKeys);
 	void SetList(IListCtrl *pList);
+	void SetRows(DirCmpReportRows *pRows) { m_pRows = pRows; }
 	void SetRootPaths(const PathContext &paths);
 	void SetReportFile(const String& sReportFile) { m_sReportFile = sReportFile; }
 	void SetColumns(int columns);
@@ -57,6 +61,7 @@ protected:
 
 private:
 	IListCtrl * m_pList; /**< Pointer to UI-list */
+	DirCmpReportRows * m_pRows; /**< Rows of the report */
 	PathContext m_rootPaths; /**< Root paths, printed to report */
 	String m_sTitle; /**< Report title, built from root paths */
 	String m_sReportFile;
@@ -0,0 +1,255 @@
+/**
+ * @file  DirCmpReportRows.cpp
+ *
+ * @brief Implementation file for DirCmpReportRows
+ *
+ */
+
+#include "DirCmpReportRows.h"
+#include <cassert>
+#include <memory>
+#include <Poco/ThreadPool.h>
+#include <Poco/Runnable.h>
+#include <Poco/Environment.h>
+#include "DiffContext.h"
+#include "DiffItem.h"
+#include "DirViewColItems.h"
+#include "IListCtrl.h"
+
+using Poco::ThreadPool;
+using Poco::Runnable;
+using Poco::Environment;
+
+namespace
+{
+
+/**
+ * @brief Formats a chunk of rows in a worker thread.
+ */
+class ChunkFormatter : public Runnable
+{
+public:
+	ChunkFormatter(const DirCmpReportRows& rows, size_t nBegin, size_t nEnd)
+		: m_rows(rows), m_nBegin(nBegin), m_nEnd(nEnd) {}
+
+	void run()
+	{
+		m_rows.FormatRows(m_nBegin, m_nEnd, m_text);
+	}
+
+	const String& text() const { return m_text; }
+
+private:
+	const DirCmpReportRows& m_rows;
+	size_t m_nBegin;
+	size_t m_nEnd;
+	String m_text;
+};
+
+}
+
+/**
+ * @brief Constructor for rows formatted from the compare results.
+ * @param [in] pCtxt Compare context of the items.
+ * @param [in] pColItems Columns displayed in the folder compare view.
+ * @param [in] colRegKeys Key names of the displayed columns, for XML reports.
+ */
+DirCmpReportRows::DirCmpReportRows(const CDiffContext *pCtxt, const DirViewColItems *pColItems, const std::vector<String>& colRegKeys)
+: m_pCtxt(pCtxt)
+, m_pColItems(pColItems)
+, m_pList(NULL)
+, m_nColumns(pColItems->GetDispColCount())
+, m_colRegKeys(colRegKeys)
+, m_nReportType(REPORT_TYPE_COMMALIST)
+, m_sSeparator(_T(","))
+{
+}
+
+/**
+ * @brief Constructor for rows read from a list control.
+ * @param [in] pList List control showing the rows.
+ * @param [in] nColumns Number of columns in the list control.
+ * @param [in] colRegKeys Key names of the displayed columns, for XML reports.
+ */
+DirCmpReportRows::DirCmpReportRows(const IListCtrl *pList, int nColumns, const std::vector<String>& colRegKeys)
+: m_pCtxt(NULL)
+, m_pColItems(NULL)
+, m_pList(pList)
+, m_nColumns(nColumns)
+, m_colRegKeys(colRegKeys)
+, m_nReportType(REPORT_TYPE_COMMALIST)
+, m_sSeparator(_T(","))
+{
+	int nRows = pList->GetRowCount();
+	m_rows.reserve(nRows);
+	for (int i = 0; i < nRows; ++i)
+		AddRow(NULL, pList->GetIndent(i), pList->GetIconIndex(i), pList->GetBackColor(i));
+}
+
+/**
+ * @brief Set the type of report the rows are formatted for.
+ */
+void DirCmpReportRows::SetReportType(REPORT_TYPE nReportType)
+{
+	m_nReportType = nReportType;
+	m_sSeparator = (nReportType == REPORT_TYPE_TABLIST) ? _T("\t") : _T(",");
+}
+
+/**
+ * @brief Add a row after the previously added rows.
+ * @param [in] pdi Item shown in the row, NULL for the parent folder item.
+ */
+void DirCmpReportRows::AddRow(const DIFFITEM *pdi, int nIndent, int nIconIndex, COLORREF clrBk)
+{
+	Row row = { pdi, nIndent, nIconIndex, clrBk };
+	m_rows.push_back(row);
+}
+
+/**
+ * @brief Return the header text of a displayed column.
+ */
+String DirCmpReportRows::GetColumnName(int nCol) const
+{
+	if (m_pList)
+		return m_pList->GetColumnName(nCol);
+	return m_pColItems->GetColDisplayName(m_pColItems->ColPhysToLog(nCol));
+}
+
+/**
+ * @brief Return the text of a cell, as shown in the folder compare view.
+ * @param [in] nRow Index of the row.
+ * @param [in] nCol Index of the displayed column.
+ */
+String DirCmpReportRows::GetCellText(size_t nRow, int nCol) const
+{
+	if (m_pList)
+		return m_pList->GetItemText(static_cast<int>(nRow), nCol);
+	int nLogCol = m_pColItems->ColPhysToLog(nCol);
+	const DIFFITEM *pdi = m_rows[nRow].pdi;
+	if (pdi == NULL)
+		return m_pColItems->IsColName(nLogCol) ? _T("..") : _T("");
+	return m_pColItems->ColGetTextToDisplay(m_pCtxt, nLogCol, *pdi);
+}
+
+/**
+ * @brief Format a row of a comma or tab separated report.
+ */
+void DirCmpReportRows::FormatListRow(const Row& row, size_t nRow, String& text) const
+{
+	text += _T("\n");
+	for (int nCol = 0; nCol < m_nColumns; ++nCol)
+	{
+		String value = GetCellText(nRow, nCol);
+		if (value.find(m_sSeparator) != String::npos)
+		{
+			text += _T("\"");
+			text += value;
+			text += _T("\"");
+		}
+		else
+			text += value;
+
+		// Add col-separator, but not after last column
+		if (nCol < m_nColumns - 1)
+			text += m_sSeparator;
+	}
+}
+
+/**
+ * @brief Format a row of a simple HTML or XML report.
+ */
+void DirCmpReportRows::FormatXmlHtmlRow(const Row& row, size_t nRow, String& text) const
+{
+	const bool xml = (m_nReportType == REPORT_TYPE_SIMPLEXML);
+	if (xml)
+		text += _T("<filediff>");
+	else
+		text += string_format(_T("<tr style='background-color: #%02x%02x%02x'>"),
+			GetRValue(row.clrBk), GetGValue(row.clrBk), GetBValue(row.clrBk));
+	for (int nCol = 0; nCol < m_nColumns; ++nCol)
+	{
+		if (xml)
+			text += _T("<") + m_colRegKeys[nCol] + _T(">");
+		else if (nCol == 0)
+			text += string_format(_T("<td class=\"icon%d indent%d\">"), row.nIconIndex, row.nIndent);
+		else
+			text += _T("<td>");
+		if (nCol == 0 && !xml && !row.sLinkPath.empty())
+		{
+			text += _T("<a href=\"");
+			text += m_sLinkDir;
+			text += _T("/");
+			text += row.sLinkPath;
+			text += _T("\">");
+			text += GetCellText(nRow, nCol);
+			text += _T("</a>");
+		}
+		else
+		{
+			text += GetCellText(nRow, nCol);
+		}
+		if (xml)
+			text += _T("</") + m_colRegKeys[nCol] + _T(">");
+		else
+			text += _T("</td>");
+	}
+	text += xml ? _T("</filediff>\n") : _T("</tr>\n");
+}
+
+/**
+ * @brief Format rows [nBegin, nEnd) and append them to the text.
+ */
+void DirCmpReportRows::FormatRows(size_t nBegin, size_t nEnd, String& text) const
+{
+	assert(nBegin <= nEnd && nEnd <= m_rows.size());
+	for (size_t nRow = nBegin; nRow < nEnd; ++nRow)
+	{
+		if (m_nReportType == REPORT_TYPE_SIMPLEHTML || m_nReportType == REPORT_TYPE_SIMPLEXML)
+			FormatXmlHtmlRow(m_rows[nRow], nRow, text);
+		else
+			FormatListRow(m_rows[nRow], nRow, text);
+	}
+}
+
+/**
+ * @brief Format all rows and give the text to the writer in order.
+ * Chunks of rows are formatted by worker threads, one batch of chunks at
+ * a time, so only the text of the current batch is kept in memory. The
+ * writer is called in the calling thread. Rows read from a list control
+ * are formatted in the calling thread.
+ * @param [in] writer Function writing the formatted text.
+ * @param [in] nThreads Number of worker threads, 0 for one per processor.
+ */
+void DirCmpReportRows::WriteRows(const std::function<void(const String&)>& writer, unsigned nThreads) const
+{
+	if (nThreads == 0)
+		nThreads = Environment::processorCount();
+	const size_t nRows = GetRowCount();
+	const size_t nChunks = (nRows + RowsPerChunk - 1) / RowsPerChunk;
+	if (m_pList || nThreads <= 1 || nChunks <= 1)
+	{
+		for (size_t nChunk = 0; nChunk < nChunks; ++nChunk)
+		{
+			ChunkFormatter formatter(*this, nChunk * RowsPerChunk, (std::min)(nRows, (nChunk + 1) * RowsPerChunk));
+			formatter.run();
+			writer(formatter.text());
+		}
+		return;
+	}
+
+	ThreadPool threadPool(1, nThreads);
+	for (size_t nBatch = 0; nBatch < nChunks; nBatch += nThreads)
+	{
+		size_t nBatchEnd = (std::min)(nChunks, nBatch + nThreads);
+		std::vector<std::unique_ptr<ChunkFormatter>> formatters;
+		for (size_t nChunk = nBatch; nChunk < nBatchEnd; ++nChunk)
+		{
+			formatters.push_back(std::unique_ptr<ChunkFormatter>(
+				new ChunkFormatter(*this, nChunk * RowsPerChunk, (std::min)(nRows, (nChunk + 1) * RowsPerChunk))));
+			threadPool.start(*formatters.back());
+		}
+		threadPool.joinAll();
+		for (size_t i = 0; i < formatters.size(); ++i)
+			writer(formatters[i]->text());
+	}
+}
@@ -0,0 +1,75 @@
+/**
+ * @file  DirCmpReportRows.h
+ *
+ * @brief Declaration file for DirCmpReportRows.
+ *
+ */
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include <functional>
+#include "UnicodeString.h"
+#include "DirReportTypes.h"
+
+struct IListCtrl;
+struct DIFFITEM;
+class CDiffContext;
+class DirViewColItems;
+
+/**
+ * @brief Formats the rows of a folder compare report.
+ *
+ * Rows are added in the order of the folder compare view, each one with
+ * the DIFFITEM it shows. Cell texts are formatted from the DIFFITEMs with
+ * DirViewColItems just like the view does, so formatting does not need
+ * the list control and is done in chunks by worker threads. The formatted
+ * chunks are given to the writer in order.
+ *
+ * Rows can also be read from a list control, then the cell texts are
+ * read from it in the calling thread.
+ */
+class DirCmpReportRows
+{
+public:
+	/** @brief One row of the report */
+	struct Row
+	{
+		const DIFFITEM *pdi; /**< Item of the row, NULL for the parent folder item */
+		int nIndent; /**< Indent level of the row */
+		int nIconIndex; /**< Index of the row icon */
+		COLORREF clrBk; /**< Background color of the row */
+		String sLinkPath; /**< Path of the file compare report, empty if none */
+	};
+
+	DirCmpReportRows(const CDiffContext *pCtxt, const DirViewColItems *pColItems, const std::vector<String>& colRegKeys);
+	DirCmpReportRows(const IListCtrl *pList, int nColumns, const std::vector<String>& colRegKeys);
+
+	void SetReportType(REPORT_TYPE nReportType);
+	void SetLinkDir(const String& sLinkDir) { m_sLinkDir = sLinkDir; }
+	void AddRow(const DIFFITEM *pdi, int nIndent, int nIconIndex, COLORREF clrBk);
+	size_t GetRowCount() const { return m_rows.size(); }
+	Row& GetRow(size_t nRow) { return m_rows[nRow]; }
+	const Row& GetRow(size_t nRow) const { return m_rows[nRow]; }
+	int GetColumnCount() const { return m_nColumns; }
+	String GetColumnName(int nCol) const;
+	String GetCellText(size_t nRow, int nCol) const;
+	void FormatRows(size_t nBegin, size_t nEnd, String& text) const;
+	void WriteRows(const std::function<void(const String&)>& writer, unsigned nThreads = 0) const;
+
+	static const size_t RowsPerChunk = 4096; /**< Rows formatted by a worker at once */
+
+private:
+	void FormatListRow(const Row& row, size_t nRow, String& text) const;
+	void FormatXmlHtmlRow(const Row& row, size_t nRow, String& text) const;
+
+	const CDiffContext *m_pCtxt;
+	const DirViewColItems *m_pColItems;
+	const IListCtrl *m_pList; /**< List control to read the cells from, or NULL */
+	int m_nColumns; /**< Number of displayed columns */
+	const std::vector<String>& m_colRegKeys; /**< Key names for currently displayed columns */
+	REPORT_TYPE m_nReportType;
+	String m_sSeparator; /**< Column separator for list reports */
+	String m_sLinkDir; /**< Folder of the file compare reports, relative to the report */
+	std::vector<Row> m_rows;
+};
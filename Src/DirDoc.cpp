@@ -230,10 +230,13 @@ void CDirDoc::Rescan()
 	m_pCompareStats->Reset();
 	m_pDirView->StartCompare(m_pCompareStats.get());
 
-	m_pDirView->DeleteAllDisplayItems();
-	// Don't clear if only scanning selected items
+	// Don't clear if only scanning selected items, their rows are
+	// repositioned when the compare is ready
 	if (!m_bMarkedRescan)
+	{
+		m_pDirView->DeleteAllDisplayItems();
 		m_pCtxt->RemoveAll();
+	}
 
 	LoadLineFilterList();
 
@@ -252,6 +255,7 @@ void CDirDoc::Rescan()
 	m_pCtxt->m_bWalkUniques = GetOptionsMgr()->GetBool(OPT_CMP_WALK_UNIQUE_DIRS);
 	m_pCtxt->m_bIgnoreReparsePoints = GetOptionsMgr()->GetBool(OPT_CMP_IGNORE_REPARSE_POINTS);
 	m_pCtxt->m_bIgnoreCodepage = GetOptionsMgr()->GetBool(OPT_CMP_IGNORE_CODEPAGE);
+	m_pCtxt->m_bDetectMovedFiles = GetOptionsMgr()->GetBool(OPT_CMP_DETECT_MOVED_FILES);
 	m_pCtxt->m_pCompareStats = m_pCompareStats.get();
 
 	// Set total items count since we don't collect items
@@ -328,11 +332,20 @@ void CDirDoc::ReloadItemStatus(uintptr_t diffPos, int idx)
 	// in case just copied (into existence) or modified
 	m_pCtxt->UpdateStatusFromDisk(diffPos, idx);
 
+	RepositionItem(diffPos);
+}
+
+/**
+ * @brief Update the row of an item after its status changed.
+ * @param [in] diffPos POSITION of item in UI list.
+ */
+void CDirDoc::RepositionItem(uintptr_t diffPos)
+{
 	int nIdx = m_pDirView->GetItemIndex(diffPos);
 	if (nIdx != -1)
 	{
-		// Update view
-		m_pDirView->UpdateDiffItemStatus(nIdx);
+		// Update view, the new status may move the row
+		m_pDirView->RepositionItems(std::vector<uintptr_t>(1, diffPos));
 	}
 }
 
@@ -443,7 +456,8 @@ void CDirDoc::UpdateChangedItem(PathContext &paths,
 		if (nDiffs != -1 && nTrivialDiffs != -1)
 			m_pCtxt->SetDiffCounts(pos, nDiffs, nTrivialDiffs);
 		for (int i = 0; i < m_pCtxt->GetCompareDirs(); ++i)
-			ReloadItemStatus(pos, i);
+			m_pCtxt->UpdateStatusFromDisk(pos, i);
+		RepositionItem(pos);
 	}
 }
 
@@ -118,6 +118,7 @@ public:
 
 protected:
 	void LoadLineFilterList();
+	void RepositionItem(uintptr_t diffPos);
 
 	// Generated message map functions
 	//{{AFX_MSG(CDirDoc)
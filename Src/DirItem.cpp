@@ -21,6 +21,7 @@
  */
 
 #include "DirItem.h"
+#include <cstdint>
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -90,6 +91,21 @@ bool DirItem::Update(const String &sFilePath)
 
 	if (!sFilePath.empty())
 	{
+#ifdef _WIN32
+		// One lookup of the path gets all the information
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (GetFileAttributesEx(sFilePath.c_str(), GetFileExInfoStandard, &data))
+		{
+			DirItem found;
+			found.ctime = Poco::Timestamp::fromFileTimeNP(data.ftCreationTime.dwLowDateTime, data.ftCreationTime.dwHighDateTime);
+			found.mtime = Poco::Timestamp::fromFileTimeNP(data.ftLastWriteTime.dwLowDateTime, data.ftLastWriteTime.dwHighDateTime);
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				found.size = ((int64_t)data.nFileSizeHigh << 32) + data.nFileSizeLow;
+			found.flags.attributes = data.dwFileAttributes;
+			UpdateFromListing(found);
+			retVal = true;
+		}
+#else
 		try
 		{
 			TFile file(sFilePath);
@@ -105,19 +121,33 @@ bool DirItem::Update(const String &sFilePath)
 			if (!file.isDirectory())
 				size = file.getSize();
 
-#ifdef _WIN32
-			flags.attributes = GetFileAttributes(sFilePath.c_str());
-#endif
-
 			retVal = true;
 		}
 		catch (...)
 		{
 		}
+#endif
 	}
 	return retVal;
 }
 
+/**
+ * @brief Update fileinfo from an item found by listing its folder.
+ * Sets the same information as Update() does. Function does not set
+ * filename and path.
+ * @param [in] found Item found by LoadFiles().
+ */
+void DirItem::UpdateFromListing(const DirItem &found)
+{
+	mtime = found.mtime;
+	// There can be files without modification date.
+	// Then we must use creation date.
+	if (mtime == 0)
+		mtime = found.ctime;
+	size = found.size;
+	flags = found.flags;
+}
+
 /**
  * @brief Clears FileInfo data.
  */
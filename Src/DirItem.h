@@ -29,8 +29,20 @@
 #include <Poco/File.h>
 #include <Poco/Timestamp.h>
 #include <boost/flyweight.hpp>
+#include <boost/functional/hash.hpp>
 #include "UnicodeString.h"
 #include "FileVersion.h"
+#include "MemoryStats.h"
+
+/**
+ * @brief File or folder name stored once for all items having it.
+ * The factory holding the names is counted to the memory stats. Characters
+ * of names too long for the small string buffer of String are allocated by
+ * the String itself and are not counted.
+ */
+typedef boost::flyweight<String,
+	boost::flyweights::hashed_factory<boost::hash<String>, std::equal_to<String>,
+		MemoryStats::Allocator<String, MemoryStats::FILENAMES> > > FlyweightString;
 
 /**
  * @brief Class for fileflags.
@@ -57,8 +69,8 @@ struct DirItem
 	Poco::Timestamp ctime; /**< time of creation */
 	Poco::Timestamp mtime; /**< time of last modify */
 	Poco::File::FileSize size; /**< file size in bytes, -1 means file does not exist*/
-	boost::flyweight<String> filename; /**< filename for this item */
-	boost::flyweight<String> path; /**< full path (excluding filename) for the item */
+	FlyweightString filename; /**< filename for this item */
+	FlyweightString path; /**< full path (excluding filename) for the item */
 	FileVersion version; /**< string of fixed file version, eg, 1.2.3.4 */
 	FileFlags flags; /**< file attributes */
 
@@ -66,5 +78,6 @@ struct DirItem
 	void SetFile(const String &fullPath);
 	String GetFile() const;
 	bool Update(const String &sFilePath);
+	void UpdateFromListing(const DirItem &found);
 	void ClearPartial();
 };
@@ -6,7 +6,9 @@
 
 #include "DirScan.h"
 #include <cassert>
+#include <map>
 #include <memory>
+#include <unordered_map>
 #include <cstdint>
 #define POCO_NO_UNWINDOWS 1
 #include <Poco/Semaphore.h>
@@ -31,6 +33,7 @@
 #include "FolderCmp.h"
 #include "DirItem.h"
 #include "DirTravel.h"
+#include "MovedFileMatcher.h"
 #include "paths.h"
 #include "Plugins.h"
 #include "MergeApp.h"
@@ -45,15 +48,18 @@ using Poco::Environment;
 using Poco::Stopwatch;
 
 // Static functions (ie, functions only used locally)
-void CompareDiffItem(DIFFITEM &di, CDiffContext * pCtxt);
+void CompareDiffItem(FolderCmp &folderCmp, DIFFITEM &di, CDiffContext * pCtxt);
 static void StoreDiffData(DIFFITEM &di, CDiffContext * pCtxt,
 		const FolderCmp * pCmpData);
 static DIFFITEM *AddToList(const String& sLeftDir, const String& sRightDir, const DirItem * lent, const DirItem * rent,
 	unsigned code, DiffFuncStruct *myStruct, DIFFITEM *parent);
 static DIFFITEM *AddToList(const String& sLeftDir, const String& sMiddleDir, const String& sRightDir, const DirItem * lent, const DirItem * ment, const DirItem * rent,
 	unsigned code, DiffFuncStruct *myStruct, DIFFITEM *parent);
-static void UpdateDiffItem(DIFFITEM & di, bool & bExists, CDiffContext *pCtxt);
+namespace { class FolderListings; }
+static void UpdateDiffItem(DIFFITEM & di, bool & bExists, CDiffContext *pCtxt, FolderListings *pListings);
 static int CompareItems(NotificationQueue& queue, DiffFuncStruct *myStruct, uintptr_t parentdiffpos);
+static int CompareRequestedItems(NotificationQueue *pQueue, FolderCmp *pFolderCmp, DiffFuncStruct *myStruct, uintptr_t parentdiffpos);
+static int CountRequestedItems(CDiffContext *pCtxt, uintptr_t parentdiffpos, int nMax);
 
 class WorkNotification: public Poco::Notification
 {
@@ -75,6 +81,13 @@ private:
 	DIFFITEM& m_di;
 };
 
+/**
+ * @brief Tells a DiffWorker to exit, queued after all the work.
+ */
+class StopNotification: public Poco::Notification
+{
+};
+
 class DiffWorker: public Runnable
 {
 public:
@@ -88,13 +101,14 @@ public:
 		CAssureScriptsForThread scriptsForRescan;
 
 		AutoPtr<Notification> pNf(m_queue.waitDequeueNotification());
-		while (pNf)
+		while (pNf && !dynamic_cast<StopNotification*>(pNf.get()))
 		{
 			WorkNotification* pWorkNf = dynamic_cast<WorkNotification*>(pNf.get());
 			if (pWorkNf) {
 				m_pCtxt->m_pCompareStats->BeginCompare(&pWorkNf->data(), m_id);
 				if (!m_pCtxt->ShouldAbort())
-					CompareDiffItem(pWorkNf->data(), m_pCtxt);
+					CompareDiffItem(m_folderCmp, pWorkNf->data(), m_pCtxt);
+				m_pCtxt->m_pCompareStats->AddCompletedItem(&pWorkNf->data());
 				pWorkNf->queueResult().enqueueNotification(new WorkCompletedNotification(pWorkNf->data()));
 			}
 			pNf = m_queue.waitDequeueNotification();
@@ -105,10 +119,56 @@ private:
 	NotificationQueue& m_queue;
 	CDiffContext *m_pCtxt;
 	int m_id;
+	FolderCmp m_folderCmp; /**< Compares the files of this worker */
 };
 
 typedef std::shared_ptr<DiffWorker> DiffWorkerPtr;
 
+/**
+ * @brief Refreshing fewer items than this compares them in the calling
+ * thread, starting the workers and their scripts would take longer.
+ */
+static const int CompareRequestedInWorkersMinItems = 16;
+
+/**
+ * @brief Pool of DiffWorkers comparing the items put into a shared queue.
+ * Content compares use one worker per processor, other methods one worker.
+ * Every worker thread loads its own instances of the unpacker and prediffer
+ * plugins; plugins declared thread-unsafe are serialized by PluginCallLock.
+ * The pool must be destroyed only after the results of all queued items
+ * were received, each worker then exits when it gets its StopNotification.
+ */
+class DiffWorkerPool
+{
+public:
+	explicit DiffWorkerPool(CDiffContext *pCtxt)
+	{
+		const int compareMethod = pCtxt->GetCompareMethod();
+		unsigned nworkers = (compareMethod == CMP_CONTENT || compareMethod == CMP_QUICK_CONTENT) ? Environment::processorCount() : 1;
+
+		pCtxt->m_pCompareStats->SetCompareThreadCount(nworkers);
+		for (unsigned i = 0; i < nworkers; ++i)
+		{
+			m_workers.push_back(DiffWorkerPtr(new DiffWorker(m_queue, pCtxt, i)));
+			m_threadPool.start(*m_workers[i]);
+		}
+	}
+
+	~DiffWorkerPool()
+	{
+		for (size_t i = 0; i < m_workers.size(); ++i)
+			m_queue.enqueueNotification(new StopNotification);
+		m_threadPool.joinAll();
+	}
+
+	NotificationQueue& queue() { return m_queue; }
+
+private:
+	ThreadPool m_threadPool;
+	std::vector<DiffWorkerPtr> m_workers;
+	NotificationQueue m_queue;
+};
+
 /**
  * @brief Collect file- and folder-names to list.
  * This function walks given folders and adds found subfolders and files into
@@ -156,8 +216,7 @@ int DirScan_GetItems(const PathContext &paths, const String subdir[],
 	}
 
 	DirItemArray dirs[3], files[3];
-	for (nIndex = 0; nIndex < nDirs; nIndex++)
-		LoadAndSortFiles(sDir[nIndex], &dirs[nIndex], &files[nIndex], casesensitive);
+	LoadAndSortFiles(nDirs, sDir, dirs, files, casesensitive);
 
 	// Allow user to abort scanning
 	if (pCtxt->ShouldAbort())
@@ -451,26 +510,8 @@ int DirScan_GetItems(const PathContext &paths, const String subdir[],
  */
 int DirScan_CompareItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
 {
-	ThreadPool threadPool;
-	std::vector<DiffWorkerPtr> workers;
-	const int compareMethod = myStruct->context->GetCompareMethod();
-	unsigned nworkers = (compareMethod == CMP_CONTENT || compareMethod == CMP_QUICK_CONTENT) ? Environment::processorCount() : 1;
-	NotificationQueue queue;
-
-	myStruct->context->m_pCompareStats->SetCompareThreadCount(nworkers);
-	for (unsigned i = 0; i < nworkers; ++i)
-	{
-		workers.push_back(DiffWorkerPtr(new DiffWorker(queue, myStruct->context, i)));
-		threadPool.start(*workers[i]);
-	}
-
-	int res = CompareItems(queue, myStruct, parentdiffpos);
-
-	Thread::sleep(100);
-	queue.wakeUpAll();
-	threadPool.joinAll();
-
-	return res;
+	DiffWorkerPool pool(myStruct->context);
+	return CompareItems(pool.queue(), myStruct, parentdiffpos);
 }
 
 static int CompareItems(NotificationQueue& queue, DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
@@ -552,17 +593,58 @@ static int CompareItems(NotificationQueue& queue, DiffFuncStruct *myStruct, uint
  */
 int DirScan_CompareRequestedItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
 {
+	CDiffContext *pCtxt = myStruct->context;
+	if (CountRequestedItems(pCtxt, parentdiffpos, CompareRequestedInWorkersMinItems) < CompareRequestedInWorkersMinItems)
+	{
+		// keep the scripts alive during the compare, like a DiffWorker does
+		CAssureScriptsForThread scriptsForRescan;
+		FolderCmp folderCmp;
+		pCtxt->m_pCompareStats->SetCompareThreadCount(1);
+		return CompareRequestedItems(NULL, &folderCmp, myStruct, parentdiffpos);
+	}
+	DiffWorkerPool pool(pCtxt);
+	return CompareRequestedItems(&pool.queue(), NULL, myStruct, parentdiffpos);
+}
+
+/**
+ * @brief Count the items marked for rescan, stopping at nMax.
+ */
+static int CountRequestedItems(CDiffContext *pCtxt, uintptr_t parentdiffpos, int nMax)
+{
+	int count = 0;
+	uintptr_t pos = pCtxt->GetFirstChildDiffPosition(parentdiffpos);
+	while (pos != NULL && count < nMax)
+	{
+		uintptr_t curpos = pos;
+		const DIFFITEM &di = pCtxt->GetNextSiblingDiffRefPosition(pos);
+		if (di.diffcode.isDirectory())
+		{
+			if (pCtxt->m_bRecursive)
+				count += CountRequestedItems(pCtxt, curpos, nMax - count);
+		}
+		else if (di.diffcode.isScanNeeded())
+			++count;
+	}
+	return count;
+}
+
+/**
+ * @brief Compare the items marked for rescan below a folder.
+ * @param [in] pQueue Queue of the DiffWorkers, NULL to compare the items
+ * in this thread with pFolderCmp.
+ */
+static int CompareRequestedItems(NotificationQueue *pQueue, FolderCmp *pFolderCmp, DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
+{
+	NotificationQueue queueResult;
 	CDiffContext *pCtxt = myStruct->context;
 	int res = 0;
+	int count = 0;
 	uintptr_t pos = pCtxt->GetFirstChildDiffPosition(parentdiffpos);
 	
 	while (pos != NULL)
 	{
 		if (pCtxt->ShouldAbort())
-		{
-			res = -1;
 			break;
-		}
 
 		uintptr_t curpos = pos;
 		DIFFITEM &di = pCtxt->GetNextSiblingDiffRefPosition(pos);
@@ -572,7 +654,7 @@ int DirScan_CompareRequestedItems(DiffFuncStruct *myStruct, uintptr_t parentdiff
 			if (pCtxt->m_bRecursive)
 			{
 				di.diffcode.diffcode &= ~(DIFFCODE::DIFF | DIFFCODE::SAME);
-				int ndiff = DirScan_CompareRequestedItems(myStruct, curpos);
+				int ndiff = CompareRequestedItems(pQueue, pFolderCmp, myStruct, curpos);
 				if (ndiff > 0)
 				{
 					if (existsalldirs)
@@ -586,16 +668,41 @@ int DirScan_CompareRequestedItems(DiffFuncStruct *myStruct, uintptr_t parentdiff
 				}
 			}
 		}
-		else
+		else if (di.diffcode.isScanNeeded())
 		{
-			if (di.diffcode.isScanNeeded())
-				CompareDiffItem(di, pCtxt);
+			if (pQueue)
+			{
+				// counted when the worker has compared it
+				pQueue->enqueueNotification(new WorkNotification(di, queueResult));
+				++count;
+				continue;
+			}
+			pCtxt->m_pCompareStats->BeginCompare(&di, 0);
+			CompareDiffItem(*pFolderCmp, di, pCtxt);
+			pCtxt->m_pCompareStats->AddCompletedItem(&di);
 		}
 		if (di.diffcode.isResultDiff() ||
 			(!existsalldirs && !di.diffcode.isResultFiltered()))
 			res++;
 	}
-	return res;
+
+	while (count > 0)
+	{
+		AutoPtr<Notification> pNf(queueResult.waitDequeueNotification());
+		if (!pNf)
+			break;
+		WorkCompletedNotification* pWorkCompletedNf = dynamic_cast<WorkCompletedNotification*>(pNf.get());
+		if (pWorkCompletedNf) {
+			DIFFITEM &di = pWorkCompletedNf->data();
+			bool existsalldirs = ((pCtxt->GetCompareDirs() == 2 && di.diffcode.isSideBoth()) || (pCtxt->GetCompareDirs() == 3 && di.diffcode.isSideAll()));
+			if (di.diffcode.isResultDiff() ||
+				(!existsalldirs && !di.diffcode.isResultFiltered()))
+				res++;
+		}
+		--count;
+	}
+
+	return pCtxt->ShouldAbort() ? -1 : res;
 }
 
 static int markChildrenForRescan(CDiffContext *pCtxt, uintptr_t parentdiffpos)
@@ -617,11 +724,70 @@ static int markChildrenForRescan(CDiffContext *pCtxt, uintptr_t parentdiffpos)
 	return ncount;
 }
 
+/**
+ * @brief Refreshing at least this many items of a folder lists the folder
+ * once, instead of looking up each item by its full path.
+ */
+static const int UpdateByListingMinItems = 16;
+
+namespace
+{
+
+/**
+ * @brief Listings of the folders whose items are refreshed.
+ * One listing of a folder gets the information of all its items, like
+ * collecting the items does.
+ */
+class FolderListings
+{
+public:
+	/**
+	 * @brief Find an item from the listing of a folder.
+	 * The folder is listed when an item is first searched from it.
+	 * @param [in] sDir Folder of the item.
+	 * @param [in] sFilename Name of the item.
+	 * @return Found item, NULL if the folder has no item with exactly same name.
+	 */
+	const DirItem *Find(const String& sDir, const String& sFilename)
+	{
+		std::map<String, Listing>::iterator it = m_listings.find(sDir);
+		if (it == m_listings.end())
+		{
+			it = m_listings.insert(std::make_pair(sDir, Listing())).first;
+			DirItemArray dirs, files;
+			LoadFiles(sDir, &dirs, &files);
+			DirItemArray *arrays[] = { &dirs, &files };
+			for (int i = 0; i < 2; ++i)
+				for (DirItemArray::const_iterator item = arrays[i]->begin(); item != arrays[i]->end(); ++item)
+					it->second.insert(std::make_pair(item->filename.get(), *item));
+		}
+		Listing::const_iterator found = it->second.find(sFilename);
+		return found != it->second.end() ? &found->second : NULL;
+	}
+
+private:
+	typedef std::unordered_map<String, DirItem> Listing;
+	std::map<String, Listing> m_listings; /**< Listings by folder path */
+};
+
+}
+
 int DirScan_UpdateMarkedItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
 {
 	CDiffContext *pCtxt = myStruct->context;
 	uintptr_t pos = pCtxt->GetFirstChildDiffPosition(parentdiffpos);
 	int ncount = 0;
+
+	// When many items of the folder are refreshed, list the folders once
+	std::unique_ptr<FolderListings> pListings;
+	int nMarked = 0;
+	for (uintptr_t markedpos = pos; markedpos != NULL && nMarked < UpdateByListingMinItems; )
+	{
+		if (pCtxt->GetNextSiblingDiffRefPosition(markedpos).diffcode.isScanNeeded())
+			++nMarked;
+	}
+	if (nMarked >= UpdateByListingMinItems)
+		pListings.reset(new FolderListings());
 	
 	while (pos != NULL)
 	{
@@ -632,7 +798,7 @@ int DirScan_UpdateMarkedItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
 		bool bItemsExist = true;
 		if (di.diffcode.isScanNeeded())
 		{
-			UpdateDiffItem(di, bItemsExist, pCtxt);
+			UpdateDiffItem(di, bItemsExist, pCtxt, pListings.get());
 			if (!bItemsExist)
 				di.RemoveSelf();
 			else if (!di.diffcode.isDirectory())
@@ -663,6 +829,47 @@ int DirScan_UpdateMarkedItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
 	}
 	return ncount;
 }
+
+/**
+ * @brief Link unique files renamed or moved to another folder.
+ *
+ * A renamed or moved file is found as a left-only and a right-only item.
+ * Such items having identical content are found by MovedFileMatcher and
+ * linked to each other. Only two-way compares are handled.
+ *
+ * @param myStruct [in] A structure containing compare-related data.
+ * @return >= 0 number of linked pairs, -1 if compare was aborted
+ */
+int DirScan_DetectMovedItems(DiffFuncStruct *myStruct)
+{
+	CDiffContext *pCtxt = myStruct->context;
+	if (pCtxt->GetCompareDirs() != 2)
+		return 0;
+
+	MovedFileMatcher matcher(pCtxt->GetAbortable());
+	std::vector<DIFFITEM *> items[2];
+	uintptr_t pos = pCtxt->GetFirstDiffPosition();
+	while (pos)
+	{
+		DIFFITEM &di = pCtxt->GetNextDiffRefPosition(pos);
+		if (di.diffcode.isDirectory() || di.diffcode.isResultFiltered() || di.movedItem)
+			continue;
+		const int nSide = di.diffcode.isSideFirstOnly() ? 0 : (di.diffcode.isSideSecondOnly() ? 1 : -1);
+		if (nSide < 0)
+			continue;
+		matcher.AddFile(nSide, paths::ConcatPath(pCtxt->GetNormalizedPath(nSide), di.diffFileInfo[nSide].GetFile()),
+			di.diffFileInfo[nSide].size);
+		items[nSide].push_back(&di);
+	}
+
+	std::vector<MovedFileMatcher::Match> matches = matcher.FindMatches();
+	if (pCtxt->ShouldAbort())
+		return -1;
+	for (size_t i = 0; i < matches.size(); ++i)
+		items[0][matches[i].first]->LinkMoved(items[1][matches[i].second]);
+	return static_cast<int>(matches.size());
+}
+
 /**
  * @brief Update diffitem file/dir infos.
  *
@@ -676,15 +883,23 @@ int DirScan_UpdateMarkedItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
  *  - true if one of items exists so diffitem is valid
  *  - false if items were deleted, so diffitem is not valid
  * @param [in] pCtxt Compare context
+ * @param [in] pListings Listings of the folders of the item, NULL to look
+ *  up the item by its paths.
  */
-static void UpdateDiffItem(DIFFITEM & di, bool & bExists, CDiffContext *pCtxt)
+static void UpdateDiffItem(DIFFITEM & di, bool & bExists, CDiffContext *pCtxt, FolderListings *pListings)
 {
 	bExists = false;
+	di.UnlinkMoved();
 	di.diffcode.setSideNone();
 	for (int i = 0; i < pCtxt->GetCompareDirs(); ++i)
 	{
 		di.diffFileInfo[i].ClearPartial();
-		if (pCtxt->UpdateInfoFromDiskHalf(di, i))
+		// Items not found from listing, e.g. renamed to different case,
+		// are looked up by path
+		const DirItem *pFound = NULL;
+		if (pListings)
+			pFound = pListings->Find(paths::ConcatPath(pCtxt->GetPath(i), di.diffFileInfo[i].path), di.diffFileInfo[i].filename);
+		if (pCtxt->UpdateInfoFromDiskHalf(di, i, pFound))
 		{
 			di.diffcode.diffcode |= DIFFCODE::FIRST << i;
 			bExists = true;
@@ -702,12 +917,13 @@ static void UpdateDiffItem(DIFFITEM & di, bool & bExists, CDiffContext *pCtxt)
  * - add  unique files
  * - compare files
  *
+ * @param [in] folderCmp File compare of the calling thread, reused for its items
  * @param [in] di DiffItem to compare
  * @param [in,out] pCtxt Compare context: contains difflist, encoding info etc.
  * @todo For date compare, maybe we should use creation date if modification
  * date is missing?
  */
-void CompareDiffItem(DIFFITEM &di, CDiffContext * pCtxt)
+void CompareDiffItem(FolderCmp &folderCmp, DIFFITEM &di, CDiffContext * pCtxt)
 {
 	int nDirs = pCtxt->GetCompareDirs();
 	// Clear rescan-request flag (not set by all codepaths)
@@ -737,7 +953,6 @@ void CompareDiffItem(DIFFITEM &di, CDiffContext * pCtxt)
 					nCurrentCompMethod != CMP_DATE_SIZE &&
 					nCurrentCompMethod != CMP_SIZE)
 				{
-					FolderCmp folderCmp;
 					unsigned diffCode = folderCmp.prepAndCompareFiles(pCtxt, di);
 					
 					// Add possible binary flag for unique items
@@ -754,7 +969,6 @@ void CompareDiffItem(DIFFITEM &di, CDiffContext * pCtxt)
 			else
 			{
 				// Really compare
-				FolderCmp folderCmp;
 				di.diffcode.diffcode |= folderCmp.prepAndCompareFiles(pCtxt, di);
 				StoreDiffData(di, pCtxt, &folderCmp);
 			}
@@ -21,3 +21,4 @@ int DirScan_UpdateMarkedItems(DiffFuncStruct *myStruct, uintptr_t parentdiffpos)
 
 int DirScan_CompareItems(DiffFuncStruct *, uintptr_t parentdiffpos);
 int DirScan_CompareRequestedItems(DiffFuncStruct *, uintptr_t parentdiffpos);
+int DirScan_DetectMovedItems(DiffFuncStruct *myStruct);
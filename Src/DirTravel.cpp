@@ -8,8 +8,12 @@
 #include "DirTravel.h"
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <clocale>
 #include <Poco/DirectoryIterator.h>
 #include <Poco/Timestamp.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
 #include <windows.h>
 #include <tchar.h>
 #include <mbstring.h>
@@ -20,18 +24,85 @@
 
 using Poco::DirectoryIterator;
 using Poco::Timestamp;
+using Poco::Thread;
+using Poco::Runnable;
 
-static void LoadFiles(const String& sDir, DirItemArray * dirs, DirItemArray * files);
 static void Sort(DirItemArray * dirs, bool casesensitive);
 
 /**
- * @brief Load arrays with all directories & files in specified dir
+ * @brief Sorting of bigger folders is done in separate threads.
+ * Starting a thread costs more than sorting a small folder.
  */
-void LoadAndSortFiles(const String& sDir, DirItemArray * dirs, DirItemArray * files, bool casesensitive)
+static const size_t ParallelSortMinItems = 10000;
+
+/**
+ * @brief Load arrays with all directories & files in specified dirs
+ * @param [in] nDirs Number of compared folders.
+ * @param [in] sDir Folders to load.
+ * @param [out] dirs Sorted subfolders of each folder.
+ * @param [out] files Sorted files of each folder.
+ * @param [in] casesensitive Is filename compare casesensitive?
+ */
+void LoadAndSortFiles(int nDirs, const String sDir[], DirItemArray dirs[], DirItemArray files[], bool casesensitive)
 {
-	LoadFiles(sDir, dirs, files);
-	Sort(dirs, casesensitive);
-	Sort(files, casesensitive);
+	for (int nIndex = 0; nIndex < nDirs; nIndex++)
+		LoadFiles(sDir[nIndex], &dirs[nIndex], &files[nIndex]);
+	SortFiles(nDirs, dirs, files, casesensitive);
+}
+
+namespace
+{
+
+/**
+ * @brief Sorts one array of items in a separate thread.
+ */
+class SortRunnable : public Runnable
+{
+public:
+	SortRunnable(DirItemArray * items, bool casesensitive) : m_items(items), m_casesensitive(casesensitive) {}
+	void run() { Sort(m_items, m_casesensitive); }
+private:
+	DirItemArray * m_items;
+	bool m_casesensitive;
+};
+
+}
+
+/**
+ * @brief Sort subfolder and file arrays of all compared folders.
+ * When the folders are big, the arrays are sorted in parallel.
+ * @param [in] nDirs Number of compared folders.
+ * @param [in,out] dirs Subfolders of each folder.
+ * @param [in,out] files Files of each folder.
+ * @param [in] casesensitive Is filename compare casesensitive?
+ */
+void SortFiles(int nDirs, DirItemArray dirs[], DirItemArray files[], bool casesensitive)
+{
+	DirItemArray * arrays[6];
+	int narrays = 0;
+	for (int nIndex = 0; nIndex < nDirs; nIndex++)
+	{
+		arrays[narrays++] = &dirs[nIndex];
+		arrays[narrays++] = &files[nIndex];
+	}
+
+	// Largest array is sorted in this thread, other big ones in their own threads
+	std::sort(arrays, arrays + narrays, [](const DirItemArray *a, const DirItemArray *b) { return a->size() > b->size(); });
+	std::unique_ptr<SortRunnable> runnables[6];
+	std::unique_ptr<Thread> threads[6];
+	int i;
+	for (i = 1; i < narrays && arrays[i]->size() >= ParallelSortMinItems; i++)
+	{
+		runnables[i].reset(new SortRunnable(arrays[i], casesensitive));
+		threads[i].reset(new Thread());
+		threads[i]->start(*runnables[i]);
+	}
+	for (int j = i; j < narrays; j++)
+		Sort(arrays[j], casesensitive);
+	if (narrays > 0)
+		Sort(arrays[0], casesensitive);
+	for (int j = 1; j < i; j++)
+		threads[j]->join();
 }
 
 /**
@@ -46,9 +117,9 @@ void LoadAndSortFiles(const String& sDir, DirItemArray * dirs, DirItemArray * fi
  * @param [in, out] dirs Array where subfolders are stored.
  * @param [in, out] files Array where files are stored.
  */
-static void LoadFiles(const String& sDir, DirItemArray * dirs, DirItemArray * files)
+void LoadFiles(const String& sDir, DirItemArray * dirs, DirItemArray * files)
 {
-	boost::flyweight<String> dir(sDir);
+	FlyweightString dir(sDir);
 #if 0
 	DirectoryIterator it(ucr::toUTF8(sDir));
 	DirectoryIterator end;
@@ -129,35 +200,137 @@ static void LoadFiles(const String& sDir, DirItemArray * dirs, DirItemArray * fi
 #endif
 }
 
-static inline int collate(const String &str1, const String &str2)
+/**
+ * @brief Is the C runtime using the "C" locale for collation?
+ * WinMerge does not change the C runtime locale, so this is checked only
+ * once. In the "C" locale _tcscoll() and _tcsicoll() are plain ordinal
+ * compares, the latter folding only ASCII letters, which can be done
+ * without locking and looking up the locale for every compare.
+ */
+static bool IsOrdinalCollation()
+{
+	static const bool bOrdinal = _tcscmp(_tsetlocale(LC_COLLATE, NULL), _T("C")) == 0;
+	return bOrdinal;
+}
+
+static inline int collate(const TCHAR *str1, const TCHAR *str2)
+{
+	return _tcscoll(str1, str2);
+}
+
+static inline int collate_ignore_case(const TCHAR *str1, const TCHAR *str2)
 {
-	return _tcscoll(str1.c_str(), str2.c_str());
+	return _tcsicoll(str1, str2);
 }
 
-static inline int collate_ignore_case(const String &str1, const String &str2)
+/**
+ * @brief Ordinal compare, same as _tcscoll() in the "C" locale.
+ */
+static inline int collate_ordinal(const TCHAR *str1, const TCHAR *str2)
 {
-	return _tcsicoll(str1.c_str(), str2.c_str());
+	for (; *str1 == *str2; ++str1, ++str2)
+	{
+		if (*str1 == 0)
+			return 0;
+	}
+	return static_cast<unsigned>(*str1) < static_cast<unsigned>(*str2) ? -1 : 1;
 }
 
+/**
+ * @brief Ordinal compare folding ASCII letters, same as _tcsicoll() in the "C" locale.
+ */
+static inline int collate_ordinal_ignore_case(const TCHAR *str1, const TCHAR *str2)
+{
+	for (;; ++str1, ++str2)
+	{
+		unsigned c1 = static_cast<unsigned>(*str1);
+		unsigned c2 = static_cast<unsigned>(*str2);
+		if (c1 != c2)
+		{
+			if (c1 - 'A' <= 'Z' - 'A')
+				c1 += 'a' - 'A';
+			if (c2 - 'A' <= 'Z' - 'A')
+				c2 += 'a' - 'A';
+			if (c1 != c2)
+				return c1 < c2 ? -1 : 1;
+		}
+		else if (c1 == 0)
+			return 0;
+	}
+}
+
+/**
+ * @brief Sort key of an item: the filename characters and the item.
+ * Keeping the name pointer in the key saves following the flyweight
+ * for every compare, and sorting keys does not copy DirItems.
+ */
+struct SortKey
+{
+	const TCHAR *name;
+	const DirItem *item;
+};
 
 template<int (*compfunc)(const TCHAR *, const TCHAR *)>
 struct StringComparer
 {
-	bool operator()(const DirItem &elem1, const DirItem &elem2)
+	bool operator()(const SortKey &elem1, const SortKey &elem2)
 	{
-		return compfunc(elem1.filename.get().c_str(), elem2.filename.get().c_str()) < 0;
+		return compfunc(elem1.name, elem2.name) < 0;
 	}
 };
 
 /**
  * @brief sort specified array
+ * With ordinal collation the names are first copied, case folded when
+ * needed, into one buffer. Sorting then compares those precomputed keys
+ * ordinally, and the compared characters are close to each other in
+ * memory instead of being spread over the heap.
  */
 static void Sort(DirItemArray * dirs, bool casesensitive)
 {
-	if (casesensitive)
-        std::sort(dirs->begin(), dirs->end(), StringComparer<_tcscoll>());
+	std::vector<SortKey> keys(dirs->size());
+	std::vector<TCHAR> keybuf;
+	if (IsOrdinalCollation())
+	{
+		size_t len = 0;
+		for (size_t i = 0; i < dirs->size(); ++i)
+			len += (*dirs)[i].filename.get().length() + 1;
+		keybuf.resize(len);
+		TCHAR *p = keybuf.data();
+		for (size_t i = 0; i < dirs->size(); ++i)
+		{
+			const String& name = (*dirs)[i].filename.get();
+			keys[i].name = p;
+			keys[i].item = &(*dirs)[i];
+			for (size_t j = 0; j < name.length(); ++j)
+			{
+				TCHAR c = name[j];
+				if (!casesensitive && static_cast<unsigned>(c - 'A') <= 'Z' - 'A')
+					c += 'a' - 'A';
+				*p++ = c;
+			}
+			*p++ = 0;
+		}
+		std::sort(keys.begin(), keys.end(), StringComparer<collate_ordinal>());
+	}
 	else
-		std::sort(dirs->begin(), dirs->end(), StringComparer<_tcsicoll>());
+	{
+		for (size_t i = 0; i < dirs->size(); ++i)
+		{
+			keys[i].name = (*dirs)[i].filename.get().c_str();
+			keys[i].item = &(*dirs)[i];
+		}
+		if (casesensitive)
+			std::sort(keys.begin(), keys.end(), StringComparer<collate>());
+		else
+			std::sort(keys.begin(), keys.end(), StringComparer<collate_ignore_case>());
+	}
+
+	DirItemArray sorted;
+	sorted.reserve(keys.size());
+	for (size_t i = 0; i < keys.size(); ++i)
+		sorted.push_back(*keys[i].item);
+	dirs->swap(sorted);
 }
 
 /**
@@ -166,8 +339,15 @@ static void Sort(DirItemArray * dirs, bool casesensitive)
  */
 int collstr(const String & s1, const String & s2, bool casesensitive)
 {
+	if (IsOrdinalCollation())
+	{
+		if (casesensitive)
+			return collate_ordinal(s1.c_str(), s2.c_str());
+		else
+			return collate_ordinal_ignore_case(s1.c_str(), s2.c_str());
+	}
 	if (casesensitive)
-		return collate(s1, s2);
+		return collate(s1.c_str(), s2.c_str());
 	else
-		return collate_ignore_case(s1, s2);
+		return collate_ignore_case(s1.c_str(), s2.c_str());
 }
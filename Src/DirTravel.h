@@ -13,5 +13,7 @@ struct DirItem;
 
 typedef std::vector<DirItem> DirItemArray;
 
-void LoadAndSortFiles(const String& sDir, DirItemArray * dirs, DirItemArray * files, bool casesensitive);
+void LoadFiles(const String& sDir, DirItemArray * dirs, DirItemArray * files);
+void LoadAndSortFiles(int nDirs, const String sDir[], DirItemArray dirs[], DirItemArray files[], bool casesensitive);
+void SortFiles(int nDirs, DirItemArray dirs[], DirItemArray files[], bool casesensitive);
 int collstr(const String & s1, const String & s2, bool casesensitive);
@@ -32,6 +32,7 @@
 #include "DirActions.h"
 #include "SourceControl.h"
 #include "DirViewColItems.h"
+#include "DirViewResultList.h"
 #include "DirFrame.h"  // StatePane
 #include "DirDoc.h"
 #include "IMergeDoc.h"
@@ -46,7 +47,9 @@
 #include "OptionsMgr.h"
 #include "BCMenu.h"
 #include "DirCmpReport.h"
+#include "DirCmpReportRows.h"
 #include "DirCompProgressBar.h"
+#include "CompareStats.h"
 #include "CompareStatisticsDlg.h"
 #include "LoadSaveCodepageDlg.h"
 #include "ConfirmFolderCopyDlg.h"
@@ -61,6 +64,7 @@
 #include "PatchTool.h"
 #include <numeric>
 #include <functional>
+#include <map>
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -81,6 +85,20 @@ static TCHAR DirViewHelpLocation[] = _T("::/htmlhelp/Compare_dirs.html");
  */
 const int TimeToSignalCompare = 3;
 
+/**
+ * @brief Interval (in milliseconds) for showing completed items.
+ * While compare is running, items compared during the interval are added
+ * to the list, or their rows are updated, in one batch.
+ */
+const UINT CompletedItemsInterval = 500;
+
+/**
+ * @brief Limit for rows inserted or deleted one by one.
+ * Every insert and delete moves the rows after it, so when a batch moves
+ * more rows than this the list is filled again in the new order instead.
+ */
+const size_t MaxRowChanges = 256;
+
 // The resource ID constants/limits for the Shell context menu
 const UINT LeftCmdFirst = 0x9000; // this should be greater than any of already defined command IDs
 const UINT RightCmdLast = 0xffff; // maximum available value
@@ -94,7 +112,8 @@ const UINT RightCmdFirst = MiddleCmdLast + 1;
 
 enum { 
 	COLUMN_REORDER = 99,
-	STATUSBAR_UPDATE = 100
+	STATUSBAR_UPDATE = 100,
+	COMPARE_RESULTS_UPDATE = 101
 };
 
 IMPLEMENT_DYNCREATE(CDirView, CListView)
@@ -108,6 +127,7 @@ CDirView::CDirView()
 		, m_lastDiffItem(-1)
 		, m_pCmpProgressBar(nullptr)
 		, m_compareStart(0)
+		, m_pCompareStats(nullptr)
 		, m_bTreeMode(false)
 		, m_dirfilter(std::bind(&COptionsMgr::GetBool, GetOptionsMgr(), _1))
 		, m_pShellContextMenuLeft(nullptr)
@@ -116,6 +136,8 @@ CDirView::CDirView()
 		, m_hCurrentMenu(nullptr)
 		, m_pSavedTreeState(nullptr)
 		, m_pColItems(nullptr)
+		, m_pColTextCache(new DirViewColTextCache())
+		, m_pResultList(new DirViewResultList())
 {
 	m_dwDefaultStyle &= ~LVS_TYPEMASK;
 	// Show selection all the time, so user can see current item even when
@@ -206,6 +228,7 @@ BEGIN_MESSAGE_MAP(CDirView, CListView)
 	ON_COMMAND(ID_REFRESH, OnRefresh)
 	ON_UPDATE_COMMAND_UI(ID_REFRESH, OnUpdateRefresh)
 	ON_WM_TIMER()
+	ON_WM_SETTINGCHANGE()
 	ON_UPDATE_COMMAND_UI(ID_STATUS_RIGHTDIR_RO, OnUpdateStatusRightRO)
 	ON_UPDATE_COMMAND_UI(ID_STATUS_MIDDLEDIR_RO, OnUpdateStatusMiddleRO)
 	ON_UPDATE_COMMAND_UI(ID_STATUS_LEFTDIR_RO, OnUpdateStatusLeftRO)
@@ -445,6 +468,240 @@ void CDirView::StartCompare(CompareStats *pCompareStats)
 	GetParentFrame()->ShowControlBar(m_pCmpProgressBar.get(), TRUE, FALSE);
 
 	m_compareStart = clock();
+
+	// Show results while comparing
+	m_pCompareStats = pCompareStats;
+	m_pResultList->Clear();
+	SetTimer(COMPARE_RESULTS_UPDATE, CompletedItemsInterval, NULL);
+}
+
+/**
+ * @brief Show the items completed since the previous call.
+ * New items are inserted at their sort position and rows of items already
+ * shown are updated, moved or deleted, without rebuilding the whole list.
+ * In tree mode the rows are only updated, new items are added when the
+ * items are collected.
+ */
+void CDirView::ShowCompletedItems()
+{
+	if (!m_pCompareStats)
+		return;
+	std::vector<const DIFFITEM *> completed;
+	m_pCompareStats->GetCompletedItems(completed);
+	if (completed.empty())
+		return;
+	std::vector<uintptr_t> batch(completed.size());
+	for (size_t i = 0; i < completed.size(); ++i)
+		batch[i] = reinterpret_cast<uintptr_t>(completed[i]);
+
+	// Rows were changed by something else since the previous batch
+	if (m_pResultList->GetCount() != static_cast<size_t>(m_pList->GetItemCount()))
+		ReloadResultList();
+
+	const CDiffContext &ctxt = GetDiffContext();
+	std::vector<DirViewResultList::Change> changes;
+	if (m_bTreeMode && ctxt.m_bRecursive)
+	{
+		m_pResultList->Refresh(batch, changes);
+	}
+	else
+	{
+		int sortCol = GetOptionsMgr()->GetInt((GetDocument()->m_nDirs < 3) ? OPT_DIRVIEW_SORT_COLUMN : OPT_DIRVIEW_SORT_COLUMN3);
+		bool bSortAscending = GetOptionsMgr()->GetBool(OPT_DIRVIEW_SORT_ASCENDING);
+		CompareState cs(&ctxt, m_pColItems.get(), sortCol, bSortAscending, m_bTreeMode);
+		DirViewResultList::LessFunc less;
+		if (sortCol != -1 && sortCol < m_pColItems->GetColCount())
+		{
+			less = [&cs](uintptr_t diffpos1, uintptr_t diffpos2)
+			{
+				return CompareState::CompareFunc(diffpos1, diffpos2, reinterpret_cast<LPARAM>(&cs)) < 0;
+			};
+		}
+		m_pResultList->Merge(batch, std::bind(&CDirView::IsListedWhileComparing, this, _1), less, changes);
+	}
+	if (changes.empty())
+		return;
+
+	ApplyResultListChanges(changes);
+
+	m_bNeedSearchLastDiffItem = true;
+	m_bNeedSearchFirstDiffItem = true;
+}
+
+/**
+ * @brief Stop showing results while comparing.
+ * Called when compare is ready, the list is then filled again.
+ */
+void CDirView::EndShowingCompletedItems()
+{
+	KillTimer(COMPARE_RESULTS_UPDATE);
+	if (m_pCompareStats)
+	{
+		std::vector<const DIFFITEM *> completed;
+		m_pCompareStats->GetCompletedItems(completed);
+	}
+	m_pCompareStats = nullptr;
+	m_pResultList->Clear();
+}
+
+/**
+ * @brief Does the completed item belong to the list (when not in tree mode)?
+ * Like in RedisplayChildren() the item is shown if it and its parent
+ * folders are showable, folders existing on all sides of a recursive
+ * compare are not shown.
+ */
+bool CDirView::IsListedWhileComparing(uintptr_t diffpos) const
+{
+	const CDiffContext &ctxt = GetDiffContext();
+	const DIFFITEM &di = ctxt.GetDiffAt(diffpos);
+	if (ctxt.m_bRecursive && di.diffcode.isDirectory() && di.diffcode.existAll(GetDocument()->m_nDirs))
+		return false;
+	for (const DIFFITEM *pdi = &di; pdi; pdi = pdi->parent)
+	{
+		if (!IsShowable(ctxt, *pdi, m_dirfilter))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Read the rows of the list control to the result list.
+ */
+void CDirView::ReloadResultList()
+{
+	const int nCount = m_pList->GetItemCount();
+	std::vector<uintptr_t> keys(nCount);
+	for (int i = 0; i < nCount; i++)
+		keys[i] = GetItemKey(i);
+	m_pResultList->Assign(keys);
+}
+
+/**
+ * @brief Fill the list control with the rows of the result list.
+ * The special items at the top of the list are kept.
+ */
+void CDirView::RebuildFromResultList()
+{
+	const std::vector<uintptr_t>& keys = m_pResultList->GetKeys();
+	int nSpecial = 0;
+	while (nSpecial < m_pList->GetItemCount() && GetItemKey(nSpecial) == SPECIAL_ITEM_POS)
+		nSpecial++;
+	for (int i = m_pList->GetItemCount() - 1; i >= nSpecial; i--)
+		m_pList->DeleteItem(i);
+	m_pColTextCache->Clear();
+	m_pList->SetItemCount(static_cast<int>(keys.size()));
+	for (size_t i = nSpecial; i < keys.size(); ++i)
+		AddNewItem(static_cast<int>(i), keys[i], I_IMAGECALLBACK, 0);
+}
+
+/**
+ * @brief Apply changes of the result list to the list control.
+ * Moved rows keep their selection and focus. If many rows are inserted
+ * or deleted the list control is filled again from the result list.
+ * @param [in] changes Changes computed by the result list, in order.
+ */
+void CDirView::ApplyResultListChanges(const std::vector<DirViewResultList::Change>& changes)
+{
+	size_t nRowChanges = 0;
+	for (size_t i = 0; i < changes.size(); ++i)
+	{
+		if (changes[i].type != DirViewResultList::ITEM_UPDATED)
+			++nRowChanges;
+	}
+
+	SetRedraw(FALSE);
+	std::map<uintptr_t, UINT> movedStates;
+	if (nRowChanges > MaxRowChanges)
+	{
+		int sel = -1;
+		while ((sel = m_pList->GetNextItem(sel, LVNI_SELECTED)) != -1)
+			movedStates[GetItemKey(sel)] = LVIS_SELECTED;
+		int focus = m_pList->GetNextItem(-1, LVNI_FOCUSED);
+		if (focus != -1)
+			movedStates[GetItemKey(focus)] |= LVIS_FOCUSED;
+		RebuildFromResultList();
+		const std::vector<uintptr_t>& keys = m_pResultList->GetKeys();
+		for (size_t i = 0; i < keys.size() && !movedStates.empty(); ++i)
+		{
+			std::map<uintptr_t, UINT>::iterator it = movedStates.find(keys[i]);
+			if (it != movedStates.end())
+			{
+				m_pList->SetItemState(static_cast<int>(i), it->second, LVIS_SELECTED | LVIS_FOCUSED);
+				movedStates.erase(it);
+			}
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < changes.size(); ++i)
+		{
+			const DirViewResultList::Change& change = changes[i];
+			switch (change.type)
+			{
+			case DirViewResultList::ITEM_DELETED:
+				if (UINT state = m_pList->GetItemState(change.nIndex, LVIS_SELECTED | LVIS_FOCUSED))
+					movedStates[change.key] = state;
+				DeleteItem(change.nIndex);
+				break;
+			case DirViewResultList::ITEM_INSERTED:
+				AddNewItem(change.nIndex, change.key, I_IMAGECALLBACK, 0);
+				if (movedStates.count(change.key))
+					m_pList->SetItemState(change.nIndex, movedStates[change.key], LVIS_SELECTED | LVIS_FOCUSED);
+				break;
+			case DirViewResultList::ITEM_UPDATED:
+				UpdateDiffItemStatus(change.nIndex);
+				break;
+			}
+		}
+	}
+	SetRedraw(TRUE);
+}
+
+/**
+ * @brief Update the rows of items changed after the compare, e.g. by file
+ * operations, and move them to their sort position.
+ * Only the changed rows are moved by binary insertion among the rows still
+ * in order, the whole list is not sorted again. In tree mode the rows are
+ * only updated.
+ * @param [in] keys Keys of the changed items.
+ */
+void CDirView::RepositionItems(const std::vector<uintptr_t>& keys)
+{
+	if (keys.empty())
+		return;
+
+	// Rows were changed by something else since the list was last in sync
+	if (m_pResultList->GetCount() != static_cast<size_t>(m_pList->GetItemCount()))
+		ReloadResultList();
+
+	const CDiffContext &ctxt = GetDiffContext();
+	std::vector<DirViewResultList::Change> changes;
+	if (m_bTreeMode && ctxt.m_bRecursive)
+	{
+		m_pResultList->Refresh(keys, changes);
+	}
+	else
+	{
+		int sortCol = GetOptionsMgr()->GetInt((GetDocument()->m_nDirs < 3) ? OPT_DIRVIEW_SORT_COLUMN : OPT_DIRVIEW_SORT_COLUMN3);
+		bool bSortAscending = GetOptionsMgr()->GetBool(OPT_DIRVIEW_SORT_ASCENDING);
+		CompareState cs(&ctxt, m_pColItems.get(), sortCol, bSortAscending, m_bTreeMode);
+		DirViewResultList::LessFunc less;
+		if (sortCol != -1 && sortCol < m_pColItems->GetColCount())
+		{
+			less = [&cs](uintptr_t diffpos1, uintptr_t diffpos2)
+			{
+				return CompareState::CompareFunc(diffpos1, diffpos2, reinterpret_cast<LPARAM>(&cs)) < 0;
+			};
+		}
+		m_pResultList->Reposition(keys, less, changes);
+	}
+	if (changes.empty())
+		return;
+
+	ApplyResultListChanges(changes);
+
+	m_bNeedSearchLastDiffItem = true;
+	m_bNeedSearchFirstDiffItem = true;
 }
 
 /**
@@ -538,6 +795,25 @@ void CDirView::RedisplayChildren(uintptr_t diffpos, int level, UINT &index, int
 	}
 }
 
+/**
+ * @brief Count the different items like RedisplayChildren() does.
+ * @return Number of different items of the whole compare.
+ */
+int CDirView::CountDifferentItems() const
+{
+	const CDiffContext &ctxt = GetDiffContext();
+	int nDirs = GetDocument()->m_nDirs;
+	int alldiffs = 0;
+	uintptr_t diffpos = ctxt.GetFirstDiffPosition();
+	while (diffpos)
+	{
+		const DIFFITEM &di = ctxt.GetNextDiffPosition(diffpos);
+		if (di.diffcode.isResultDiff() || (!di.diffcode.existAll(nDirs) && !di.diffcode.isResultFiltered()))
+			++alldiffs;
+	}
+	return alldiffs;
+}
+
 /**
  * @brief Redisplay folder compare view.
  * This function clears folder compare view and then adds
@@ -919,6 +1195,7 @@ void CDirView::UpdateAfterFileScript(FileActionScript & actionList)
 	bool bItemsRemoved = false;
 	int curSel = GetFirstSelectedInd();
 	CDiffContext& ctxt = GetDiffContext();
+	std::vector<uintptr_t> updated;
 	while (actionList.GetActionItemCount()>0)
 	{
 		// Start handling from tail of list, so removing items
@@ -940,8 +1217,11 @@ void CDirView::UpdateAfterFileScript(FileActionScript & actionList)
 			bItemsRemoved = true;
 		}
 		else if (updatetype == UPDATEITEM_UPDATE)
-			UpdateDiffItemStatus(act.context);
+			updated.push_back(GetItemKey(act.context));
 	}
+
+	// Move the updated rows to their sort position
+	RepositionItems(updated);
 	
 	// Make sure selection is at sensible place if all selected items
 	// were removed.
@@ -977,6 +1257,7 @@ void CDirView::DoUpdateDirCopy(CCmdUI* pCmdUI, eMenuType menuType)
  */
 void CDirView::UpdateResources()
 {
+	m_pColTextCache->Clear();
 	UpdateColumnNames();
 	GetParentFrame()->UpdateResources();
 }
@@ -1019,6 +1300,7 @@ void CDirView::SortColumnsAppropriately()
 	//sort using static CompareFunc comparison function
 	CompareState cs(&GetDiffContext(), m_pColItems.get(), sortCol, bSortAscending, m_bTreeMode);
 	GetListCtrl().SortItems(cs.CompareFunc, reinterpret_cast<DWORD_PTR>(&cs));
+	m_pResultList->Clear();
 
 	m_bNeedSearchLastDiffItem = true;
 	m_bNeedSearchFirstDiffItem = true;
@@ -1547,6 +1829,9 @@ void CDirView::DeleteItem(int sel)
 {
 	if (m_bTreeMode)
 		CollapseSubdir(sel);
+	uintptr_t key = GetItemKey(sel);
+	if (key != SPECIAL_ITEM_POS)
+		m_pColTextCache->Invalidate(GetDiffContext().GetDiffAt(key));
 	m_pList->DeleteItem(sel);
 }
 
@@ -1555,6 +1840,8 @@ void CDirView::DeleteAllDisplayItems()
 	// item data are just positions (diffposes)
 	// that is, they contain no memory needing to be freed
 	m_pList->DeleteAllItems();
+	m_pColTextCache->Clear();
+	m_pResultList->Clear();
 }
 
 /**
@@ -2077,9 +2364,21 @@ LRESULT CDirView::OnUpdateUIMessage(WPARAM wParam, LPARAM lParam)
 			GetParentFrame()->ShowControlBar(m_pCmpProgressBar.get(), FALSE, FALSE);
 		m_pCmpProgressBar.reset();
 
+		bool bMarkedRescan = !m_markedRescanKeys.empty();
+		if (bMarkedRescan)
+			ShowCompletedItems();
+		EndShowingCompletedItems();
 		pDoc->CompareReady();
 
-		Redisplay();
+		if (bMarkedRescan && !(m_bTreeMode && GetDiffContext().m_bRecursive))
+		{
+			// The rows were kept, only the rescanned items can have moved
+			RepositionItems(m_markedRescanKeys);
+			GetParentFrame()->SetLastCompareResult(CountDifferentItems());
+		}
+		else
+			Redisplay();
+		m_markedRescanKeys.clear();
 
 		if (!pDoc->GetReportFile().empty())
 		{
@@ -2257,6 +2556,10 @@ void CDirView::OnTimer(UINT_PTR nIDEvent)
 			std::bind(&CListCtrl::SetColumnWidth, m_pList, _1, _2), DefColumnWidth);
 		Redisplay();
 	}
+	else if (nIDEvent == COMPARE_RESULTS_UPDATE)
+	{
+		ShowCompletedItems();
+	}
 	else if (nIDEvent == STATUSBAR_UPDATE)
 	{
 		int items = GetSelectedCount();
@@ -2267,6 +2570,18 @@ void CDirView::OnTimer(UINT_PTR nIDEvent)
 	CListView::OnTimer(nIDEvent);
 }
 
+/**
+ * @brief Format the column texts again after the regional settings changed.
+ * Sizes and dates are formatted with the number and date formats of the
+ * user locale, so the cached texts are stale after a change.
+ */
+void CDirView::OnSettingChange(UINT uFlags, LPCTSTR lpszSection)
+{
+	CListView::OnSettingChange(uFlags, lpszSection);
+	m_pColTextCache->Clear();
+	m_pList->Invalidate();
+}
+
 /**
  * @brief Change left-side readonly-status
  */
@@ -2455,6 +2770,19 @@ void CDirView::OnToolsGenerateReport()
 	FileCmpReport freport(this);
 	IListCtrlImpl list(m_pList->m_hWnd);
 	report.SetList(&list);
+
+	// Cells of the rows are formatted from the compare results
+	DirCmpReportRows rows(&ctxt, m_pColItems.get(), colKeys);
+	int nRows = m_pList->GetItemCount();
+	for (int i = 0; i < nRows; ++i)
+	{
+		uintptr_t key = GetItemKey(i);
+		const DIFFITEM *pdi = (key == SPECIAL_ITEM_POS) ? NULL : &ctxt.GetDiffAt(key);
+		COLORREF clrBk, clrText;
+		GetColors(i, 0, clrBk, clrText);
+		rows.AddRow(pdi, list.GetIndent(i), list.GetIconIndex(i), clrBk);
+	}
+	report.SetRows(&rows);
 	PathContext paths = ctxt.GetNormalizedPaths();
 
 	// If inside archive, convert paths
@@ -2963,6 +3291,9 @@ void CDirView::OnMarkedRescan()
 	std::for_each(SelBegin(), SelEnd(), MarkForRescan);
 	if (std::distance(SelBegin(), SelEnd()) > 0)
 	{
+		m_markedRescanKeys.clear();
+		for (DirItemIterator it = SelBegin(); it != SelEnd(); ++it)
+			m_markedRescanKeys.push_back(reinterpret_cast<uintptr_t>(&*it));
 		m_pSavedTreeState.reset(SaveTreeState(GetDiffContext()));
 		GetDocument()->SetMarkedRescan();
 		GetDocument()->Rescan();
@@ -3690,6 +4021,9 @@ int CDirView::AddNewItem(int i, uintptr_t diffpos, int iImage, int iIndent)
  */
 void CDirView::UpdateDiffItemStatus(UINT nIdx)
 {
+	uintptr_t key = GetItemKey(nIdx);
+	if (key != SPECIAL_ITEM_POS)
+		m_pColTextCache->Invalidate(GetDiffContext().GetDiffAt(key));
 	GetListCtrl().RedrawItems(nIdx, nIdx);
 }
 
@@ -3734,8 +4068,7 @@ void CDirView::ReflectGetdispinfo(NMLVDISPINFO *pParam)
 	const DIFFITEM &di = ctxt.GetDiffAt(key);
 	if (pParam->item.mask & LVIF_TEXT)
 	{
-		String s = m_pColItems->ColGetTextToDisplay(&ctxt, i, di);
-		pParam->item.pszText = AllocDispinfoText(s);
+		pParam->item.pszText = AllocDispinfoText(m_pColTextCache->GetText(*m_pColItems, &ctxt, i, di));
 	}
 	if (pParam->item.mask & LVIF_IMAGE)
 	{
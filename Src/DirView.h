@@ -33,6 +33,7 @@
 #include "UnicodeString.h"
 #include "DirItemIterator.h"
 #include "DirActions.h"
+#include "DirViewResultList.h"
 
 class FileActionScript;
 
@@ -52,6 +53,7 @@ class CLoadSaveCodepageDlg;
 class CShellContextMenu;
 class CDiffContext;
 class DirViewColItems;
+class DirViewColTextCache;
 class DirItemEnumerator;
 struct IListCtrl;
 
@@ -160,6 +162,7 @@ public:
 		static int CALLBACK CompareFunc(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort);
 	} friend;
 	void UpdateDiffItemStatus(UINT nIdx);
+	void RepositionItems(const std::vector<uintptr_t>& keys);
 private:
 	void InitiateSort();
 	void NameColumn(const char* idname, int subitem);
@@ -189,6 +192,13 @@ protected:
 	int AddSpecialItems();
 	void GetCurrentColRegKeys(std::vector<String>& colKeys);
 	void OpenSpecialItems(uintptr_t pos1, uintptr_t pos2, uintptr_t pos3);
+	void ShowCompletedItems();
+	void EndShowingCompletedItems();
+	bool IsListedWhileComparing(uintptr_t diffpos) const;
+	void ReloadResultList();
+	void RebuildFromResultList();
+	void ApplyResultListChanges(const std::vector<DirViewResultList::Change>& changes);
+	int CountDifferentItems() const;
 
 // Implementation data
 protected:
@@ -205,6 +215,9 @@ protected:
 	DirViewFilterSettings m_dirfilter;
 	std::unique_ptr<DirCompProgressBar> m_pCmpProgressBar;
 	clock_t m_compareStart; /**< Starting process time of the compare */
+	CompareStats *m_pCompareStats; /**< Stats of the running compare, NULL if not comparing */
+	std::unique_ptr<DirViewResultList> m_pResultList; /**< Rows kept in order while comparing */
+	std::vector<uintptr_t> m_markedRescanKeys; /**< Items of the running marked rescan */
 	bool m_bUserCancelEdit; /**< TRUE if the user cancels rename */
 	String m_lastCopyFolder; /**< Last Copy To -target folder. */
 
@@ -220,6 +233,7 @@ protected:
 	HMENU m_hCurrentMenu; /**< Current shell context menu (either left or right) */
 	std::unique_ptr<DirViewTreeState> m_pSavedTreeState;
 	std::unique_ptr<DirViewColItems> m_pColItems;
+	std::unique_ptr<DirViewColTextCache> m_pColTextCache; /**< Formatted texts of shown cells */
 
 	// Generated message map functions
 	afx_msg void OnColumnClick(NMHDR* pNMHDR, LRESULT* pResult);
@@ -276,6 +290,7 @@ protected:
 	afx_msg void OnRefresh();
 	afx_msg void OnUpdateRefresh(CCmdUI* pCmdUI);
 	afx_msg void OnTimer(UINT_PTR nIDEvent);
+	afx_msg void OnSettingChange(UINT uFlags, LPCTSTR lpszSection);
 	afx_msg void OnEditColumns();
 	template<SIDE_TYPE stype>
 	afx_msg void OnReadOnly();
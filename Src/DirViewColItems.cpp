@@ -178,8 +178,8 @@ static String MakeShortSize(int64_t size)
 template<class Type>
 static Type ColFileNameGet(const CDiffContext *, const void *p) //sfilename
 {
-	const boost::flyweight<String> &lfilename = static_cast<const DIFFITEM*>(p)->diffFileInfo[0].filename;
-	const boost::flyweight<String> &rfilename = static_cast<const DIFFITEM*>(p)->diffFileInfo[1].filename;
+	const FlyweightString &lfilename = static_cast<const DIFFITEM*>(p)->diffFileInfo[0].filename;
+	const FlyweightString &rfilename = static_cast<const DIFFITEM*>(p)->diffFileInfo[1].filename;
 	if (lfilename.get().empty())
 		return rfilename;
 	else if (rfilename.get().empty() || lfilename == rfilename)
@@ -278,6 +278,22 @@ static String ColStatusGet(const CDiffContext *pCtxt, const void *p)
 		else
 			s = _("File skipped");
 	}
+	else if (di.diffcode.isMoved() && di.movedItem &&
+		(di.diffcode.isSideFirstOnly() ? di.movedItem->diffcode.isSideSecondOnly() :
+			di.diffcode.isSideSecondOnly() && di.movedItem->diffcode.isSideFirstOnly()))
+	{
+		// Unique item with identical content on the other side
+		const DIFFITEM &moved = *di.movedItem;
+		const int nSide = di.diffcode.isSideFirstOnly() ? 0 : 1;
+		const int nMovedSide = 1 - nSide;
+		const String sMovedPath = paths::ConcatPath(moved.getFilepath(nMovedSide, pCtxt->GetNormalizedPath(nMovedSide)),
+				moved.diffFileInfo[nMovedSide].filename);
+		const bool bRenamed = string_compare_nocase(di.diffFileInfo[nSide].path, moved.diffFileInfo[nMovedSide].path) == 0;
+		if (nSide == 0)
+			s = string_format_string1(bRenamed ? _("Identical, renamed to: %1") : _("Identical, moved to: %1"), sMovedPath);
+		else
+			s = string_format_string1(bRenamed ? _("Identical, renamed from: %1") : _("Identical, moved from: %1"), sMovedPath);
+	}
 	else if (di.diffcode.isSideFirstOnly())
 	{
 		s = string_format_string1(_("Left only: %1"),
@@ -716,7 +732,7 @@ static int ColFileNameSort(const CDiffContext *pCtxt, const void *p, const void
 		return -1;
 	if (!ldi.diffcode.isDirectory() && rdi.diffcode.isDirectory())
 		return 1;
-	return string_compare_nocase(ColFileNameGet<boost::flyweight<String> >(pCtxt, p), ColFileNameGet<boost::flyweight<String> >(pCtxt, q));
+	return string_compare_nocase(ColFileNameGet<FlyweightString>(pCtxt, p), ColFileNameGet<FlyweightString>(pCtxt, q));
 }
 
 /**
@@ -1426,3 +1442,131 @@ String DirViewColItems::SaveColumnOrders()
 	assert(m_invcolorder.size() == m_numcols);
 	return string_join<String (*)(int)>(m_colorder.begin(), m_colorder.end(), _T(" "), string_to_str);
 }
+
+/**
+ * @brief Get text for specified column from cache.
+ * The text is formatted with DirViewColItems::ColGetTextToDisplay() when
+ * it is not cached yet or when the item has changed since.
+ * @param [in] colItems Columns of the view.
+ * @param [in] pCtxt Compare context.
+ * @param [in] col Logical column number.
+ * @param [in] di Difference data.
+ * @return Text for the specified column, valid until the cache is cleared.
+ */
+const String& DirViewColTextCache::GetText(const DirViewColItems& colItems,
+		const CDiffContext *pCtxt, int col, const DIFFITEM & di)
+{
+	size_t stamp = GetStamp(di);
+	Row& row = m_rows[&di];
+	if (row.texts.empty() || row.stamp != stamp)
+	{
+		Release(row);
+		row.stamp = stamp;
+		row.texts.assign(colItems.GetColCount(), NoText);
+	}
+	unsigned& index = row.texts[col];
+	if (index == NoText)
+		index = Intern(colItems.ColGetTextToDisplay(pCtxt, col, di));
+	return *m_texts[index].text;
+}
+
+/**
+ * @brief Forget cached texts of an item.
+ */
+void DirViewColTextCache::Invalidate(const DIFFITEM & di)
+{
+	auto it = m_rows.find(&di);
+	if (it == m_rows.end())
+		return;
+	Release(it->second);
+	m_rows.erase(it);
+}
+
+/**
+ * @brief Forget all cached texts.
+ * Must be called when the items are deleted and when the GUI language
+ * or the display options change.
+ */
+void DirViewColTextCache::Clear()
+{
+	m_rows.clear();
+	m_texts.clear();
+	m_freeTexts.clear();
+	m_textIndex.clear();
+}
+
+/**
+ * @brief Compute a value that changes when shown properties of item change.
+ */
+size_t DirViewColTextCache::GetStamp(const DIFFITEM & di)
+{
+	size_t stamp = di.diffcode.diffcode;
+	auto combine = [&stamp](size_t value) { stamp ^= value + 0x9e3779b9 + (stamp << 6) + (stamp >> 2); };
+	combine(static_cast<size_t>(di.nsdiffs));
+	combine(static_cast<size_t>(di.nidiffs));
+	combine(di.customFlags1);
+	combine(reinterpret_cast<size_t>(di.movedItem));
+	for (int i = 0; i < 3; ++i)
+	{
+		const DiffFileInfo& dfi = di.diffFileInfo[i];
+		combine(static_cast<size_t>(dfi.mtime.epochMicroseconds()));
+		combine(static_cast<size_t>(dfi.ctime.epochMicroseconds()));
+		combine(static_cast<size_t>(dfi.size));
+		combine(dfi.flags.attributes);
+		combine(reinterpret_cast<size_t>(&dfi.filename.get()));
+		combine(reinterpret_cast<size_t>(&dfi.path.get()));
+		combine(static_cast<size_t>(dfi.encoding.m_codepage));
+		combine(static_cast<size_t>(dfi.encoding.m_unicoding) + (dfi.encoding.m_bom ? 0x100 : 0));
+		combine(dfi.m_textStats.ncrlfs + (dfi.m_textStats.ncrs << 8) + (dfi.m_textStats.nlfs << 16) + (dfi.m_textStats.nzeros << 24));
+	}
+	return stamp;
+}
+
+/**
+ * @brief Store text once and return its index.
+ * The text is referenced by one more cell.
+ */
+unsigned DirViewColTextCache::Intern(const String& text)
+{
+	auto it = m_textIndex.find(text);
+	if (it == m_textIndex.end())
+	{
+		unsigned index;
+		if (!m_freeTexts.empty())
+		{
+			index = m_freeTexts.back();
+			m_freeTexts.pop_back();
+		}
+		else
+		{
+			index = static_cast<unsigned>(m_texts.size());
+			m_texts.push_back(Text());
+		}
+		it = m_textIndex.insert(std::make_pair(text, index)).first;
+		m_texts[index].text = &it->first;
+		m_texts[index].refs = 0;
+	}
+	++m_texts[it->second].refs;
+	return it->second;
+}
+
+/**
+ * @brief Release the texts of a row, freeing texts no other cell shows.
+ */
+void DirViewColTextCache::Release(Row& row)
+{
+	for (size_t i = 0; i < row.texts.size(); ++i)
+	{
+		unsigned index = row.texts[i];
+		if (index == NoText)
+			continue;
+		Text& text = m_texts[index];
+		if (--text.refs == 0)
+		{
+			m_textIndex.erase(m_textIndex.find(*text.text));
+			text.text = NULL;
+			m_freeTexts.push_back(index);
+		}
+	}
+	row.texts.clear();
+}
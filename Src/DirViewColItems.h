@@ -10,6 +10,7 @@
 #include "UnicodeString.h"
 #include <vector>
 #include <sstream>
+#include <unordered_map>
 
 struct DIFFITEM;
 class CDiffContext;
@@ -121,3 +122,46 @@ private:
 	std::vector<int> m_colorder; /**< colorder[logical#]=physical# */
 	std::vector<int> m_invcolorder; /**< invcolorder[physical]=logical# */
 };
+
+/**
+ * @brief Cache of formatted column texts of dirview rows.
+ * The list control asks for the text of every visible cell on each
+ * repaint, and formatting sizes, times and paths is slow compared to
+ * looking up an already formatted string. Texts are kept per item and
+ * logical column, equal texts are stored only once and freed when no
+ * cached cell shows them any more. A row is formatted again when the
+ * shown properties of its DIFFITEM change.
+ */
+class DirViewColTextCache
+{
+public:
+	DirViewColTextCache() {}
+	const String& GetText(const DirViewColItems& colItems, const CDiffContext *pCtxt, int col, const DIFFITEM & di);
+	void Invalidate(const DIFFITEM & di);
+	void Clear();
+	size_t GetRowCount() const { return m_rows.size(); }
+	size_t GetTextCount() const { return m_textIndex.size(); }
+
+private:
+	enum : unsigned { NoText = static_cast<unsigned>(-1) }; /**< Text not formatted yet */
+	/** @brief Cached texts of one item */
+	struct Row
+	{
+		size_t stamp; /**< GetStamp() of the item when texts were formatted */
+		std::vector<unsigned> texts; /**< Index to m_texts for each logical column */
+	};
+	/** @brief Interned text */
+	struct Text
+	{
+		const String *text; /**< Key in m_textIndex, NULL if the slot is free */
+		unsigned refs; /**< Number of cached cells showing the text */
+	};
+	static size_t GetStamp(const DIFFITEM & di);
+	unsigned Intern(const String& text);
+	void Release(Row& row);
+
+	std::unordered_map<const DIFFITEM *, Row> m_rows;
+	std::unordered_map<String, unsigned> m_textIndex; /**< Interned texts */
+	std::vector<Text> m_texts; /**< Keys of m_textIndex by index */
+	std::vector<unsigned> m_freeTexts; /**< Free slots of m_texts */
+};
@@ -0,0 +1,255 @@
+/**
+ * @file  DirViewResultList.cpp
+ *
+ * @brief Implementation file for DirViewResultList
+ *
+ */
+
+#include "DirViewResultList.h"
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+/**
+ * @brief Merge a batch of completed items into the list.
+ * Rows of completed items are updated in place when they are still in
+ * order with their neighbours, moved when their sort position changed and
+ * deleted when they no longer belong to the list. Completed items not yet
+ * in the list are inserted at their sort position.
+ * @param [in] batch Keys of the completed items.
+ * @param [in] isListed Tells if an item belongs to the list.
+ * @param [in] less Sort order of the list, if empty new items are appended.
+ * @param [out] changes Changes to apply to the list control, in order.
+ */
+void DirViewResultList::Merge(const std::vector<uintptr_t>& batch, const ItemFunc& isListed, const LessFunc& less, std::vector<Change>& changes)
+{
+	changes.clear();
+	if (batch.empty())
+		return;
+
+	std::unordered_set<uintptr_t> pending(batch.begin(), batch.end());
+	const size_t nRows = m_keys.size();
+	std::vector<char> touched(nRows);
+	for (size_t i = 0; i < nRows; ++i)
+		touched[i] = pending.count(m_keys[i]) ? 1 : 0;
+
+	// Rows not in the batch keep their order, so a completed row can stay
+	// if it is not before the previous kept row and not after the next
+	// row not in the batch.
+	std::vector<size_t> nextFixed(nRows);
+	size_t nNext = nRows;
+	for (size_t i = nRows; i-- > 0; )
+	{
+		nextFixed[i] = nNext;
+		if (!touched[i])
+			nNext = i;
+	}
+
+	std::vector<uintptr_t> kept;
+	std::vector<char> keptUpdated;
+	std::vector<uintptr_t> inserted;
+	kept.reserve(nRows);
+	keptUpdated.reserve(nRows);
+	for (size_t i = 0; i < nRows; ++i)
+	{
+		uintptr_t key = m_keys[i];
+		if (touched[i])
+		{
+			pending.erase(key);
+			bool bKeep = isListed(key);
+			if (bKeep && less)
+			{
+				if ((!kept.empty() && less(key, kept.back())) ||
+					(nextFixed[i] < nRows && less(m_keys[nextFixed[i]], key)))
+				{
+					inserted.push_back(key);
+					bKeep = false;
+				}
+			}
+			if (!bKeep)
+			{
+				Change change = { ITEM_DELETED, static_cast<int>(i), key };
+				changes.push_back(change);
+				continue;
+			}
+		}
+		kept.push_back(key);
+		keptUpdated.push_back(touched[i]);
+	}
+	// Delete from the end so the indexes of the other rows stay valid
+	std::reverse(changes.begin(), changes.end());
+
+	for (std::vector<uintptr_t>::const_iterator it = batch.begin(); it != batch.end(); ++it)
+	{
+		if (pending.erase(*it) && isListed(*it))
+			inserted.push_back(*it);
+	}
+	if (less)
+		std::stable_sort(inserted.begin(), inserted.end(), less);
+
+	// Merge the inserted rows to the kept rows, kept rows first among equal
+	m_keys.clear();
+	m_keys.reserve(kept.size() + inserted.size());
+	size_t k = 0, n = 0;
+	while (k < kept.size() || n < inserted.size())
+	{
+		Change change;
+		if (n < inserted.size() && (k == kept.size() || (less && less(inserted[n], kept[k]))))
+		{
+			change.type = ITEM_INSERTED;
+			change.key = inserted[n++];
+		}
+		else
+		{
+			change.type = ITEM_UPDATED;
+			change.key = kept[k];
+			if (!keptUpdated[k++])
+			{
+				m_keys.push_back(change.key);
+				continue;
+			}
+		}
+		change.nIndex = static_cast<int>(m_keys.size());
+		m_keys.push_back(change.key);
+		changes.push_back(change);
+	}
+}
+
+/**
+ * @brief Update the rows of completed items without moving them.
+ * Used when the rows are not kept sorted, e.g. in tree mode.
+ * @param [in] batch Keys of the completed items.
+ * @param [out] changes Rows to update.
+ */
+void DirViewResultList::Refresh(const std::vector<uintptr_t>& batch, std::vector<Change>& changes) const
+{
+	changes.clear();
+	if (batch.empty())
+		return;
+
+	std::unordered_set<uintptr_t> pending(batch.begin(), batch.end());
+	for (size_t i = 0; i < m_keys.size(); ++i)
+	{
+		if (pending.count(m_keys[i]))
+		{
+			Change change = { ITEM_UPDATED, static_cast<int>(i), m_keys[i] };
+			changes.push_back(change);
+		}
+	}
+}
+
+/**
+ * @brief Move the rows of updated items to their new sort position.
+ * The other rows must be in sort order. Updated rows still in order with
+ * their neighbours are only updated, the others are removed and inserted
+ * back at the position found by binary search, so the whole list need
+ * not be sorted again after a few items changed.
+ * @param [in] updated Keys of the updated items, keys not in the list are ignored.
+ * @param [in] less Sort order of the list, if empty the rows are only updated.
+ * @param [out] changes Changes to apply to the list control, in order.
+ */
+void DirViewResultList::Reposition(const std::vector<uintptr_t>& updated, const LessFunc& less, std::vector<Change>& changes)
+{
+	if (!less)
+	{
+		Refresh(updated, changes);
+		return;
+	}
+	changes.clear();
+	if (updated.empty())
+		return;
+
+	std::unordered_set<uintptr_t> pending(updated.begin(), updated.end());
+	const size_t nRows = m_keys.size();
+	std::vector<size_t> touchedRows;
+	for (size_t i = 0; i < nRows; ++i)
+	{
+		if (pending.count(m_keys[i]))
+			touchedRows.push_back(i);
+	}
+	if (touchedRows.empty())
+		return;
+
+	// Row after each run of touched rows
+	std::vector<size_t> nextFixed(touchedRows.size());
+	for (size_t t = touchedRows.size(); t-- > 0; )
+	{
+		const size_t i = touchedRows[t];
+		nextFixed[t] = (t + 1 < touchedRows.size() && touchedRows[t + 1] == i + 1) ? nextFixed[t + 1] : i + 1;
+	}
+
+	// A touched row can stay if it is not before the previous row kept
+	// and not after the next row that is not touched.
+	std::vector<char> moved(touchedRows.size());
+	size_t nPrevKept = nRows; // Row before the current one that stays, nRows if none
+	for (size_t t = 0; t < touchedRows.size(); ++t)
+	{
+		const size_t i = touchedRows[t];
+		const uintptr_t key = m_keys[i];
+		if (i > 0 && (t == 0 || touchedRows[t - 1] != i - 1 || !moved[t - 1]))
+			nPrevKept = i - 1;
+		if ((nPrevKept != nRows && less(key, m_keys[nPrevKept])) ||
+			(nextFixed[t] < nRows && less(m_keys[nextFixed[t]], key)))
+			moved[t] = 1;
+	}
+
+	// Delete from the end so the indexes of the other rows stay valid
+	for (size_t t = touchedRows.size(); t-- > 0; )
+	{
+		if (moved[t])
+		{
+			Change change = { ITEM_DELETED, static_cast<int>(touchedRows[t]), m_keys[touchedRows[t]] };
+			changes.push_back(change);
+		}
+	}
+
+	std::vector<uintptr_t> kept;
+	std::vector<uintptr_t> removed;
+	kept.reserve(nRows);
+	for (size_t i = 0, t = 0; i < nRows; ++i)
+	{
+		bool bTouched = t < touchedRows.size() && touchedRows[t] == i;
+		if (bTouched && moved[t])
+			removed.push_back(m_keys[i]);
+		else
+		{
+			if (bTouched)
+			{
+				Change change = { ITEM_UPDATED, static_cast<int>(kept.size()), m_keys[i] };
+				changes.push_back(change);
+			}
+			kept.push_back(m_keys[i]);
+		}
+		if (bTouched)
+			++t;
+	}
+
+	// Find the position of each removed row among the kept rows by binary
+	// search, then insert them all in one pass, kept rows first among equal.
+	std::vector<std::pair<size_t, uintptr_t> > inserted(removed.size());
+	for (size_t r = 0; r < removed.size(); ++r)
+	{
+		size_t pos = std::upper_bound(kept.begin(), kept.end(), removed[r], less) - kept.begin();
+		inserted[r] = std::make_pair(pos, removed[r]);
+	}
+	std::stable_sort(inserted.begin(), inserted.end(),
+		[&less](const std::pair<size_t, uintptr_t>& a, const std::pair<size_t, uintptr_t>& b)
+		{
+			return a.first < b.first || (a.first == b.first && less(a.second, b.second));
+		});
+
+	m_keys.clear();
+	m_keys.reserve(kept.size() + inserted.size());
+	size_t n = 0;
+	for (size_t k = 0; k <= kept.size(); ++k)
+	{
+		for (; n < inserted.size() && inserted[n].first == k; ++n)
+		{
+			Change change = { ITEM_INSERTED, static_cast<int>(m_keys.size()), inserted[n].second };
+			changes.push_back(change);
+			m_keys.push_back(inserted[n].second);
+		}
+		if (k < kept.size())
+			m_keys.push_back(kept[k]);
+	}
+}
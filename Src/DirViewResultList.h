@@ -0,0 +1,56 @@
+/**
+ * @file  DirViewResultList.h
+ *
+ * @brief Declaration file for DirViewResultList.
+ *
+ */
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+/**
+ * @brief Keeps the rows of the folder compare view in order while compare
+ * results arrive in batches.
+ *
+ * The list mirrors the item keys of the list control. For each batch of
+ * completed items it computes the rows to delete, insert and update, so
+ * the view can apply the results without rebuilding the whole list. The
+ * class does not refer to the list control or to the compare context, the
+ * items are accessed only through the functions given by the caller.
+ */
+class DirViewResultList
+{
+public:
+	/** @brief Is the first item sorted before the second item? */
+	typedef std::function<bool(uintptr_t, uintptr_t)> LessFunc;
+	/** @brief Does the item belong to the list? */
+	typedef std::function<bool(uintptr_t)> ItemFunc;
+
+	enum ChangeType
+	{
+		ITEM_DELETED, /**< Row nIndex was deleted */
+		ITEM_INSERTED, /**< Row was inserted to nIndex */
+		ITEM_UPDATED, /**< Row nIndex has new data */
+	};
+
+	/** @brief One change to apply to the list control, in order */
+	struct Change
+	{
+		ChangeType type;
+		int nIndex;
+		uintptr_t key;
+	};
+
+	void Assign(const std::vector<uintptr_t>& keys) { m_keys = keys; }
+	void Clear() { m_keys.clear(); }
+	size_t GetCount() const { return m_keys.size(); }
+	const std::vector<uintptr_t>& GetKeys() const { return m_keys; }
+	void Merge(const std::vector<uintptr_t>& batch, const ItemFunc& isListed, const LessFunc& less, std::vector<Change>& changes);
+	void Refresh(const std::vector<uintptr_t>& batch, std::vector<Change>& changes) const;
+	void Reposition(const std::vector<uintptr_t>& updated, const LessFunc& less, std::vector<Change>& changes);
+
+private:
+	std::vector<uintptr_t> m_keys; /**< Item keys in the order of the rows */
+};
@@ -0,0 +1,423 @@
+/**
+ * @file  FileCmpHtmlReport.cpp
+ *
+ * @brief Implementation file for FileCmpHtmlReport
+ *
+ */
+
+#include "FileCmpHtmlReport.h"
+#include <cassert>
+#include <memory>
+#include <Poco/ThreadPool.h>
+#include <Poco/Runnable.h>
+#include <Poco/Event.h>
+#include <Poco/Environment.h>
+#include <Poco/Exception.h>
+#include "unicoder.h"
+
+using Poco::ThreadPool;
+using Poco::Runnable;
+using Poco::Event;
+using Poco::Environment;
+using Poco::NoThreadAvailableException;
+
+namespace
+{
+
+/**
+ * @brief Append a non-negative number to the string.
+ */
+void AppendNumber(String& str, int n)
+{
+	TCHAR buf[16];
+	TCHAR *p = buf + sizeof(buf) / sizeof(buf[0]);
+	do
+	{
+		*--p = static_cast<TCHAR>('0' + n % 10);
+		n /= 10;
+	} while (n > 0);
+	str.append(p, buf + sizeof(buf) / sizeof(buf[0]));
+}
+
+/**
+ * @brief Append a CSS color value to the string.
+ */
+void AppendColor(String& str, COLORREF clr)
+{
+	str += string_format(_T("#%02x%02x%02x"), GetRValue(clr), GetGValue(clr), GetBValue(clr));
+}
+
+}
+
+/**
+ * @brief Formats and encodes a chunk of rows in a worker thread.
+ * The chunk owns the cells of its rows, so the report can collect the
+ * next chunk meanwhile.
+ */
+class FileCmpHtmlReport::ChunkFormatter : public Runnable
+{
+public:
+	ChunkFormatter(const FileCmpHtmlReport& report, std::vector<Cell>& cells)
+		: m_report(report), m_done(false)
+	{
+		m_cells.swap(cells);
+	}
+
+	void run()
+	{
+		String html;
+		m_report.FormatRows(m_cells.data(), m_cells.size() / m_report.m_nBuffers, html);
+		std::vector<Cell>().swap(m_cells);
+		ucr::toUTF8(html, m_utf8);
+		m_done.set();
+	}
+
+	bool IsDone() { return m_done.tryWait(0); }
+	void Wait() { m_done.wait(); }
+	const std::string& utf8() const { return m_utf8; }
+
+private:
+	const FileCmpHtmlReport& m_report;
+	std::vector<Cell> m_cells;
+	std::string m_utf8;
+	Event m_done;
+};
+
+/**
+ * @brief Constructor.
+ * @param [in] nBuffers Number of compared files.
+ */
+FileCmpHtmlReport::FileCmpHtmlReport(int nBuffers)
+: m_nBuffers(nBuffers)
+, m_nRows(0)
+, m_pStream(NULL)
+, m_nThreads(1)
+{
+	for (int nBuffer = 0; nBuffer < 3; nBuffer++)
+		m_nScreenChars[nBuffer] = 80;
+}
+
+/**
+ * @brief Destructor, waits for the chunks still being formatted.
+ */
+FileCmpHtmlReport::~FileCmpHtmlReport()
+{
+	if (m_pThreadPool)
+		m_pThreadPool->joinAll();
+}
+
+/**
+ * @brief Set the width of the view, long words are broken at it.
+ */
+void FileCmpHtmlReport::SetScreenChars(int nBuffer, int nScreenChars)
+{
+	m_nScreenChars[nBuffer] = nScreenChars > 0 ? nScreenChars : 1;
+}
+
+/**
+ * @brief Set the color of a color index used by the styles of the rows.
+ */
+void FileCmpHtmlReport::SetColor(int nColorIndex, COLORREF clr)
+{
+	m_colors[nColorIndex] = clr;
+}
+
+/**
+ * @brief Return the CSS classes of the color indexes and font styles.
+ * Text of color index N has class cN and background of color index N
+ * has class bN.
+ */
+String FileCmpHtmlReport::GetStyles() const
+{
+	String styles;
+	std::map<int, COLORREF>::const_iterator it;
+	for (it = m_colors.begin(); it != m_colors.end(); ++it)
+	{
+		styles += _T(".c");
+		AppendNumber(styles, it->first);
+		styles += _T(" {color: ");
+		AppendColor(styles, it->second);
+		styles += _T(";}\n");
+	}
+	for (it = m_colors.begin(); it != m_colors.end(); ++it)
+	{
+		styles += _T(".b");
+		AppendNumber(styles, it->first);
+		styles += _T(" {background-color: ");
+		AppendColor(styles, it->second);
+		styles += _T(";}\n");
+	}
+	styles +=
+		_T(".fb {font-weight: bold;}\n")
+		_T(".fi {font-style: italic;}\n");
+	return styles;
+}
+
+/**
+ * @brief Start writing rows to the stream.
+ * @param [in] stream Stream to write to.
+ * @param [in] nThreads Number of worker threads, 0 for one per processor.
+ */
+void FileCmpHtmlReport::BeginRows(std::ostream& stream, unsigned nThreads)
+{
+	if (nThreads == 0)
+		nThreads = Environment::processorCount();
+	m_pStream = &stream;
+	m_nThreads = nThreads;
+	m_nRows = 0;
+	m_cells.clear();
+	m_cells.reserve(RowsPerChunk * m_nBuffers);
+	if (m_nThreads > 1)
+		m_pThreadPool.reset(new ThreadPool(1, m_nThreads));
+}
+
+/**
+ * @brief Add a row to the report.
+ * When the current chunk is full, it is handed to a worker first.
+ * @return Cells of the row, one for each compared file. They are valid
+ * until the next call.
+ */
+FileCmpHtmlReport::Cell * FileCmpHtmlReport::AddRow()
+{
+	if (m_cells.size() >= RowsPerChunk * m_nBuffers)
+		FlushChunk();
+	m_cells.resize(m_cells.size() + m_nBuffers);
+	++m_nRows;
+	return &m_cells[m_cells.size() - m_nBuffers];
+}
+
+/**
+ * @brief Format the last chunk and write all rows not yet written.
+ * @return true if writing succeeded.
+ */
+bool FileCmpHtmlReport::EndRows()
+{
+	FlushChunk();
+	while (!m_formatters.empty())
+		WriteFormatted(true);
+	m_pThreadPool.reset();
+	bool bSuccess = !!*m_pStream;
+	m_pStream = NULL;
+	return bSuccess;
+}
+
+/**
+ * @brief Format the HTML of rows.
+ * @param [in] cells Cells of the rows, m_nBuffers cells per row.
+ * @param [in] nRows Number of rows to format.
+ * @param [in,out] html HTML of the rows is appended here.
+ */
+void FileCmpHtmlReport::FormatRows(const Cell *rows, size_t nRows, String& html) const
+{
+	int nBuffer;
+	for (size_t nRow = 0; nRow < nRows; ++nRow)
+	{
+		const Cell *cells = &rows[nRow * m_nBuffers];
+		html += _T("<tr>\n");
+		bool bBorderLine = false;
+		for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+		{
+			FormatCell(nBuffer, cells[nBuffer], html);
+			html += _T("\n");
+			if (cells[nBuffer].bHiddenBelow)
+				bBorderLine = true;
+		}
+		html += _T("</tr>\n");
+
+		if (bBorderLine)
+		{
+			html += _T("<tr height=1>");
+			for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+			{
+				if (cells[nBuffer].bHiddenBelow)
+					html += _T("<td style=\"background-color: black\"></td><td style=\"background-color: black\"></td>");
+				else
+					html += _T("<td></td><td></td>");
+			}
+			html += _T("</tr>\n");
+		}
+	}
+}
+
+/**
+ * @brief Format the line number and text cells of one side of a row.
+ */
+void FileCmpHtmlReport::FormatCell(int nBuffer, const Cell& cell, String& html) const
+{
+	if (!cell.bExists)
+	{
+		html += _T("<td class=\"ln\"></td><td></td>");
+		return;
+	}
+
+	html += _T("<td class=\"ln\">");
+	if (cell.nDiffAnchor > 0)
+	{
+		html += _T("<a name=\"d");
+		AppendNumber(html, cell.nDiffAnchor);
+		html += _T("\" href=\"#d");
+		AppendNumber(html, cell.nDiffAnchor);
+		html += _T("\">.</a>");
+	}
+	if (cell.nLineNumber > 0)
+		AppendNumber(html, cell.nLineNumber);
+	html += _T("</td>");
+
+	html += _T("<td class=\"");
+	AppendClasses(cell.style, html);
+	html += _T("\"><code>");
+
+	const int nLength = static_cast<int>(cell.sText.length());
+	const TCHAR *pszText = cell.sText.c_str();
+	int nNonbreakChars = 0;
+	bool bLastCharSpace = false;
+	const size_t nSpans = cell.spans.size();
+	for (size_t i = 0; i < nSpans; ++i)
+	{
+		int nBegin = cell.spans[i].nCharPos;
+		int nEnd = (i + 1 < nSpans) ? cell.spans[i + 1].nCharPos : nLength;
+		if (nEnd > nBegin)
+		{
+			html += _T("<span class=\"");
+			AppendClasses(cell.spans[i].style, html);
+			html += _T("\">");
+			EscapeHTML(pszText + nBegin, nEnd - nBegin, bLastCharSpace, nNonbreakChars, m_nScreenChars[nBuffer], html);
+			html += _T("</span>");
+		}
+	}
+
+	// Keep empty and blank lines visible
+	int nLastBegin = nSpans > 0 ? cell.spans[nSpans - 1].nCharPos : 0;
+	if (nSpans > 0 && cell.sText.find_first_not_of(' ', nLastBegin) == String::npos)
+		html += _T("&nbsp;");
+
+	html += _T("</code></td>");
+}
+
+/**
+ * @brief Append the CSS classes of a style to HTML.
+ */
+void FileCmpHtmlReport::AppendClasses(const Style& style, String& html)
+{
+	html += _T("c");
+	AppendNumber(html, style.nColorIndex);
+	html += _T(" b");
+	AppendNumber(html, style.nBgColorIndex);
+	if (style.bBold)
+		html += _T(" fb");
+	if (style.bItalic)
+		html += _T(" fi");
+}
+
+/**
+ * @brief Append text to HTML, escaping special characters and adding
+ * word break opportunities.
+ */
+void FileCmpHtmlReport::EscapeHTML(const TCHAR *pszText, size_t nLength, bool& bLastCharSpace, int& nNonbreakChars, int nScreenChars, String& html) const
+{
+	for (size_t i = 0; i < nLength; ++i)
+	{
+		TCHAR ch = pszText[i];
+		switch (ch)
+		{
+		case '&':
+			html += _T("&amp;");
+			bLastCharSpace = false;
+			nNonbreakChars++;
+			break;
+		case '<':
+			html += _T("&lt;");
+			bLastCharSpace = false;
+			nNonbreakChars++;
+			break;
+		case '>':
+			html += _T("&gt;");
+			bLastCharSpace = false;
+			nNonbreakChars++;
+			break;
+		case 0xB7:
+		case 0xBB:
+			html += ch;
+			html += _T("<wbr>");
+			bLastCharSpace = false;
+			nNonbreakChars = 0;
+			break;
+		case ' ':
+			if (bLastCharSpace)
+			{
+				html += _T("&nbsp;");
+				bLastCharSpace = false;
+			}
+			else
+			{
+				html += ' ';
+				bLastCharSpace = true;
+			}
+			nNonbreakChars = 0;
+			break;
+		default:
+			html += ch;
+			bLastCharSpace = false;
+			nNonbreakChars++;
+		}
+		if ((nNonbreakChars % nScreenChars) == nScreenChars - 1)
+		{
+			html += _T("<wbr>");
+			nNonbreakChars = 0;
+		}
+	}
+}
+
+/**
+ * @brief Hand the rows of the current chunk to a worker, or format them
+ * here if there are no workers.
+ * When every worker is busy, the oldest chunk is waited for and written
+ * first, so the number of chunks in memory stays bounded.
+ */
+void FileCmpHtmlReport::FlushChunk()
+{
+	if (m_cells.empty())
+		return;
+	std::unique_ptr<ChunkFormatter> formatter(new ChunkFormatter(*this, m_cells));
+	m_cells.reserve(RowsPerChunk * m_nBuffers);
+	if (!m_pThreadPool)
+	{
+		formatter->run();
+		m_formatters.push_back(std::move(formatter));
+		WriteFormatted(false);
+		return;
+	}
+
+	while (m_formatters.size() >= m_nThreads)
+		WriteFormatted(true);
+	try
+	{
+		m_pThreadPool->start(*formatter);
+	}
+	catch (NoThreadAvailableException&)
+	{
+		// A worker that has just finished may not be idle yet
+		formatter->run();
+	}
+	m_formatters.push_back(std::move(formatter));
+	WriteFormatted(false);
+}
+
+/**
+ * @brief Write the formatted chunks at the front of the queue to the stream.
+ * @param [in] bWait Wait for the first chunk if it is not done yet.
+ */
+void FileCmpHtmlReport::WriteFormatted(bool bWait)
+{
+	while (!m_formatters.empty())
+	{
+		ChunkFormatter& formatter = *m_formatters.front();
+		if (bWait)
+			formatter.Wait();
+		else if (!formatter.IsDone())
+			break;
+		bWait = false;
+		m_pStream->write(formatter.utf8().data(), formatter.utf8().size());
+		m_formatters.pop_front();
+	}
+}
@@ -0,0 +1,97 @@
+/**
+ * @file  FileCmpHtmlReport.h
+ *
+ * @brief Declaration file for FileCmpHtmlReport.
+ *
+ */
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <ostream>
+#include "UnicodeString.h"
+
+namespace Poco { class ThreadPool; }
+
+/**
+ * @brief Renders rows of a side-by-side file compare report as HTML.
+ *
+ * The rows are collected from the views into snapshots of line texts and
+ * style ids, one chunk of rows at a time. A snapshot does not refer to the
+ * views or the text buffers, so a full chunk is formatted by a worker
+ * thread while the next one is collected, and the UTF-8 encoded chunks are
+ * written to the stream in order as soon as they are done. At most one
+ * chunk per worker is kept in memory.
+ *
+ * Colors are not written for every span but as CSS classes, one for the
+ * text and one for the background of each color index, so the class names
+ * do not depend on the color scheme. The colors are set before the rows,
+ * so the classes can be written in the head of the report.
+ */
+class FileCmpHtmlReport
+{
+public:
+	/** @brief Colors and font style of text */
+	struct Style
+	{
+		int nColorIndex; /**< Color index of the text */
+		int nBgColorIndex; /**< Color index of the background */
+		bool bBold;
+		bool bItalic;
+	};
+
+	/** @brief Start of text shown in one style */
+	struct Span
+	{
+		int nCharPos; /**< Position in Cell::sText */
+		Style style;
+	};
+
+	/** @brief One side of a report row */
+	struct Cell
+	{
+		Cell() : bExists(false), nLineNumber(0), nDiffAnchor(0), style(), bHiddenBelow(false) {}
+		bool bExists; /**< Is there a line on this side? */
+		int nLineNumber; /**< Line number to show, 0 if none */
+		int nDiffAnchor; /**< Number of the difference starting here, 0 if none */
+		Style style; /**< Style of the line */
+		String sText; /**< Line text with tabs expanded */
+		std::vector<Span> spans; /**< Styled parts of the text */
+		bool bHiddenBelow; /**< Are lines hidden after this row? */
+	};
+
+	explicit FileCmpHtmlReport(int nBuffers);
+	~FileCmpHtmlReport();
+	void SetScreenChars(int nBuffer, int nScreenChars);
+	void SetColor(int nColorIndex, COLORREF clr);
+	String GetStyles() const;
+	void BeginRows(std::ostream& stream, unsigned nThreads = 0);
+	Cell * AddRow();
+	bool EndRows();
+	size_t GetRowCount() const { return m_nRows; }
+	void FormatRows(const Cell *cells, size_t nRows, String& html) const;
+
+	static const size_t RowsPerChunk = 4096; /**< Rows formatted by a worker at once */
+
+private:
+	class ChunkFormatter;
+
+	void FlushChunk();
+	void WriteFormatted(bool bWait);
+	void FormatCell(int nBuffer, const Cell& cell, String& html) const;
+	static void AppendClasses(const Style& style, String& html);
+	void EscapeHTML(const TCHAR *pszText, size_t nLength, bool& bLastCharSpace, int& nNonbreakChars, int nScreenChars, String& html) const;
+
+	int m_nBuffers;
+	int m_nScreenChars[3];
+	std::vector<Cell> m_cells; /**< Cells of the rows of the current chunk, m_nBuffers cells per row */
+	size_t m_nRows;
+	std::map<int, COLORREF> m_colors; /**< Colors by color index */
+	std::ostream *m_pStream;
+	unsigned m_nThreads;
+	std::unique_ptr<Poco::ThreadPool> m_pThreadPool;
+	std::deque<std::unique_ptr<ChunkFormatter>> m_formatters; /**< Chunks not yet written, in row order */
+};
@@ -23,6 +23,7 @@
 #include "FileFilterHelper.h"
 #include "UnicodeString.h"
 #include "FilterList.h"
+#include "FileMask.h"
 #include "DirItem.h"
 #include "FileFilterMgr.h"
 #include "paths.h"
@@ -183,6 +184,7 @@ void FileFilterHelper::UseMask(bool bUseMask)
 	else
 	{
 		m_pMaskFilter.reset();
+		m_pMask.reset();
 	}
 }
 
@@ -197,11 +199,20 @@ void FileFilterHelper::SetMask(const String& strMask)
 		throw "Filter mask tried to set when masks disabled!";
 	}
 	m_sMask = strMask;
+	m_pMaskFilter->RemoveAllFilters();
+
+	// Most masks are lists of extensions and wildcards, matched without
+	// the regular expression
+	if (!m_pMask)
+		m_pMask.reset(new FileMask);
+	if (m_pMask->SetMask(strMask))
+		return;
+	m_pMask.reset();
+
 	String regExp = ParseExtensions(strMask);
 
 	std::string regexp_str = ucr::toUTF8(regExp);
 
-	m_pMaskFilter->RemoveAllFilters();
 	m_pMaskFilter->AddRegExp(regexp_str);
 }
 
@@ -220,6 +231,9 @@ bool FileFilterHelper::includeFile(const String& szFileName) const
 			throw "Use mask set, but no filter rules for mask!";
 		}
 
+		if (m_pMask)
+			return m_pMask->Match(szFileName);
+
 		// preprend a backslash if there is none
 		String strFileName = string_makelower(szFileName);
 		if (strFileName.empty() || strFileName[0] != '\\')
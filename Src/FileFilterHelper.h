@@ -28,6 +28,7 @@
 
 class FileFilterMgr;
 class FilterList;
+class FileMask;
 struct FileFilter;
 
 /**
@@ -151,6 +152,7 @@ protected:
 
 private:
 	std::unique_ptr<FilterList> m_pMaskFilter;       /*< Filter for filemasks (*.cpp) */
+	std::unique_ptr<FileMask> m_pMask;       /*< Compiled filemask, if it could be compiled */
 	FileFilter * m_currentFilter;     /*< Currently selected filefilter */
 	std::unique_ptr<FileFilterMgr> m_fileFilterMgr;  /*< Associated FileFilterMgr */
 	String m_sFileFilterPath;        /*< Path to current filter */
@@ -0,0 +1,240 @@
+/**
+ * @file  FileMask.cpp
+ *
+ * @brief Implementation file for FileMask.
+ */
+
+#include "FileMask.h"
+
+const TCHAR FileMask::Separators[] = _T(" ;|,:");
+
+namespace
+{
+
+/**
+ * @brief File name as the mask regular expression sees it.
+ * The name is in lower case, starts with a backslash and has a dot.
+ */
+class MaskSubject
+{
+public:
+	explicit MaskSubject(const String& name)
+	: m_name(name.c_str())
+	, m_length(name.length())
+	, m_prefix((name.empty() || name[0] != '\\') ? 1 : 0)
+	, m_suffix(name.find('.') == String::npos ? 1 : 0)
+	{
+	}
+
+	size_t size() const { return m_prefix + m_length + m_suffix; }
+
+	TCHAR operator[](size_t i) const
+	{
+		if (i < m_prefix)
+			return '\\';
+		i -= m_prefix;
+		if (i < m_length)
+			return static_cast<TCHAR>(_totlower(m_name[i]));
+		return '.';
+	}
+
+	/** @brief Return index of the extension after the last dot. */
+	size_t ExtensionBegin() const
+	{
+		if (m_suffix)
+			return size();
+		size_t i = m_length;
+		while (m_name[i - 1] != '.')
+			--i;
+		return m_prefix + i;
+	}
+
+	/** @brief Return number of code units in the character at @p i. */
+	size_t CharLength(size_t i) const
+	{
+		// The regular expression is matched in UTF-8, so '?' matches a
+		// surrogate pair
+		if (sizeof(TCHAR) == 2 && i + 1 < size() &&
+			(*this)[i] >= 0xD800 && (*this)[i] <= 0xDBFF &&
+			(*this)[i + 1] >= 0xDC00 && (*this)[i + 1] <= 0xDFFF)
+			return 2;
+		return 1;
+	}
+
+private:
+	const TCHAR *m_name;
+	size_t m_length;
+	size_t m_prefix;
+	size_t m_suffix;
+};
+
+inline size_t HashChar(size_t hash, TCHAR c)
+{
+	return (hash ^ static_cast<size_t>(c)) * 16777619;
+}
+
+const size_t HashInit = 2166136261U;
+
+/**
+ * @brief Match a wildcard pattern to the end of the name.
+ * @param [in] pattern Pattern in lower case, '*' matches any characters and
+ * '?' matches one character.
+ * @param [in] subject Name to match.
+ * @param [in] start Index in name where the pattern must start matching.
+ */
+bool MatchWildcards(const String& pattern, const MaskSubject& subject, size_t start)
+{
+	const size_t patternLength = pattern.length();
+	const size_t length = subject.size();
+	size_t p = 0, i = start;
+	size_t starP = String::npos, starI = 0;
+	while (i < length)
+	{
+		if (p < patternLength)
+		{
+			TCHAR c = pattern[p];
+			if (c == '*')
+			{
+				starP = ++p;
+				starI = i;
+				continue;
+			}
+			if (c == '?')
+			{
+				i += subject.CharLength(i);
+				++p;
+				continue;
+			}
+			if (c == subject[i])
+			{
+				++i;
+				++p;
+				continue;
+			}
+		}
+		// Let the last star match one more character
+		if (starP == String::npos)
+			return false;
+		starI += subject.CharLength(starI);
+		i = starI;
+		p = starP;
+	}
+	while (p < patternLength && pattern[p] == '*')
+		++p;
+	return p == patternLength;
+}
+
+}
+
+/**
+ * @brief Default constructor, the mask matches nothing.
+ */
+FileMask::FileMask()
+: m_bMatchAll(false)
+{
+}
+
+/**
+ * @brief Compile the mask.
+ * Patterns are separated like FileFilterHelper::ParseExtensions() separates
+ * them. Like its regular expression, the mask matches all names if it has
+ * no patterns or ends with a separator.
+ * @param [in] mask Mask to compile.
+ * @return false if the mask cannot be compiled.
+ */
+bool FileMask::SetMask(const String& mask)
+{
+	m_bMatchAll = false;
+	m_extensions.clear();
+	m_patterns.clear();
+
+	size_t begin = 0;
+	while (begin <= mask.length())
+	{
+		size_t end = mask.find_first_of(Separators, begin);
+		if (end == String::npos)
+			end = mask.length();
+		String pattern = string_makelower(mask.substr(begin, end - begin));
+		begin = end + 1;
+		if (pattern.empty())
+			continue;
+		if (pattern.find_first_of(_T("\\+{}^")) != String::npos)
+			return false;
+
+		if (pattern.length() >= 2 && pattern[0] == '*' && pattern[1] == '.' &&
+			pattern.find_first_of(_T("*?."), 2) == String::npos)
+		{
+			String ext = pattern.substr(2);
+			size_t hash = HashInit;
+			for (size_t i = 0; i < ext.length(); ++i)
+				hash = HashChar(hash, ext[i]);
+			m_extensions.insert(std::make_pair(hash, ext));
+		}
+		else
+			m_patterns.push_back(pattern);
+	}
+
+	if ((m_extensions.empty() && m_patterns.empty()) ||
+		(!mask.empty() && _tcschr(Separators, mask[mask.length() - 1]) != NULL))
+		m_bMatchAll = true;
+	return true;
+}
+
+/**
+ * @brief Check if the name matches any pattern of the mask.
+ * @param [in] fileName Name or path of the file, in any case.
+ */
+bool FileMask::Match(const String& fileName) const
+{
+	if (m_bMatchAll)
+		return true;
+	if (!m_extensions.empty() && MatchExtension(fileName))
+		return true;
+
+	MaskSubject subject(fileName);
+	const size_t length = subject.size();
+	for (size_t i = 0; i < m_patterns.size(); ++i)
+	{
+		const String& pattern = m_patterns[i];
+		// A pattern matches at the begin of the name, or after a backslash.
+		// Starting with a star it can match at the begin of the name
+		// whenever it matches after a backslash.
+		if (MatchWildcards(pattern, subject, 0))
+			return true;
+		if (pattern[0] == '*')
+			continue;
+		for (size_t start = 1; start <= length; ++start)
+		{
+			if (subject[start - 1] == '\\' && MatchWildcards(pattern, subject, start))
+				return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Check if the extension of the name is one of "*.ext" patterns.
+ */
+bool FileMask::MatchExtension(const String& fileName) const
+{
+	MaskSubject subject(fileName);
+	const size_t begin = subject.ExtensionBegin();
+	const size_t end = subject.size();
+	size_t hash = HashInit;
+	for (size_t i = begin; i < end; ++i)
+		hash = HashChar(hash, subject[i]);
+
+	auto range = m_extensions.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const String& ext = it->second;
+		if (ext.length() != end - begin)
+			continue;
+		size_t i = 0;
+		while (i < ext.length() && ext[i] == subject[begin + i])
+			++i;
+		if (i == ext.length())
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file  FileMask.h
+ *
+ * @brief Declaration file for FileMask.
+ */
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "UnicodeString.h"
+
+/**
+ * @brief Compiled file mask (e.g. "*.cpp;*.h;*.rc").
+ *
+ * Matches file names exactly like the regular expression built from the
+ * mask by FileFilterHelper, without converting or copying the names.
+ * Patterns of form "*.ext" are looked up from a hash of extensions, other
+ * patterns are matched as wildcards. Masks having characters meaningful in
+ * the regular expression (e.g. backslash or '+') cannot be compiled, and
+ * must be matched with the regular expression.
+ */
+class FileMask
+{
+public:
+	FileMask();
+
+	bool SetMask(const String& mask);
+	bool Match(const String& fileName) const;
+
+	static const TCHAR Separators[]; /**< Characters separating patterns */
+
+private:
+	bool MatchExtension(const String& fileName) const;
+
+	bool m_bMatchAll; /**< Does the mask match all names? */
+	std::unordered_multimap<size_t, String> m_extensions; /**< "ext" of "*.ext" patterns, by hash */
+	std::vector<String> m_patterns; /**< Other patterns, in lower case */
+};
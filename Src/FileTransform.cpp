@@ -69,6 +69,7 @@ bool FileTransform_Packing(String & filepath, PackingInfo handler)
 		// use a temporary dest name
 		String srcFileName = bufferData.GetDataFileAnsi(); // <-Call order is important
 		String dstFileName = bufferData.GetDestFileName(); // <-Call order is important
+		PluginCallLock lock(*plugin);
 		bHandled = InvokePackFile(srcFileName,
 			dstFileName,
 			bufferData.GetNChanged(),
@@ -78,6 +79,7 @@ bool FileTransform_Packing(String & filepath, PackingInfo handler)
 	}
 	else
 	{
+		PluginCallLock lock(*plugin);
 		bHandled = InvokePackBuffer(*bufferData.GetDataBufferAnsi(),
 			bufferData.GetNChanged(),
 			piScript, handler.subcode);
@@ -129,6 +131,7 @@ bool FileTransform_Unpacking(String & filepath, const PackingInfo * handler, int
 		// use a temporary dest name
 		String srcFileName = bufferData.GetDataFileAnsi(); // <-Call order is important
 		String dstFileName = bufferData.GetDestFileName(); // <-Call order is important
+		PluginCallLock lock(*plugin);
 		bHandled = InvokeUnpackFile(srcFileName,
 			dstFileName,
 			bufferData.GetNChanged(),
@@ -138,6 +141,7 @@ bool FileTransform_Unpacking(String & filepath, const PackingInfo * handler, int
 	}
 	else
 	{
+		PluginCallLock lock(*plugin);
 		bHandled = InvokeUnpackBuffer(*bufferData.GetDataBufferAnsi(),
 			bufferData.GetNChanged(),
 			piScript, subcode);
@@ -194,6 +198,7 @@ bool FileTransform_Unpacking(String & filepath, const String& filteredText, Pack
 		// use a temporary dest name
 		String srcFileName = bufferData.GetDataFileAnsi(); // <-Call order is important
 		String dstFileName = bufferData.GetDestFileName(); // <-Call order is important
+		PluginCallLock lock(*plugin);
 		bHandled = InvokeUnpackFile(srcFileName,
 			dstFileName,
 			bufferData.GetNChanged(),
@@ -212,6 +217,7 @@ bool FileTransform_Unpacking(String & filepath, const String& filteredText, Pack
 		{
 			handler->pluginName = plugin->m_name;
 			handler->bWithFile = false;
+			PluginCallLock lock(*plugin);
 			bHandled = InvokeUnpackBuffer(*bufferData.GetDataBufferAnsi(),
 				bufferData.GetNChanged(),
 				plugin->m_lpDispatch, handler->subcode);
@@ -284,6 +290,7 @@ bool FileTransform_Prediffing(String & filepath, PrediffingInfo handler, bool bM
 		// use a temporary dest name
 		String srcFileName = bufferData.GetDataFileAnsi(); // <-Call order is important
 		String dstFileName = bufferData.GetDestFileName(); // <-Call order is important
+		PluginCallLock lock(*plugin);
 		bHandled = InvokePrediffFile(srcFileName,
 			dstFileName,
 			bufferData.GetNChanged(),
@@ -294,6 +301,7 @@ bool FileTransform_Prediffing(String & filepath, PrediffingInfo handler, bool bM
 	else
 	{
 		// probably it is for VB/VBscript so use a BSTR as argument
+		PluginCallLock lock(*plugin);
 		bHandled = InvokePrediffBuffer(*bufferData.GetDataBufferUnicode(),
 			bufferData.GetNChanged(),
 			piScript);
@@ -337,6 +345,7 @@ bool FileTransform_Prediffing(String & filepath, const String& filteredText, Pre
 		// use a temporary dest name
 		String srcFileName = bufferData.GetDataFileAnsi(); // <-Call order is important
 		String dstFileName = bufferData.GetDestFileName(); // <-Call order is important
+		PluginCallLock lock(*plugin);
 		bHandled = InvokePrediffFile(srcFileName,
 			dstFileName,
 			bufferData.GetNChanged(),
@@ -353,6 +362,7 @@ bool FileTransform_Prediffing(String & filepath, const String& filteredText, Pre
 			handler->pluginName = plugin->m_name;
 			handler->bWithFile = false;
 			// probably it is for VB/VBscript so use a BSTR as argument
+			PluginCallLock lock(*plugin);
 			bHandled = InvokePrediffBuffer(*bufferData.GetDataBufferUnicode(),
 				bufferData.GetNChanged(),
 				plugin->m_lpDispatch);
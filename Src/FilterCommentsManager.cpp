@@ -58,14 +58,14 @@ void FilterCommentsManager::Load()
 		AutoPtr<IniFileConfiguration> pConf(new IniFileConfiguration(ucr::toUTF8(m_IniFileName)));
 		for(SectionNo = 0;;++SectionNo) 
 		{//Get each set of markers
-			FilterCommentsSet filtercommentsset;
+			std::shared_ptr<FilterCommentsSet> filtercommentsset(new FilterCommentsSet);
 			std::string SectionName = "set" + ucr::toUTF8(string_to_str(SectionNo));
-			filtercommentsset.StartMarker = pConf->getString(SectionName + ".StartMarker", "");
-			filtercommentsset.EndMarker = pConf->getString(SectionName + ".EndMarker", "");
-			filtercommentsset.InlineMarker = pConf->getString(SectionName + ".InlineMarker", "");
-			if (filtercommentsset.StartMarker.empty() && 
-				filtercommentsset.EndMarker.empty() &&
-				filtercommentsset.InlineMarker.empty())
+			filtercommentsset->StartMarker = pConf->getString(SectionName + ".StartMarker", "");
+			filtercommentsset->EndMarker = pConf->getString(SectionName + ".EndMarker", "");
+			filtercommentsset->InlineMarker = pConf->getString(SectionName + ".InlineMarker", "");
+			if (filtercommentsset->StartMarker.empty() && 
+				filtercommentsset->EndMarker.empty() &&
+				filtercommentsset->InlineMarker.empty())
 			{
 				break;
 			}
@@ -92,28 +92,31 @@ void FilterCommentsManager::Load()
 /**
 	@brief Get comment markers that are associated with this file type.
 		If there are no comment markers associated with this file type,
-		then return an empty set.
+		then return NULL.
 	@param[in]  The file name extension. Example:("cpp", "java", "c", "h")
 				Must be lower case.
+	@note The returned set is shared and lives as long as the manager,
+		so look it up once per file, not once per diff block.
 */
-FilterCommentsSet FilterCommentsManager::GetSetForFileType(const String& FileTypeName) const
+const FilterCommentsSet * FilterCommentsManager::GetSetForFileType(const String& FileTypeName) const
 {
-	std::map <String, FilterCommentsSet> :: const_iterator pSet =
+	std::map <String, FilterCommentsSetPtr> :: const_iterator pSet =
 		m_FilterCommentsSetByFileType.find(FileTypeName);
 	if (pSet == m_FilterCommentsSetByFileType.end())
-		return FilterCommentsSet();
-	return pSet->second;
+		return NULL;
+	return pSet->second.get();
 }
 
 void FilterCommentsManager::CreateDefaultMarkers()
 {
-	FilterCommentsSet filtercommentsset[2];
-	filtercommentsset[0].StartMarker = "/*";
-	filtercommentsset[0].EndMarker = "*/";
-	filtercommentsset[0].InlineMarker = "//";
-	filtercommentsset[1].StartMarker = "";
-	filtercommentsset[1].EndMarker = "";
-	filtercommentsset[1].InlineMarker = "'";
+	std::shared_ptr<FilterCommentsSet> filtercommentsset[2] = {
+		std::make_shared<FilterCommentsSet>(), std::make_shared<FilterCommentsSet>() };
+	filtercommentsset[0]->StartMarker = "/*";
+	filtercommentsset[0]->EndMarker = "*/";
+	filtercommentsset[0]->InlineMarker = "//";
+	filtercommentsset[1]->StartMarker = "";
+	filtercommentsset[1]->EndMarker = "";
+	filtercommentsset[1]->InlineMarker = "'";
 	TCHAR CommonFileTypes[][16][9] = {
 		{ _T("java"), _T("cs"), _T("cpp"), _T("c"), _T("h"), _T("cxx"), _T("cc"), _T("js"), _T("jsl"), _T("tli"), _T("tlh"), _T("rc") },
 		{ _T("bas"), _T("vb"), _T("vbs"), _T("frm"), _T("dsm"), _T("cls"), _T("ctl"), _T("pag"), _T("dsr") }
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include "UnicodeString.h"
 
 //IngnoreComment logic developed by David Maisonave AKA (Axter)
@@ -43,12 +44,16 @@ struct FilterCommentsSet
 	std::string InlineMarker;
 };
 
+typedef std::shared_ptr<const FilterCommentsSet> FilterCommentsSetPtr;
+
 /**
 @class FilterCommentsManager
 @brief FilterCommentsManager reads language comment start and end marker strings from
 		an INI file, and stores it in the map member variable m_FilterCommentsSetByFileType.
 		Each set of comment markers have a list of file types that can be used with
 		the file markers.
+		The sets are built once and never modified, so all the file types of a set,
+		and all the compare threads, share the same FilterCommentsSet.
 @note
 The ignore-comment logic can only use ANSI strings, because the search buffer is
 char* type.
@@ -62,7 +67,7 @@ class FilterCommentsManager
 {
 public:
 	explicit FilterCommentsManager(const String &IniFileName = _T(""));
-	FilterCommentsSet GetSetForFileType(const String& FileTypeName) const;
+	const FilterCommentsSet * GetSetForFileType(const String& FileTypeName) const;
 
 private:
 	FilterCommentsManager(const FilterCommentsManager&); //Don't allow copy
@@ -71,6 +76,6 @@ private:
 	void Load();
 
 	//Use CString instead of std::string, so as to allow UNICODE file extensions
-	std::map<String, FilterCommentsSet> m_FilterCommentsSetByFileType;
+	std::map<String, FilterCommentsSetPtr> m_FilterCommentsSetByFileType;
 	String m_IniFileName;
 };
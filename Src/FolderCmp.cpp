@@ -65,6 +65,10 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 
 	unsigned code = DIFFCODE::FILE | DIFFCODE::CMPERR;
 
+	// Same instance compares many files, forget counts of previous file
+	m_ndiffs = CDiffContext::DIFFS_UNKNOWN;
+	m_ntrivialdiffs = CDiffContext::DIFFS_UNKNOWN;
+
 	if (nCompMethod == CMP_CONTENT ||
 		nCompMethod == CMP_QUICK_CONTENT)
 	{
@@ -182,7 +186,7 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 					m_pDiffUtilsEngine.reset(new CompareEngines::DiffUtils());
 				m_pDiffUtilsEngine->SetCodepage(codepage);
 				bool success = m_pDiffUtilsEngine->SetCompareOptions(
-						*pCtxt->GetCompareOptions(CMP_CONTENT));
+						pCtxt->GetContentCompareOptions());
 				if (success)
 				{
 					if (pCtxt->m_pFilterList != NULL)
@@ -190,11 +194,28 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 					else
 						m_pDiffUtilsEngine->ClearFilterList();
 					m_pDiffUtilsEngine->SetFilterCommentsManager(pCtxt->m_pFilterCommentsManager);
+					m_pDiffUtilsEngine->SetAdditionalOptions(pCtxt->m_bStopAfterFirstDiff);
 					m_pDiffUtilsEngine->SetFileData(2, m_diffFileData.m_inf);
-					code = m_pDiffUtilsEngine->diffutils_compare_files();
-					m_pDiffUtilsEngine->GetDiffCounts(m_ndiffs, m_ntrivialdiffs);
-					m_pDiffUtilsEngine->GetTextStats(0, &m_diffFileData.m_textStats[0]);
-					m_pDiffUtilsEngine->GetTextStats(1, &m_diffFileData.m_textStats[1]);
+
+					// Most files are the same, so check that first by reading
+					// the files line by line with the options set above
+					if (m_pTextPrecheck == NULL)
+						m_pTextPrecheck.reset(new CompareEngines::TextPrecheck());
+					if (m_pTextPrecheck->CompareFiles(m_diffFileData.m_inf))
+					{
+						code = DIFFCODE::FILE | DIFFCODE::TEXT | DIFFCODE::SAME;
+						m_ndiffs = 0;
+						m_ntrivialdiffs = 0;
+						m_pTextPrecheck->GetTextStats(0, &m_diffFileData.m_textStats[0]);
+						m_pTextPrecheck->GetTextStats(1, &m_diffFileData.m_textStats[1]);
+					}
+					else
+					{
+						code = m_pDiffUtilsEngine->diffutils_compare_files();
+						m_pDiffUtilsEngine->GetDiffCounts(m_ndiffs, m_ntrivialdiffs);
+						m_pDiffUtilsEngine->GetTextStats(0, &m_diffFileData.m_textStats[0]);
+						m_pDiffUtilsEngine->GetTextStats(1, &m_diffFileData.m_textStats[1]);
+					}
 				}
 				else
 					code = DIFFCODE::FILE | DIFFCODE::TEXT | DIFFCODE::CMPERR;
@@ -213,7 +234,7 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 					m_pDiffUtilsEngine.reset(new CompareEngines::DiffUtils());
 				m_pDiffUtilsEngine->SetCodepage(codepage);
 				bool success = m_pDiffUtilsEngine->SetCompareOptions(
-						*pCtxt->GetCompareOptions(CMP_CONTENT));
+						pCtxt->GetContentCompareOptions());
 				if (success)
 				{
 					if (pCtxt->m_pFilterList != NULL)
@@ -225,10 +246,13 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 					bool bRet;
 					int bin_flag = 0, bin_flag10 = 0, bin_flag12 = 0;
 
+					// Keep line hashes so Make3wayDiff can compare file 0 and file 2 by them
+					keep_line_hashes = 1;
 					m_pDiffUtilsEngine->SetFileData(2, diffdata10.m_diffFileData.m_inf);
 					bRet = m_pDiffUtilsEngine->Diff2Files(&script10, 0, &bin_flag10, false, NULL);
 					m_pDiffUtilsEngine->SetFileData(2, diffdata12.m_diffFileData.m_inf);
 					bRet = m_pDiffUtilsEngine->Diff2Files(&script12, 0, &bin_flag12, false, NULL);
+					keep_line_hashes = 0;
 					code = DIFFCODE::FILE;
 
 					CDiffWrapper dw;
@@ -275,7 +299,7 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 				if (m_pByteCompare == NULL)
 					m_pByteCompare.reset(new ByteCompare());
 				bool success = m_pByteCompare->SetCompareOptions(
-					*pCtxt->GetCompareOptions(CMP_QUICK_CONTENT));
+					pCtxt->GetQuickCompareOptions());
 	
 				if (success)
 				{
@@ -304,7 +328,7 @@ int FolderCmp::prepAndCompareFiles(CDiffContext * pCtxt, DIFFITEM &di)
 				if (m_pByteCompare == NULL)
 					m_pByteCompare.reset(new ByteCompare());
 				bool success = m_pByteCompare->SetCompareOptions(
-					*pCtxt->GetCompareOptions(CMP_QUICK_CONTENT));
+					pCtxt->GetQuickCompareOptions());
 	
 				if (success)
 				{
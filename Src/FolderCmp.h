@@ -9,6 +9,7 @@
 #include "DiffFileData.h"
 #include "DiffUtils.h"
 #include "ByteCompare.h"
+#include "TextPrecheck.h"
 #include "BinaryCompare.h"
 #include "TimeSizeCompare.h"
 #include "PathContext.h"
@@ -33,7 +34,8 @@ struct PluginsContext
  * @brief Class implementing file compare for folder compare.
  * This class implements (called from DirScan.cpp) compare of two files
  * during folder compare. The class implements both diffutils compare and
- * quick compare.
+ * quick compare. Each compare thread uses one instance for all its files, so
+ * the compare engines are created and given the options once.
  */
 class FolderCmp
 {
@@ -52,6 +54,7 @@ public:
 private:
 	std::unique_ptr<CompareEngines::DiffUtils> m_pDiffUtilsEngine;
 	std::unique_ptr<CompareEngines::ByteCompare> m_pByteCompare;
+	std::unique_ptr<CompareEngines::TextPrecheck> m_pTextPrecheck;
 	std::unique_ptr<CompareEngines::BinaryCompare> m_pBinaryCompare;
 	std::unique_ptr<CompareEngines::TimeSizeCompare> m_pTimeSizeCompare;
 };
@@ -31,6 +31,8 @@
 
 #include "StdAfx.h"
 #include "GhostTextBuffer.h"
+#include <algorithm>
+#include "LineArray.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -113,6 +115,8 @@ bool CGhostTextBuffer::InternalDeleteGhostLine (CCrystalTextView * pSource,
 		m_aLines[i].Clear();
 	}
 
+	m_LineFlagIndex.DeleteLines(nLine, nCount);
+	m_LineFlagRanges.DeleteLines(nLine, nCount);
 	vector<LineInfo>::iterator iterBegin = m_aLines.begin() + nLine;
 	vector<LineInfo>::iterator iterEnd = iterBegin + nCount;
 	m_aLines.erase(iterBegin, iterEnd);
@@ -152,6 +156,31 @@ void CGhostTextBuffer::GetTextWithoutEmptys(int nStartLine, int nStartChar,
                  int nEndLine, int nEndChar, 
                  CString &text, CRLFSTYLE nCrlfStyle /* CRLF_STYLE_AUTOMATIC */,
                  bool bExcludeInvisibleLines/*=true*/)
+{
+	// first pass gets the exact size, second pass copies the text
+	const int nLength = CopyTextWithoutEmptys(nStartLine, nStartChar, nEndLine, nEndChar,
+		NULL, nCrlfStyle, bExcludeInvisibleLines);
+	LPTSTR pszBuf = text.GetBuffer(nLength);
+	CopyTextWithoutEmptys(nStartLine, nStartChar, nEndLine, nEndChar,
+		pszBuf, nCrlfStyle, bExcludeInvisibleLines);
+	text.ReleaseBuffer(nLength);
+}
+
+/**
+ * @brief Copy text of specified lines to a buffer (ghost lines will not
+ * contribute to text).
+ *
+ * Ghost lines are skipped using the reality blocks and invisible lines
+ * using the flag ranges, so only the copied lines are visited. Call first with NULL buffer to get the length of the text.
+ * @param [out] pszBuf Buffer for the text, or NULL to only count the length.
+ * No terminating zero is added.
+ * @return Length of the text in characters.
+ * @sa GetTextWithoutEmptys()
+ */
+int CGhostTextBuffer::CopyTextWithoutEmptys(int nStartLine, int nStartChar, 
+                 int nEndLine, int nEndChar, LPTSTR pszBuf,
+                 CRLFSTYLE nCrlfStyle /* CRLF_STYLE_AUTOMATIC */,
+                 bool bExcludeInvisibleLines/*=true*/) const
 {
 	const size_t lines = m_aLines.size();
 	ASSERT(nStartLine >= 0 && nStartLine < static_cast<intptr_t>(lines));
@@ -159,74 +188,73 @@ void CGhostTextBuffer::GetTextWithoutEmptys(int nStartLine, int nStartChar,
 	ASSERT(nEndLine >= 0 && nEndLine < static_cast<intptr_t>(lines));
 	ASSERT(nEndChar >= 0 && nEndChar <= GetFullLineLength(nEndLine));
 	ASSERT(nStartLine < nEndLine || nStartLine == nEndLine && nStartChar <= nEndChar);
-	// some edit functions (copy...) should do nothing when there is no selection.
-	// assert to be sure to catch these 'do nothing' cases.
-//	ASSERT(nStartLine != nEndLine || nStartChar != nEndChar);
 
-	// estimate size (upper bound)
-	int nBufSize = 0;
-	int i = 0;
-	for (i = nStartLine; i <= nEndLine; ++i)
-		nBufSize += (GetFullLineLength(i) + 2); // in case we insert EOLs
-	LPTSTR pszBuf = text.GetBuffer(nBufSize);
+	// in automatic mode the EOL is read from the line buffer,
+	// otherwise we must copy this EOL type only
+	LPCTSTR pszEol = (nCrlfStyle != CRLF_STYLE_AUTOMATIC) ? GetStringEol(nCrlfStyle) : NULL;
+	const int nLastRealLine = ApparentLastRealLine();
 
-	if (nCrlfStyle != CRLF_STYLE_AUTOMATIC)
+	// find the first reality block containing or after the start line
+	std::vector<RealityBlock>::const_iterator it = m_RealityBlocks.begin();
+	int blo = 0;
+	int bhi = static_cast<int>(m_RealityBlocks.size());
+	while (blo < bhi)
 	{
-		// we must copy this EOL type only
-		const CString sEol = GetStringEol (nCrlfStyle);
+		int i = (blo + bhi) / 2;
+		const RealityBlock & block = m_RealityBlocks[i];
+		if (nStartLine >= block.nStartApparent + block.nCount)
+			blo = i + 1;
+		else
+			bhi = i;
+	}
 
-		for (i = nStartLine; i <= nEndLine; ++i)
+	int nLength = 0;
+	for (it += blo; it != m_RealityBlocks.end() && it->nStartApparent <= nEndLine; ++it)
+	{
+		int nBlockStart = it->nStartApparent;
+		int nBlockStartChar = 0;
+		if (nBlockStart <= nStartLine)
 		{
-			// exclude ghost lines
-			if ((GetLineFlags(i) & LF_GHOST) || (bExcludeInvisibleLines && (GetLineFlags(i) & LF_INVISIBLE)))
-				continue;
-
-			// copy the line, excluding the EOL
-			int soffset = (i == nStartLine ? nStartChar : 0);
-			int eoffset = (i == nEndLine ? nEndChar : GetLineLength(i));
-			int chars = eoffset - soffset;
-			LPCTSTR szLine = m_aLines[i].GetLine(soffset);
-			CopyMemory(pszBuf, szLine, chars * sizeof(TCHAR));
-			pszBuf += chars;
-
-			// copy the EOL of the requested type
-			if (i != ApparentLastRealLine())
-			{
-				CopyMemory(pszBuf, sEol, sEol.GetLength() * sizeof(TCHAR));
-				pszBuf += sEol.GetLength();
-			}
+			nBlockStart = nStartLine;
+			nBlockStartChar = nStartChar;
 		}
-	} 
-	else 
-	{
-		for (i = nStartLine; i <= nEndLine; ++i)
+		int nBlockEnd = it->nStartApparent + it->nCount - 1;
+		int nBlockEndChar;
+		if (nBlockEnd >= nEndLine)
 		{
-			// exclude ghost lines
-			if ((GetLineFlags(i) & LF_GHOST) || (bExcludeInvisibleLines && GetLineFlags(i) & LF_INVISIBLE))
-				continue;
-
-			// copy the line including the EOL
-			int soffset = (i == nStartLine ? nStartChar : 0);
-			int eoffset = (i == nEndLine ? nEndChar : GetFullLineLength(i));
-			int chars = eoffset - soffset;
-			LPCTSTR szLine = m_aLines[i].GetLine(soffset);
-			CopyMemory(pszBuf, szLine, chars * sizeof(TCHAR));
-			pszBuf += chars;
-
-			// check that we really have an EOL
-			if (i != ApparentLastRealLine() && GetLineLength(i) == GetFullLineLength(i))
+			nBlockEnd = nEndLine;
+			nBlockEndChar = nEndChar;
+		}
+		else
+			nBlockEndChar = pszEol ? GetLineLength(nBlockEnd) : GetFullLineLength(nBlockEnd);
+
+		// copy the visible runs of lines of the block
+		int nLine = nBlockStart;
+		int nLineChar = nBlockStartChar;
+		while (nLine <= nBlockEnd)
+		{
+			int nRunEnd = nBlockEnd;
+			if (bExcludeInvisibleLines)
 			{
-				// Oops, real line lacks EOL
-				// (If this happens, editor probably has bug)
-				ASSERT(0);
-				CString sEol = GetStringEol (nCrlfStyle);
-				CopyMemory(pszBuf, sEol, sEol.GetLength());
-				pszBuf += sEol.GetLength();
+				nRunEnd = (std::min)(m_LineFlagRanges.GetRunEnd(nLine) - 1, nBlockEnd);
+				if (m_LineFlagRanges.GetLineFlags(nLine) & LF_INVISIBLE)
+				{
+					nLine = nRunEnd + 1;
+					nLineChar = 0;
+					continue;
+				}
 			}
+			int nRunEndChar = nBlockEndChar;
+			if (nRunEnd < nBlockEnd)
+				nRunEndChar = pszEol ? GetLineLength(nRunEnd) : GetFullLineLength(nRunEnd);
+			nLength += LineArray::GetText(m_aLines, nLine, nLineChar,
+				nRunEnd, nRunEndChar, pszBuf ? pszBuf + nLength : NULL,
+				pszEol, nRunEnd != nLastRealLine);
+			nLine = nRunEnd + 1;
+			nLineChar = 0;
 		}
 	}
-	text.ReleaseBuffer(static_cast<int>(pszBuf - text));
-	text.FreeExtra();
+	return nLength;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -433,6 +461,18 @@ void CGhostTextBuffer::RemoveAllGhostLines()
 	int nlines = GetLineCount();
 	int newnl = 0;
 	int ct;
+	// Remove the ghost lines from the flag ranges, last ones first
+	// so the lines before them keep their numbers
+	for(ct = nlines - 1; ct >= 0; ct--)
+	{
+		if (GetLineFlags(ct) & LF_GHOST)
+		{
+			int nEnd = ct;
+			while (ct > 0 && (GetLineFlags(ct - 1) & LF_GHOST))
+				ct--;
+			m_LineFlagRanges.DeleteLines(ct, nEnd - ct + 1);
+		}
+	}
 	// Free the buffer of ghost lines
 	for(ct = 0; ct < nlines; ct++)
 	{
@@ -449,6 +489,7 @@ void CGhostTextBuffer::RemoveAllGhostLines()
 
 	// Discard unused entries in one shot
 	m_aLines.resize(newnl);
+	m_LineFlagIndex.Invalidate();
 	RecomputeRealityMapping();
 }
 
@@ -74,6 +74,10 @@ public :
 			int nEndLine, int nEndChar, CString &text,
 			CRLFSTYLE nCrlfStyle =CRLF_STYLE_AUTOMATIC,
 			bool bExcludeInvisibleLines = true);
+	int CopyTextWithoutEmptys (int nStartLine, int nStartChar,
+			int nEndLine, int nEndChar, LPTSTR pszBuf,
+			CRLFSTYLE nCrlfStyle =CRLF_STYLE_AUTOMATIC,
+			bool bExcludeInvisibleLines = true) const;
 
 
 	// Text modification functions
@@ -244,24 +244,51 @@ void CGhostTextView::GetTextWithoutEmptysInColumnSelection (CString & text, bool
 	text.FreeExtra ();
 }
 
-HGLOBAL CGhostTextView::PrepareDragData ()
+/**
+ * @brief Get text of specified lines (without ghost lines) in global memory.
+ * The exact size of the text is computed first and the text is copied
+ * straight to the allocated memory, so no temporary copy of a large
+ * selection is made for the clipboard or drag-n-drop.
+ * @param [out] cbData Size of the text in bytes, including the terminating zero.
+ * @return Memory handle, or NULL if the allocation failed.
+ */
+HGLOBAL CGhostTextView::GetTextWithoutEmptysData (int nStartLine, int nStartChar,
+		int nEndLine, int nEndChar, SIZE_T &cbData,
+		bool bExcludeInvisibleLines/*=true*/)
 {
-	PrepareSelBounds ();
-	if (m_ptDrawSelStart == m_ptDrawSelEnd)
+	cbData = 0;
+	if (m_pGhostTextBuffer == NULL)
 		return NULL;
 
-	CString text;
-	GetTextWithoutEmptys (m_ptDrawSelStart.y, m_ptDrawSelStart.x, m_ptDrawSelEnd.y, m_ptDrawSelEnd.x, text);
-	int cchText = text.GetLength();
-	SIZE_T cbData = (cchText + 1) * sizeof(TCHAR);
+	const int cchText = m_pGhostTextBuffer->CopyTextWithoutEmptys (nStartLine, nStartChar,
+		nEndLine, nEndChar, NULL, CRLF_STYLE_AUTOMATIC, bExcludeInvisibleLines);
+	cbData = (cchText + 1) * sizeof(TCHAR);
 	HGLOBAL hData =::GlobalAlloc (GMEM_MOVEABLE | GMEM_DDESHARE, cbData);
 	if (hData == NULL)
 		return NULL;
 
+	SIZE_T dwSize = ::GlobalSize (hData);
 	LPTSTR pszData = (LPTSTR)::GlobalLock (hData);
 	if (pszData)
-		memcpy (pszData, text, cbData);
+	{
+		m_pGhostTextBuffer->CopyTextWithoutEmptys (nStartLine, nStartChar,
+			nEndLine, nEndChar, pszData, CRLF_STYLE_AUTOMATIC, bExcludeInvisibleLines);
+		memset (pszData + cchText, 0, dwSize - cchText * sizeof(TCHAR));
+	}
 	::GlobalUnlock (hData);
+	return hData;
+}
+
+HGLOBAL CGhostTextView::PrepareDragData ()
+{
+	PrepareSelBounds ();
+	if (m_ptDrawSelStart == m_ptDrawSelEnd)
+		return NULL;
+
+	SIZE_T cbData;
+	HGLOBAL hData = GetTextWithoutEmptysData (m_ptDrawSelStart.y, m_ptDrawSelStart.x, m_ptDrawSelEnd.y, m_ptDrawSelEnd.x, cbData);
+	if (hData == NULL)
+		return NULL;
 
 	m_ptDraggedTextBegin = m_ptDrawSelStart;
 	m_ptDraggedTextEnd = m_ptDrawSelEnd;
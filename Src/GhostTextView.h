@@ -108,6 +108,9 @@ public:
 			bool bExcludeInvisibleLines = true);
 	virtual void GetTextWithoutEmptysInColumnSelection (CString & text,
 			bool bExcludeInvisibleLines = true);
+	HGLOBAL GetTextWithoutEmptysData (int nStartLine, int nStartChar,
+			int nEndLine, int nEndChar, SIZE_T &cbData,
+			bool bExcludeInvisibleLines = true);
 	/** 
 	 * @brief Override this drag-n-drop function to call GetTextWithoutEmptys
 	 */
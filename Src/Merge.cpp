@@ -67,6 +67,8 @@
 #include "TFile.h"
 #include "SourceControl.h"
 #include "paths.h"
+#include "UniFile.h"
+#include "MemoryStats.h"
 
 // For shutdown cleanup
 #include "charsets.h"
@@ -538,6 +540,17 @@ int CMergeApp::ExitInstance()
 	const String temp = env::GetTemporaryPath();
 	ClearTempfolder(temp);
 	delete m_mainThreadScripts;
+
+	// Dump memory stats if asked with -memstats
+	if (!m_sMemoryStatsFile.empty())
+	{
+		UniStdioFile file;
+		if (file.OpenCreateUtf8(m_sMemoryStatsFile))
+		{
+			file.WriteString(MemoryStats::ToString());
+			file.Close();
+		}
+	}
 	CWinApp::ExitInstance();
 	return 0;
 }
@@ -630,6 +643,7 @@ BOOL CMergeApp::ParseArgsAndDoOpen(MergeCmdLineInfo& cmdInfo, CMainFrame* pMainF
 	BOOL bCompared = FALSE;
 	String strDesc[3];
 	m_bNonInteractive = cmdInfo.m_bNonInteractive;
+	m_sMemoryStatsFile = cmdInfo.m_sMemoryStatsFile;
 
 	// Set the global file filter.
 	if (!cmdInfo.m_sFileFilter.empty())
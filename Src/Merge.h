@@ -171,6 +171,7 @@ private:
 	CAssureScriptsForThread * m_mainThreadScripts;
 	int m_nLastCompareResult;
 	bool m_bNonInteractive;
+	String m_sMemoryStatsFile; /**< File to dump memory stats to at exit */
 	LONG m_nActiveOperations; /**< Active operations count. */
 	bool m_bMergingMode; /**< Merging or Edit mode */
 	CFont m_fontGUI;
@@ -340,6 +340,11 @@ void MergeCmdLineInfo::ParseWinMergeCmdLine(const TCHAR *q)
 			// Get prediffer if specified (otherwise prediffer will be blank, which is default)
 			q = EatParam(q, m_sPreDiffer);
 		}
+		else if (param == _T("memstats"))
+		{
+			// -memstats "filename" - dump memory usage of compares at exit
+			q = EatParam(q, m_sMemoryStatsFile);
+		}
 		else if (param == _T("wl"))
 		{
 			// -wl to open left path as read-only
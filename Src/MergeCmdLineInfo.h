@@ -83,6 +83,7 @@ public:
 
 	String m_sOutputpath;
 	String m_sReportFile;
+	String m_sMemoryStatsFile; /**< File to dump memory stats to at exit. */
 
 	PathContext m_Files; /**< Files (or directories) to compare. */
 
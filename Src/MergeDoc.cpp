@@ -28,6 +28,7 @@
 #include "StdAfx.h"
 #include "MergeDoc.h"
 #include <cstdint>
+#include <fstream>
 #include <io.h>
 #include <Poco/Timestamp.h>
 #include "UnicodeString.h"
@@ -63,6 +64,11 @@
 #include "Merge7zFormatMergePluginImpl.h"
 #include "7zCommon.h"
 #include "PatchTool.h"
+#include "FileCmpHtmlReport.h"
+#include "OptionsDiffColors.h"
+#include "SyntaxColors.h"
+#include "DiffLineRanges.h"
+#include "MergeDocRescanJob.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -139,6 +145,7 @@ CMergeDoc::CMergeDoc()
 , m_pEncodingErrorBar(nullptr)
 , m_bHasSyncPoints(false)
 , m_bAutoMerged(false)
+, m_hRescanNotifyWnd(NULL)
 {
 	DIFFOPTIONS options = {0};
 
@@ -157,6 +164,7 @@ CMergeDoc::CMergeDoc()
 	}
 
 	m_nCurDiff=-1;
+	m_nWordDiffCacheRevision = 0;
 	m_bEnableRescan = true;
 	// COleDateTime m_LastRescan
 	curUndo = undoTgt.begin();
@@ -167,6 +175,8 @@ CMergeDoc::CMergeDoc()
 
 	m_diffWrapper.SetOptions(&options);
 	m_diffWrapper.SetPrediffer(NULL);
+
+	m_rescanThread.AddListener(this, &CMergeDoc::BackgroundRescanCallback);
 }
 
 #pragma warning(default:4355)
@@ -178,6 +188,9 @@ CMergeDoc::CMergeDoc()
  */
 CMergeDoc::~CMergeDoc()
 {	
+	m_rescanThread.Cancel();
+	m_rescanThread.RemoveListener(this, &CMergeDoc::BackgroundRescanCallback);
+
 	if (m_pDirDoc)
 	{
 		m_pDirDoc->MergeDocClosing(this);
@@ -191,6 +204,7 @@ CMergeDoc::~CMergeDoc()
 void CMergeDoc::DeleteContents ()
 {
 	CDocument::DeleteContents ();
+	m_rescanThread.Cancel();
 	for (int nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
 		m_ptBuf[nBuffer]->FreeAll ();
 	m_tempFiles[0].Delete();
@@ -349,7 +363,6 @@ int CMergeDoc::Rescan(bool &bBinary, IDENTLEVEL &identical,
 	DIFFOPTIONS diffOptions = {0};
 	DiffFileInfo fileInfo;
 	bool diffSuccess;
-	int nResult = RESCAN_OK;
 	FileChange FileChanged[3] = {FileNoChange, FileNoChange, FileNoChange};
 	int nBuffer;
 
@@ -361,15 +374,8 @@ int CMergeDoc::Rescan(bool &bBinary, IDENTLEVEL &identical,
 
 	ClearWordDiffCache();
 
-	if (GetOptionsMgr()->GetBool(OPT_LINEFILTER_ENABLED))
-	{
-		m_diffWrapper.SetFilterList(theApp.m_pLineFilters->GetAsString());
-	}
-	else
-	{
-		m_diffWrapper.SetFilterList(_T(""));
-	}
-	m_diffWrapper.SetFilterCommentsManager(theApp.m_pFilterCommentsManager.get());
+	// A background rescan would only be outdated by this one
+	m_rescanThread.Cancel();
 
 	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
 	{
@@ -414,13 +420,7 @@ int CMergeDoc::Rescan(bool &bBinary, IDENTLEVEL &identical,
 
 	// Set up DiffWrapper
 	m_diffWrapper.GetOptions(&diffOptions);
-
-	bool bForceUTF8 = diffOptions.bIgnoreCase;
-	IF_IS_TRUE_ALL (
-		m_ptBuf[0]->getCodepage() == m_ptBuf[nBuffer]->getCodepage() && m_ptBuf[nBuffer]->getUnicoding() == ucr::NONE,
-		nBuffer, m_nBuffers) {}
-	else
-		bForceUTF8 = true;
+	bool bForceUTF8 = PrepareDiffWrapper(m_diffWrapper, m_tempFiles);
 
 	// Clear diff list
 	m_diffList.Clear();
@@ -432,28 +432,20 @@ int CMergeDoc::Rescan(bool &bBinary, IDENTLEVEL &identical,
 			m_diffWrapper.GetMovedLines(nBuffer)->Clear();
 	}
 
-	// Set paths for diffing and run diff
-	m_diffWrapper.EnablePlugins(GetOptionsMgr()->GetBool(OPT_PLUGINS_ENABLED));
-	if (m_nBuffers < 3)
-		m_diffWrapper.SetPaths(PathContext(m_tempFiles[0].GetPath(), m_tempFiles[1].GetPath()), true);
-	else
-		m_diffWrapper.SetPaths(PathContext(m_tempFiles[0].GetPath(), m_tempFiles[1].GetPath(), m_tempFiles[2].GetPath()), true);
-	m_diffWrapper.SetCompareFiles(m_filePaths);
-	m_diffWrapper.SetCodepage(bForceUTF8 ? CP_UTF8 : (m_ptBuf[0]->m_encoding.m_unicoding ? CP_UTF8 : m_ptBuf[0]->m_encoding.m_codepage));
-	m_diffWrapper.SetCodepage(m_ptBuf[0]->m_encoding.m_unicoding ?
-			CP_UTF8 : m_ptBuf[0]->m_encoding.m_codepage);
-
 	DIFFSTATUS status;
 
 	if (!HasSyncPoints())
 	{
 		// Save text buffer to file
+		FileTextStats stats[3];
 		for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
 		{
 			m_ptBuf[nBuffer]->SetTempPath(tempPath);
 			SaveBuffForDiff(*m_ptBuf[nBuffer], m_tempFiles[nBuffer].GetPath(), bForceUTF8);
+			stats[nBuffer] = m_ptBuf[nBuffer]->GetTempFileTextStats();
 		}
 
+		m_diffWrapper.SetTextStats(stats);
 		m_diffWrapper.SetCreateDiffList(&m_diffList);
 		diffSuccess = !!m_diffWrapper.RunFileDiff();
 
@@ -470,13 +462,16 @@ int CMergeDoc::Rescan(bool &bBinary, IDENTLEVEL &identical,
 		for (int i = 0; i <= syncpoints.size(); ++i)
 		{
 			// Save text buffer to file
+			FileTextStats stats[3];
 			for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
 			{
 				nLines[nBuffer] = (i >= syncpoints.size()) ? -1 : syncpoints[i][nBuffer] - nStartLine[nBuffer];
 				m_ptBuf[nBuffer]->SetTempPath(tempPath);
 				SaveBuffForDiff(*m_ptBuf[nBuffer], m_tempFiles[nBuffer].GetPath(), bForceUTF8,
 					nStartLine[nBuffer], nLines[nBuffer]);
+				stats[nBuffer] = m_ptBuf[nBuffer]->GetTempFileTextStats();
 			}
+			m_diffWrapper.SetTextStats(stats);
 			DiffList templist;
 			templist.Clear();
 			m_diffWrapper.SetCreateDiffList(&templist);
@@ -497,26 +492,76 @@ int CMergeDoc::Rescan(bool &bBinary, IDENTLEVEL &identical,
 		m_diffWrapper.SetCreateDiffList(&m_diffList);
 	}
 
-	// If comparing whitespaces and
-	// other file has EOL before EOF and other not...
-	if (!diffOptions.nIgnoreWhitespace && !diffOptions.bIgnoreBlankLines)
+	int lineCount[3];
+	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+		lineCount[nBuffer] = m_ptBuf[nBuffer]->GetLineCount();
+	FixMissingEOL(m_diffWrapper, diffOptions, status, m_nBuffers, lineCount);
+
+	return ApplyRescanResult(diffSuccess, status, bBinary, identical);
+}
+
+/**
+ * @brief Set up a diff wrapper for comparing the temp files of the buffers.
+ * @param [in,out] diffWrapper Diff wrapper having the compare options set.
+ * @param [in] tempFiles Temp files the buffers are saved to.
+ * @return true if the buffers must be saved as UTF-8 for diffing.
+ */
+bool CMergeDoc::PrepareDiffWrapper(CDiffWrapper &diffWrapper, const TempFile tempFiles[])
+{
+	if (GetOptionsMgr()->GetBool(OPT_LINEFILTER_ENABLED))
 	{
-		if (std::count(status.bMissingNL, status.bMissingNL + m_nBuffers, status.bMissingNL[0]) < m_nBuffers)
-		{
-			// ..lasf DIFFRANGE of file which has EOL must be
-			// fixed to contain last line too
-			int lineCount[3];
-			for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
-				lineCount[nBuffer] = m_ptBuf[nBuffer]->GetLineCount();
-			m_diffWrapper.FixLastDiffRange(m_nBuffers, lineCount, status.bMissingNL, diffOptions.bIgnoreBlankLines);
-		}
+		diffWrapper.SetFilterList(theApp.m_pLineFilters->GetAsString());
 	}
+	else
+	{
+		diffWrapper.SetFilterList(_T(""));
+	}
+	diffWrapper.SetFilterCommentsManager(theApp.m_pFilterCommentsManager.get());
+
+	DIFFOPTIONS diffOptions = {0};
+	diffWrapper.GetOptions(&diffOptions);
+
+	int nBuffer;
+	bool bForceUTF8 = diffOptions.bIgnoreCase;
+	IF_IS_TRUE_ALL (
+		m_ptBuf[0]->getCodepage() == m_ptBuf[nBuffer]->getCodepage() && m_ptBuf[nBuffer]->getUnicoding() == ucr::NONE,
+		nBuffer, m_nBuffers) {}
+	else
+		bForceUTF8 = true;
+
+	// Set paths for diffing
+	diffWrapper.EnablePlugins(GetOptionsMgr()->GetBool(OPT_PLUGINS_ENABLED));
+	if (m_nBuffers < 3)
+		diffWrapper.SetPaths(PathContext(tempFiles[0].GetPath(), tempFiles[1].GetPath()), true);
+	else
+		diffWrapper.SetPaths(PathContext(tempFiles[0].GetPath(), tempFiles[1].GetPath(), tempFiles[2].GetPath()), true);
+	diffWrapper.SetCompareFiles(m_filePaths);
+	diffWrapper.SetCodepage(bForceUTF8 ? CP_UTF8 : (m_ptBuf[0]->m_encoding.m_unicoding ? CP_UTF8 : m_ptBuf[0]->m_encoding.m_codepage));
+	diffWrapper.SetCodepage(m_ptBuf[0]->m_encoding.m_unicoding ?
+			CP_UTF8 : m_ptBuf[0]->m_encoding.m_codepage);
+
+	return bForceUTF8;
+}
+
+/**
+ * @brief Update the buffers and the views from the result of the compare.
+ * @param [in] bDiffSuccess Did the compare succeed?
+ * @param [in] status Status of the compare.
+ * @param [in,out] bBinary Set to true if binary files were detected.
+ * @param [out] identical Identical/diff result of the compare.
+ * @return RESCAN_OK or RESCAN_FILE_ERR.
+ */
+int CMergeDoc::ApplyRescanResult(bool bDiffSuccess, DIFFSTATUS &status,
+		bool &bBinary, IDENTLEVEL &identical)
+{
+	int nResult = RESCAN_OK;
+	int nBuffer;
 
 	// set identical/diff result as recorded by diffutils
 	identical = status.Identical;
 
 	// Determine errors and binary file compares
-	if (!diffSuccess)
+	if (!bDiffSuccess)
 		nResult = RESCAN_FILE_ERR;
 	else if (status.bBinaries)
 	{
@@ -1606,6 +1651,17 @@ void CMergeDoc::FlushAndRescan(bool bForced /* =false */)
 
 	CWaitCursor waitstatus;
 
+	RescanAndUpdateViews(bForced, NULL);
+}
+
+/**
+ * @brief Rescan, or apply a background rescan, and update the views.
+ * Restores cursor and scroll position after rescanning.
+ * @param [in] bForced If true rescan cannot be suppressed
+ * @param [in] pJob Completed background rescan to apply, or NULL to rescan.
+ */
+void CMergeDoc::RescanAndUpdateViews(bool bForced, MergeDocRescanJob *pJob)
+{
 	int nActiveViewIndexType = GetActiveMergeViewIndexType();
 
 	// store cursors and hide caret
@@ -1620,7 +1676,21 @@ void CMergeDoc::FlushAndRescan(bool bForced /* =false */)
 
 	bool bBinary = false;
 	IDENTLEVEL identical = IDENTLEVEL_NONE;
-	int nRescanResult = Rescan(bBinary, identical, bForced);
+	int nRescanResult;
+	if (pJob)
+	{
+		ClearWordDiffCache();
+		m_diffList = pJob->m_diffList;
+		m_nCurDiff = -1;
+		if (m_diffWrapper.GetDetectMovedBlocks() && pJob->m_diffWrapper.GetDetectMovedBlocks())
+		{
+			for (int nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+				*m_diffWrapper.GetMovedLines(nBuffer) = *pJob->m_diffWrapper.GetMovedLines(nBuffer);
+		}
+		nRescanResult = ApplyRescanResult(pJob->m_bDiffSuccess, pJob->m_status, bBinary, identical);
+	}
+	else
+		nRescanResult = Rescan(bBinary, identical, bForced);
 
 	// restore cursors and caret
 	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
@@ -1986,8 +2056,7 @@ void CMergeDoc::PrimeTextBuffers()
 				DWORD dflag = LF_GHOST;
 				if ((file == 0 && curDiff.op == OP_3RDONLY) || (file == 2 && curDiff.op == OP_1STONLY))
 					dflag |= LF_SNP;
-				for (int i = 1; i <= nextra; i++)
-					m_ptBuf[file]->SetLineFlag(lcountnew[file]-i, dflag, true, false, false);
+				m_ptBuf[file]->SetLineFlagRange(lcountnew[file] - nextra, lcountnew[file] - 1, dflag, true);
 			}
 			lcountnew[file] -= nmaxline;
 
@@ -2024,27 +2093,19 @@ void CMergeDoc::PrimeTextBuffers()
 			{
 				for (file = 0; file < m_nBuffers; file++)
 				{
-					// left side
-					int i;
-					for (i = curDiff.dbegin; i <= curDiff.dend; i++)
-					{
-						if (curDiff.blank[file] == -1 || (int)i < curDiff.blank[file])
-						{
-							// set diff or trivial flag
-							DWORD dflag = (curDiff.op == OP_TRIVIAL) ? LF_TRIVIAL : LF_DIFF;
-							if ((file == 0 && curDiff.op == OP_3RDONLY) || (file == 2 && curDiff.op == OP_1STONLY))
-								dflag |= LF_SNP;
-							m_ptBuf[file]->SetLineFlag(i, dflag, true, false, false);
-m_ptBuf[file]->SetLineFlag(i, LF_INVISIBLE, false, false, false);
-						}
-						else
-						{
-							// ghost lines are already inserted (and flagged)
-							// ghost lines opposite to trivial lines are ghost and trivial
-							if (curDiff.op == OP_TRIVIAL)
-								m_ptBuf[file]->SetLineFlag(i, LF_TRIVIAL, true, false, false);
-						}
-					}
+					int nGhostBegin = (curDiff.blank[file] == -1) ? curDiff.dend + 1 : curDiff.blank[file];
+
+					// set diff or trivial flag
+					DWORD dflag = (curDiff.op == OP_TRIVIAL) ? LF_TRIVIAL : LF_DIFF;
+					if ((file == 0 && curDiff.op == OP_3RDONLY) || (file == 2 && curDiff.op == OP_1STONLY))
+						dflag |= LF_SNP;
+					m_ptBuf[file]->SetLineFlagRange(curDiff.dbegin, nGhostBegin - 1, dflag, true);
+					m_ptBuf[file]->SetLineFlagRange(curDiff.dbegin, nGhostBegin - 1, LF_INVISIBLE, false);
+
+					// ghost lines are already inserted (and flagged)
+					// ghost lines opposite to trivial lines are ghost and trivial
+					if (curDiff.op == OP_TRIVIAL)
+						m_ptBuf[file]->SetLineFlagRange(nGhostBegin, curDiff.dend, LF_TRIVIAL, true);
 				}
 			}
 			break;
@@ -2106,9 +2167,13 @@ CMergeDoc::FileChange CMergeDoc::IsFileChangedOnDisk(LPCTSTR szPath, DiffFileInf
 		return FileNoChange;
 }
 
+/**
+ * @brief Hide identical lines farther than the diff context from differences.
+ * The visible line ranges are built from the diff list, and only the flags
+ * of the lines in the ranges are written.
+ */
 void CMergeDoc::HideLines()
 {
-	int nLine;
 	int file;
 
 	if (m_nDiffContext < 0)
@@ -2125,40 +2190,17 @@ void CMergeDoc::HideLines()
 			nLineCount = m_ptBuf[file]->GetLineCount();
 	}
 
-	for (nLine =  0; nLine < nLineCount;)
+	DiffLineRanges lineRanges;
+	lineRanges.Build(m_diffList, nLineCount, m_nDiffContext);
+	const std::vector<DiffLineRanges::Range>& visibleRanges = lineRanges.GetVisibleRanges();
+	const std::vector<DiffLineRanges::Range> hiddenRanges = lineRanges.GetHiddenRanges();
+	for (file = 0; file < m_nBuffers; file++)
 	{
-		if (!(m_ptBuf[0]->GetLineFlags(nLine) & (LF_DIFF | LF_GHOST)))
-		{
-			for (file = 0; file < m_nBuffers; file++)
-				m_ptBuf[file]->SetLineFlag(nLine, LF_INVISIBLE, true, false, false);
-			nLine++;
-		}
-		else
-		{
-			int nLine2 = (nLine - m_nDiffContext < 0) ? 0 : (nLine - m_nDiffContext);
-			for (; nLine2 < nLine; nLine2++)
-			{
-				for (file = 0; file < m_nBuffers; file++)
-					m_ptBuf[file]->SetLineFlag(nLine2, LF_INVISIBLE, false, false, false);
-			}
-		
-			for (; nLine < nLineCount; nLine++)
-			{
-				if (!(m_ptBuf[0]->GetLineFlags(nLine) & (LF_DIFF | LF_GHOST)))
-					break;
-				for (file = 0; file < m_nBuffers; file++)
-					m_ptBuf[file]->SetLineFlag(nLine, LF_INVISIBLE, false, false, false);
-			}
-
-			int nLineEnd2 = (nLine + m_nDiffContext >= nLineCount) ? nLineCount-1 : (nLine + m_nDiffContext);
-			for (; nLine < nLineEnd2; nLine++)
-			{
-				for (file = 0; file < m_nBuffers; file++)
-					m_ptBuf[file]->SetLineFlag(nLine, LF_INVISIBLE, false, false, false);
-				if (m_ptBuf[0]->GetLineFlags(nLine) & (LF_DIFF | LF_GHOST))
-					nLineEnd2 = (nLine + 1 + m_nDiffContext >= nLineCount) ? nLineCount-1 : (nLine + 1 + m_nDiffContext);
-			}
-		}
+		std::vector<DiffLineRanges::Range>::const_iterator it;
+		for (it = hiddenRanges.begin(); it != hiddenRanges.end(); ++it)
+			m_ptBuf[file]->SetLineFlagRange(it->nBegin, it->nEnd - 1, LF_INVISIBLE, true);
+		for (it = visibleRanges.begin(); it != visibleRanges.end(); ++it)
+			m_ptBuf[file]->SetLineFlagRange(it->nBegin, it->nEnd - 1, LF_INVISIBLE, false);
 	}
 
 	for (file = 0; file < m_nBuffers; file++)
@@ -2289,8 +2331,115 @@ void CMergeDoc::RescanIfNeeded(float timeOutInSecond)
 	// else we did Rescan after the request, so do nothing
 	COleDateTimeSpan elapsed = COleDateTime::GetCurrentTime() - m_LastRescan;
 	if (elapsed.GetTotalSeconds() >= timeOutInSecond)
-		// (laoran 08-01-2003) maybe should be FlushAndRescan(true) ??
-		FlushAndRescan();
+	{
+		// Compare in the background so that typing is not blocked,
+		// if that is not possible rescan right away
+		if (!StartBackgroundRescan())
+			// (laoran 08-01-2003) maybe should be FlushAndRescan(true) ??
+			FlushAndRescan();
+	}
+}
+
+/**
+ * @brief Get a number that changes whenever the text of a buffer changes.
+ */
+unsigned CMergeDoc::GetEditRevision() const
+{
+	unsigned nRevision = 0;
+	for (int nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+		nRevision += m_ptBuf[nBuffer]->m_dwCurrentRevisionNumber;
+	return nRevision;
+}
+
+/**
+ * @brief Start comparing a snapshot of the buffers in the background.
+ * The texts are written to temp files and compared in a worker thread, a
+ * rescan already running is aborted. The result is applied in
+ * OnBackgroundRescanCompleted() if the buffers were not edited meanwhile.
+ * Rescans needing user interaction, sync points or the unpacker or
+ * prediffer plugin of the document are not run in the background.
+ * @return true if the rescan was started.
+ */
+bool CMergeDoc::StartBackgroundRescan()
+{
+	if (!m_bEnableRescan || HasSyncPoints())
+		return false;
+
+	// Plugins run only in the UI thread
+	PrediffingInfo prediffer;
+	GetPrediffer(&prediffer);
+	if (GetOptionsMgr()->GetBool(OPT_PLUGINS_ENABLED) &&
+		(!m_pInfoUnpacker->pluginName.empty() || !prediffer.pluginName.empty()))
+		return false;
+
+	int nBuffer;
+	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+	{
+		// Changed files are rescanned right away to ask about reloading
+		DiffFileInfo fileInfo;
+		if (!m_filePaths[nBuffer].empty() &&
+			IsFileChangedOnDisk(m_filePaths[nBuffer].c_str(), fileInfo, false, nBuffer) != FileNoChange)
+			return false;
+	}
+
+	std::unique_ptr<MergeDocRescanJob> pJob(new MergeDocRescanJob(GetEditRevision(), m_nBuffers));
+	LPCTSTR tnames[] = {_T("t0_wmbg"), _T("t1_wmbg"), _T("t2_wmbg")};
+	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+	{
+		if (pJob->m_tempFiles[nBuffer].Create(tnames[nBuffer]).empty())
+			return false;
+	}
+
+	m_diffWrapper.GetOptions(&pJob->m_diffOptions);
+	pJob->m_diffWrapper.SetOptions(&pJob->m_diffOptions);
+	pJob->m_diffWrapper.SetDetectMovedBlocks(m_diffWrapper.GetDetectMovedBlocks());
+	bool bForceUTF8 = PrepareDiffWrapper(pJob->m_diffWrapper, pJob->m_tempFiles);
+	// There is no prediffer, don't look for one in the worker thread
+	pJob->m_diffWrapper.EnablePlugins(false);
+
+	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+	{
+		// Same encoding SaveBuffForDiff() saves the buffer in
+		CDiffTextBuffer & buf = *m_ptBuf[nBuffer];
+		FileTextEncoding & encoding = pJob->m_encoding[nBuffer];
+		encoding = buf.getEncoding();
+		if (encoding.m_unicoding != ucr::NONE || bForceUTF8)
+		{
+			encoding.m_unicoding = ucr::UTF8;
+			encoding.SetCodepage(CP_UTF8);
+			encoding.m_bom = false;
+		}
+		buf.GetTextForTempFile(pJob->m_text[nBuffer]);
+		pJob->m_textStats[nBuffer] = buf.GetTempFileTextStats();
+		pJob->m_nLineCount[nBuffer] = buf.GetLineCount();
+	}
+
+	m_hRescanNotifyWnd = m_pView[0]->GetSafeHwnd();
+	m_LastRescan = COleDateTime::GetCurrentTime();
+	m_rescanThread.Start(pJob.release());
+	return true;
+}
+
+/**
+ * @brief Called in the worker thread when a background rescan completed.
+ */
+void CMergeDoc::BackgroundRescanCallback(unsigned& nRevision)
+{
+	PostMessage(m_hRescanNotifyWnd, MSG_RESCAN_COMPLETED, nRevision, 0);
+}
+
+/**
+ * @brief Apply the result of a completed background rescan.
+ * An outdated result is dropped; the edits that outdated it have already
+ * restarted the rescan timer.
+ */
+void CMergeDoc::OnBackgroundRescanCompleted()
+{
+	std::unique_ptr<RescanJob> pJob = m_rescanThread.TakeResult(GetEditRevision());
+	if (!pJob || !m_bEnableRescan)
+		return;
+
+	RescanAndUpdateViews(false, static_cast<MergeDocRescanJob *>(pJob.get()));
 }
 
 /**
@@ -2889,6 +3038,9 @@ bool CMergeDoc::IsMixedEOL(int nBuffer) const
 void CMergeDoc::SetEditedAfterRescan(int nBuffer)
 {
 	m_bEditAfterRescan[nBuffer] = true;
+	// The background rescan compares outdated text now, the rescan timer
+	// restarts it
+	m_rescanThread.Cancel();
 }
 
 /**
@@ -3154,6 +3306,10 @@ String CMergeDoc::GetFileExt(LPCTSTR sFileName, LPCTSTR sDescription) const
 
 /**
  * @brief Generate report from file compare results.
+ * The lines are collected from the views in chunks, which are formatted
+ * and encoded by worker threads and written as soon as they are done.
+ * Colors are written as CSS classes of the syntax color indexes, followed
+ * by the diff colors used as line colors.
  */
 bool CMergeDoc::GenerateReport(const String& sFileName) const
 {
@@ -3165,8 +3321,8 @@ bool CMergeDoc::GenerateReport(const String& sFileName) const
 	int nFontSize = -MulDiv (lf.lfHeight, 72, dc.GetDeviceCaps (LOGPIXELSY));
 
 	// create HTML report
-	UniStdioFile file;
-	if (!file.Open(sFileName, _T("wt")))
+	std::ofstream file(sFileName.c_str());
+	if (!file)
 	{
 		String errMsg = GetSysError(GetLastError());
 		String msg = string_format_string1(
@@ -3175,8 +3331,43 @@ bool CMergeDoc::GenerateReport(const String& sFileName) const
 		return false;
 	}
 
-	file.SetCodepage(CP_UTF8);
+	// CSS classes of the colors
+	FileCmpHtmlReport report(m_nBuffers);
+	SyntaxColors *pColors = m_pView[0]->GetSyntaxColors();
+	for (int nColorIndex = 0; nColorIndex < COLORINDEX_LAST; nColorIndex++)
+		report.SetColor(nColorIndex, pColors->GetColor(nColorIndex));
+	COLORSETTINGS colors;
+	Options::DiffColors::Load(GetOptionsMgr(), colors);
+	const COLORREF lineColors[] = {
+		colors.clrDiff, colors.clrSelDiff, colors.clrDiffDeleted, colors.clrSelDiffDeleted,
+		colors.clrDiffText, colors.clrSelDiffText,
+		colors.clrTrivial, colors.clrTrivialDeleted, colors.clrTrivialText,
+		colors.clrMoved, colors.clrMovedDeleted, colors.clrMovedText,
+		colors.clrSelMoved, colors.clrSelMovedDeleted, colors.clrSelMovedText,
+		colors.clrSNP, colors.clrSNPDeleted, colors.clrSNPText,
+		colors.clrSelSNP, colors.clrSelSNPDeleted, colors.clrSelSNPText,
+		colors.clrWordDiff, colors.clrWordDiffDeleted, colors.clrWordDiffText,
+		colors.clrSelWordDiff, colors.clrSelWordDiffDeleted, colors.clrSelWordDiffText,
+	};
+	// Line colors are not given as color indexes, so they are looked up,
+	// diff colors first
+	std::map<COLORREF, int> lineColorIndexes;
+	for (int i = 0; i < static_cast<int>(_countof(lineColors)); i++)
+	{
+		report.SetColor(COLORINDEX_LAST + i, lineColors[i]);
+		lineColorIndexes.insert(std::make_pair(lineColors[i], COLORINDEX_LAST + i));
+	}
+	for (int nColorIndex = 0; nColorIndex < COLORINDEX_LAST; nColorIndex++)
+		lineColorIndexes.insert(std::make_pair(pColors->GetColor(nColorIndex), nColorIndex));
+	auto colorIndex = [&lineColorIndexes](int nColorIndex, COLORREF clr, int nDefaultIndex)
+	{
+		if (nColorIndex >= 0)
+			return nColorIndex;
+		std::map<COLORREF, int>::const_iterator it = lineColorIndexes.find(clr);
+		return (it != lineColorIndexes.end()) ? it->second : nDefaultIndex;
+	};
 
+	int nBuffer;
 	String header = 
 		string_format(
 		_T("<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\"\n")
@@ -3191,18 +3382,17 @@ bool CMergeDoc::GenerateReport(const String& sFileName) const
 		_T("tr { vertical-align: top; }\n")
 		_T(".border { border-radius: 6px; border: 1px #a0a0a0 solid; box-shadow: 1px 1px 2px rgba(0, 0, 0, 0.15); overflow: hidden; }\n")
 		_T(".ln {text-align: right; word-break: normal; background-color: lightgrey; box-shadow: inset 1px 0px 0px rgba(0, 0, 0, 0.10);}\n")
-		_T(".title {color: white; background-color: blue; vertical-align: top; padding: 4px 4px; background: linear-gradient(mediumblue, darkblue);}\n")
-		_T("%s")
+		_T(".title {color: white; background-color: blue; vertical-align: top; padding: 4px 4px; background: linear-gradient(mediumblue, darkblue);}\n"),
+		nFontSize) +
+		report.GetStyles() +
 		_T("-->\n")
 		_T("</style>\n")
 		_T("</head>\n")
 		_T("<body>\n")
 		_T("<div class=\"border\">")
-		_T("<table cellspacing=\"0\" cellpadding=\"0\" style=\"width: 100%%; margin: 0; border: none;\">\n")
+		_T("<table cellspacing=\"0\" cellpadding=\"0\" style=\"width: 100%; margin: 0; border: none;\">\n")
 		_T("<thead>\n")
-		_T("<tr>\n"),
-		nFontSize, m_pView[0]->GetHTMLStyles());
-	file.WriteString(header);
+		_T("<tr>\n");
 
 	// Get paths
 	// If archive, use archive path + folder + filename inside archive
@@ -3223,34 +3413,39 @@ bool CMergeDoc::GenerateReport(const String& sFileName) const
 	}
 
 	// left and right title
-	int nBuffer;
 	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
 	{
 		int nLineNumberColumnWidth = 1;
-		String data = string_format(_T("<th class=\"title\" style=\"width:%d%%\"></th>"), 
+		header += string_format(_T("<th class=\"title\" style=\"width:%d%%\"></th>"), 
 			nLineNumberColumnWidth);
-		file.WriteString(data);
-		data = string_format(_T("<th class=\"title\" style=\"width:%f%%\">"),
+		header += string_format(_T("<th class=\"title\" style=\"width:%f%%\">"),
 			(double)(100 - nLineNumberColumnWidth * m_nBuffers) / m_nBuffers);
-		file.WriteString(data);
-		file.WriteString(paths[nBuffer].c_str());
-		file.WriteString(_T("</th>\n"));
+		header += paths[nBuffer];
+		header += _T("</th>\n");
 	}
-	file.WriteString(
+	header +=
 		_T("</tr>\n")
 		_T("</thead>\n")
-		_T("<tbody>\n"));
+		_T("<tbody>\n");
+	file << ucr::toUTF8(header);
 
 	// write the body of the report
 	int idx[3] = {0};
 	int nLineCount[3] = {0};
 	int nDiff = 0;
 	for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+	{
 		nLineCount[nBuffer] = m_ptBuf[nBuffer]->GetLineCount();
+		report.SetScreenChars(nBuffer, m_pView[nBuffer]->GetScreenChars());
+	}
+	report.BeginRows(file);
 
+	CString strText;
+	std::vector<CCrystalTextView::HTMLBLOCK> blocks;
+	CCrystalTextView::HTMLBLOCK lineBlock;
 	for (;;)
 	{
-		file.WriteString(_T("<tr>\n"));
+		FileCmpHtmlReport::Cell *cells = report.AddRow();
 		for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
 		{
 			for (; idx[nBuffer] < nLineCount[nBuffer]; idx[nBuffer]++)
@@ -3261,64 +3456,57 @@ bool CMergeDoc::GenerateReport(const String& sFileName) const
 				
 			if (idx[nBuffer] < nLineCount[nBuffer])
 			{
+				FileCmpHtmlReport::Cell& cell = cells[nBuffer];
+				cell.bExists = true;
 				// line number
-				String tdtag = _T("<td class=\"ln\">");
 				DWORD dwFlags = m_ptBuf[nBuffer]->GetLineFlags(idx[nBuffer]);
 				if (nBuffer == 0 && 
 				     (dwFlags & (LF_DIFF | LF_GHOST)) && (idx[nBuffer] == 0 || 
 				    !(m_ptBuf[nBuffer]->GetLineFlags(idx[nBuffer] - 1) & (LF_DIFF | LF_GHOST))))
 				{
 					++nDiff;
-					tdtag += string_format(_T("<a name=\"d%d\" href=\"#d%d\">.</a>"), nDiff, nDiff);
+					cell.nDiffAnchor = nDiff;
 				}
 				if (!(dwFlags & LF_GHOST) && m_pView[nBuffer]->GetViewLineNumbers())
-					tdtag += string_format(_T("%d</td>"), m_ptBuf[nBuffer]->ComputeRealLine(idx[nBuffer]) + 1);
-				else
-					tdtag += _T("</td>");
-				file.WriteString(tdtag);
-				// write a line on left/right side
-				file.WriteString((LPCTSTR)m_pView[nBuffer]->GetHTMLLine(idx[nBuffer], _T("td")));
+					cell.nLineNumber = m_ptBuf[nBuffer]->ComputeRealLine(idx[nBuffer]) + 1;
+				// a line on left/right side
+				m_pView[nBuffer]->GetHTMLLineBlocks(idx[nBuffer], strText, blocks, lineBlock);
+				cell.sText.assign((LPCTSTR)strText, strText.GetLength());
+				FileCmpHtmlReport::Style style = {
+					colorIndex(lineBlock.m_nColorIndex, lineBlock.m_clrText, COLORINDEX_NORMALTEXT),
+					colorIndex(lineBlock.m_nBgColorIndex, lineBlock.m_clrBkgnd, COLORINDEX_BKGND),
+					lineBlock.m_bBold, lineBlock.m_bItalic };
+				cell.style = style;
+				cell.spans.resize(blocks.size());
+				for (size_t i = 0; i < blocks.size(); ++i)
+				{
+					FileCmpHtmlReport::Style blockStyle = {
+						colorIndex(blocks[i].m_nColorIndex, blocks[i].m_clrText, COLORINDEX_NORMALTEXT),
+						colorIndex(blocks[i].m_nBgColorIndex, blocks[i].m_clrBkgnd, COLORINDEX_BKGND),
+						blocks[i].m_bBold, blocks[i].m_bItalic };
+					cell.spans[i].nCharPos = blocks[i].m_nCharPos;
+					cell.spans[i].style = blockStyle;
+				}
 				idx[nBuffer]++;
+				cell.bHiddenBelow = idx[nBuffer] < nLineCount[nBuffer] && !m_pView[nBuffer]->GetLineVisible(idx[nBuffer]);
 			}
-			else
-				file.WriteString(_T("<td class=\"ln\"></td><td></td>"));
-			file.WriteString(_T("\n"));
-		}
-		file.WriteString(_T("</tr>\n"));
-
-		bool bBorderLine = false;
-		for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
-		{
-			if (idx[nBuffer] < nLineCount[nBuffer] && !m_pView[nBuffer]->GetLineVisible(idx[nBuffer]))
-				bBorderLine = true;
-		}
-
-		if (bBorderLine)
-		{
-			file.WriteString(_T("<tr height=1>"));
-			for (nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
-			{
-				if (idx[nBuffer] < nLineCount[nBuffer] && !m_pView[nBuffer]->GetLineVisible(idx[nBuffer]))
-					file.WriteString(_T("<td style=\"background-color: black\"></td><td style=\"background-color: black\"></td>"));
-				else
-					file.WriteString(_T("<td></td><td></td>"));
-			}
-			file.WriteString(_T("</tr>\n"));
 		}
 
 		if (idx[0] >= nLineCount[0] && idx[1] >= nLineCount[1] && (m_nBuffers < 3 || idx[2] >= nLineCount[2]))
 			break;
 	}
-	file.WriteString(
+	report.EndRows();
+
+	file << ucr::toUTF8(
 		_T("</tbody>\n")
 		_T("</table>\n")
 		_T("</div>")
 		_T("</body>\n")
 		_T("</html>\n"));
 
-	file.Close();
+	file.close();
 
-	return true;
+	return !file.fail();
 }
 
 /**
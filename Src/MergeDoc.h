@@ -34,6 +34,8 @@
 #include "PathContext.h"
 #include "DiffFileInfo.h"
 #include "IMergeDoc.h"
+#include "RescanThread.h"
+#include "MemoryStats.h"
 
 /**
  * @brief Additional action codes for WinMerge.
@@ -143,6 +145,7 @@ class PrediffingInfo;
 class CChildFrame;
 class CDirDoc;
 class CEncodingErrorBar;
+class MergeDocRescanJob;
 
 /**
  * @brief Document class for merging two files
@@ -192,6 +195,8 @@ public:
 	void ChangeFile(int nBuffer, const String& path);
 	void RescanIfNeeded(float timeOutInSecond);
 	int Rescan(bool &bBinary, IDENTLEVEL &identical, bool bForced = false);
+	bool StartBackgroundRescan();
+	void OnBackgroundRescanCompleted();
 	void CheckFileChanged(void);
 	void ShowRescanError(int nRescanResult, IDENTLEVEL identical);
 	bool Undo();
@@ -246,9 +251,14 @@ public:
 	void Showlinediff(CMergeEditView *pView, bool bReversed = false);
 	void GetWordDiffArray(int nLineIndex, std::vector<WordDiff> *pWordDiffs);
 	void ClearWordDiffCache(int nDiff = -1);
+	unsigned GetWordDiffCacheRevision() const { return m_nWordDiffCacheRevision; }
 private:
 	void Computelinediff(CMergeEditView *pView, CRect rc[], bool bReversed);
-	std::map<int, std::vector<WordDiff> > m_cacheWordDiffs;
+	typedef std::vector<WordDiff, MemoryStats::Allocator<WordDiff, MemoryStats::WORDDIFF_CACHE> > WordDiffCacheArray;
+	typedef std::map<int, WordDiffCacheArray, std::less<int>,
+		MemoryStats::Allocator<std::pair<const int, WordDiffCacheArray>, MemoryStats::WORDDIFF_CACHE> > WordDiffCache;
+	WordDiffCache m_cacheWordDiffs; /**< Word diffs of differences, counted to memory stats */
+	unsigned m_nWordDiffCacheRevision; /**< Incremented when word diffs are cleared */
 // End MergeDocLineDiffs.cpp
 
 // Implementation in MergeDocEncoding.cpp
@@ -295,6 +305,11 @@ private:
 	bool IsValidCodepageForMergeEditor(unsigned cp) const;
 	void SanityCheckCodepage(FileLocation & fileinfo);
 	DWORD LoadOneFile(int index, String filename, bool readOnly, const String& strDesc, const FileTextEncoding & encoding);
+	bool PrepareDiffWrapper(CDiffWrapper &diffWrapper, const TempFile tempFiles[]);
+	int ApplyRescanResult(bool bDiffSuccess, DIFFSTATUS &status, bool &bBinary, IDENTLEVEL &identical);
+	void RescanAndUpdateViews(bool bForced, MergeDocRescanJob *pJob);
+	unsigned GetEditRevision() const;
+	void BackgroundRescanCallback(unsigned& nRevision);
 
 // Implementation data
 protected:
@@ -311,6 +326,8 @@ protected:
 	BUFFERTYPE m_nBufferType[3];
 	bool m_bEditAfterRescan[3]; /**< Left/middle/right doc edited after rescanning */
 	TempFile m_tempFiles[3]; /**< Temp files for compared files */
+	CRescanThread m_rescanThread; /**< Runs automatic rescans after edits */
+	HWND m_hRescanNotifyWnd; /**< Window told about completed background rescans */
 	int m_nDiffContext;
 	bool m_bMixedEol; /**< Does this document have mixed EOL style? */
 	std::unique_ptr<CEncodingErrorBar> m_pEncodingErrorBar;
@@ -126,13 +126,14 @@ void CMergeDoc::Computelinediff(CMergeEditView *pView, CRect rc[], bool bReverse
 
 void CMergeDoc::ClearWordDiffCache(int nDiff/* = -1 */)
 {
+	++m_nWordDiffCacheRevision;
 	if (nDiff == -1)
 	{
 		m_cacheWordDiffs.clear();
 	}
 	else
 	{
-		std::map<int, std::vector<WordDiff> >::iterator it = m_cacheWordDiffs.find(nDiff);
+		WordDiffCache::iterator it = m_cacheWordDiffs.find(nDiff);
 		if (it != m_cacheWordDiffs.end())
 			m_cacheWordDiffs.erase(it);
 	}
@@ -157,7 +158,7 @@ void CMergeDoc::GetWordDiffArray(int nLineIndex, vector<WordDiff> *pWordDiffs)
 	int nDiff = m_diffList.LineToDiff(nLineIndex);
 	if (nDiff == -1)
 		return;
-	std::map<int, std::vector<WordDiff> >::iterator itmap = m_cacheWordDiffs.find(nDiff);
+	WordDiffCache::iterator itmap = m_cacheWordDiffs.find(nDiff);
 	if (itmap != m_cacheWordDiffs.end())
 	{
 		pWordDiffs->resize((*itmap).second.size());
@@ -0,0 +1,68 @@
+/**
+ * @file  MergeDocRescanJob.cpp
+ *
+ * @brief Implementation file for MergeDocRescanJob.
+ *
+ */
+
+#include "MergeDocRescanJob.h"
+#include <algorithm>
+#include "UniFile.h"
+#include "IAbortable.h"
+
+/**
+ * @brief Fix the last diff range when only some files have EOL before EOF.
+ * @param [in] diffWrapper Diff wrapper that created the diff list.
+ * @param [in] diffOptions Compare options.
+ * @param [in] status Status of the compare.
+ * @param [in] nBuffers Number of compared files.
+ * @param [in] lineCount Line counts of the buffers.
+ */
+void FixMissingEOL(CDiffWrapper & diffWrapper, const DIFFOPTIONS & diffOptions,
+	DIFFSTATUS & status, int nBuffers, int lineCount[])
+{
+	// If comparing whitespaces and
+	// other file has EOL before EOF and other not...
+	if (!diffOptions.nIgnoreWhitespace && !diffOptions.bIgnoreBlankLines)
+	{
+		if (std::count(status.bMissingNL, status.bMissingNL + nBuffers, status.bMissingNL[0]) < nBuffers)
+		{
+			// ..lasf DIFFRANGE of file which has EOL must be
+			// fixed to contain last line too
+			diffWrapper.FixLastDiffRange(nBuffers, lineCount, status.bMissingNL, diffOptions.bIgnoreBlankLines);
+		}
+	}
+}
+
+/**
+ * @brief Write the texts to the temp files and compare them.
+ * Called in the worker thread.
+ */
+void MergeDocRescanJob::Run(const IAbortable& abortable)
+{
+	for (int nBuffer = 0; nBuffer < m_nBuffers; nBuffer++)
+	{
+		if (abortable.ShouldAbort())
+			return;
+
+		UniStdioFile file;
+		file.SetUnicoding(m_encoding[nBuffer].m_unicoding);
+		file.SetBom(m_encoding[nBuffer].m_bom);
+		file.SetCodepage(m_encoding[nBuffer].m_codepage);
+		if (!file.OpenCreate(m_tempFiles[nBuffer].GetPath()))
+			return;
+		file.WriteBom();
+		file.WriteString(m_text[nBuffer]);
+		file.Close();
+		String().swap(m_text[nBuffer]);
+	}
+
+	if (abortable.ShouldAbort())
+		return;
+
+	m_diffWrapper.SetTextStats(m_textStats);
+	m_diffWrapper.SetCreateDiffList(&m_diffList);
+	m_bDiffSuccess = m_diffWrapper.RunFileDiff();
+	m_diffWrapper.GetDiffStatus(&m_status);
+	FixMissingEOL(m_diffWrapper, m_diffOptions, m_status, m_nBuffers, m_nLineCount);
+}
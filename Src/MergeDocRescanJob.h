@@ -0,0 +1,44 @@
+/**
+ * @file  MergeDocRescanJob.h
+ *
+ * @brief Declaration file for MergeDocRescanJob.
+ *
+ */
+#pragma once
+
+#include "RescanThread.h"
+#include "DiffWrapper.h"
+#include "DiffList.h"
+#include "TempFile.h"
+#include "FileTextEncoding.h"
+#include "FileTextStats.h"
+#include "UnicodeString.h"
+
+/**
+ * @brief Compare stage of a rescan run in the background.
+ * Holds the texts of the buffers as they were when the rescan was started,
+ * its own temp files and diff wrapper, so the buffers can be edited while
+ * the texts are compared.
+ */
+class MergeDocRescanJob : public RescanJob
+{
+public:
+	MergeDocRescanJob(unsigned nRevision, int nBuffers)
+		: RescanJob(nRevision), m_nBuffers(nBuffers), m_bDiffSuccess(false) {}
+	virtual void Run(const IAbortable& abortable);
+
+	int m_nBuffers;
+	String m_text[3]; /**< Texts to compare, as written to the temp files */
+	FileTextStats m_textStats[3]; /**< Text stats of the texts */
+	FileTextEncoding m_encoding[3]; /**< Encodings to write the temp files in */
+	int m_nLineCount[3]; /**< Line counts of the buffers */
+	TempFile m_tempFiles[3]; /**< Temp files of this rescan */
+	DIFFOPTIONS m_diffOptions; /**< Compare options */
+	CDiffWrapper m_diffWrapper;
+	DiffList m_diffList;
+	DIFFSTATUS m_status;
+	bool m_bDiffSuccess;
+};
+
+void FixMissingEOL(CDiffWrapper & diffWrapper, const DIFFOPTIONS & diffOptions,
+	DIFFSTATUS & status, int nBuffers, int lineCount[]);
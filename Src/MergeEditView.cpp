@@ -225,6 +225,7 @@ BEGIN_MESSAGE_MAP(CMergeEditView, CCrystalEditViewEx)
 	ON_COMMAND(ID_VIEW_ZOOMIN, OnViewZoomIn)
 	ON_COMMAND(ID_VIEW_ZOOMOUT, OnViewZoomOut)
 	ON_COMMAND(ID_VIEW_ZOOMNORMAL, OnViewZoomNormal)
+	ON_MESSAGE(MSG_RESCAN_COMPLETED, OnRescanCompleted)
 	//}}AFX_MSG_MAP
 END_MESSAGE_MAP()
 
@@ -467,6 +468,40 @@ int CMergeEditView::GetAdditionalTextBlocks (int nLineIndex, TEXTBLOCK *&pBuf)
 	return static_cast<int>(j);
 }
 
+/**
+ * @brief Return the state the word difference blocks of the line depend on.
+ * The cached text blocks of the line are rebuilt when the word difference
+ * cache is cleared, the current difference or the highlight options change.
+ */
+DWORD CMergeEditView::GetAdditionalTextBlocksStamp(int nLineIndex)
+{
+	if (IsDetailViewPane())
+	{
+		if (nLineIndex < m_lineBegin || nLineIndex > m_lineEnd)
+			return 0;
+	}
+
+	DWORD dwLineFlags = GetLineFlags(nLineIndex);
+	if ((dwLineFlags & LF_SNP) == LF_SNP || (dwLineFlags & LF_DIFF) != LF_DIFF || (dwLineFlags & LF_MOVED) == LF_MOVED)
+		return 0;
+
+	if (!GetOptionsMgr()->GetBool(OPT_WORDDIFF_HIGHLIGHT))
+		return 0;
+
+	CMergeDoc *pDoc = GetDocument();
+	if (pDoc->IsEditedAfterRescan(m_nThisPane))
+		return 0;
+
+	DWORD dwStamp = 1;
+	if (IsLineInCurrentDiff(nLineIndex))
+		dwStamp |= 2;
+	if (m_cachedColors.clrSelDiffText != CLR_NONE)
+		dwStamp |= 4;
+	if (m_cachedColors.clrDiffText != CLR_NONE)
+		dwStamp |= 8;
+	return dwStamp | (pDoc->GetWordDiffCacheRevision() << 4);
+}
+
 COLORREF CMergeEditView::GetColor(int nColorIndex)
 {
 	switch (nColorIndex & ~COLORINDEX_APPLYFORCE)
@@ -883,7 +918,6 @@ void CMergeEditView::OnUpdateCurdiff(CCmdUI* pCmdUI)
  */
 void CMergeEditView::OnEditCopy()
 {
-	CMergeDoc * pDoc = GetDocument();
 	CPoint ptSelStart, ptSelEnd;
 	GetSelection(ptSelStart, ptSelEnd);
 
@@ -891,19 +925,20 @@ void CMergeEditView::OnEditCopy()
 	if (ptSelStart == ptSelEnd)
 		return;
 
-	CString text;
-
 	if (!m_bColumnSelection)
 	{
-		CDiffTextBuffer * buffer = pDoc->m_ptBuf[m_nThisPane].get();
-
-		buffer->GetTextWithoutEmptys(ptSelStart.y, ptSelStart.x,
-			ptSelEnd.y, ptSelEnd.x, text);
+		// Gather the text straight into the clipboard memory
+		SIZE_T cbData;
+		HGLOBAL hData = GetTextWithoutEmptysData(ptSelStart.y, ptSelStart.x,
+			ptSelEnd.y, ptSelEnd.x, cbData);
+		PutDataToClipboard(hData, cbData);
 	}
 	else
+	{
+		CString text;
 		GetTextWithoutEmptysInColumnSelection(text);
-
-	PutToClipboard(text, text.GetLength(), m_bColumnSelection);
+		PutToClipboard(text, text.GetLength(), m_bColumnSelection);
+	}
 }
 
 /**
@@ -930,14 +965,19 @@ void CMergeEditView::OnEditCut()
 	if (ptSelStart == ptSelEnd)
 		return;
 
-	CString text;
 	if (!m_bColumnSelection)
-		pDoc->m_ptBuf[m_nThisPane]->GetTextWithoutEmptys(ptSelStart.y, ptSelStart.x,
-			ptSelEnd.y, ptSelEnd.x, text);
+	{
+		SIZE_T cbData;
+		HGLOBAL hData = GetTextWithoutEmptysData(ptSelStart.y, ptSelStart.x,
+			ptSelEnd.y, ptSelEnd.x, cbData);
+		PutDataToClipboard(hData, cbData);
+	}
 	else
+	{
+		CString text;
 		GetTextWithoutEmptysInColumnSelection(text);
-
-	PutToClipboard(text, text.GetLength(), m_bColumnSelection);
+		PutToClipboard(text, text.GetLength(), m_bColumnSelection);
+	}
 
 	if (!m_bColumnSelection)
 	{
@@ -2148,6 +2188,15 @@ void CMergeEditView::OnTimer(UINT_PTR nIDEvent)
 	CCrystalEditViewEx::OnTimer(nIDEvent);
 }
 
+/**
+ * @brief Apply the background rescan the document's rescan thread completed.
+ */
+LRESULT CMergeEditView::OnRescanCompleted(WPARAM wParam, LPARAM lParam)
+{
+	GetDocument()->OnBackgroundRescanCompleted();
+	return 0;
+}
+
 /**
  * @brief Returns if buffer is read-only
  * @note This has no any relation to file being read-only!
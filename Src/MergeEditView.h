@@ -134,6 +134,7 @@ public:
 	void GetSelection(CPoint &ptStart, CPoint &ptEnd) { CCrystalTextView::GetSelection(ptStart, ptEnd); }
 	virtual void UpdateSiblingScrollPos (bool bHorz);
 	virtual int GetAdditionalTextBlocks (int nLineIndex, TEXTBLOCK *&pBuf);
+	virtual DWORD GetAdditionalTextBlocksStamp (int nLineIndex);
 	virtual COLORREF GetColor(int nColorIndex);
 	virtual void GetLineColors (int nLineIndex, COLORREF & crBkgnd,
 			COLORREF & crText, bool & bDrawWhitespace);
@@ -343,6 +344,7 @@ protected:
 	afx_msg void OnViewZoomIn();
 	afx_msg void OnViewZoomOut();
 	afx_msg void OnViewZoomNormal();
+	afx_msg LRESULT OnRescanCompleted(WPARAM wParam, LPARAM lParam);
 	//}}AFX_MSG
 	DECLARE_MESSAGE_MAP()
 };
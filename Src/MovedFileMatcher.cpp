@@ -0,0 +1,353 @@
+/**
+ * @file  MovedFileMatcher.cpp
+ *
+ * @brief Implementation file for MovedFileMatcher.
+ *
+ */
+
+#include "MovedFileMatcher.h"
+#include <algorithm>
+#include <memory>
+#include <cassert>
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+#include <fcntl.h>
+#include <Poco/SHA1Engine.h>
+#include <Poco/ThreadPool.h>
+#include <Poco/Runnable.h>
+#include <Poco/AtomicCounter.h>
+#include <Poco/Environment.h>
+#include "IAbortable.h"
+#include "paths.h"
+
+using Poco::SHA1Engine;
+using Poco::DigestEngine;
+using Poco::ThreadPool;
+using Poco::Runnable;
+using Poco::AtomicCounter;
+using Poco::Environment;
+
+namespace
+{
+
+const size_t ReadBufferSize = 256 * 1024; /**< Buffer size for hashing whole files. */
+
+/**
+ * @brief Sort file references and keep only groups having files of both sides.
+ * @param [in,out] refs File references, sorted and filtered in place.
+ * @param [in] less Ordering of the references, equal ones form a group.
+ * @return Start of each kept group in @p refs, followed by the end of the last group.
+ */
+template <class Ref, class Less>
+std::vector<size_t> KeepGroupsOfBothSides(std::vector<Ref>& refs, Less less)
+{
+	std::sort(refs.begin(), refs.end(), less);
+	std::vector<size_t> groups;
+	size_t nKept = 0;
+	for (size_t i = 0; i < refs.size(); )
+	{
+		bool bSides[2] = { false, false };
+		size_t j = i;
+		for (; j < refs.size() && !less(refs[i], refs[j]); ++j)
+			bSides[refs[j].nSide] = true;
+		if (bSides[0] && bSides[1])
+		{
+			groups.push_back(nKept);
+			for (size_t k = i; k < j; ++k)
+				refs[nKept++] = refs[k];
+		}
+		i = j;
+	}
+	refs.resize(nKept);
+	groups.push_back(nKept);
+	return groups;
+}
+
+/**
+ * @brief Hash the content of a file.
+ * @param [in] sPath Path of the file.
+ * @param [in] nSize Size of the file found when scanning.
+ * @param [in] bSampled Hash only sampled blocks of files bigger than the samples?
+ * @param [in,out] buffer Buffer for reading.
+ * @param [out] digest Digest of the read content.
+ * @return true if the file was read, false if reading failed or the size changed.
+ */
+bool HashFile(const String& sPath, int64_t nSize, bool bSampled, std::vector<char>& buffer, std::string& digest)
+{
+	int fd = _topen(sPath.c_str(), O_BINARY | O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	SHA1Engine engine;
+	bool bRead = true;
+	const int nBlockSize = MovedFileMatcher::SampleBlockSize;
+	if (bSampled && nSize > static_cast<int64_t>(MovedFileMatcher::SampleBlocks) * nBlockSize)
+	{
+		static_assert(MovedFileMatcher::SampleBlocks == 3, "Sample offsets do not match the number of blocks");
+		const int64_t offsets[MovedFileMatcher::SampleBlocks] = { 0, nSize / 2 - nBlockSize / 2, nSize - nBlockSize };
+		buffer.resize((std::max)(buffer.size(), static_cast<size_t>(nBlockSize)));
+		for (int i = 0; i < MovedFileMatcher::SampleBlocks && bRead; ++i)
+		{
+			bRead = _lseeki64(fd, offsets[i], SEEK_SET) == offsets[i] &&
+				read(fd, &buffer[0], nBlockSize) == nBlockSize;
+			if (bRead)
+				engine.update(&buffer[0], nBlockSize);
+		}
+	}
+	else
+	{
+		buffer.resize((std::max)(buffer.size(), ReadBufferSize));
+		int64_t nTotal = 0;
+		for (;;)
+		{
+			int nRead = read(fd, &buffer[0], static_cast<unsigned>(ReadBufferSize));
+			if (nRead <= 0)
+			{
+				bRead = (nRead == 0 && nTotal == nSize);
+				break;
+			}
+			engine.update(&buffer[0], nRead);
+			nTotal += nRead;
+		}
+	}
+	close(fd);
+
+	if (bRead)
+	{
+		const DigestEngine::Digest& d = engine.digest();
+		digest.assign(d.begin(), d.end());
+	}
+	return bRead;
+}
+
+}
+
+/**
+ * @brief Hashes files taken from a shared list in a worker thread.
+ */
+class MovedFileMatcher::FileHasher : public Runnable
+{
+public:
+	FileHasher(MovedFileMatcher& matcher, const std::vector<FileRef>& refs, AtomicCounter& next, bool bSampled)
+		: m_matcher(matcher), m_refs(refs), m_next(next), m_bSampled(bSampled) {}
+
+	void run()
+	{
+		std::vector<char> buffer;
+		for (;;)
+		{
+			if (m_matcher.m_piAbortable && m_matcher.m_piAbortable->ShouldAbort())
+				return;
+			size_t i = static_cast<size_t>(++m_next - 1);
+			if (i >= m_refs.size())
+				return;
+			File& file = m_matcher.m_files[m_refs[i].nSide][m_refs[i].nIndex];
+			if (!HashFile(file.sPath, file.nSize, m_bSampled, buffer, m_bSampled ? file.sample : file.hash))
+				file.bError = true;
+		}
+	}
+
+private:
+	MovedFileMatcher& m_matcher;
+	const std::vector<FileRef>& m_refs;
+	AtomicCounter& m_next;
+	bool m_bSampled;
+};
+
+/**
+ * @brief Constructor.
+ * @param [in] piAbortable Interface for aborting the matching, or NULL.
+ */
+MovedFileMatcher::MovedFileMatcher(const IAbortable *piAbortable)
+: m_piAbortable(piAbortable)
+, m_nSampled(0)
+, m_nHashed(0)
+{
+}
+
+MovedFileMatcher::~MovedFileMatcher()
+{
+}
+
+/**
+ * @brief Add a unique file of one side.
+ * @param [in] nSide 0 for the left side, 1 for the right side.
+ * @param [in] sPath Full path of the file.
+ * @param [in] nSize Size of the file in bytes.
+ * @return Index of the file on its side, used in the matches.
+ */
+size_t MovedFileMatcher::AddFile(int nSide, const String& sPath, int64_t nSize)
+{
+	assert(nSide == 0 || nSide == 1);
+	File file = { sPath, nSize, std::string(), std::string(), false };
+	m_files[nSide].push_back(file);
+	return m_files[nSide].size() - 1;
+}
+
+/**
+ * @brief Find the files of the left side having the same content as a file of the right side.
+ * Empty files and files which cannot be read are not matched.
+ * @param [in] nThreads Number of hashing threads, 0 for one per processor.
+ * @return Matched files ordered by the left side index, empty if aborted.
+ */
+std::vector<MovedFileMatcher::Match> MovedFileMatcher::FindMatches(unsigned nThreads)
+{
+	std::vector<Match> matches;
+	if (nThreads == 0)
+		nThreads = Environment::processorCount();
+
+	auto file = [this](const FileRef& ref) -> File& { return m_files[ref.nSide][ref.nIndex]; };
+	auto bySize = [&file](const FileRef& ref1, const FileRef& ref2) {
+		return file(ref1).nSize < file(ref2).nSize;
+	};
+	auto bySample = [&file](const FileRef& ref1, const FileRef& ref2) {
+		const File& file1 = file(ref1), &file2 = file(ref2);
+		return file1.nSize != file2.nSize ? file1.nSize < file2.nSize : file1.sample < file2.sample;
+	};
+	auto byHash = [&file](const FileRef& ref1, const FileRef& ref2) {
+		const File& file1 = file(ref1), &file2 = file(ref2);
+		return file1.nSize != file2.nSize ? file1.nSize < file2.nSize : file1.hash < file2.hash;
+	};
+	auto failed = [&file](const FileRef& ref) { return file(ref).bError; };
+
+	// 1. Files of the same size on both sides
+	std::vector<FileRef> refs;
+	for (int nSide = 0; nSide < 2; ++nSide)
+	{
+		for (size_t i = 0; i < m_files[nSide].size(); ++i)
+		{
+			if (m_files[nSide][i].nSize > 0)
+			{
+				FileRef ref = { nSide, i };
+				refs.push_back(ref);
+			}
+		}
+	}
+	KeepGroupsOfBothSides(refs, bySize);
+
+	// 2. Files of the same size whose sampled blocks match
+	if (!HashFiles(refs, true, nThreads))
+		return matches;
+	refs.erase(std::remove_if(refs.begin(), refs.end(), failed), refs.end());
+	KeepGroupsOfBothSides(refs, bySample);
+
+	// 3. Files whose whole content matches, the samples of small files cover it already
+	std::vector<FileRef> sampledRefs;
+	for (size_t i = 0; i < refs.size(); ++i)
+	{
+		File& f = file(refs[i]);
+		if (f.nSize <= static_cast<int64_t>(SampleBlocks) * SampleBlockSize)
+			f.hash = f.sample;
+		else
+			sampledRefs.push_back(refs[i]);
+	}
+	if (!HashFiles(sampledRefs, false, nThreads))
+		return matches;
+	refs.erase(std::remove_if(refs.begin(), refs.end(), failed), refs.end());
+	std::vector<size_t> groups = KeepGroupsOfBothSides(refs, byHash);
+
+	for (size_t nGroup = 0; nGroup + 1 < groups.size(); ++nGroup)
+	{
+		std::vector<FileRef> group(refs.begin() + groups[nGroup], refs.begin() + groups[nGroup + 1]);
+		PairFiles(group, matches);
+	}
+	std::sort(matches.begin(), matches.end());
+	return matches;
+}
+
+/**
+ * @brief Hash files in worker threads.
+ * @param [in] refs Files to hash.
+ * @param [in] bSampled Hash sampled blocks instead of the whole content?
+ * @param [in] nThreads Number of worker threads.
+ * @return false if aborted.
+ */
+bool MovedFileMatcher::HashFiles(const std::vector<FileRef>& refs, bool bSampled, unsigned nThreads)
+{
+	if (bSampled)
+		m_nSampled += refs.size();
+	else
+		m_nHashed += refs.size();
+
+	AtomicCounter next;
+	nThreads = static_cast<unsigned>((std::min)(static_cast<size_t>(nThreads), refs.size()));
+	if (nThreads <= 1)
+	{
+		FileHasher hasher(*this, refs, next, bSampled);
+		hasher.run();
+	}
+	else
+	{
+		ThreadPool threadPool(1, nThreads);
+		std::vector<std::unique_ptr<FileHasher>> hashers;
+		for (unsigned i = 0; i < nThreads; ++i)
+		{
+			hashers.push_back(std::unique_ptr<FileHasher>(new FileHasher(*this, refs, next, bSampled)));
+			threadPool.start(*hashers.back());
+		}
+		threadPool.joinAll();
+	}
+	return !m_piAbortable || !m_piAbortable->ShouldAbort();
+}
+
+/**
+ * @brief Pair the files of both sides in a group of files with the same content.
+ * A file is paired with a file of the same name first, the rest in path order.
+ * @param [in] group Files of the group.
+ * @param [in,out] matches Matches the pairs are added to.
+ */
+void MovedFileMatcher::PairFiles(const std::vector<FileRef>& group, std::vector<Match>& matches) const
+{
+	struct NamedFile
+	{
+		String sName;
+		const String *psPath;
+		size_t nIndex;
+		bool bPaired;
+		bool operator<(const NamedFile& other) const
+		{
+			int nResult = string_compare_nocase(sName, other.sName);
+			return nResult != 0 ? nResult < 0 : *psPath < *other.psPath;
+		}
+	};
+	std::vector<NamedFile> files[2];
+	for (size_t i = 0; i < group.size(); ++i)
+	{
+		const File& file = m_files[group[i].nSide][group[i].nIndex];
+		NamedFile namedFile = { paths::FindFileName(file.sPath), &file.sPath, group[i].nIndex, false };
+		files[group[i].nSide].push_back(namedFile);
+	}
+	for (int nSide = 0; nSide < 2; ++nSide)
+		std::sort(files[nSide].begin(), files[nSide].end());
+
+	// Files of the same name, moved to another folder
+	for (size_t i = 0, j = 0; i < files[0].size() && j < files[1].size(); )
+	{
+		int nResult = string_compare_nocase(files[0][i].sName, files[1][j].sName);
+		if (nResult < 0)
+			++i;
+		else if (nResult > 0)
+			++j;
+		else
+		{
+			matches.push_back(Match(files[0][i].nIndex, files[1][j].nIndex));
+			files[0][i++].bPaired = true;
+			files[1][j++].bPaired = true;
+		}
+	}
+
+	// Renamed files
+	for (size_t i = 0, j = 0; ; ++i, ++j)
+	{
+		while (i < files[0].size() && files[0][i].bPaired)
+			++i;
+		while (j < files[1].size() && files[1][j].bPaired)
+			++j;
+		if (i >= files[0].size() || j >= files[1].size())
+			break;
+		matches.push_back(Match(files[0][i].nIndex, files[1][j].nIndex));
+	}
+}
@@ -0,0 +1,75 @@
+/**
+ * @file  MovedFileMatcher.h
+ *
+ * @brief Declaration file for MovedFileMatcher.
+ *
+ */
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <string>
+#include "UnicodeString.h"
+
+class IAbortable;
+
+/**
+ * @brief Finds files with identical content among the unique files of two sides.
+ *
+ * A file renamed or moved to another folder shows up in folder compare as
+ * a left-only and a right-only item. Comparing every left-only file to
+ * every right-only file is too slow for big trees, so candidates are
+ * narrowed down in stages:
+ *  - files are grouped by size, only sizes found on both sides are kept
+ *  - the candidates are hashed from a few sampled blocks
+ *  - files whose samples match are hashed fully
+ * Hashing is done by worker threads. Files of a group with the same
+ * content are paired with the file of the same name if there is one, so
+ * moved files are preferred over renamed ones.
+ */
+class MovedFileMatcher
+{
+public:
+	/** @brief Indexes of the matched files of the left and right side. */
+	typedef std::pair<size_t, size_t> Match;
+
+	explicit MovedFileMatcher(const IAbortable *piAbortable = NULL);
+	~MovedFileMatcher();
+
+	size_t AddFile(int nSide, const String& sPath, int64_t nSize);
+	size_t GetFileCount(int nSide) const { return m_files[nSide].size(); }
+	std::vector<Match> FindMatches(unsigned nThreads = 0);
+
+	size_t GetSampledCount() const { return m_nSampled; }
+	size_t GetHashedCount() const { return m_nHashed; }
+
+	static const int SampleBlockSize = 4096; /**< Size of one sampled block. */
+	static const int SampleBlocks = 3; /**< Blocks sampled: start, middle and end. */
+
+private:
+	/** @brief Unique file of one side */
+	struct File
+	{
+		String sPath; /**< Full path of the file. */
+		int64_t nSize; /**< Size of the file in bytes. */
+		std::string sample; /**< Digest of the sampled blocks. */
+		std::string hash; /**< Digest of the whole content. */
+		bool bError; /**< Could the file not be read? */
+	};
+	/** @brief Reference to a file of either side */
+	struct FileRef
+	{
+		int nSide;
+		size_t nIndex;
+	};
+	class FileHasher;
+
+	bool HashFiles(const std::vector<FileRef>& refs, bool bSampled, unsigned nThreads);
+	void PairFiles(const std::vector<FileRef>& group, std::vector<Match>& matches) const;
+
+	std::vector<File> m_files[2]; /**< Unique files of the left and right side. */
+	const IAbortable *m_piAbortable; /**< Interface for aborting the matching. */
+	size_t m_nSampled; /**< Number of files hashed from samples. */
+	size_t m_nHashed; /**< Number of files hashed fully. */
+};
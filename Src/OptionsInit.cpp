@@ -124,6 +124,7 @@ void Init(COptionsMgr *pOptions)
 	pOptions->InitOption(OPT_CMP_QUICK_LIMIT, 4 * 1024 * 1024); // 4 Megs
 	pOptions->InitOption(OPT_CMP_WALK_UNIQUE_DIRS, false);
 	pOptions->InitOption(OPT_CMP_IGNORE_REPARSE_POINTS, false);
+	pOptions->InitOption(OPT_CMP_DETECT_MOVED_FILES, false);
 	pOptions->InitOption(OPT_CMP_IGNORE_CODEPAGE, true);
 	pOptions->InitOption(OPT_CMP_INCLUDE_SUBDIRS, true);
 
@@ -28,6 +28,7 @@
 #define POCO_NO_UNWINDOWS 1
 #include <vector>
 #include <list>
+#include <map>
 #include <unordered_set>
 #include <algorithm>
 #include <cstdarg>
@@ -520,6 +521,24 @@ int PluginInfo::LoadPlugin(const String & scriptletFilepath, const wchar_t *tran
 	}
 	VariantClear(&ret);
 
+	// get optional property PluginIsThreadSafe
+	if (SearchScriptForDefinedProperties(lpDispatch, L"PluginIsThreadSafe"))
+	{
+		h = ::invokeW(lpDispatch, &ret, L"PluginIsThreadSafe", opGet[0], NULL);
+		if (FAILED(h) || ret.vt != VT_BOOL)
+		{
+			scinfo.Log(_T("Plugin had PluginIsThreadSafe property, but error getting its value"));
+			return -100; // error (Plugin had PluginIsThreadSafe property, but error getting its value)
+		}
+		m_bThreadSafe = !!ret.boolVal;
+	}
+	else
+	{
+		// default to false : calls of the plugin are serialized
+		m_bThreadSafe = false;
+	}
+	VariantClear(&ret);
+
 	LoadFilterString();
 
 	// keep the filename
@@ -935,6 +954,33 @@ CAssureScriptsForThread::~CAssureScriptsForThread()
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// class PluginCallLock : serialize the calls of plugins which are not thread-safe
+
+/// One mutex for each plugin file, shared by the instances of all threads
+static std::map<String, std::shared_ptr<Poco::Mutex>> thePluginCallMutexes;
+static FastMutex thePluginCallMutexesLock;
+
+PluginCallLock::PluginCallLock(const PluginInfo & plugin)
+{
+	if (plugin.m_bThreadSafe)
+		return;
+	{
+		FastMutex::ScopedLock lock(thePluginCallMutexesLock);
+		std::shared_ptr<Poco::Mutex> & pMutex = thePluginCallMutexes[plugin.m_filepath];
+		if (!pMutex)
+			pMutex.reset(new Poco::Mutex);
+		m_pMutex = pMutex;
+	}
+	m_pMutex->lock();
+}
+
+PluginCallLock::~PluginCallLock()
+{
+	if (m_pMutex)
+		m_pMutex->unlock();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // wrap invokes with error handlers
 
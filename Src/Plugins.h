@@ -31,6 +31,7 @@
 #include <windows.h>
 #include <oleauto.h>
 #include <memory>
+#include <Poco/Mutex.h>
 #include "UnicodeString.h"
 
 struct FileFilterElement;
@@ -50,7 +51,7 @@ class PluginInfo
 {
 public:
 	PluginInfo()
-		: m_lpDispatch(NULL), m_filters(NULL), m_bAutomatic(FALSE), m_nFreeFunctions(0), m_disabled(false)
+		: m_lpDispatch(NULL), m_filters(NULL), m_bAutomatic(FALSE), m_bThreadSafe(false), m_nFreeFunctions(0), m_disabled(false)
 	{	
 	}
 
@@ -78,6 +79,7 @@ public:
 	String      m_filtersText;
 	String      m_description;
 	bool        m_bAutomatic;
+	bool        m_bThreadSafe; /**< Plugin may be called by several threads at once */
 	bool        m_disabled;
 	std::vector<FileFilterElementPtr> m_filters;
 	/// only for plugins with free function names (EDITOR_SCRIPT)
@@ -165,6 +167,27 @@ public:
 	~CAssureScriptsForThread();
 };
 
+/**
+ * @brief Serialize the calls of a plugin which is not declared thread-safe.
+ *
+ * Each worker thread has its own instances of the plugins (CScriptsOfThread),
+ * so calls from several threads may run at the same time. Plugins without the
+ * PluginIsThreadSafe property may share files or global state : hold a
+ * PluginCallLock around each call so only one thread at a time uses them.
+ * Calls of thread-safe plugins are not locked.
+ */
+class PluginCallLock
+{
+public:
+	explicit PluginCallLock(const PluginInfo & plugin);
+	~PluginCallLock();
+private:
+	std::shared_ptr<Poco::Mutex> m_pMutex;
+
+	PluginCallLock(const PluginCallLock& other); // non construction-copyable
+	PluginCallLock& operator=(const PluginCallLock&); // non copyable
+};
+
 
 
 /**
@@ -29,6 +29,7 @@ PropCompareFolder::PropCompareFolder(COptionsMgr *optionsMgr)
  , m_bIncludeSubdirs(FALSE)
  , m_bExpandSubdirs(FALSE)
  , m_bIgnoreReparsePoints(FALSE)
+ , m_bDetectMovedFiles(FALSE)
  , m_nQuickCompareLimit(4 * Mega)
 {
 }
@@ -44,6 +45,7 @@ void PropCompareFolder::DoDataExchange(CDataExchange* pDX)
 	DDX_Check(pDX, IDC_RECURS_CHECK, m_bIncludeSubdirs);
 	DDX_Check(pDX, IDC_EXPAND_SUBDIRS, m_bExpandSubdirs);
 	DDX_Check(pDX, IDC_IGNORE_REPARSEPOINTS, m_bIgnoreReparsePoints);
+	DDX_Check(pDX, IDC_DETECT_MOVED_FILES, m_bDetectMovedFiles);
 	DDX_Text(pDX, IDC_COMPARE_QUICKC_LIMIT, m_nQuickCompareLimit);
 	//}}AFX_DATA_MAP
 	UpdateControls();
@@ -72,6 +74,7 @@ void PropCompareFolder::ReadOptions()
 	m_bIncludeSubdirs = GetOptionsMgr()->GetBool(OPT_CMP_INCLUDE_SUBDIRS);
 	m_bExpandSubdirs = GetOptionsMgr()->GetBool(OPT_DIRVIEW_EXPAND_SUBDIRS);
 	m_bIgnoreReparsePoints = GetOptionsMgr()->GetBool(OPT_CMP_IGNORE_REPARSE_POINTS);
+	m_bDetectMovedFiles = GetOptionsMgr()->GetBool(OPT_CMP_DETECT_MOVED_FILES);
 	m_nQuickCompareLimit = GetOptionsMgr()->GetInt(OPT_CMP_QUICK_LIMIT) / Mega ;
 }
 
@@ -89,6 +92,7 @@ void PropCompareFolder::WriteOptions()
 	GetOptionsMgr()->SaveOption(OPT_CMP_INCLUDE_SUBDIRS, m_bIncludeSubdirs);
 	GetOptionsMgr()->SaveOption(OPT_DIRVIEW_EXPAND_SUBDIRS, m_bExpandSubdirs);
 	GetOptionsMgr()->SaveOption(OPT_CMP_IGNORE_REPARSE_POINTS, m_bIgnoreReparsePoints);
+	GetOptionsMgr()->SaveOption(OPT_CMP_DETECT_MOVED_FILES, m_bDetectMovedFiles);
 
 	if (m_nQuickCompareLimit > 2000)
 		m_nQuickCompareLimit = 2000;
@@ -132,6 +136,7 @@ void PropCompareFolder::OnDefaults()
 	m_bIncludeSubdirs = GetOptionsMgr()->GetDefault<bool>(OPT_CMP_INCLUDE_SUBDIRS);
 	m_bExpandSubdirs = GetOptionsMgr()->GetDefault<bool>(OPT_DIRVIEW_EXPAND_SUBDIRS);
 	m_bIgnoreReparsePoints = GetOptionsMgr()->GetDefault<bool>(OPT_CMP_IGNORE_REPARSE_POINTS);
+	m_bDetectMovedFiles = GetOptionsMgr()->GetDefault<bool>(OPT_CMP_DETECT_MOVED_FILES);
 	m_nQuickCompareLimit = GetOptionsMgr()->GetDefault<unsigned>(OPT_CMP_QUICK_LIMIT) / Mega;
 	UpdateData(FALSE);
 }
@@ -154,6 +159,8 @@ void PropCompareFolder::OnBnClickedRecursCheck()
 void PropCompareFolder::UpdateControls()
 {
 	CComboBox * pCombo = (CComboBox*)GetDlgItem(IDC_COMPAREMETHODCOMBO);
-	EnableDlgItem(IDC_COMPARE_STOPFIRST, pCombo->GetCurSel() == 1);
+	// Full and quick contents compare can stop after the first difference
+	int nCompareMethod = pCombo->GetCurSel();
+	EnableDlgItem(IDC_COMPARE_STOPFIRST, nCompareMethod == 0 || nCompareMethod == 1);
 	EnableDlgItem(IDC_EXPAND_SUBDIRS, IsDlgButtonChecked(IDC_RECURS_CHECK) == 1);
 }
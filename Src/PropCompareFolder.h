@@ -42,6 +42,7 @@ public:
 	bool    m_bIncludeSubdirs;
 	bool    m_bExpandSubdirs;
 	bool    m_bIgnoreReparsePoints;
+	bool    m_bDetectMovedFiles;
 	unsigned m_nQuickCompareLimit;
 	//}}AFX_DATA
 
@@ -0,0 +1,162 @@
+/**
+ * @file  RescanThread.cpp
+ *
+ * @brief Implementation file for CRescanThread.
+ *
+ */
+
+#include "RescanThread.h"
+#include "IAbortable.h"
+
+using Poco::FastMutex;
+
+/** @brief abort handler for CRescanThread -- just a gateway to CRescanThread */
+class RescanThreadAbortable : public IAbortable
+{
+public:
+	explicit RescanThreadAbortable(const CRescanThread * pThread) : m_pThread(pThread) { }
+	virtual bool ShouldAbort() const { return m_pThread->ShouldAbort(); }
+
+private:
+	const CRescanThread * m_pThread;
+};
+
+/**
+ * @brief Default constructor.
+ */
+CRescanThread::CRescanThread()
+: m_pAbortgate(new RescanThreadAbortable(this))
+, m_bStarted(false)
+, m_bRunning(false)
+, m_bAborting(false)
+, m_bQuit(false)
+{
+}
+
+/**
+ * @brief Destructor, aborts the running job and waits for the thread.
+ */
+CRescanThread::~CRescanThread()
+{
+	{
+		FastMutex::ScopedLock lock(m_mutex);
+		m_bQuit = true;
+		m_bAborting = true;
+		m_pPending.reset();
+	}
+	m_wakeup.set();
+	if (m_bStarted)
+		m_thread.join();
+}
+
+/**
+ * @brief Start comparing a snapshot.
+ * A running job is aborted and a job not yet started is dropped.
+ * @param [in] pJob Job to run, the thread takes ownership.
+ */
+void CRescanThread::Start(RescanJob *pJob)
+{
+	{
+		FastMutex::ScopedLock lock(m_mutex);
+		m_pPending.reset(pJob);
+		m_pCompleted.reset();
+		if (m_bRunning)
+			m_bAborting = true;
+	}
+	if (!m_bStarted)
+	{
+		m_thread.start(ThreadProc, this);
+		m_bStarted = true;
+	}
+	m_wakeup.set();
+}
+
+/**
+ * @brief Abort the running job and drop the waiting and completed jobs.
+ */
+void CRescanThread::Cancel()
+{
+	FastMutex::ScopedLock lock(m_mutex);
+	m_pPending.reset();
+	m_pCompleted.reset();
+	if (m_bRunning)
+		m_bAborting = true;
+}
+
+/**
+ * @brief Is a job running or waiting to run?
+ */
+bool CRescanThread::IsBusy() const
+{
+	FastMutex::ScopedLock lock(m_mutex);
+	return m_bRunning || m_pPending != nullptr;
+}
+
+/**
+ * @brief Take the completed job if it compared the given revision.
+ * An outdated result is dropped.
+ * @param [in] nRevision Current edit revision of the document.
+ * @return The completed job, or NULL if there is no up to date result.
+ */
+std::unique_ptr<RescanJob> CRescanThread::TakeResult(unsigned nRevision)
+{
+	FastMutex::ScopedLock lock(m_mutex);
+	std::unique_ptr<RescanJob> pJob(std::move(m_pCompleted));
+	if (pJob && pJob->GetRevision() != nRevision)
+		pJob.reset();
+	return pJob;
+}
+
+/**
+ * @brief runtime interface for child thread, called on child thread
+ */
+bool CRescanThread::ShouldAbort() const
+{
+	FastMutex::ScopedLock lock(m_mutex);
+	return m_bAborting;
+}
+
+/**
+ * @brief Thread function of the worker thread.
+ */
+void CRescanThread::ThreadProc(void *lpParam)
+{
+	static_cast<CRescanThread *>(lpParam)->RunJobs();
+}
+
+/**
+ * @brief Run the jobs given to the thread until told to quit.
+ */
+void CRescanThread::RunJobs()
+{
+	for (;;)
+	{
+		m_wakeup.wait();
+
+		std::unique_ptr<RescanJob> pJob;
+		{
+			FastMutex::ScopedLock lock(m_mutex);
+			if (m_bQuit)
+				return;
+			pJob = std::move(m_pPending);
+			if (!pJob)
+				continue;
+			m_bRunning = true;
+			m_bAborting = false;
+		}
+
+		pJob->Run(*m_pAbortgate);
+
+		unsigned nRevision = pJob->GetRevision();
+		bool bCompleted;
+		{
+			FastMutex::ScopedLock lock(m_mutex);
+			m_bRunning = false;
+			bCompleted = !m_bAborting;
+			if (bCompleted)
+				m_pCompleted = std::move(pJob);
+		}
+		if (bCompleted)
+			m_listeners.notify(this, nRevision);
+	}
+}
@@ -0,0 +1,89 @@
+/**
+ * @file  RescanThread.h
+ *
+ * @brief Declaration file for CRescanThread.
+ *
+ */
+#pragma once
+
+#include <memory>
+#define POCO_NO_UNWINDOWS 1
+#include <Poco/Thread.h>
+#include <Poco/Mutex.h>
+#include <Poco/Event.h>
+#include <Poco/BasicEvent.h>
+#include <Poco/Delegate.h>
+
+class IAbortable;
+class RescanThreadAbortable;
+
+/**
+ * @brief Compare of one snapshot of the compared texts.
+ * The snapshot is taken on the UI thread when the job is created, Run() is
+ * called on the worker thread and the results are read on the UI thread
+ * after CRescanThread::TakeResult() has returned the job.
+ */
+class RescanJob
+{
+public:
+	explicit RescanJob(unsigned nRevision) : m_nRevision(nRevision) {}
+	virtual ~RescanJob() {}
+
+	/** @brief Compare the snapshot, may return early when aborted. */
+	virtual void Run(const IAbortable& abortable) = 0;
+	/** @brief Edit revision of the document the snapshot was taken at. */
+	unsigned GetRevision() const { return m_nRevision; }
+
+private:
+	unsigned m_nRevision; /**< Edit revision of the snapshot. */
+};
+
+/**
+ * @brief Runs the compare stage of file compare rescans in a worker thread.
+ *
+ * Only the latest rescan matters: starting a rescan aborts the running one
+ * and replaces a rescan not yet started. Listeners are notified in the
+ * worker thread when a rescan completes; the UI thread then takes the
+ * result, which is given only if the document is still at the revision the
+ * snapshot was taken at.
+ */
+class CRescanThread
+{
+public:
+	CRescanThread();
+	~CRescanThread();
+
+	template<class T>
+	void AddListener(T *pObj, void (T::*pMethod)(unsigned& nRevision)) {
+		m_listeners += Poco::delegate(pObj, pMethod);
+	}
+	template<class T>
+	void RemoveListener(T *pObj, void (T::*pMethod)(unsigned& nRevision)) {
+		m_listeners -= Poco::delegate(pObj, pMethod);
+	}
+
+// called on main thread
+	void Start(RescanJob *pJob);
+	void Cancel();
+	bool IsBusy() const;
+	std::unique_ptr<RescanJob> TakeResult(unsigned nRevision);
+
+// called on child thread
+	bool ShouldAbort() const;
+
+private:
+	static void ThreadProc(void *lpParam);
+	void RunJobs();
+
+	Poco::Thread m_thread; /**< Worker thread, started with the first job. */
+	Poco::Event m_wakeup; /**< Set when there is a job or the thread must quit. */
+	mutable Poco::FastMutex m_mutex; /**< Protects the jobs and the flags. */
+	std::unique_ptr<RescanJob> m_pPending; /**< Job waiting for the worker. */
+	std::unique_ptr<RescanJob> m_pCompleted; /**< Latest completed job. */
+	std::unique_ptr<RescanThreadAbortable> m_pAbortgate;
+	bool m_bStarted; /**< Has the worker thread been started? */
+	bool m_bRunning; /**< Is the worker running a job? */
+	bool m_bAborting; /**< Should the running job stop? */
+	bool m_bQuit; /**< Should the worker thread exit? */
+	Poco::BasicEvent<unsigned> m_listeners; /**< Notified of completed jobs. */
+};
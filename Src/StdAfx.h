@@ -56,6 +56,8 @@
 const UINT MSG_UI_UPDATE = WM_USER + 1;
 /// Request to save panesizes
 const UINT MSG_STORE_PANESIZES = WM_USER + 2;
+/// File compare rescan thread tells a rescan has completed
+const UINT MSG_RESCAN_COMPLETED = WM_USER + 3;
 /* @} */
 
 /// Seconds ignored in filetime differences if option enabled
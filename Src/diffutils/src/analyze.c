@@ -67,6 +67,7 @@ static struct change *build_script PARAMS((struct file_data const[]));
 static void briefly_report PARAMS((int, struct file_data const[]));
 static void compareseq PARAMS((int, int, int, int, int));
 static void discard_confusing_lines PARAMS((struct file_data[]));
+static int find_first_change PARAMS((struct file_data const[]));
 static void shift_boundaries PARAMS((struct file_data[]));
 
 /* Find the midpoint of the shortest edit script for a specified
@@ -832,6 +833,23 @@ briefly_report (changes, filevec)
 	     filevec[0].name, filevec[1].name);
 }
 
+/* WinMerge: Return the first line whose equivalence class differs
+   between the two files, or -1 if all lines are equivalent.  The main
+   comparison algorithm finds changes exactly when there is such a line.  */
+static int
+find_first_change (filevec)
+     struct file_data const filevec[];
+{
+  int i;
+  int n0 = filevec[0].buffered_lines, n1 = filevec[1].buffered_lines;
+  int const *e0 = filevec[0].equivs, *e1 = filevec[1].equivs;
+
+  for (i = 0; i < n0 && i < n1; i++)
+    if (e0[i] != e1[i])
+      return i;
+  return n0 == n1 ? -1 : i;
+}
+
 //  Report the differences of two files.  DEPTH is the current directory
 // depth. 
 // WinMerge: add moved_blocks_flag for detecting moved blocks and
@@ -917,6 +935,25 @@ struct change * diff_2_files (struct file_data filevec[], int depth, int * bin_s
 	}
 	else
 	{
+		// WinMerge: when only the status is needed, look for the first
+		// differing line before running the main algorithm.  If changes
+		// to blank lines are ignored, the whole script is needed to tell
+		// whether the change found is ignored.
+		if (stop_after_first_change)
+		{
+			int first = find_first_change (filevec);
+			if (first < 0 || !ignore_blank_lines_flag)
+			{
+				files[0] = filevec[0];
+				files[1] = filevec[1];
+				if (first >= 0)
+					script = add_change (first, first,
+						first < filevec[0].buffered_lines,
+						first < filevec[1].buffered_lines, 0);
+				return script;
+			}
+		}
+
 		//  Allocate vectors for the results of comparison:
 		// a flag for each line of each file, saying whether that line
 		// is an insertion or deletion.
@@ -1118,11 +1155,20 @@ void cleanup_file_buffers(struct file_data fd[])
 		free (fd[0].changed_flag - 1);
 	
 	for (i = 1; i >= 0; --i)
+	{
 		free (fd[i].equivs);
+		free (fd[i].line_hashes);
+		fd[i].line_hashes = 0;
+	}
 	
 	for (i = 0; i < 2; ++i)
 		free ((void *)(fd[i].linbuf + fd[i].linbuf_base));
 
+	/* WinMerge: linbuf and equivs were counted in find_and_hash_each_line,
+	   line_hashes in read_files */
+	memory_stats_diffutils (-(fd[0].lines_bytes + fd[1].lines_bytes));
+	fd[0].lines_bytes = fd[1].lines_bytes = 0;
+
 	if (fd[0].buffer != fd[1].buffer)
 		free (fd[0].buffer);
 	free (fd[1].buffer);
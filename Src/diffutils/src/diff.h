@@ -109,6 +109,15 @@ EXTERN int      ignore_blank_lines_flag;
 /* WinMerge moved block code */
 EXTERN int moved_blocks_flag;
 
+/* WinMerge: only whether the files differ is needed.  The script holds
+   just the first change, unless changes to blank lines are ignored.  */
+EXTERN int stop_after_first_change;
+
+/* WinMerge: keep the hash of each hashed line in file_data.line_hashes,
+   so that lines of two compares run with same options can be compared
+   without their text.  Used by the three-way compare.  */
+EXTERN int keep_line_hashes;
+
 /* 1 if lines may match even if their lengths are different.
    This depends on various options.  */
 EXTERN int      length_varies;
@@ -293,6 +302,17 @@ struct file_data {
 
     /* text stats for WinMerge */
     int count_crlfs, count_crs, count_lfs, count_zeros;
+
+    /* WinMerge: nonzero if the caller set the text stats above, so
+       prepare_text_end need not count them again.  */
+    int known_text_stats;
+
+    /* WinMerge: hash of each hashed line, indexed like equivs,
+       or 0 if keep_line_hashes was not set.  */
+    unsigned	   *line_hashes;
+
+    /* WinMerge: bytes of linbuf, equivs and line_hashes counted to memory stats */
+    long lines_bytes;
 };
 
 /* Describe the two files currently being compared.  */
@@ -309,6 +329,8 @@ EXTERN FILE *outfile;
 /* WinMerge: add last two params */
 struct change * diff_2_files PARAMS((struct file_data[], int, int *, int, int*));
 void moved_block_analysis(struct change ** pscript, struct file_data fd[]);
+/* WinMerge: count line table allocations to memory stats, see DiffFileData.cpp */
+void memory_stats_diffutils(long bytes);
 
 /* context.c */
 void print_context_header PARAMS((struct file_data[], int));
@@ -332,6 +354,7 @@ void print_ifdef_script PARAMS((struct change *));
 int read_files PARAMS((struct file_data[], int, int *));
 int sip PARAMS((struct file_data *, int));
 void slurp PARAMS((struct file_data *));
+int lines_equivalent PARAMS((char const HUGE *, size_t, char const HUGE *, size_t));
 
 /* normal.c */
 void print_normal_script PARAMS((struct change *));
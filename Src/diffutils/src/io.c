@@ -256,6 +256,121 @@ ISWSPACE (char ch)
   return ch==' ' || ch=='\t';
 }
 
+/* WinMerge: Hash the line at *PP the way lines are hashed for their
+   equivalence classes, and advance *PP past the end of the line.  Loops
+   advance the pointer to eol (end of line) respecting UNIX (\n),
+   MS-DOS/Windows (\r\n), and MAC (\r) eols.  A newline must follow
+   the line.  */
+static unsigned
+hash_line (pp)
+     unsigned char const HUGE **pp;
+{
+  unsigned char const HUGE *p = *pp;
+  unsigned h = 0;
+  unsigned char c;
+
+  /* Hash this line until we find a newline. */
+  if (ignore_case_flag)
+    {
+      if (ignore_all_space_flag)
+        while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
+          {
+            if (! ISWSPACE (c))
+              h = HASH (h, isupper (c) ? tolower (c) : c);
+          }
+      else if (ignore_space_change_flag)
+        /* Note that \r must be hashed (if !ignore_eol_diff) */
+        while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
+          {
+            if (ISWSPACE (c))
+              {
+                /* skip whitespace after whitespace */
+                while (ISWSPACE (c = *p++))
+                  ;
+                if (c == '\n')
+                  {
+                    goto hashing_done; /* never hash trailing \n */
+                  }
+                else if (c != '\r')
+                  {
+              /* runs of whitespace not ending line hashed as one space */
+                    h = HASH (h, ' ');
+                  }
+              }
+            /* c is now the first non-space.  */
+            /* c can be a \r (CR) if !ignore_eol_diff */
+            h = HASH (h, isupper (c) ? tolower (c) : c);
+            if (c == '\r' && *p != '\n')
+              goto hashing_done;
+          }
+      else
+        while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
+          {
+            h = HASH (h, isupper (c) ? tolower (c) : c);
+          }
+    }
+  else
+    {
+      if (ignore_all_space_flag)
+        while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
+          {
+            if (! ISWSPACE (c))
+              h = HASH (h, c);
+          }
+      else if (ignore_space_change_flag)
+        /* Note that \r must be hashed (if !ignore_eol_diff) */
+        while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
+          {
+            if (ISWSPACE (c))
+              {
+                /* skip whitespace after whitespace */
+                while (ISWSPACE (c = *p++))
+                  ;
+                if (c == '\n')
+                  {
+                    goto hashing_done; /* never hash trailing \n */
+                  }
+                else if (c != '\r')
+                  {
+              /* runs of whitespace not ending line hashed as one space */
+                    h = HASH (h, ' ');
+                  }
+              }
+            /* c is now the first non-space.  */
+            /* c can be a \r (CR) if !ignore_eol_diff */
+            h = HASH (h, c);
+            if (c == '\r' && *p != '\n')
+              goto hashing_done;
+          }
+      else
+        while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
+          {
+            h = HASH (h, c);
+          }
+    }
+hashing_done:
+  *pp = p;
+  return h;
+}
+
+/* WinMerge: Return nonzero if the lines S1 and S2, LEN1 and LEN2 bytes
+   long, fall in the same equivalence class.  A newline must follow each
+   line, and EOLs must be mapped as prepare_text_end maps them.  */
+int
+lines_equivalent (s1, len1, s2, len2)
+     char const HUGE *s1, HUGE *s2;
+     size_t len1, len2;
+{
+  unsigned char const HUGE *p1 = (unsigned char const HUGE *) s1;
+  unsigned char const HUGE *p2 = (unsigned char const HUGE *) s2;
+
+  if (len1 == len2 && memcmp (s1, s2, len1) == 0)
+    return 1;
+  if (len1 != len2 && !length_varies)
+    return 0;
+  return hash_line (&p1) == hash_line (&p2) && !line_cmp (s1, len1, s2, len2);
+}
+
 /* Split the file into lines, simultaneously computing the equivalence class for
    each line. */
 static void
@@ -264,7 +379,6 @@ find_and_hash_each_line (current)
 {
   unsigned h;
   unsigned char const HUGE *p = (unsigned char const HUGE *) current->prefix_end;
-  unsigned char c;
   int i, *bucket;
   size_t length;
 
@@ -274,6 +388,8 @@ find_and_hash_each_line (current)
   int line = 0;
   int linbuf_base = current->linbuf_base;
   int *cureqs = (int *) xmalloc (alloc_lines * sizeof (int));
+  int cureqs_alloc = alloc_lines; /* WinMerge: for memory stats */
+  long lines_bytes;
   struct equivclass HUGE *eqs = equivs;
   int eqs_index = equivs_index;
   int eqs_alloc = equivs_alloc;
@@ -293,92 +409,7 @@ find_and_hash_each_line (current)
 
       /* Compute the equivalence class (hash) for this line.  */
 
-      h = 0;
-
-
-      /* loops advance pointer to eol (end of line)
-         respecting UNIX (\r), MS-DOS/Windows (\r\n), and MAC (\r) eols */
-
-      /* Hash this line until we find a newline. */
-      if (ignore_case_flag)
-        {
-          if (ignore_all_space_flag)
-            while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
-              {
-                if (! ISWSPACE (c))
-                  h = HASH (h, isupper (c) ? tolower (c) : c);
-              }
-          else if (ignore_space_change_flag)
-            /* Note that \r must be hashed (if !ignore_eol_diff) */
-            while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
-              {
-                if (ISWSPACE (c))
-                  {
-                    /* skip whitespace after whitespace */
-                    while (ISWSPACE (c = *p++))
-                      ;
-                    if (c == '\n')
-                      {
-                        goto hashing_done; /* never hash trailing \n */
-                      }
-                    else if (c != '\r')
-                      {
-                  /* runs of whitespace not ending line hashed as one space */
-                        h = HASH (h, ' ');
-                      }
-                  }
-                /* c is now the first non-space.  */
-                /* c can be a \r (CR) if !ignore_eol_diff */
-                h = HASH (h, isupper (c) ? tolower (c) : c);
-                if (c == '\r' && *p != '\n')
-                  goto hashing_done;
-              }
-          else
-            while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
-              {
-                h = HASH (h, isupper (c) ? tolower (c) : c);
-              }
-        }
-      else
-        {
-          if (ignore_all_space_flag)
-            while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
-              {
-                if (! ISWSPACE (c))
-                  h = HASH (h, c);
-              }
-          else if (ignore_space_change_flag)
-            /* Note that \r must be hashed (if !ignore_eol_diff) */
-            while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
-              {
-                if (ISWSPACE (c))
-                  {
-                    /* skip whitespace after whitespace */
-                    while (ISWSPACE (c = *p++))
-                      ;
-                    if (c == '\n')
-                      {
-                        goto hashing_done; /* never hash trailing \n */
-                      }
-                    else if (c != '\r')
-                      {
-                  /* runs of whitespace not ending line hashed as one space */
-                        h = HASH (h, ' ');
-                      }
-                  }
-                /* c is now the first non-space.  */
-                /* c can be a \r (CR) if !ignore_eol_diff */
-                h = HASH (h, c);
-                if (c == '\r' && *p != '\n')
-                  goto hashing_done;
-              }
-          else
-            while ((c = *p++) != '\n' && (c != '\r' || *p == '\n'))
-              {
-                h = HASH (h, c);
-              }
-        }
-hashing_done:;
+      h = hash_line (&p);
 
       bucket = &buckets[h % nbuckets];
       length = (char const HUGE *) p - ip - ((char const HUGE *) p == incomplete_tail);
@@ -415,6 +446,7 @@ hashing_done:;
           /* Double (alloc_lines - linbuf_base) by adding to alloc_lines.  */
           alloc_lines = 2 * alloc_lines - linbuf_base;
           cureqs = (int *) xrealloc (cureqs, alloc_lines * sizeof (*cureqs));
+          cureqs_alloc = alloc_lines;
           linbuf = (char const HUGE **) xrealloc ((void *)(linbuf + linbuf_base),
                      (alloc_lines - linbuf_base)
                      * sizeof (*linbuf))
@@ -467,6 +499,13 @@ hashing_done:;
   equivs = eqs;
   equivs_alloc = eqs_alloc;
   equivs_index = eqs_index;
+
+  /* WinMerge: count the line table and equivalence codes to memory stats
+     until cleanup_file_buffers frees them */
+  lines_bytes = (alloc_lines - linbuf_base) * sizeof (*linbuf)
+    + cureqs_alloc * sizeof (*cureqs);
+  memory_stats_diffutils (lines_bytes - current->lines_bytes);
+  current->lines_bytes = lines_bytes;
 }
 
 /* Convert any non octet encoded unicode text to UTF-8.
@@ -663,11 +702,38 @@ prepare_text_end (current, side)
     {
       p[buffered_chars++] = '\n';
       current->missing_newline = 1;
-      --current->count_lfs; // compensate for extra newline
+      if (!current->known_text_stats)
+        --current->count_lfs; // compensate for extra newline
     }
 
 	current->buffered_chars = buffered_chars;
 
+	/* WinMerge: with the text stats known there is nothing to count,
+	   and the text needs to be scanned only to map the line endings.  */
+	if (current->known_text_stats)
+	{
+		t = r;
+		if (ignore_eol_diff)
+		{
+			t = q = p + buffered_chars;
+			while (q > r)
+			{
+				switch (*--t = *--q)
+				{
+				case '\r':
+					*t = '\n';
+					break;
+				case '\n':
+					if (q > r && q[-1] == '\r')
+						++t;
+					break;
+				}
+			}
+		}
+		bzero (p + buffered_chars, sizeof (word));
+		return t;
+	}
+
 	/* Count line endings and map them to '\n' if ignore_eol_diff is set. */
 	t = q = p + buffered_chars;
 	while (q > r)
@@ -992,6 +1058,7 @@ read_files (filevec, pretend_binary, bin_file)
   int i;
   int skip_test = always_text_flag | pretend_binary;
   int appears_binary = 0;
+  int hashed_alloc; /* WinMerge: for memory stats */
 
   if (bin_file)
     *bin_file = 0;
@@ -1057,11 +1124,33 @@ read_files (filevec, pretend_binary, bin_file)
   buckets = (int *) xmalloc (nbuckets * sizeof (*buckets));
   bzero (buckets, nbuckets * sizeof (*buckets));
 
+  /* WinMerge: count the equivalence classes and hash buckets to memory stats */
+  hashed_alloc = equivs_alloc;
+  memory_stats_diffutils ((long) (equivs_alloc * sizeof (struct equivclass)
+                                  + nbuckets * sizeof (*buckets)));
+
   for (i = 0; i < 2; ++i)
     find_and_hash_each_line (&filevec[i]);
 
   filevec[0].equiv_max = filevec[1].equiv_max = equivs_index;
 
+  /* WinMerge: equivalence codes are local to this compare, the hashes
+     are not.  Keep them before the equivalence classes are freed.  */
+  if (keep_line_hashes)
+    for (i = 0; i < 2; ++i)
+      {
+        int j, n = filevec[i].buffered_lines;
+        unsigned *hashes = (unsigned *) xmalloc ((n + 1) * sizeof (*hashes));
+        for (j = 0; j < n; ++j)
+          hashes[j] = equivs[filevec[i].equivs[j]].hash;
+        filevec[i].line_hashes = hashes;
+        memory_stats_diffutils ((long) ((n + 1) * sizeof (*hashes)));
+        filevec[i].lines_bytes += (n + 1) * sizeof (*hashes);
+      }
+
+  memory_stats_diffutils ((long) ((equivs_alloc - hashed_alloc) * sizeof (struct equivclass)));
+  memory_stats_diffutils (-(long) (equivs_alloc * sizeof (struct equivclass)
+                                   + nbuckets * sizeof (*buckets)));
   free (equivs);
   free (buckets);
 
@@ -515,6 +515,7 @@
 #define IDC_PATH0_READONLY              8806
 #define IDC_PATH1_READONLY              8807
 #define IDC_PATH2_READONLY              8808
+#define IDC_DETECT_MOVED_FILES          8809
 #define IDS_SPLASH_DEVELOPERS           8976
 #define IDS_SPLASH_GPLTEXT              8977
 #define IDS_MESSAGEBOX_OK               9001
@@ -797,6 +798,10 @@
 #define IDS_DIFFERENT                   17850
 #define IDS_CMPRES_ERROR                17851
 #define IDS_TEXT_FILES_SAME             17852
+#define IDS_IDENTICAL_RENAMED_TO_FMT    17853
+#define IDS_IDENTICAL_MOVED_TO_FMT      17854
+#define IDS_IDENTICAL_RENAMED_FROM_FMT  17855
+#define IDS_IDENTICAL_MOVED_FROM_FMT    17856
 #define IDS_TEXT_FILES_DIFF             17861
 #define IDS_ELAPSED_TIME                17881
 #define IDS_STATUS_SELITEM1             17882
@@ -1228,7 +1233,7 @@
 #define _APS_3D_CONTROLS                     1
 #define _APS_NEXT_RESOURCE_VALUE        244
 #define _APS_NEXT_COMMAND_VALUE         33545
-#define _APS_NEXT_CONTROL_VALUE         8809
+#define _APS_NEXT_CONTROL_VALUE         8810
 #define _APS_NEXT_SYMED_VALUE           115
 #endif
 #endif
@@ -24,6 +24,11 @@ static TCHAR BreakCharDefaults[] = _T(",.;:");
 
 static bool isSafeWhitespace(TCHAR ch);
 static bool isWordBreak(int breakType, const TCHAR *str, int index);
+static void ComputeByteDiff(LPCTSTR pbeg1, int len1, LPCTSTR pbeg2, int len2,
+	bool casitive, int xwhite, int begin[2], int end[2], bool equal);
+
+/** @brief Longest changed range (in chars) refined by the character diff. */
+static const int MaxCharDiffLength = 128;
 
 void sd_Init()
 {
@@ -176,6 +181,7 @@ sd_ComputeWordDiffs(int nFiles, const String str[3],
 			// Hash all words in both lines and then compare them word by word
 			// storing differences into m_wdiffs
 			sdiffs10.BuildWordDiffList();
+			sdiffs12.ShareWords1(sdiffs10);
 			sdiffs12.BuildWordDiffList();
 			if (byte_level)
 			{
@@ -334,7 +340,8 @@ stringdiffs::BuildWordDiffList_DP()
 void
 stringdiffs::BuildWordDiffList()
 {
-	BuildWordsArray(m_str1, m_words1);
+	if (m_words1.empty())
+		BuildWordsArray(m_str1, m_words1);
 	BuildWordsArray(m_str2, m_words2);
 
 #ifdef _WIN64
@@ -354,6 +361,20 @@ stringdiffs::BuildWordDiffList()
 	BuildWordDiffList_DP();
 }
 
+/**
+ * @brief Reuse the words of first string already built by another instance
+ *
+ * Used in 3-way compare where the middle string is the first string of both
+ * pairings, so it is tokenized only once.
+ * @param [in] src Instance with the same first string, BuildWordDiffList() already called.
+ */
+void
+stringdiffs::ShareWords1(const stringdiffs & src)
+{
+	assert(&m_str1 == &src.m_str1 || m_str1 == src.m_str1);
+	m_words1 = src.m_words1;
+}
+
 /**
  * @brief Break line into constituent words
  */
@@ -759,7 +780,24 @@ AdvanceOverWhitespace(LPCTSTR * pcurrent, LPCTSTR end)
  * Assumes whitespace is never leadbyte or trailbyte!
  */
 void
-sd_ComputeByteDiff(String & str1, String & str2, 
+sd_ComputeByteDiff(const String & str1, const String & str2, 
+		   bool casitive, int xwhite, 
+		   int begin[2], int end[2], bool equal)
+{
+	ComputeByteDiff(str1.c_str(), static_cast<int>(str1.length()),
+		str2.c_str(), static_cast<int>(str2.length()),
+		casitive, xwhite, begin, end, equal);
+}
+
+/**
+ * @brief Same as sd_ComputeByteDiff, but works on ranges of existing strings
+ * @param pbeg1, len1 [in] first range (need not be zero-terminated)
+ * @param pbeg2, len2 [in] second range (need not be zero-terminated)
+ *
+ * Results are relative to pbeg1 and pbeg2.
+ */
+static void
+ComputeByteDiff(LPCTSTR pbeg1, int len1, LPCTSTR pbeg2, int len2,
 		   bool casitive, int xwhite, 
 		   int begin[2], int end[2], bool equal)
 {
@@ -767,12 +805,6 @@ sd_ComputeByteDiff(String & str1, String & str2,
 	// Also this way can distinguish if we set begin[0] to -1 for no diff in line
 	begin[0] = end[0] = begin[1] = end[1] = 0;
 
-	int len1 = str1.length();
-	int len2 = str2.length();
-
-	LPCTSTR pbeg1 = str1.c_str();
-	LPCTSTR pbeg2 = str2.c_str();
-
 	if (len1 == 0 || len2 == 0)
 	{
 		if (len1 == len2)
@@ -995,21 +1027,22 @@ sd_ComputeByteDiff(String & str1, String & str2,
 
 /**
  * @brief adjust the range of the specified word diffs down to byte(char) level.
- * @param str1, str2 [in] line to be compared
- * @param casitive [in] true for case-sensitive, false for case-insensitive
- * @param xwhite [in] This governs whether we handle whitespace specially
- *  (see WHITESPACE_COMPARE_ALL, WHITESPACE_IGNORE_CHANGE, WHITESPACE_IGNORE_ALL)
+ *
+ * Common leading and trailing characters of each word diff are trimmed first,
+ * then the remaining range is refined with a character diff (see ComputeCharDiffs).
+ * Everything works on the original strings, no substrings are built.
  */
 void stringdiffs::wordLevelToByteLevel()
 {
+	std::vector<wdiff> refined;
+	refined.reserve(m_wdiffs.size());
 	for (size_t i = 0; i < m_wdiffs.size(); i++)
 	{
-		int begin[3], end[3];
-		wdiff& diff = m_wdiffs[i];
-		String str1_2, str2_2;
-		str1_2 = m_str1.substr(diff.begin[0], diff.end[0] - diff.begin[0] + 1);
-		str2_2 = m_str2.substr(diff.begin[1], diff.end[1] - diff.begin[1] + 1);
-		sd_ComputeByteDiff(str1_2, str2_2, m_case_sensitive, m_whitespace, begin, end, false);
+		int begin[2], end[2];
+		wdiff diff = m_wdiffs[i];
+		ComputeByteDiff(m_str1.c_str() + diff.begin[0], diff.end[0] - diff.begin[0] + 1,
+			m_str2.c_str() + diff.begin[1], diff.end[1] - diff.begin[1] + 1,
+			m_case_sensitive, m_whitespace, begin, end, false);
 		if (begin[0] == -1)
 		{
 			// no visible diff on side1
@@ -1030,6 +1063,100 @@ void stringdiffs::wordLevelToByteLevel()
 			diff.end[1] = diff.begin[1] + end[1];
 			diff.begin[1] += begin[1];
 		}
+		ComputeCharDiffs(diff, refined);
 	}
+	m_wdiffs.swap(refined);
 }
 
+/**
+ * @brief Split one changed range into character level diffs.
+ *
+ * Runs a longest common subsequence over the characters of the range. The
+ * range is kept as is when it is too long (see MaxCharDiffLength), when one
+ * side is empty, or when it contains whitespace that is to be ignored.
+ * Single matching characters between changes are not worth showing and are
+ * left inside the changed ranges.
+ * @param [in] diff Range to refine.
+ * @param [out] diffs Resulting diffs are appended here.
+ */
+void stringdiffs::ComputeCharDiffs(const wdiff & diff, std::vector<wdiff> & diffs)
+{
+	const int len1 = diff.end[0] - diff.begin[0] + 1;
+	const int len2 = diff.end[1] - diff.begin[1] + 1;
+	if (len1 <= 1 || len2 <= 1 || len1 > MaxCharDiffLength || len2 > MaxCharDiffLength)
+	{
+		diffs.push_back(diff);
+		return;
+	}
+	const TCHAR *p1 = m_str1.c_str() + diff.begin[0];
+	const TCHAR *p2 = m_str2.c_str() + diff.begin[1];
+	for (int i = 0; i < len1; ++i)
+	{
+		if (IsLeadByte(p1[i]) || (m_whitespace != WHITESPACE_COMPARE_ALL && isSafeWhitespace(p1[i])))
+		{
+			diffs.push_back(diff);
+			return;
+		}
+	}
+	for (int j = 0; j < len2; ++j)
+	{
+		if (IsLeadByte(p2[j]) || (m_whitespace != WHITESPACE_COMPARE_ALL && isSafeWhitespace(p2[j])))
+		{
+			diffs.push_back(diff);
+			return;
+		}
+	}
+
+	// m_lcs[i * (len2 + 1) + j] is the LCS length of p1[i..] and p2[j..]
+	const int width = len2 + 1;
+	m_lcs.assign((len1 + 1) * width, 0);
+	for (int i = len1 - 1; i >= 0; --i)
+	{
+		for (int j = len2 - 1; j >= 0; --j)
+		{
+			if (caseMatch(p1[i], p2[j]))
+				m_lcs[i * width + j] = m_lcs[(i + 1) * width + j + 1] + 1;
+			else
+				m_lcs[i * width + j] = std::max(m_lcs[(i + 1) * width + j], m_lcs[i * width + j + 1]);
+		}
+	}
+
+	// Walk the table and emit the changed ranges between matched runs
+	bool split = false;
+	int i = 0, j = 0, i0 = 0, j0 = 0;
+	while (i < len1 && j < len2)
+	{
+		if (caseMatch(p1[i], p2[j]) && m_lcs[i * width + j] == m_lcs[(i + 1) * width + j + 1] + 1)
+		{
+			int n = 0;
+			while (i + n < len1 && j + n < len2 && caseMatch(p1[i + n], p2[j + n]) &&
+				m_lcs[(i + n) * width + j + n] == m_lcs[(i + n + 1) * width + j + n + 1] + 1)
+				++n;
+			bool atBoundary = (i == 0 && j == 0) || (i + n == len1 && j + n == len2);
+			if (n > 1 || atBoundary)
+			{
+				if (i0 < i || j0 < j)
+					diffs.push_back(wdiff(diff.begin[0] + i0, diff.begin[0] + i - 1,
+						diff.begin[1] + j0, diff.begin[1] + j - 1));
+				i0 = i + n;
+				j0 = j + n;
+				split = true;
+			}
+			i += n;
+			j += n;
+		}
+		else if (m_lcs[(i + 1) * width + j] >= m_lcs[i * width + j + 1])
+			++i;
+		else
+			++j;
+	}
+	if (!split)
+	{
+		// Nothing worth splitting
+		diffs.push_back(diff);
+		return;
+	}
+	if (i0 < len1 || j0 < len2)
+		diffs.push_back(wdiff(diff.begin[0] + i0, diff.begin[0] + len1 - 1,
+			diff.begin[1] + j0, diff.begin[1] + len2 - 1));
+}
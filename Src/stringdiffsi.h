@@ -48,6 +48,7 @@ public:
 	~stringdiffs();
 
 	void BuildWordDiffList();
+	void ShareWords1(const stringdiffs & src);
 	void wordLevelToByteLevel();
 	void PopulateDiffs();
 
@@ -91,6 +92,7 @@ private:
 		return (word1.bBreak == dlinsert);
 	}
 	bool caseMatch(TCHAR ch1, TCHAR ch2) const;
+	void ComputeCharDiffs(const wdiff & diff, std::vector<wdiff> & diffs);
 	bool BuildWordDiffList_DP();
 	int dp(std::vector<char> & edscript);
 	int onp(std::vector<char> & edscript);
@@ -111,4 +113,5 @@ private:
 	std::vector<word> m_words1;
 	std::vector<word> m_words2;
 	std::vector<wdiff> m_wdiffs;
+	std::vector<unsigned short> m_lcs; /**< Scratch table of ComputeCharDiffs() */
 };
@@ -0,0 +1,63 @@
+/** 
+ * @file  Benchmark.h
+ *
+ * @brief Timing helpers for the benchmark tests.
+ *
+ * Benchmarks are ordinary Google Test cases built into Benchmarks.exe.
+ * Timings are printed and recorded as test properties, so running with
+ * --gtest_output=xml:results.xml gives results that can be compared
+ * between builds with Tools/Scripts/CompareBenchmarks.py.
+ */
+#pragma once
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace bench
+{
+
+/**
+ * @brief Simple deterministic random generator, so inputs are the same on every run.
+ */
+class Random
+{
+public:
+	explicit Random(unsigned seed = 12345) : m_state(seed) {}
+	unsigned Next() { m_state = m_state * 1103515245 + 12345; return (m_state >> 16) & 0x7fff; }
+	int Next(int n) { return static_cast<int>(Next() % n); }
+private:
+	unsigned m_state;
+};
+
+/**
+ * @brief Run func repeatedly and record the average time per iteration.
+ * @param [in] name Name of the measurement, used as the test property name.
+ * @param [in] func Function to measure.
+ * @param [in] minIterations Minimum number of iterations.
+ * @param [in] minSeconds Minimum total running time.
+ * @return Average nanoseconds per iteration.
+ */
+template <class Func>
+double Measure(const std::string& name, Func func, int minIterations = 3, double minSeconds = 0.5)
+{
+	typedef std::chrono::steady_clock clock;
+	int iterations = 0;
+	double elapsed = 0;
+	clock::time_point start = clock::now();
+	do
+	{
+		func();
+		++iterations;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (iterations < minIterations || elapsed < minSeconds);
+
+	double nsPerIteration = elapsed * 1e9 / iterations;
+	printf("[ BENCH    ] %s: %.0f ns/iteration (%d iterations)\n",
+		name.c_str(), nsPerIteration, iterations);
+	testing::Test::RecordProperty(name, std::to_string(static_cast<long long>(nsPerIteration)));
+	return nsPerIteration;
+}
+
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/ByteCompare.h"
+#include "CompareEngines/BinaryCompare.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffItem.h"
+#include "PathContext.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking the quick contents and binary compare
+	// engines with identical file pairs, so the whole files are read.
+	class ByteCompareBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Write text file pairs and binary file pairs once for all benchmarks.
+		 * The text pairs differ only in amount of whitespace and in EOL styles.
+		 */
+		static void SetUpTestCase()
+		{
+			const char *eols[] = { "\r\n", "\n", "\r" };
+			bench::Random rnd;
+			for (int i = 0; i < 20; ++i)
+			{
+				std::string left, right;
+				while (left.size() < 256 * 1024)
+				{
+					std::string line = "\tint value" + std::to_string(rnd.Next(1000)) + " = compute(a, " + std::to_string(rnd.Next(100)) + ");";
+					left += line + "\r\n";
+					right += (rnd.Next(5) == 0 ? "    " + line.substr(1) : line) + eols[rnd.Next(3)];
+				}
+				s_textLeft.push_back(WriteFile("text" + std::to_string(i) + "_left", left));
+				s_textRight.push_back(WriteFile("text" + std::to_string(i) + "_right", right));
+
+				std::string bin(1024 * 1024, '\0');
+				for (size_t j = 0; j < bin.size(); ++j)
+					bin[j] = static_cast<char>(rnd.Next(256));
+				s_binLeft.push_back(WriteFile("bin" + std::to_string(i) + "_left", bin));
+				s_binRight.push_back(WriteFile("bin" + std::to_string(i) + "_right", bin));
+			}
+		}
+
+		static void TearDownTestCase()
+		{
+			std::vector<String> *lists[] = { &s_textLeft, &s_textRight, &s_binLeft, &s_binRight };
+			for (int l = 0; l < 4; ++l)
+			{
+				for (size_t i = 0; i < lists[l]->size(); ++i)
+					remove(ucr::toUTF8((*lists[l])[i]).c_str());
+				lists[l]->clear();
+			}
+		}
+
+		static String WriteFile(const std::string& name, const std::string& data)
+		{
+			String filename = ucr::toTString("ByteCompareBench_" + name + ".dat");
+			std::ofstream ostr(ucr::toUTF8(filename).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << data;
+			return filename;
+		}
+
+		/**
+		 * @brief Compare the pairs like quick contents folder compare does.
+		 * @return Number of pairs found identical.
+		 */
+		static int QuickCompareAll(const std::vector<String>& left, const std::vector<String>& right, const CompareOptions& options)
+		{
+			CompareEngines::ByteCompare engine;
+			int nsame = 0;
+			for (size_t i = 0; i < left.size(); ++i)
+			{
+				DiffFileData data;
+				data.SetDisplayFilepaths(left[i], right[i]);
+				if (!data.OpenFiles(left[i], right[i]))
+					continue;
+				engine.SetCompareOptions(options);
+				engine.SetAdditionalOptions(false);
+				engine.SetFileData(2, data.m_inf);
+				int code = engine.CompareFiles(data.m_FileLocation);
+				if ((code & DIFFCODE::COMPAREFLAGS) == DIFFCODE::SAME)
+					++nsame;
+			}
+			return nsame;
+		}
+
+		static std::vector<String> s_textLeft;
+		static std::vector<String> s_textRight;
+		static std::vector<String> s_binLeft;
+		static std::vector<String> s_binRight;
+	};
+
+	std::vector<String> ByteCompareBench::s_textLeft;
+	std::vector<String> ByteCompareBench::s_textRight;
+	std::vector<String> ByteCompareBench::s_binLeft;
+	std::vector<String> ByteCompareBench::s_binRight;
+
+	TEST_F(ByteCompareBench, QuickContents)
+	{
+		int nsame = 0;
+		CompareOptions options;
+		bench::Measure("QuickBinary20MB", [&]() {
+			nsame = QuickCompareAll(s_binLeft, s_binRight, options);
+		});
+		EXPECT_EQ(static_cast<int>(s_binLeft.size()), nsame);
+
+		options.m_ignoreWhitespace = WHITESPACE_IGNORE_CHANGE;
+		options.m_bIgnoreEOLDifference = true;
+		bench::Measure("QuickTextIgnoreWhitespace5MB", [&]() {
+			nsame = QuickCompareAll(s_textLeft, s_textRight, options);
+		});
+		EXPECT_EQ(static_cast<int>(s_textLeft.size()), nsame);
+	}
+
+	TEST_F(ByteCompareBench, Binary)
+	{
+		CompareEngines::BinaryCompare engine;
+		int nsame = 0;
+		bench::Measure("Binary20MB", [&]() {
+			nsame = 0;
+			for (size_t i = 0; i < s_binLeft.size(); ++i)
+			{
+				PathContext files(s_binLeft[i], s_binRight[i]);
+				DIFFITEM di;
+				di.diffFileInfo[0].size = di.diffFileInfo[1].size = 1024 * 1024;
+				if (engine.CompareFiles(files, di) == DIFFCODE::SAME)
+					++nsame;
+			}
+		});
+		EXPECT_EQ(static_cast<int>(s_binLeft.size()), nsame);
+	}
+
+}  // namespace
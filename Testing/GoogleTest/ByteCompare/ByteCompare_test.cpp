@@ -417,6 +417,60 @@ namespace
 		remove(filename_lf.c_str());
 	}
 
+	TEST_F(ByteCompareTest, IgnoreEOLDifferenceAtBufferEnd)
+	{
+		const char *eols[] = { "\r\n", "\n", "\r" };
+		std::string filename_left  = "_tmp_.txt";
+		std::string filename_right = "_tmp_2.txt";
+
+		const enum WhitespaceIgnoreChoices whitespaces[] = {
+			WHITESPACE_COMPARE_ALL, WHITESPACE_COMPARE_ALL,
+			WHITESPACE_IGNORE_CHANGE, WHITESPACE_IGNORE_ALL };
+
+		for (int ignore = 0; ignore < 4; ++ignore)
+		{
+			CompareEngines::ByteCompare bc;
+			QuickCompareOptions option;
+			option.m_bIgnoreEOLDifference = true;
+			option.m_bIgnoreBlankLines = (ignore == 1);
+			option.m_ignoreWhitespace = whitespaces[ignore];
+			bc.SetCompareOptions(option);
+
+			for (int eol_left = 0; eol_left < 3; ++eol_left)
+			{
+				for (int eol_right = 0; eol_right < 3; ++eol_right)
+				{
+					// the first EOL falls on each position around the end of
+					// the first buffer, the lines of varying length after it
+					// on many positions around the ends of the next buffers.
+					// The lines start with whitespace, changed on the right
+					// side when ignored, so the sides also reach the buffer
+					// ends at different positions
+					for (int first = WMCMPBUFF - 3; first <= WMCMPBUFF + 1; ++first)
+					{
+						std::string left(first, 'a'), right(first, 'a');
+						for (int i = 0; i < 3000; ++i)
+						{
+							std::string line(i % 37, static_cast<char>('a' + i % 26));
+							std::string space = (ignore >= 2 && i % 5 == 0) ? "    " : "\t";
+							left  += eols[eol_left]  + ("\t" + line);
+							right += eols[eol_right] + (space + line);
+						}
+
+						TempFile file_left (filename_left,  left.c_str(),  left.size());
+						TempFile file_right(filename_right, right.c_str(), right.size());
+
+						FilePair pair(filename_left, filename_right);
+						bc.SetFileData(2, pair.filedata);
+
+						EXPECT_EQ(DIFFCODE::TEXT|DIFFCODE::SAME, bc.CompareFiles(pair.location))
+							<< "ignore " << ignore << " eols " << eol_left << " " << eol_right << " first " << first;
+					}
+				}
+			}
+		}
+	}
+
 	TEST_F(ByteCompareTest, IgnoreCase)
 	{
 		CompareEngines::ByteCompare bc;
@@ -1182,6 +1182,16 @@ namespace
 		EXPECT_EQ(_T(""), cmdInfo.m_sPreDiffer);
 	}
 
+	// Memory stats dump file
+	TEST_F(MergeCmdLineInfoTest, MemoryStatsFile)
+	{
+		MergeCmdLineInfo cmdInfo(_T("C:\\WinMerge\\WinMerge.exe -memstats \"C:\\Temp\\mem stats.txt\" -dl First"));
+		EXPECT_EQ(0, cmdInfo.m_Files.GetSize());
+		EXPECT_EQ(_T("C:\\Temp\\mem stats.txt"), cmdInfo.m_sMemoryStatsFile);
+		EXPECT_EQ(_T("First"), cmdInfo.m_sLeftDesc);
+		EXPECT_EQ(_T(""), cmdInfo.m_sReportFile);
+	}
+
 #if 0 // Disabled for now - should we handle this case?
 	// Missing description
 	TEST_F(MergeCmdLineInfoTest, DescMissing)
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <vector>
+#include <cstdlib>
+#include "DiffList.h"
+#include "DiffLineRanges.h"
+#include "LineFlagRanges.h"
+
+namespace
+{
+	enum { DIFF = 1, GHOST = 2, INVISIBLE = 4 };
+
+	// The fixture for testing DiffLineRanges against per line flags.
+	class DiffLineRangesTest : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Flag diff and ghost lines of the first file like
+		 * CMergeDoc::PrimeTextBuffers() does.
+		 */
+		static std::vector<int> FlagLines(const DiffList& diffList, int nLines)
+		{
+			std::vector<int> flags(nLines);
+			for (int nDiff = 0; nDiff < diffList.GetSize(); nDiff++)
+			{
+				const DIFFRANGE *dfi = diffList.DiffRangeAt(nDiff);
+				for (int i = dfi->dbegin; i <= dfi->dend && i < nLines; i++)
+				{
+					if (dfi->blank[0] != -1 && i >= dfi->blank[0])
+						flags[i] |= GHOST;
+					else if (dfi->op != OP_TRIVIAL)
+						flags[i] |= DIFF;
+				}
+			}
+			return flags;
+		}
+
+		/**
+		 * @brief Hide lines like CMergeDoc::HideLines() did, testing the
+		 * flags of each line.
+		 */
+		static void HideLines(std::vector<int>& flags, int nLineCount, int nContext)
+		{
+			int nLine;
+			for (nLine = 0; nLine < nLineCount;)
+			{
+				if (!(flags[nLine] & (DIFF | GHOST)))
+				{
+					flags[nLine] |= INVISIBLE;
+					nLine++;
+				}
+				else
+				{
+					int nLine2 = (nLine - nContext < 0) ? 0 : (nLine - nContext);
+					for (; nLine2 < nLine; nLine2++)
+						flags[nLine2] &= ~INVISIBLE;
+
+					for (; nLine < nLineCount; nLine++)
+					{
+						if (!(flags[nLine] & (DIFF | GHOST)))
+							break;
+						flags[nLine] &= ~INVISIBLE;
+					}
+
+					int nLineEnd2 = (nLine + nContext >= nLineCount) ? nLineCount-1 : (nLine + nContext);
+					for (; nLine < nLineEnd2; nLine++)
+					{
+						flags[nLine] &= ~INVISIBLE;
+						if (flags[nLine] & (DIFF | GHOST))
+							nLineEnd2 = (nLine + 1 + nContext >= nLineCount) ? nLineCount-1 : (nLine + 1 + nContext);
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief Make a diff list of random differences with random gaps.
+		 * @return Number of lines covered by the differences and gaps.
+		 */
+		static int MakeDiffList(DiffList& diffList, int nDiffs, int nMaxGap)
+		{
+			static const OP_TYPE ops[] = { OP_DIFF, OP_1STONLY, OP_2NDONLY, OP_TRIVIAL };
+			int nLine = 0;
+			for (int i = 0; i < nDiffs; i++)
+			{
+				nLine += rand() % (nMaxGap + 1);
+				DIFFRANGE dr;
+				dr.op = ops[rand() % 4];
+				dr.dbegin = nLine;
+				dr.dend = nLine + rand() % 5;
+				if (rand() % 2)
+					dr.blank[0] = dr.dbegin + rand() % (dr.dend - dr.dbegin + 1);
+				diffList.AddDiff(dr);
+				nLine = dr.dend + 1;
+			}
+			return nLine + rand() % (nMaxGap + 1);
+		}
+
+		/** @brief Is the line in one of the ranges? */
+		static bool InRanges(const std::vector<DiffLineRanges::Range>& ranges, int nLine)
+		{
+			for (size_t i = 0; i < ranges.size(); ++i)
+			{
+				if (ranges[i].nBegin <= nLine && nLine < ranges[i].nEnd)
+					return true;
+			}
+			return false;
+		}
+
+		static bool IsDiffLine(const DiffLineRanges& ranges, int nLine)
+		{
+			return InRanges(ranges.GetDiffRanges(), nLine);
+		}
+
+		/** @brief Lines after the shortest buffer are always shown */
+		static bool IsLineVisible(const DiffLineRanges& ranges, int nLine)
+		{
+			return nLine >= ranges.GetLineCount() || InRanges(ranges.GetVisibleRanges(), nLine);
+		}
+
+		static void ExpectEqualToFlags(const DiffList& diffList, int nLines, int nLineCount, int nContext)
+		{
+			std::vector<int> flags = FlagLines(diffList, nLines);
+			HideLines(flags, nLineCount, nContext);
+
+			DiffLineRanges ranges;
+			ranges.Build(diffList, nLineCount, nContext);
+			// Flag the lines of a buffer like CMergeDoc::HideLines() does
+			std::vector<DiffLineRanges::Range> hidden = ranges.GetHiddenRanges();
+			const std::vector<DiffLineRanges::Range>& visible = ranges.GetVisibleRanges();
+			LineFlagRanges lineFlags(INVISIBLE);
+			for (size_t i = 0; i < hidden.size(); ++i)
+				lineFlags.SetLineFlags(hidden[i].nBegin, hidden[i].nEnd - 1, INVISIBLE, INVISIBLE);
+			for (size_t i = 0; i < visible.size(); ++i)
+				lineFlags.SetLineFlags(visible[i].nBegin, visible[i].nEnd - 1, INVISIBLE, 0);
+			for (int nLine = 0; nLine < nLines; nLine++)
+			{
+				bool bDiff = nLine < nLineCount && (flags[nLine] & (DIFF | GHOST)) != 0;
+				EXPECT_EQ(bDiff, IsDiffLine(ranges, nLine)) << "line " << nLine;
+				EXPECT_EQ(!(flags[nLine] & INVISIBLE), IsLineVisible(ranges, nLine)) << "line " << nLine << " context " << nContext;
+				EXPECT_EQ(flags[nLine] & INVISIBLE, static_cast<int>(lineFlags.GetLineFlags(nLine))) << "line " << nLine << " context " << nContext;
+			}
+		}
+	};
+
+	TEST_F(DiffLineRangesTest, NoDiffs)
+	{
+		DiffLineRanges ranges;
+		std::vector<DiffLineRanges::Range> diffRanges;
+		ranges.Build(diffRanges, 10, 3);
+		EXPECT_EQ(0, ranges.GetVisibleRanges().size());
+		ASSERT_EQ(1, ranges.GetHiddenRanges().size());
+		EXPECT_EQ(0, ranges.GetHiddenRanges()[0].nBegin);
+		EXPECT_EQ(10, ranges.GetHiddenRanges()[0].nEnd);
+		EXPECT_FALSE(IsLineVisible(ranges, 0));
+		EXPECT_FALSE(IsLineVisible(ranges, 9));
+		EXPECT_TRUE(IsLineVisible(ranges, 10));
+	}
+
+	TEST_F(DiffLineRangesTest, AllLinesShown)
+	{
+		DiffLineRanges ranges;
+		std::vector<DiffLineRanges::Range> diffRanges(1);
+		diffRanges[0].nBegin = 4;
+		diffRanges[0].nEnd = 5;
+		ranges.Build(diffRanges, 10, -1);
+		EXPECT_EQ(0, ranges.GetHiddenRanges().size());
+		EXPECT_TRUE(IsLineVisible(ranges, 0));
+		EXPECT_TRUE(IsDiffLine(ranges, 4));
+		EXPECT_FALSE(IsDiffLine(ranges, 5));
+	}
+
+	TEST_F(DiffLineRangesTest, ContextAroundDiff)
+	{
+		DiffLineRanges ranges;
+		std::vector<DiffLineRanges::Range> diffRanges(1);
+		diffRanges[0].nBegin = 4;
+		diffRanges[0].nEnd = 6;
+		ranges.Build(diffRanges, 20, 2);
+		ASSERT_EQ(1, ranges.GetVisibleRanges().size());
+		EXPECT_EQ(2, ranges.GetVisibleRanges()[0].nBegin);
+		EXPECT_EQ(8, ranges.GetVisibleRanges()[0].nEnd);
+	}
+
+	TEST_F(DiffLineRangesTest, ContextsMerged)
+	{
+		DiffLineRanges ranges;
+		std::vector<DiffLineRanges::Range> diffRanges(2);
+		diffRanges[0].nBegin = 2;
+		diffRanges[0].nEnd = 3;
+		diffRanges[1].nBegin = 7;
+		diffRanges[1].nEnd = 8;
+		ranges.Build(diffRanges, 20, 2);
+		ASSERT_EQ(1, ranges.GetVisibleRanges().size());
+		EXPECT_EQ(0, ranges.GetVisibleRanges()[0].nBegin);
+		EXPECT_EQ(10, ranges.GetVisibleRanges()[0].nEnd);
+	}
+
+	// The context after a difference never shows the last line
+	TEST_F(DiffLineRangesTest, LastLine)
+	{
+		DiffList diffList;
+		DIFFRANGE dr;
+		dr.op = OP_DIFF;
+		dr.dbegin = dr.dend = 7;
+		diffList.AddDiff(dr);
+		ExpectEqualToFlags(diffList, 10, 10, 5);
+		DiffLineRanges ranges;
+		ranges.Build(diffList, 10, 5);
+		EXPECT_TRUE(IsLineVisible(ranges, 8));
+		EXPECT_FALSE(IsLineVisible(ranges, 9));
+	}
+
+	// Ignored differences are diff lines only where the first file has ghost lines
+	TEST_F(DiffLineRangesTest, TrivialDiff)
+	{
+		DiffList diffList;
+		DIFFRANGE dr;
+		dr.op = OP_TRIVIAL;
+		dr.dbegin = 2;
+		dr.dend = 3;
+		diffList.AddDiff(dr);
+		dr.dbegin = 6;
+		dr.dend = 8;
+		dr.blank[0] = 7;
+		diffList.AddDiff(dr);
+		DiffLineRanges ranges;
+		ranges.Build(diffList, 12, 0);
+		EXPECT_FALSE(IsDiffLine(ranges, 2));
+		EXPECT_FALSE(IsDiffLine(ranges, 6));
+		EXPECT_TRUE(IsDiffLine(ranges, 7));
+		EXPECT_TRUE(IsDiffLine(ranges, 8));
+		ExpectEqualToFlags(diffList, 12, 12, 0);
+	}
+
+	TEST_F(DiffLineRangesTest, EqualToFlagsRandom)
+	{
+		srand(1);
+		for (int nTest = 0; nTest < 500; nTest++)
+		{
+			DiffList diffList;
+			int nLines = MakeDiffList(diffList, rand() % 8, 1 + rand() % 12);
+			// The shortest buffer may end before the last difference
+			int nLineCount = nLines - rand() % 3;
+			if (nLineCount < 0)
+				nLineCount = 0;
+			for (int nContext = 0; nContext <= 6; nContext++)
+				ExpectEqualToFlags(diffList, nLines, nLineCount, nContext);
+			if (HasFailure())
+				break;
+		}
+	}
+
+}  // namespace
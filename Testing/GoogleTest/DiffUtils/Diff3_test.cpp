@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <string>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffList.h"
+#include "DiffWrapper.h"
+#include "unicoder.h"
+#include "../UnitTests/RandomFileTest.h"
+
+namespace
+{
+	// The fixture for testing that the three-way diff blocks are classified
+	// the same whether file 0 and file 2 are compared by line hashes or by text.
+	class Diff3Test : public RandomFileTest
+	{
+	protected:
+		Diff3Test() : RandomFileTest("Diff3Test")
+		{
+		}
+
+		/**
+		 * @brief Compare three files like the folder compare does.
+		 * @param [in] bKeepLineHashes Compare file 0 and file 2 by line hashes.
+		 * @return Diff blocks found.
+		 */
+		std::vector<DIFFRANGE> Compare3(const String files[3], const DiffutilsOptions& options, bool bKeepLineHashes)
+		{
+			CompareEngines::DiffUtils engine;
+			engine.SetCompareOptions(options);
+			engine.SetCodepage(CP_UTF8);
+			DiffFileData data10, data12;
+			data10.SetDisplayFilepaths(files[1], files[0]);
+			data12.SetDisplayFilepaths(files[1], files[2]);
+			EXPECT_TRUE(data10.OpenFiles(files[1], files[0]));
+			EXPECT_TRUE(data12.OpenFiles(files[1], files[2]));
+
+			struct change *script10 = NULL, *script12 = NULL;
+			int bin_flag10 = 0, bin_flag12 = 0;
+			keep_line_hashes = bKeepLineHashes;
+			engine.SetFileData(2, data10.m_inf);
+			engine.Diff2Files(&script10, 0, &bin_flag10, false, NULL);
+			engine.SetFileData(2, data12.m_inf);
+			engine.Diff2Files(&script12, 0, &bin_flag12, false, NULL);
+			keep_line_hashes = 0;
+			EXPECT_EQ(bKeepLineHashes, data10.m_inf[1].line_hashes != NULL);
+			EXPECT_EQ(bKeepLineHashes, data12.m_inf[1].line_hashes != NULL);
+
+			CDiffWrapper dw;
+			DiffList diffList;
+			dw.SetCreateDiffList(&diffList);
+			dw.LoadWinMergeDiffsFromDiffUtilsScript3(script10, script12, data10.m_inf, data12.m_inf);
+			dw.FreeDiffUtilsScript3(script10, script12);
+
+			std::vector<DIFFRANGE> diffs(diffList.GetSize());
+			for (int i = 0; i < diffList.GetSize(); ++i)
+				diffList.GetDiff(i, diffs[i]);
+			return diffs;
+		}
+
+		/** @brief Check both ways of comparing file 0 and file 2 find the same blocks. */
+		void CheckSame(const String files[3], const DiffutilsOptions& options)
+		{
+			std::vector<DIFFRANGE> byText = Compare3(files, options, false);
+			std::vector<DIFFRANGE> byHash = Compare3(files, options, true);
+			ASSERT_EQ(byText.size(), byHash.size());
+			for (size_t i = 0; i < byText.size(); ++i)
+			{
+				EXPECT_EQ(byText[i].op, byHash[i].op);
+				for (int file = 0; file < 3; ++file)
+				{
+					EXPECT_EQ(byText[i].begin[file], byHash[i].begin[file]);
+					EXPECT_EQ(byText[i].end[file], byHash[i].end[file]);
+				}
+			}
+		}
+	};
+
+	/** @brief Op of the only diff block of a sample, or OP_NONE if none. */
+	OP_TYPE SampleOp(const std::vector<DIFFRANGE>& diffs)
+	{
+		EXPECT_GE(1u, diffs.size());
+		return diffs.empty() ? OP_NONE : diffs[0].op;
+	}
+
+	TEST_F(Diff3Test, Samples)
+	{
+		static const struct { const TCHAR *name; OP_TYPE op; } samples[] =
+		{
+			{ _T("file123_0.txt"), OP_NONE },
+			{ _T("file123_samesize_samecontents.txt"), OP_NONE },
+			{ _T("file123_samesize_diffcontents.txt"), OP_DIFF },
+			{ _T("file123_samesize_diffcontents1.txt"), OP_1STONLY },
+			{ _T("file123_samesize_diffcontents2.txt"), OP_2NDONLY },
+			{ _T("file123_samesize_diffcontents3.txt"), OP_3RDONLY },
+			{ _T("file123_diffsize.txt"), OP_DIFF },
+			{ _T("file123_diffsize1.txt"), OP_1STONLY },
+			{ _T("file123_diffsize2.txt"), OP_2NDONLY },
+			{ _T("file123_diffsize3.txt"), OP_3RDONLY },
+		};
+		DiffutilsOptions options;
+		for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+		{
+			String files[3];
+			for (int file = 0; file < 3; ++file)
+				files[file] = String(_T("../../Data/Compare/Dir")) + static_cast<TCHAR>('1' + file) + _T("/") + samples[i].name;
+			EXPECT_EQ(samples[i].op, SampleOp(Compare3(files, options, false))) << ucr::toUTF8(samples[i].name);
+			EXPECT_EQ(samples[i].op, SampleOp(Compare3(files, options, true))) << ucr::toUTF8(samples[i].name);
+		}
+	}
+
+	// Random files share an identical prefix and suffix, which is not hashed,
+	// and file 0 and file 2 often make the same change to file 1.
+	TEST_F(Diff3Test, RandomFiles)
+	{
+		static const char *words[] = { "int", "value", "return", "Count", "for", "x", "=", "+", ";" };
+		for (int ignore = 0; ignore < 2; ++ignore)
+		{
+			DiffutilsOptions options;
+			if (ignore)
+			{
+				options.m_ignoreWhitespace = WHITESPACE_IGNORE_CHANGE;
+				options.m_bIgnoreCase = true;
+			}
+			for (int n = 0; n < 100; ++n)
+			{
+				std::vector<std::string> lines;
+				int nLines = 1 + Next(60);
+				for (int i = 0; i < nLines; ++i)
+				{
+					std::string line;
+					int nWords = Next(6);
+					for (int w = 0; w < nWords; ++w)
+						line += std::string(w ? " " : "") + words[Next(9)];
+					lines.push_back(line);
+				}
+				std::vector<std::string> changed[3] = { lines, lines, lines };
+				int nChanges = Next(6);
+				for (int c = 0; c < nChanges; ++c)
+				{
+					int i = Next(nLines);
+					std::string line = lines[i] + (Next(2) ? " changed" : " CHANGED  ");
+					if (Next(2))
+						changed[0][i] = changed[2][i] = line;
+					else
+						changed[Next(3)][i] = line;
+				}
+				String files[3];
+				for (int file = 0; file < 3; ++file)
+					files[file] = WriteLines(std::to_string(n) + "_" + std::to_string(file), changed[file], "\r\n");
+				CheckSame(files, options);
+			}
+		}
+	}
+
+}  // namespace
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffItem.h"
+#include "FilterCommentsManager.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking the diffutils compare engine.
+	class DiffUtilsBench : public testing::Test
+	{
+	protected:
+		DiffUtilsBench()
+			: m_filterCommentsManager(_T("DiffUtilsBench_NoSuchFile.ini"))
+		{
+		}
+
+		virtual ~DiffUtilsBench()
+		{
+			for (size_t i = 0; i < m_files.size(); ++i)
+				remove(ucr::toUTF8(m_files[i]).c_str());
+		}
+
+		/**
+		 * @brief Write a small C/Java like source file.
+		 * Both variants of a file have the same code and different comments.
+		 */
+		String WriteSource(int index, int variant, const TCHAR *ext)
+		{
+			static const char *words[2][4] = {
+				{ "compute", "the", "next", "value" },
+				{ "returns", "an", "updated", "result" } };
+			const char **w = words[variant];
+			std::ostringstream ss;
+			ss << "/* File " << index << ": " << w[0] << " " << w[1] << " " << w[3] << " */\n";
+			for (int f = 0; f < 8; ++f)
+			{
+				ss << "// " << w[f % 4] << " " << w[(f + 1) % 4] << " function " << f << "\n";
+				ss << "int func" << f << "(int a, int b)\n";
+				ss << "{\n";
+				ss << "\t/* " << w[2] << " " << w[3] << "\n";
+				ss << "\t   " << w[0] << " */\n";
+				ss << "\tint c = a * " << f << " + b; // " << w[1] << " " << w[2] << "\n";
+				ss << "\tchar *s = \"// not a comment\";\n";
+				ss << "\treturn c;\n";
+				ss << "}\n\n";
+			}
+			String filename = _T("DiffUtilsBench_") + ucr::toTString(std::to_string(index)) +
+				(variant ? _T("_right.") : _T("_left.")) + ext;
+			std::ofstream ostr(ucr::toUTF8(filename).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << ss.str();
+			m_files.push_back(filename);
+			return filename;
+		}
+
+		/**
+		 * @brief Compare all file pairs like folder compare does.
+		 * @return Number of pairs found identical.
+		 */
+		int CompareAll(const std::vector<String>& left, const std::vector<String>& right, bool filterComments)
+		{
+			DiffutilsOptions options;
+			options.m_filterCommentsLines = filterComments;
+			CompareEngines::DiffUtils engine;
+			int nsame = 0;
+			for (size_t i = 0; i < left.size(); ++i)
+			{
+				DiffFileData data;
+				data.SetDisplayFilepaths(left[i], right[i]);
+				if (!data.OpenFiles(left[i], right[i]))
+					continue;
+				engine.SetCompareOptions(options);
+				engine.SetFilterCommentsManager(&m_filterCommentsManager);
+				engine.SetFileData(2, data.m_inf);
+				int code = engine.diffutils_compare_files();
+				if ((code & DIFFCODE::COMPAREFLAGS) == DIFFCODE::SAME)
+					++nsame;
+			}
+			return nsame;
+		}
+
+		/**
+		 * @brief Write a pair of files differing in whitespace, case, blank
+		 * lines and EOLs, and in some lines of content.
+		 */
+		void WriteVariantPair(bench::Random& rnd, int index, String& left, String& right)
+		{
+			std::ostringstream ssLeft, ssRight;
+			for (int line = 0; line < 1000; ++line)
+			{
+				std::string text = "int value" + std::to_string(rnd.Next(1000)) + " = Compute(a, " + std::to_string(rnd.Next(100)) + ");";
+				ssLeft << "\t" << text << "\r\n";
+				switch (rnd.Next(10))
+				{
+				case 0: ssRight << "    " << text << "\r\n"; break;
+				case 1: ssRight << "\t" << text << "\n"; break;
+				case 2: for (size_t i = 0; i < text.size(); ++i) text[i] = static_cast<char>(toupper(text[i]));
+					ssRight << "\t" << text << "\r\n"; break;
+				case 3: ssRight << "\r\n\t" << text << "\r\n"; break;
+				case 4: ssRight << "\t" << text << (rnd.Next(10) == 0 ? " changed" : "") << "\r\n"; break;
+				default: ssRight << "\t" << text << "\r\n"; break;
+				}
+			}
+			std::string prefix = "DiffUtilsBench_Variant" + std::to_string(index);
+			left = ucr::toTString(prefix + "_left.txt");
+			right = ucr::toTString(prefix + "_right.txt");
+			std::ofstream(ucr::toUTF8(left).c_str(), std::ios::out|std::ios::binary|std::ios::trunc) << ssLeft.str();
+			std::ofstream(ucr::toUTF8(right).c_str(), std::ios::out|std::ios::binary|std::ios::trunc) << ssRight.str();
+			m_files.push_back(left);
+			m_files.push_back(right);
+		}
+
+		/**
+		 * @brief Compare all file pairs with the options.
+		 * @return Total number of differences found.
+		 */
+		int CountDiffs(const std::vector<String>& left, const std::vector<String>& right, const DiffutilsOptions& options)
+		{
+			CompareEngines::DiffUtils engine;
+			int ntotal = 0;
+			for (size_t i = 0; i < left.size(); ++i)
+			{
+				DiffFileData data;
+				data.SetDisplayFilepaths(left[i], right[i]);
+				if (!data.OpenFiles(left[i], right[i]))
+					continue;
+				engine.SetCompareOptions(options);
+				engine.SetFileData(2, data.m_inf);
+				engine.diffutils_compare_files();
+				int ndiffs = 0, ntrivialdiffs = 0;
+				engine.GetDiffCounts(ndiffs, ntrivialdiffs);
+				ntotal += ndiffs;
+			}
+			return ntotal;
+		}
+
+		FilterCommentsManager m_filterCommentsManager;
+		std::vector<String> m_files;
+	};
+
+	TEST_F(DiffUtilsBench, FilterComments)
+	{
+		std::vector<String> left, right;
+		for (int i = 0; i < 200; ++i)
+		{
+			const TCHAR *ext = (i % 2) ? _T("java") : _T("c");
+			left.push_back(WriteSource(i, 0, ext));
+			right.push_back(WriteSource(i, 1, ext));
+		}
+
+		int nsame = 0;
+		bench::Measure("NoFilter", [&]() {
+			nsame = CompareAll(left, right, false);
+		});
+		EXPECT_EQ(0, nsame);
+		bench::Measure("FilterComments", [&]() {
+			nsame = CompareAll(left, right, true);
+		});
+		EXPECT_EQ(static_cast<int>(left.size()), nsame);
+	}
+
+	// diff_2_files with each ignore option
+	TEST_F(DiffUtilsBench, IgnoreOptions)
+	{
+		bench::Random rnd;
+		std::vector<String> left, right;
+		for (int i = 0; i < 20; ++i)
+		{
+			String l, r;
+			WriteVariantPair(rnd, i, l, r);
+			left.push_back(l);
+			right.push_back(r);
+		}
+
+		struct Variant
+		{
+			const char *name;
+			WhitespaceIgnoreChoices whitespace;
+			bool bIgnoreCase;
+			bool bIgnoreBlankLines;
+			bool bIgnoreEol;
+		};
+		static const Variant variants[] = {
+			{ "CompareAll", WHITESPACE_COMPARE_ALL, false, false, false },
+			{ "IgnoreWhitespaceChange", WHITESPACE_IGNORE_CHANGE, false, false, false },
+			{ "IgnoreAllWhitespace", WHITESPACE_IGNORE_ALL, false, false, false },
+			{ "IgnoreCase", WHITESPACE_COMPARE_ALL, true, false, false },
+			{ "IgnoreBlankLines", WHITESPACE_COMPARE_ALL, false, true, false },
+			{ "IgnoreEol", WHITESPACE_COMPARE_ALL, false, false, true },
+			{ "IgnoreAll", WHITESPACE_IGNORE_ALL, true, true, true },
+		};
+		int nCompareAllDiffs = INT_MAX;
+		for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v)
+		{
+			DiffutilsOptions options;
+			options.m_ignoreWhitespace = variants[v].whitespace;
+			options.m_bIgnoreCase = variants[v].bIgnoreCase;
+			options.m_bIgnoreBlankLines = variants[v].bIgnoreBlankLines;
+			options.m_bIgnoreEOLDifference = variants[v].bIgnoreEol;
+			int ndiffs = 0;
+			bench::Measure(std::string("Diff2Files") + variants[v].name, [&]() {
+				ndiffs = CountDiffs(left, right, options);
+			});
+			EXPECT_GT(ndiffs, 0) << variants[v].name;
+			if (v == 0)
+				nCompareAllDiffs = ndiffs;
+			else
+				EXPECT_LT(ndiffs, nCompareAllDiffs) << variants[v].name;
+		}
+	}
+
+}  // namespace
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <string>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareOptions.h"
+#include "DiffContext.h"
+#include "DiffFileData.h"
+#include "DiffItem.h"
+#include "FilterList.h"
+#include "unicoder.h"
+#include "../UnitTests/RandomFileTest.h"
+
+namespace
+{
+	/** @brief Result of comparing a pair of files */
+	struct CompareResult
+	{
+		unsigned code;
+		int ndiffs;
+		int ntrivialdiffs;
+	};
+
+	// The fixture for testing the status of the diffutils compare engine
+	// when it stops after the first difference.
+	class DiffUtilsTest : public RandomFileTest
+	{
+	protected:
+		DiffUtilsTest() : RandomFileTest("DiffUtilsTest")
+		{
+		}
+
+		/**
+		 * @brief Write a random pair of files.
+		 * The right file is a copy of the left one with a few changes in
+		 * whitespace, case, blank lines, filtered lines or content.
+		 */
+		void WritePair(int index, String& left, String& right)
+		{
+			static const char *words[] = { "int", "value", "return", "Count", "for", "x", "=", "+", ";" };
+			std::vector<std::string> lines;
+			int nLines = 1 + Next(60);
+			for (int i = 0; i < nLines; ++i)
+			{
+				std::string line;
+				int nWords = Next(6);
+				for (int w = 0; w < nWords; ++w)
+					line += std::string(w ? " " : "") + words[Next(9)];
+				lines.push_back(line);
+			}
+			std::vector<std::string> changed = lines;
+			int nChanges = Next(3);
+			for (int c = 0; c < nChanges; ++c)
+			{
+				int i = Next(static_cast<int>(changed.size()));
+				switch (Next(6))
+				{
+				case 0: changed[i] = "  " + changed[i] + " "; break;
+				case 1: for (size_t j = 0; j < changed[i].size(); ++j) changed[i][j] = static_cast<char>(toupper(changed[i][j])); break;
+				case 2: changed.insert(changed.begin() + i, ""); break;
+				case 3: changed.insert(changed.begin() + i, "// TODO " + std::string(words[Next(9)])); break;
+				case 4: changed[i] += " changed"; break;
+				case 5: changed.erase(changed.begin() + i); if (changed.empty()) changed.push_back("x"); break;
+				}
+			}
+			left = WriteLines(std::to_string(index) + "_left", lines, "\n");
+			right = WriteLines(std::to_string(index) + "_right", changed, "\n");
+		}
+
+		CompareResult Compare(const String& left, const String& right, const DiffutilsOptions& options, FilterList *pFilterList, bool bStopAfterFirstDiff)
+		{
+			CompareEngines::DiffUtils engine;
+			DiffFileData data;
+			data.SetDisplayFilepaths(left, right);
+			EXPECT_TRUE(data.OpenFiles(left, right));
+			engine.SetCompareOptions(options);
+			engine.SetCodepage(CP_UTF8);
+			if (pFilterList)
+				engine.SetFilterList(pFilterList);
+			engine.SetAdditionalOptions(bStopAfterFirstDiff);
+			engine.SetFileData(2, data.m_inf);
+			CompareResult result;
+			result.code = engine.diffutils_compare_files();
+			engine.GetDiffCounts(result.ndiffs, result.ntrivialdiffs);
+			return result;
+		}
+
+		/**
+		 * @brief Check the status found when stopping after the first
+		 * difference is the status found by the full compare.
+		 */
+		void CheckStatus(const DiffutilsOptions& options, FilterList *pFilterList)
+		{
+			int nsame = 0;
+			for (int i = 0; i < 300; ++i)
+			{
+				String left, right;
+				WritePair(i, left, right);
+				CompareResult full = Compare(left, right, options, pFilterList, false);
+				CompareResult stop = Compare(left, right, options, pFilterList, true);
+				ASSERT_EQ(full.code, stop.code) << "pair " << i;
+				if ((full.code & DIFFCODE::COMPAREFLAGS) == DIFFCODE::SAME)
+				{
+					EXPECT_EQ(full.ndiffs, stop.ndiffs) << "pair " << i;
+					EXPECT_EQ(full.ntrivialdiffs, stop.ntrivialdiffs) << "pair " << i;
+					++nsame;
+				}
+				else
+				{
+					EXPECT_GT(full.ndiffs, 0) << "pair " << i;
+					EXPECT_EQ(CDiffContext::DIFFS_UNKNOWN_QUICKCOMPARE, stop.ndiffs) << "pair " << i;
+				}
+			}
+			// both statuses are covered
+			EXPECT_GT(nsame, 0);
+			EXPECT_LT(nsame, 300);
+		}
+
+	};
+
+	TEST_F(DiffUtilsTest, StopAfterFirstDiff)
+	{
+		DiffutilsOptions options;
+		CheckStatus(options, NULL);
+	}
+
+	TEST_F(DiffUtilsTest, StopAfterFirstDiffIgnoreWhitespaceAndCase)
+	{
+		DiffutilsOptions options;
+		options.m_ignoreWhitespace = WHITESPACE_IGNORE_ALL;
+		options.m_bIgnoreCase = true;
+		CheckStatus(options, NULL);
+		options.m_ignoreWhitespace = WHITESPACE_IGNORE_CHANGE;
+		CheckStatus(options, NULL);
+	}
+
+	TEST_F(DiffUtilsTest, StopAfterFirstDiffIgnoreBlankLines)
+	{
+		DiffutilsOptions options;
+		options.m_bIgnoreBlankLines = true;
+		CheckStatus(options, NULL);
+	}
+
+	TEST_F(DiffUtilsTest, StopAfterFirstDiffLineFilters)
+	{
+		DiffutilsOptions options;
+		options.m_bIgnoreBlankLines = true;
+		FilterList filterList;
+		filterList.AddRegExp("^// TODO");
+		CheckStatus(options, &filterList);
+	}
+
+	// One file ends where the other goes on
+	TEST_F(DiffUtilsTest, StopAfterFirstDiffLongerFile)
+	{
+		std::vector<std::string> lines(100, "line");
+		String left = WriteLines("short", lines, "\n");
+		lines.push_back("last line");
+		String right = WriteLines("long", lines, "\n");
+		DiffutilsOptions options;
+		CompareResult stop = Compare(left, right, options, NULL, true);
+		EXPECT_EQ(DIFFCODE::DIFF, stop.code & DIFFCODE::COMPAREFLAGS);
+		stop = Compare(right, left, options, NULL, true);
+		EXPECT_EQ(DIFFCODE::DIFF, stop.code & DIFFCODE::COMPAREFLAGS);
+		stop = Compare(left, left, options, NULL, true);
+		EXPECT_EQ(DIFFCODE::SAME, stop.code & DIFFCODE::COMPAREFLAGS);
+		EXPECT_EQ(0, stop.ndiffs);
+	}
+
+}  // namespace
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareEngines/TextPrecheck.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffItem.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// Compares mostly identical trees with and without the text precheck
+	class TextPrecheckBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Write the file pairs once for all benchmarks.
+		 * Every 10th pair differs in content, the other pairs differ only
+		 * in EOLs and trailing whitespace.
+		 */
+		static void SetUpTestCase()
+		{
+			bench::Random rnd;
+			for (int i = 0; i < 1000; ++i)
+			{
+				std::ostringstream left, right;
+				for (int line = 0; line < 300; ++line)
+				{
+					std::ostringstream ss;
+					ss << "\tint value" << rnd.Next(1000) << " = compute(" << rnd.Next(100) << ", x);";
+					left << ss.str() << "\r\n";
+					right << ss.str() << (line % 7 == 0 ? " \n" : "\n");
+				}
+				if (i % 10 == 0)
+					right << "\tint added = 0;\n";
+				s_left.push_back(WriteFile(i, _T("left"), left.str()));
+				s_right.push_back(WriteFile(i, _T("right"), right.str()));
+			}
+		}
+
+		static void TearDownTestCase()
+		{
+			for (size_t i = 0; i < s_left.size(); ++i)
+			{
+				remove(ucr::toUTF8(s_left[i]).c_str());
+				remove(ucr::toUTF8(s_right[i]).c_str());
+			}
+			s_left.clear();
+			s_right.clear();
+		}
+
+		static String WriteFile(int index, const TCHAR *side, const std::string& data)
+		{
+			String filename = _T("TextPrecheckBench_") + ucr::toTString(std::to_string(index)) + _T("_") + side + _T(".txt");
+			std::ofstream ostr(ucr::toUTF8(filename).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << data;
+			return filename;
+		}
+
+		/**
+		 * @brief Compare all file pairs like folder compare does.
+		 * @return Number of pairs found identical.
+		 */
+		static int CompareAll(bool bPrecheck)
+		{
+			DiffutilsOptions options;
+			options.m_ignoreWhitespace = WHITESPACE_IGNORE_CHANGE;
+			options.m_bIgnoreEOLDifference = true;
+			CompareEngines::DiffUtils engine;
+			CompareEngines::TextPrecheck precheck;
+			engine.SetCompareOptions(options);
+			int nsame = 0;
+			for (size_t i = 0; i < s_left.size(); ++i)
+			{
+				DiffFileData data;
+				data.SetDisplayFilepaths(s_left[i], s_right[i]);
+				if (!data.OpenFiles(s_left[i], s_right[i]))
+					continue;
+				int code;
+				if (bPrecheck && precheck.CompareFiles(data.m_inf))
+					code = DIFFCODE::FILE | DIFFCODE::TEXT | DIFFCODE::SAME;
+				else
+				{
+					engine.SetFileData(2, data.m_inf);
+					code = engine.diffutils_compare_files();
+				}
+				if ((code & DIFFCODE::COMPAREFLAGS) == DIFFCODE::SAME)
+					++nsame;
+			}
+			return nsame;
+		}
+
+		static std::vector<String> s_left;
+		static std::vector<String> s_right;
+	};
+
+	std::vector<String> TextPrecheckBench::s_left;
+	std::vector<String> TextPrecheckBench::s_right;
+
+	TEST_F(TextPrecheckBench, MostlySame1000)
+	{
+		int nsame = 0;
+		bench::Measure("MostlySame1000Diffutils", [&]() {
+			nsame = CompareAll(false);
+		});
+		EXPECT_EQ(900, nsame);
+		bench::Measure("MostlySame1000Precheck", [&]() {
+			nsame = CompareAll(true);
+		});
+		EXPECT_EQ(900, nsame);
+	}
+
+}  // namespace
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <string>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareEngines/TextPrecheck.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffItem.h"
+#include "unicoder.h"
+#include "../UnitTests/RandomFileTest.h"
+
+namespace
+{
+	// The fixture for testing the text precheck against full diffutils compare.
+	class TextPrecheckTest : public RandomFileTest
+	{
+	protected:
+		TextPrecheckTest() : RandomFileTest("TextPrecheckTest")
+		{
+		}
+
+		/**
+		 * @brief Make random text of lines with various EOLs.
+		 * Some texts have lines longer than the buffer of the check.
+		 */
+		std::string MakeText()
+		{
+			static const char *words[] = { "int", "Value", "return", "x", "=", ";", "\xc3\xa4" };
+			static const char *eols[] = { "\n", "\r\n", "\r" };
+			std::string text;
+			if (Next(10) == 0)
+				text += "\xEF\xBB\xBF";
+			int nLines = Next(40);
+			bool bLong = (Next(10) == 0);
+			for (int i = 0; i < nLines; ++i)
+			{
+				int nWords = bLong && i == 1 ? 30000 : Next(6);
+				for (int w = 0; w < nWords; ++w)
+				{
+					if (w > 0 || Next(4) == 0)
+						text += Next(3) ? " " : "\t ";
+					text += words[Next(7)];
+				}
+				if (Next(5) == 0)
+					text += " ";
+				text += eols[Next(10) == 0 ? Next(3) : 0];
+			}
+			// sometimes no EOL at end of file
+			if (!text.empty() && Next(5) == 0)
+				text.erase(text.size() - 1);
+			return text;
+		}
+
+		/**
+		 * @brief Change the text a little, so it is often the same with
+		 * some compare options.
+		 */
+		std::string ChangeText(const std::string& text)
+		{
+			std::string changed = text;
+			int nChanges = Next(3);
+			for (int c = 0; c < nChanges && !changed.empty(); ++c)
+			{
+				size_t pos = Next(static_cast<int>(changed.size()));
+				switch (Next(8))
+				{
+				case 0: changed.insert(pos, " "); break;
+				case 1: changed.insert(pos, "\t\t"); break;
+				case 2: if (changed[pos] == ' ') changed.erase(pos, 1); break;
+				case 3: changed[pos] = static_cast<char>(toupper(changed[pos])); break;
+				case 4: changed.insert(pos, "\n"); break;
+				case 5: if (changed[pos] == '\n') changed.replace(pos, 1, Next(2) ? "\r\n" : "\r"); break;
+				case 6: if (changed[pos] == '\r') changed.erase(pos, 1); break;
+				case 7: changed += Next(2) ? "\n" : "x"; break;
+				}
+			}
+			return changed;
+		}
+
+		/**
+		 * @brief Check the precheck finds the files the same exactly when
+		 * diffutils finds no changes at all.
+		 */
+		void CheckPair(const std::string& name, const std::string& text0, const std::string& text1, const DiffutilsOptions& options)
+		{
+			String left = WriteFile(name + "_left", text0);
+			String right = WriteFile(name + "_right", text1);
+			CompareEngines::DiffUtils engine;
+			engine.SetCompareOptions(options);
+			DiffFileData data;
+			data.SetDisplayFilepaths(left, right);
+			ASSERT_TRUE(data.OpenFiles(left, right));
+
+			CompareEngines::TextPrecheck precheck;
+			bool bSame = precheck.CompareFiles(data.m_inf);
+
+			// The files are read by diffutils from the begin again
+			engine.SetFileData(2, data.m_inf);
+			unsigned code = engine.diffutils_compare_files();
+			int ndiffs = 0, ntrivialdiffs = 0;
+			engine.GetDiffCounts(ndiffs, ntrivialdiffs);
+			bool bNoChanges = (code & DIFFCODE::COMPAREFLAGS) == DIFFCODE::SAME && ndiffs == 0 && ntrivialdiffs == 0;
+			ASSERT_EQ(bNoChanges, bSame) << name;
+			if (bSame)
+			{
+				EXPECT_EQ(DIFFCODE::TEXT, code & DIFFCODE::TEXTFLAGS) << name;
+				for (int i = 0; i < 2; ++i)
+				{
+					FileTextStats expected, stats;
+					engine.GetTextStats(i, &expected);
+					precheck.GetTextStats(i, &stats);
+					EXPECT_EQ(expected.ncrs, stats.ncrs) << name;
+					EXPECT_EQ(expected.nlfs, stats.nlfs) << name;
+					EXPECT_EQ(expected.ncrlfs, stats.ncrlfs) << name;
+					EXPECT_EQ(expected.nzeros, stats.nzeros) << name;
+				}
+			}
+		}
+
+	};
+
+	// Random pairs compared with all combinations of the ignore options
+	TEST_F(TextPrecheckTest, SameAsDiffutils)
+	{
+		static const WhitespaceIgnoreChoices whitespace[] = {
+			WHITESPACE_COMPARE_ALL, WHITESPACE_IGNORE_CHANGE, WHITESPACE_IGNORE_ALL };
+		for (int nWhitespace = 0; nWhitespace < 3; ++nWhitespace)
+		{
+			for (int nFlags = 0; nFlags < 8; ++nFlags)
+			{
+				DiffutilsOptions options;
+				options.m_ignoreWhitespace = whitespace[nWhitespace];
+				options.m_bIgnoreCase = (nFlags & 1) != 0;
+				options.m_bIgnoreEOLDifference = (nFlags & 2) != 0;
+				options.m_bIgnoreBlankLines = (nFlags & 4) != 0;
+				for (int i = 0; i < 100; ++i)
+				{
+					std::string text = MakeText();
+					std::string name = std::to_string(nWhitespace) + "_" + std::to_string(nFlags) + "_" + std::to_string(i);
+					CheckPair(name, text, ChangeText(text), options);
+					if (HasFatalFailure())
+						return;
+				}
+			}
+		}
+	}
+
+	// EOLs split between the buffers of the check
+	TEST_F(TextPrecheckTest, EolAtBufferEnd)
+	{
+		const size_t size = CompareEngines::TextPrecheck::BufferSize;
+		DiffutilsOptions options;
+		for (int nFlags = 0; nFlags < 2; ++nFlags)
+		{
+			options.m_bIgnoreEOLDifference = (nFlags != 0);
+			std::string text0 = std::string(size - 1, 'a') + "\r\nb\r\r\n";
+			std::string text1 = std::string(size - 1, 'a') + "\nb\r\r\n";
+			CheckPair("crlf" + std::to_string(nFlags), text0, text0, options);
+			CheckPair("crlf_lf" + std::to_string(nFlags), text0, text1, options);
+			std::string text2 = std::string(size - 1, 'a') + "\r\rb";
+			CheckPair("crcr" + std::to_string(nFlags), text2, text2, options);
+			CheckPair("crcr_crlf" + std::to_string(nFlags), text2, text0, options);
+		}
+	}
+
+	// Binary files are left to diffutils
+	TEST_F(TextPrecheckTest, BinaryFile)
+	{
+		std::string text("abc\n\0def\n", 9);
+		String left = WriteFile("bin_left", text);
+		String right = WriteFile("bin_right", text);
+		DiffutilsOptions options;
+		CompareEngines::DiffUtils engine;
+		engine.SetCompareOptions(options);
+		DiffFileData data;
+		data.SetDisplayFilepaths(left, right);
+		ASSERT_TRUE(data.OpenFiles(left, right));
+		CompareEngines::TextPrecheck precheck;
+		EXPECT_FALSE(precheck.CompareFiles(data.m_inf));
+	}
+
+}  // namespace
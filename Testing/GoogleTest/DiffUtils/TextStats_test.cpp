@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <vector>
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffTextLines.h"
+#include "FileTextStats.h"
+#include "UniFile.h"
+#include "unicoder.h"
+
+namespace
+{
+	/** @brief EOL sample and its expected text stats */
+	struct Sample
+	{
+		const TCHAR *name;
+		unsigned ncrlfs;
+		unsigned ncrs;
+		unsigned nlfs;
+		unsigned nzeros;
+	};
+
+	const Sample samples[] =
+	{
+		{ _T("Dos.txt"), 4, 0, 0, 0 },
+		{ _T("Unix.txt"), 0, 0, 4, 0 },
+		{ _T("Mac.txt"), 0, 4, 0, 0 },
+		{ _T("Mixed.txt"), 3, 1, 1, 0 },
+		{ _T("Zeros.txt"), 2, 0, 1, 3 },
+	};
+
+	String SamplePath(const TCHAR *name)
+	{
+		return String(_T("../../Data/EOL/")) + name;
+	}
+
+	// The fixture for testing that the text stats counted when loading
+	// a file and when comparing it agree, and that the compare gives the
+	// same results when it is given the stats instead of counting them.
+	class TextStatsTest : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Compare a sample to the DOS sample.
+		 * @param [in] bKnownStats Give the expected stats to the compare.
+		 * @param [out] stats Stats the compare reports for the sample.
+		 * @return Number of differences found.
+		 */
+		int Compare(const Sample& sample, const DiffutilsOptions& options, bool bKnownStats, FileTextStats& stats)
+		{
+			FileTextStats known = Expected(sample);
+			return Compare(SamplePath(sample.name), options, bKnownStats ? &known : NULL, stats);
+		}
+
+		/**
+		 * @brief Compare a file to the DOS sample.
+		 * @param [in] pKnownStats Stats given to the compare, NULL to count them.
+		 * @param [out] stats Stats the compare reports for the file.
+		 * @return Number of differences found.
+		 */
+		int Compare(const String& left, const DiffutilsOptions& options, const FileTextStats *pKnownStats, FileTextStats& stats)
+		{
+			String right = SamplePath(samples[0].name);
+			CompareEngines::DiffUtils engine;
+			engine.SetCompareOptions(options);
+			DiffFileData data;
+			data.SetDisplayFilepaths(left, right);
+			EXPECT_TRUE(data.OpenFiles(left, right));
+			if (pKnownStats)
+			{
+				data.SetTextStats(0, *pKnownStats);
+				data.SetTextStats(1, Expected(samples[0]));
+			}
+			engine.SetFileData(2, data.m_inf);
+			engine.diffutils_compare_files();
+			engine.GetTextStats(0, &stats);
+			int ndiffs, ntrivialdiffs;
+			engine.GetDiffCounts(ndiffs, ntrivialdiffs);
+			return ndiffs;
+		}
+
+		static FileTextStats Expected(const Sample& sample)
+		{
+			FileTextStats stats;
+			stats.ncrlfs = sample.ncrlfs;
+			stats.ncrs = sample.ncrs;
+			stats.nlfs = sample.nlfs;
+			stats.nzeros = sample.nzeros;
+			return stats;
+		}
+	};
+
+	TEST_F(TextStatsTest, Load)
+	{
+		for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+		{
+			UniMemFile file;
+			ASSERT_TRUE(file.OpenReadOnly(SamplePath(samples[i].name)));
+			file.SetCodepage(1252);
+			String line, eol;
+			bool lossy = false;
+			while (file.ReadString(line, eol, &lossy))
+				;
+			const UniFile::txtstats& stats = file.GetTxtStats();
+			EXPECT_EQ(static_cast<int>(samples[i].ncrlfs), stats.ncrlfs) << ucr::toUTF8(samples[i].name);
+			EXPECT_EQ(static_cast<int>(samples[i].ncrs), stats.ncrs) << ucr::toUTF8(samples[i].name);
+			EXPECT_EQ(static_cast<int>(samples[i].nlfs), stats.nlfs) << ucr::toUTF8(samples[i].name);
+			EXPECT_EQ(static_cast<int>(samples[i].nzeros), stats.nzeros) << ucr::toUTF8(samples[i].name);
+			EXPECT_EQ(0, stats.nlosses);
+			file.Close();
+		}
+	}
+
+	TEST_F(TextStatsTest, Compare)
+	{
+		for (int ignoreEol = 0; ignoreEol < 2; ++ignoreEol)
+		{
+			DiffutilsOptions options;
+			options.m_bIgnoreEOLDifference = !!ignoreEol;
+			for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+			{
+				FileTextStats counted, given;
+				int ndiffsCounted = Compare(samples[i], options, false, counted);
+				int ndiffsGiven = Compare(samples[i], options, true, given);
+				EXPECT_EQ(ndiffsCounted, ndiffsGiven) << ucr::toUTF8(samples[i].name);
+				// The first three samples differ only in EOLs
+				if (i < 3)
+					EXPECT_EQ(ignoreEol || i == 0, ndiffsGiven == 0) << ucr::toUTF8(samples[i].name);
+				EXPECT_EQ(samples[i].ncrlfs, counted.ncrlfs) << ucr::toUTF8(samples[i].name);
+				EXPECT_EQ(samples[i].ncrs, counted.ncrs) << ucr::toUTF8(samples[i].name);
+				EXPECT_EQ(samples[i].nlfs, counted.nlfs) << ucr::toUTF8(samples[i].name);
+				EXPECT_EQ(samples[i].nzeros, counted.nzeros) << ucr::toUTF8(samples[i].name);
+				EXPECT_EQ(counted.ncrlfs, given.ncrlfs);
+				EXPECT_EQ(counted.ncrs, given.ncrs);
+				EXPECT_EQ(counted.nlfs, given.nlfs);
+				EXPECT_EQ(counted.nzeros, given.nzeros);
+			}
+		}
+	}
+
+	// The stats counted while a buffer is saved to a temp file are the ones
+	// diffutils counts in that file
+	TEST_F(TextStatsTest, SaveTempFile)
+	{
+		std::vector<String> lines;
+		lines.push_back(_T("dos\r\n"));
+		lines.push_back(_T("unix\n"));
+		lines.push_back(_T("mac\r"));
+		// Control chars are escaped, so the temp file has no zeros
+		lines.push_back(String(_T("zero ")) + _T('\0') + _T(" and bell \a\n"));
+		lines.push_back(_T("\r\n"));
+		lines.push_back(_T("\n"));
+		lines.push_back(_T("last line"));
+		static const LPCTSTR eols[] = { NULL, _T("\r\n"), _T("\n"), _T("\r") };
+		const int nLines = static_cast<int>(lines.size());
+		std::vector<LineInfo> aLines(nLines);
+		for (int i = 0; i < nLines; ++i)
+			aLines[i].Create(lines[i].c_str(), static_cast<int>(lines[i].length()));
+		const String path = _T("TextStatsTest_temp.txt");
+		for (size_t i = 0; i < sizeof(eols) / sizeof(eols[0]); ++i)
+		{
+			// Write the lines as CDiffTextBuffer::SaveToFile() writes a temp file
+			UniStdioFile file;
+			file.SetUnicoding(ucr::UTF8);
+			file.SetCodepage(CP_UTF8);
+			file.SetBom(false);
+			ASSERT_TRUE(file.OpenCreate(path));
+			FileTextStats saved;
+			DiffTextLines::WriteRealLines(aLines, 0, nLines, nLines - 1, 0, eols[i], &saved,
+				[&file](const String& sLine) { file.WriteString(sLine); });
+			file.Close();
+			EXPECT_EQ(0u, saved.nzeros);
+
+			DiffutilsOptions options;
+			FileTextStats counted, given;
+			int ndiffsCounted = Compare(path, options, NULL, counted);
+			int ndiffsGiven = Compare(path, options, &saved, given);
+			EXPECT_EQ(ndiffsCounted, ndiffsGiven) << i;
+			EXPECT_EQ(counted.ncrlfs, saved.ncrlfs) << i;
+			EXPECT_EQ(counted.ncrs, saved.ncrs) << i;
+			EXPECT_EQ(counted.nlfs, saved.nlfs) << i;
+			EXPECT_EQ(counted.nzeros, saved.nzeros) << i;
+		}
+		for (int i = 0; i < nLines; ++i)
+			aLines[i].FreeBuffer();
+		remove(ucr::toUTF8(path).c_str());
+	}
+
+}  // namespace
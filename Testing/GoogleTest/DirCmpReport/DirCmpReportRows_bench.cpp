@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "DirCmpReportRows.h"
+#include "DirViewColItems.h"
+#include "DiffContext.h"
+#include "DiffItem.h"
+#include "PathContext.h"
+#include "DiffWrapper.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking folder compare reports.
+	class DirCmpReportRowsBench : public testing::Test
+	{
+	protected:
+		DirCmpReportRowsBench()
+			: m_ctxt(PathContext(_T("c:\\left"), _T("c:\\right")), CMP_CONTENT)
+			, m_colItems(2)
+		{
+			m_colItems.LoadColumnOrders(_T(""));
+			for (int i = 0; i < m_colItems.GetDispColCount(); ++i)
+				m_colKeys.push_back(m_colItems.GetColRegValueNameBase(m_colItems.ColPhysToLog(i)));
+		}
+
+		/**
+		 * @brief Add rows looking like results of a folder compare
+		 */
+		void AddRows(DirCmpReportRows& rows, int count)
+		{
+			static const TCHAR *exts[] = { _T(".cpp"), _T(".h"), _T(".txt"), _T(".xml"), _T(".bin") };
+			static const unsigned codes[] = {
+				DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::SAME,
+				DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::DIFF,
+				DIFFCODE::FILE | DIFFCODE::FIRST | DIFFCODE::TEXT,
+				DIFFCODE::FILE | DIFFCODE::SECOND | DIFFCODE::BIN };
+			bench::Random rnd;
+			for (int i = 0; i < count; ++i)
+			{
+				DIFFITEM *di = m_ctxt.AddDiff(NULL);
+				di->diffcode.diffcode = codes[rnd.Next(4)];
+				String path = _T("src\\module") + string_to_str(rnd.Next(20));
+				String name = _T("file") + string_to_str(i) + exts[rnd.Next(5)];
+				for (int j = 0; j < 2; ++j)
+				{
+					if (!di->diffcode.exists(j))
+						continue;
+					di->diffFileInfo[j].path = path;
+					di->diffFileInfo[j].filename = name;
+					di->diffFileInfo[j].size = rnd.Next(10000000);
+					di->diffFileInfo[j].mtime = Poco::Timestamp::fromEpochTime(1400000000 + rnd.Next(100000000));
+				}
+				di->nsdiffs = di->diffcode.isResultDiff() ? rnd.Next(50) : 0;
+				rows.AddRow(di, 0, rnd.Next(10), RGB(255, 255, 255));
+			}
+		}
+
+		CDiffContext m_ctxt;
+		DirViewColItems m_colItems;
+		std::vector<String> m_colKeys;
+	};
+
+	// Format the rows of a big compare as HTML with one and all processors
+	TEST_F(DirCmpReportRowsBench, Html200k)
+	{
+		DirCmpReportRows rows(&m_ctxt, &m_colItems, m_colKeys);
+		AddRows(rows, 200000);
+		rows.SetReportType(REPORT_TYPE_SIMPLEHTML);
+		size_t length1 = 0, length = 0;
+		bench::Measure("Html200kOneThread", [&]() {
+			length1 = 0;
+			rows.WriteRows([&](const String& text) { length1 += text.length(); }, 1);
+		}, 1);
+		bench::Measure("Html200k", [&]() {
+			length = 0;
+			rows.WriteRows([&](const String& text) { length += text.length(); });
+		}, 1);
+		EXPECT_EQ(length1, length);
+		EXPECT_GT(length, 0u);
+	}
+
+}  // namespace
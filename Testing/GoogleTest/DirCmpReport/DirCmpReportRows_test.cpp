@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "DirCmpReportRows.h"
+#include "DirViewColItems.h"
+#include "DiffContext.h"
+#include "DiffItem.h"
+#include "PathContext.h"
+#include "IListCtrl.h"
+#include "DiffWrapper.h"
+
+namespace
+{
+	/**
+	 * @brief List control showing the items like the folder compare view.
+	 * The first row is the parent folder item.
+	 */
+	class FakeListCtrl : public IListCtrl
+	{
+	public:
+		FakeListCtrl(const CDiffContext& ctxt, const DirViewColItems& colItems, const std::vector<const DIFFITEM *>& items)
+			: m_ctxt(ctxt), m_colItems(colItems), m_items(items) {}
+
+		virtual int GetColumnCount() const { return m_colItems.GetDispColCount(); }
+		virtual int GetRowCount() const { return static_cast<int>(m_items.size()); }
+		virtual String GetColumnName(int col) const { return m_colItems.GetColDisplayName(m_colItems.ColPhysToLog(col)); }
+		virtual String GetItemText(int row, int col) const
+		{
+			int logcol = m_colItems.ColPhysToLog(col);
+			if (m_items[row] == NULL)
+				return m_colItems.IsColName(logcol) ? _T("..") : _T("");
+			return m_colItems.ColGetTextToDisplay(&m_ctxt, logcol, *m_items[row]);
+		}
+		virtual void *GetItemData(int row) const { return const_cast<DIFFITEM *>(m_items[row]); }
+		virtual int GetBackColor(int row) const { return RGB(row % 256, 255, 0); }
+		virtual bool IsSelectedItem(int sel) const { return false; }
+		virtual int GetNextItem(int sel, bool selected = false, bool reverse = false) const { return -1; }
+		virtual int GetNextSelectedItem(int sel, bool reverse = false) const { return -1; }
+		virtual unsigned GetSelectedCount() const { return 0; }
+		virtual int GetIndent(int row) const { return row % 3; }
+		virtual int GetIconIndex(int row) const { return row % 5; }
+		virtual int GetIconCount() const { return 5; }
+		virtual std::string GetIconPNGData(int iconIndex) const { return ""; }
+
+	private:
+		const CDiffContext& m_ctxt;
+		const DirViewColItems& m_colItems;
+		const std::vector<const DIFFITEM *>& m_items;
+	};
+
+	// The fixture for testing report rows formatted from the compare results.
+	class DirCmpReportRowsTest : public testing::Test
+	{
+	protected:
+		DirCmpReportRowsTest()
+			: m_ctxt(PathContext(_T("c:\\left"), _T("c:\\right")), CMP_CONTENT)
+			, m_colItems(2)
+		{
+			// Show all columns
+			m_colItems.LoadColumnOrders(_T(""));
+			std::vector<int> colorder(m_colItems.GetColCount());
+			for (int i = 0; i < m_colItems.GetColCount(); ++i)
+				colorder[i] = i;
+			m_colItems.SetColumnOrdering(&colorder[0]);
+			for (int i = 0; i < m_colItems.GetDispColCount(); ++i)
+				m_colKeys.push_back(m_colItems.GetColRegValueNameBase(m_colItems.ColPhysToLog(i)));
+			m_items.push_back(NULL);
+		}
+
+		/**
+		 * @brief Add items looking like results of a folder compare
+		 */
+		void AddItems(int count)
+		{
+			static const unsigned codes[] = {
+				DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::SAME,
+				DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::DIFF,
+				DIFFCODE::FILE | DIFFCODE::FIRST | DIFFCODE::BIN,
+				DIFFCODE::DIR | DIFFCODE::SECOND };
+			for (int i = 0; i < count; ++i)
+			{
+				DIFFITEM *di = m_ctxt.AddDiff(NULL);
+				di->diffcode.diffcode = codes[i % 4];
+				for (int j = 0; j < 2; ++j)
+				{
+					if (!di->diffcode.exists(j))
+						continue;
+					di->diffFileInfo[j].path = _T("src\\module") + string_to_str(i % 7);
+					// some names contain the separators of list reports
+					di->diffFileInfo[j].filename = _T("file") + string_to_str(i) + (i % 11 == 0 ? _T(", copy.txt") : _T(".txt"));
+					di->diffFileInfo[j].size = i * 1000 + j;
+					di->diffFileInfo[j].mtime = Poco::Timestamp::fromEpochTime(1400000000 + i * 60 + j);
+					di->diffFileInfo[j].m_textStats.ncrlfs = i % 13;
+				}
+				di->nsdiffs = di->diffcode.isResultDiff() ? i % 50 : 0;
+				m_items.push_back(di);
+			}
+		}
+
+		/**
+		 * @brief Fill rows from the compare results the way the view shows them
+		 */
+		void AddRows(DirCmpReportRows& rows, const IListCtrl& list)
+		{
+			for (size_t i = 0; i < m_items.size(); ++i)
+			{
+				int row = static_cast<int>(i);
+				rows.AddRow(m_items[i], list.GetIndent(row), list.GetIconIndex(row), list.GetBackColor(row));
+			}
+		}
+
+		static String Format(const DirCmpReportRows& rows, unsigned nThreads)
+		{
+			String text;
+			rows.WriteRows([&text](const String& chunk) { text += chunk; }, nThreads);
+			return text;
+		}
+
+		CDiffContext m_ctxt;
+		DirViewColItems m_colItems;
+		std::vector<String> m_colKeys;
+		std::vector<const DIFFITEM *> m_items;
+	};
+
+	// Reports formatted from the compare results in worker threads are the
+	// same as reports read from the list control
+	TEST_F(DirCmpReportRowsTest, SameAsListControl)
+	{
+		AddItems(3 * static_cast<int>(DirCmpReportRows::RowsPerChunk) + 100);
+		FakeListCtrl list(m_ctxt, m_colItems, m_items);
+		DirCmpReportRows listRows(&list, m_colItems.GetDispColCount(), m_colKeys);
+		DirCmpReportRows rows(&m_ctxt, &m_colItems, m_colKeys);
+		AddRows(rows, list);
+
+		ASSERT_EQ(listRows.GetRowCount(), rows.GetRowCount());
+		ASSERT_EQ(listRows.GetColumnCount(), rows.GetColumnCount());
+		for (int col = 0; col < rows.GetColumnCount(); ++col)
+			EXPECT_EQ(listRows.GetColumnName(col), rows.GetColumnName(col));
+
+		static const REPORT_TYPE types[] = {
+			REPORT_TYPE_COMMALIST, REPORT_TYPE_TABLIST, REPORT_TYPE_SIMPLEHTML, REPORT_TYPE_SIMPLEXML };
+		for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i)
+		{
+			listRows.SetReportType(types[i]);
+			rows.SetReportType(types[i]);
+			String expected = Format(listRows, 1);
+			EXPECT_EQ(expected, Format(rows, 1)) << "report type " << types[i];
+			EXPECT_EQ(expected, Format(rows, 4)) << "report type " << types[i];
+		}
+	}
+
+	TEST_F(DirCmpReportRowsTest, CommaList)
+	{
+		AddItems(12);
+		DirCmpReportRows rows(&m_ctxt, &m_colItems, m_colKeys);
+		for (size_t i = 0; i < m_items.size(); ++i)
+			rows.AddRow(m_items[i], 0, 0, RGB(255, 255, 255));
+		rows.SetReportType(REPORT_TYPE_COMMALIST);
+
+		String text;
+		rows.FormatRows(0, 2, text);
+		// the parent folder item has only a name
+		String parent = _T("\n..") + String(m_colItems.GetDispColCount() - 1, ',');
+		EXPECT_EQ(0u, text.find(parent));
+		EXPECT_EQ(_T('\n'), text[parent.size()]);
+		EXPECT_NE(String::npos, text.find(_T("\"file0, copy.txt\"")));
+		text.clear();
+		rows.FormatRows(12, 13, text);
+		EXPECT_NE(String::npos, text.find(_T("\"file11, copy.txt\"")));
+
+		// names are not quoted in tab separated lists
+		rows.SetReportType(REPORT_TYPE_TABLIST);
+		text.clear();
+		rows.FormatRows(1, 2, text);
+		EXPECT_EQ(String::npos, text.find(_T("\"")));
+		EXPECT_NE(String::npos, text.find(_T("\nfile0, copy.txt\t")));
+	}
+
+	TEST_F(DirCmpReportRowsTest, HtmlRow)
+	{
+		AddItems(1);
+		DirCmpReportRows rows(&m_ctxt, &m_colItems, m_colKeys);
+		rows.AddRow(m_items[1], 2, 3, RGB(0x12, 0x34, 0x56));
+		rows.GetRow(0).sLinkPath = _T("src_module0_file0.txt.html");
+		rows.SetLinkDir(_T("report.files"));
+		rows.SetReportType(REPORT_TYPE_SIMPLEHTML);
+
+		String text;
+		rows.FormatRows(0, 1, text);
+		String first = _T("<tr style='background-color: #123456'><td class=\"icon3 indent2\">")
+			_T("<a href=\"report.files/src_module0_file0.txt.html\">") + rows.GetCellText(0, 0) + _T("</a></td>");
+		EXPECT_EQ(0u, text.find(first));
+		EXPECT_EQ(_T("</tr>\n"), text.substr(text.size() - 6));
+
+		// XML rows have no links
+		rows.SetReportType(REPORT_TYPE_SIMPLEXML);
+		text.clear();
+		rows.FormatRows(0, 1, text);
+		String xmlFirst = _T("<filediff><") + m_colKeys[0] + _T(">") + rows.GetCellText(0, 0) + _T("</") + m_colKeys[0] + _T(">");
+		EXPECT_EQ(0u, text.find(xmlFirst));
+		EXPECT_EQ(String::npos, text.find(_T("<a href")));
+		EXPECT_EQ(_T("</filediff>\n"), text.substr(text.size() - 12));
+	}
+
+}  // namespace
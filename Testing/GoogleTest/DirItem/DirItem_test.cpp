@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include <windows.h>
 #include <tchar.h>
+#include <cstdio>
+#include <fstream>
 #include "UnicodeString.h"
 #include "DirItem.h"
+#include "unicoder.h"
 
 namespace
 {
@@ -47,5 +50,43 @@ namespace
 		EXPECT_TRUE(item.ctime == 0);
 	}
 
+	TEST_F(DirItemTest, Update)
+	{
+		const char *filename = "DirItemTest_Update.txt";
+		{
+			std::ofstream ostr(filename, std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << "0123456789";
+		}
+		DirItem item;
+		EXPECT_TRUE(item.Update(ucr::toTString(filename)));
+		EXPECT_EQ(10, item.size);
+		EXPECT_TRUE(item.mtime != 0);
+		remove(filename);
+
+		EXPECT_FALSE(item.Update(ucr::toTString(filename)));
+		EXPECT_EQ(-1, item.size);
+		EXPECT_TRUE(item.mtime == 0);
+	}
+
+	TEST_F(DirItemTest, UpdateFromListing)
+	{
+		DirItem found;
+		found.ctime = 1000;
+		found.mtime = 2000;
+		found.size = 10;
+		found.flags.attributes = 0x20;
+
+		DirItem item;
+		item.UpdateFromListing(found);
+		EXPECT_TRUE(item.mtime == 2000);
+		EXPECT_EQ(10, item.size);
+		EXPECT_EQ(0x20u, item.flags.attributes);
+
+		// Creation time is used for files without modification time
+		found.mtime = 0;
+		item.UpdateFromListing(found);
+		EXPECT_TRUE(item.mtime == 1000);
+	}
+
 
 }  // namespace
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "DirTravel.h"
+#include "DirItem.h"
+#include "paths.h"
+#include "TFile.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking sorting and merging of huge folders.
+	class DirTravelBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Make items of two sides of a folder, in file system order
+		 * Every 50th name exists only on one side, the other side
+		 * may differ in case.
+		 */
+		static void MakeItems(size_t count, DirItemArray& left, DirItemArray& right)
+		{
+			static const TCHAR *exts[] = { _T(".cpp"), _T(".H"), _T(".txt"), _T(".Xml"), _T("") };
+			bench::Random rnd;
+			left.reserve(count);
+			right.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				String name = (rnd.Next(2) ? _T("File_") : _T("file-")) + string_to_str(static_cast<int>(rnd.Next(1000000)))
+					+ _T("_") + string_to_str(static_cast<int>(i)) + exts[rnd.Next(5)];
+				DirItem item;
+				item.filename = name;
+				if (i % 50 != 1)
+					left.push_back(item);
+				if (i % 50 != 2)
+				{
+					if (rnd.Next(10) == 0)
+						std::transform(name.begin(), name.end(), name.begin(), _totupper);
+					item.filename = name;
+					right.push_back(item);
+				}
+			}
+		}
+
+		/**
+		 * @brief Count names found on both sides like DirScan does
+		 */
+		template<class Compare>
+		static size_t CountPairs(const DirItemArray& left, const DirItemArray& right, Compare compare)
+		{
+			size_t i = 0, j = 0, count = 0;
+			while (i < left.size() && j < right.size())
+			{
+				int result = compare(left[i].filename, right[j].filename);
+				if (result < 0)
+					++i;
+				else if (result > 0)
+					++j;
+				else
+				{
+					++count;
+					++i;
+					++j;
+				}
+			}
+			return count;
+		}
+
+		static bool CollateLess(const DirItem& item1, const DirItem& item2)
+		{
+			return _tcsicoll(item1.filename.get().c_str(), item2.filename.get().c_str()) < 0;
+		}
+
+		static int Collate(const String& s1, const String& s2)
+		{
+			return _tcsicoll(s1.c_str(), s2.c_str());
+		}
+
+		static int CollStr(const String& s1, const String& s2)
+		{
+			return collstr(s1, s2, false);
+		}
+
+		void SortAndMerge(size_t count)
+		{
+			DirItemArray files[2];
+			MakeItems(count, files[0], files[1]);
+			const size_t expectedPairs = count - 2 * ((count + 48) / 50);
+
+			DirItemArray sorted[2];
+			size_t pairs = 0;
+			bench::Measure("Collate" + std::to_string(count), [&]() {
+				for (int i = 0; i < 2; ++i)
+				{
+					sorted[i] = files[i];
+					std::sort(sorted[i].begin(), sorted[i].end(), CollateLess);
+				}
+				pairs = CountPairs(sorted[0], sorted[1], Collate);
+			}, 1);
+			EXPECT_EQ(expectedPairs, pairs);
+			std::vector<String> expectedOrder;
+			for (size_t i = 0; i < sorted[0].size(); ++i)
+				expectedOrder.push_back(sorted[0][i].filename);
+
+			DirItemArray dirs[2];
+			bench::Measure("SortFiles" + std::to_string(count), [&]() {
+				for (int i = 0; i < 2; ++i)
+					sorted[i] = files[i];
+				SortFiles(2, dirs, sorted, false);
+				pairs = CountPairs(sorted[0], sorted[1], CollStr);
+			}, 1);
+			EXPECT_EQ(expectedPairs, pairs);
+			ASSERT_EQ(expectedOrder.size(), sorted[0].size());
+			for (size_t i = 0; i < sorted[0].size(); ++i)
+				ASSERT_EQ(expectedOrder[i], sorted[0][i].filename.get());
+		}
+	};
+
+	TEST_F(DirTravelBench, SortAndMerge100k)
+	{
+		SortAndMerge(100000);
+	}
+
+	TEST_F(DirTravelBench, SortAndMerge1M)
+	{
+		SortAndMerge(1000000);
+	}
+
+	// The fixture for benchmarking getting information of the items of
+	// a deep folder tree, like comparing and refreshing folders does.
+	class DirTravelDeepTreeBench : public testing::Test
+	{
+	protected:
+		static const int nDepth = 6; /**< Levels of subfolders */
+		static const int nSubfolders = 3; /**< Subfolders in each folder */
+		static const int nFiles = 20; /**< Files in each folder */
+
+		/**
+		 * @brief Write the tree once for all benchmarks.
+		 */
+		static void SetUpTestCase()
+		{
+			MakeTree(s_root, nDepth);
+		}
+
+		static void TearDownTestCase()
+		{
+			try { TFile(s_root).remove(true); } catch (...) {}
+		}
+
+		static void MakeTree(const String& sDir, int depth)
+		{
+			paths::CreateIfNeeded(sDir);
+			for (int i = 0; i < nFiles; ++i)
+			{
+				std::ofstream ostr(ucr::toUTF8(paths::ConcatPath(sDir, _T("file") + string_to_str(i) + _T(".txt"))).c_str());
+				ostr << "line " << i << "\n";
+			}
+			if (depth > 0)
+				for (int i = 0; i < nSubfolders; ++i)
+					MakeTree(paths::ConcatPath(sDir, _T("folder") + string_to_str(i)), depth - 1);
+		}
+
+		/**
+		 * @brief Walk the tree like folder compare collecting the items does.
+		 * @param [in] sDir Folder to walk.
+		 * @param [out] folders Walked folders with their files.
+		 * @return Number of files found.
+		 */
+		static int Walk(const String& sDir, std::vector<std::pair<String, DirItemArray> > *folders)
+		{
+			DirItemArray dirs, files;
+			LoadAndSortFiles(1, &sDir, &dirs, &files, false);
+			int count = static_cast<int>(files.size());
+			if (folders)
+				folders->push_back(std::make_pair(sDir, files));
+			for (size_t i = 0; i < dirs.size(); ++i)
+				count += Walk(paths::ConcatPath(sDir, dirs[i].filename), folders);
+			return count;
+		}
+
+		static const String s_root;
+	};
+
+	const String DirTravelDeepTreeBench::s_root = _T("DirTravelBench_tree");
+
+	// Refresh all files one by one by their paths, and by listing each
+	// folder once
+	TEST_F(DirTravelDeepTreeBench, WalkAndRefresh)
+	{
+		int nExpected = 0;
+		for (int level = 0, nFolders = 1; level <= nDepth; ++level, nFolders *= nSubfolders)
+			nExpected += nFolders * nFiles;
+
+		int count = 0;
+		bench::Measure("WalkDeepTree", [&]() {
+			count = Walk(s_root, NULL);
+		});
+		EXPECT_EQ(nExpected, count);
+
+		std::vector<std::pair<String, DirItemArray> > folders;
+		Walk(s_root, &folders);
+
+		bench::Measure("RefreshDeepTreeByPath", [&]() {
+			count = 0;
+			for (size_t i = 0; i < folders.size(); ++i)
+			{
+				const DirItemArray& files = folders[i].second;
+				for (size_t j = 0; j < files.size(); ++j)
+				{
+					DirItem item;
+					if (item.Update(paths::ConcatPath(folders[i].first, files[j].filename)) && item.size > 0)
+						++count;
+				}
+			}
+		});
+		EXPECT_EQ(nExpected, count);
+
+		bench::Measure("RefreshDeepTreeByListing", [&]() {
+			count = 0;
+			for (size_t i = 0; i < folders.size(); ++i)
+			{
+				DirItemArray dirs, listed;
+				LoadFiles(folders[i].first, &dirs, &listed);
+				std::unordered_map<String, const DirItem *> listing;
+				for (size_t j = 0; j < listed.size(); ++j)
+					listing[listed[j].filename] = &listed[j];
+				const DirItemArray& files = folders[i].second;
+				for (size_t j = 0; j < files.size(); ++j)
+				{
+					std::unordered_map<String, const DirItem *>::const_iterator found = listing.find(files[j].filename);
+					DirItem item;
+					if (found != listing.end())
+					{
+						item.UpdateFromListing(*found->second);
+						if (item.size > 0)
+							++count;
+					}
+				}
+			}
+		});
+		EXPECT_EQ(nExpected, count);
+	}
+
+}  // namespace
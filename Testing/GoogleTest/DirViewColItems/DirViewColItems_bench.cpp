@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "DirViewColItems.h"
+#include "DiffContext.h"
+#include "DiffItem.h"
+#include "PathContext.h"
+#include "DiffWrapper.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking rendering of folder compare rows.
+	class DirViewColItemsBench : public testing::Test
+	{
+	protected:
+		DirViewColItemsBench()
+			: m_ctxt(PathContext(_T("c:\\left"), _T("c:\\right")), CMP_CONTENT)
+			, m_colItems(2)
+		{
+			// Show all columns
+			m_colItems.LoadColumnOrders(_T(""));
+			std::vector<int> colorder(m_colItems.GetColCount());
+			for (int i = 0; i < m_colItems.GetColCount(); ++i)
+				colorder[i] = i;
+			m_colItems.SetColumnOrdering(&colorder[0]);
+		}
+
+		/**
+		 * @brief Add items looking like results of a folder compare
+		 */
+		void AddItems(int count)
+		{
+			static const TCHAR *exts[] = { _T(".cpp"), _T(".h"), _T(".txt"), _T(".xml"), _T(".bin") };
+			static const unsigned codes[] = {
+				DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::SAME,
+				DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::DIFF,
+				DIFFCODE::FILE | DIFFCODE::FIRST | DIFFCODE::TEXT,
+				DIFFCODE::FILE | DIFFCODE::SECOND | DIFFCODE::BIN };
+			bench::Random rnd;
+			for (int i = 0; i < count; ++i)
+			{
+				DIFFITEM *di = m_ctxt.AddDiff(NULL);
+				di->diffcode.diffcode = codes[rnd.Next(4)];
+				String path = _T("src\\module") + string_to_str(rnd.Next(20));
+				String name = _T("file") + string_to_str(i) + exts[rnd.Next(5)];
+				for (int j = 0; j < 2; ++j)
+				{
+					if (!di->diffcode.exists(j))
+						continue;
+					di->diffFileInfo[j].path = path;
+					di->diffFileInfo[j].filename = name;
+					di->diffFileInfo[j].size = rnd.Next(10000000);
+					di->diffFileInfo[j].mtime = Poco::Timestamp::fromEpochTime(1400000000 + rnd.Next(100000000));
+					di->diffFileInfo[j].ctime = di->diffFileInfo[j].mtime;
+					di->diffFileInfo[j].m_textStats.ncrlfs = rnd.Next(1000);
+				}
+				di->nsdiffs = di->diffcode.isResultDiff() ? rnd.Next(50) : 0;
+				m_items.push_back(di);
+			}
+		}
+
+		CDiffContext m_ctxt;
+		DirViewColItems m_colItems;
+		std::vector<const DIFFITEM *> m_items;
+	};
+
+	// Scroll through the list, repainting a page of rows at each step
+	// like the list control does
+	TEST_F(DirViewColItemsBench, ScrollRows)
+	{
+		const int nPageRows = 40;
+		AddItems(2000);
+		const int ncols = m_colItems.GetDispColCount();
+		size_t totalLength = 0;
+
+		bench::Measure("Uncached", [&]() {
+			for (size_t top = 0; top + nPageRows <= m_items.size(); top += 4)
+				for (size_t row = top; row < top + nPageRows; ++row)
+					for (int col = 0; col < ncols; ++col)
+						totalLength += m_colItems.ColGetTextToDisplay(&m_ctxt, m_colItems.ColPhysToLog(col), *m_items[row]).length();
+		});
+
+		DirViewColTextCache cache;
+		bench::Measure("Cached", [&]() {
+			for (size_t top = 0; top + nPageRows <= m_items.size(); top += 4)
+				for (size_t row = top; row < top + nPageRows; ++row)
+					for (int col = 0; col < ncols; ++col)
+						totalLength += cache.GetText(m_colItems, &m_ctxt, m_colItems.ColPhysToLog(col), *m_items[row]).length();
+		});
+		EXPECT_EQ(m_items.size(), cache.GetRowCount());
+		EXPECT_LT(cache.GetTextCount(), m_items.size() * ncols);
+
+		// Cached texts are the same as formatted ones, also after an item changes
+		DIFFITEM &di = const_cast<DIFFITEM &>(*m_items[1]);
+		di.diffFileInfo[0].size += 1;
+		di.nsdiffs += 1;
+		for (int col = 0; col < ncols; ++col)
+		{
+			int logcol = m_colItems.ColPhysToLog(col);
+			for (size_t row = 0; row < 10; ++row)
+				EXPECT_EQ(m_colItems.ColGetTextToDisplay(&m_ctxt, logcol, *m_items[row]),
+					cache.GetText(m_colItems, &m_ctxt, logcol, *m_items[row]));
+		}
+		EXPECT_GT(totalLength, 0u);
+	}
+
+}  // namespace
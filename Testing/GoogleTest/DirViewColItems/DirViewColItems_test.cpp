@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "DirViewColItems.h"
+#include "DiffContext.h"
+#include "DiffItem.h"
+#include "PathContext.h"
+#include "DiffWrapper.h"
+
+namespace
+{
+	// The fixture for testing that the cached column texts are the same as
+	// freshly formatted texts, also after the items change.
+	class DirViewColTextCacheTest : public testing::Test
+	{
+	protected:
+		DirViewColTextCacheTest()
+			: m_ctxt(PathContext(_T("c:\\left"), _T("c:\\right")), CMP_CONTENT)
+			, m_colItems(2)
+		{
+			m_colItems.LoadColumnOrders(_T(""));
+		}
+
+		DIFFITEM *AddItem(const String& name, int64_t size)
+		{
+			DIFFITEM *di = m_ctxt.AddDiff(NULL);
+			di->diffcode.diffcode = DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::DIFF;
+			for (int j = 0; j < 2; ++j)
+			{
+				di->diffFileInfo[j].path = _T("src");
+				di->diffFileInfo[j].filename = name;
+				di->diffFileInfo[j].size = size;
+				di->diffFileInfo[j].mtime = Poco::Timestamp::fromEpochTime(1400000000);
+			}
+			return di;
+		}
+
+		/** @brief Get all column texts of an item from the cache and check them. */
+		void ExpectTexts(const DIFFITEM& di)
+		{
+			for (int col = 0; col < m_colItems.GetColCount(); ++col)
+				EXPECT_EQ(m_colItems.ColGetTextToDisplay(&m_ctxt, col, di),
+					m_cache.GetText(m_colItems, &m_ctxt, col, di)) << "column " << col;
+		}
+
+		CDiffContext m_ctxt;
+		DirViewColItems m_colItems;
+		DirViewColTextCache m_cache;
+	};
+
+	TEST_F(DirViewColTextCacheTest, Cached)
+	{
+		DIFFITEM *di = AddItem(_T("file.txt"), 1000);
+		ExpectTexts(*di);
+		const String& text = m_cache.GetText(m_colItems, &m_ctxt, 0, *di);
+		EXPECT_EQ(&text, &m_cache.GetText(m_colItems, &m_ctxt, 0, *di));
+		EXPECT_EQ(1u, m_cache.GetRowCount());
+	}
+
+	// A change of a shown property changes the stamp and the row is
+	// formatted again, without growing the interned texts.
+	TEST_F(DirViewColTextCacheTest, StaleRow)
+	{
+		DIFFITEM *di = AddItem(_T("file.txt"), 1000);
+		ExpectTexts(*di);
+		for (int i = 1; i <= 100; ++i)
+		{
+			di->diffFileInfo[0].size = 1000 + i * 4096;
+			di->diffFileInfo[1].mtime = Poco::Timestamp::fromEpochTime(1400000000 + i * 86400);
+			di->nsdiffs = i;
+			ExpectTexts(*di);
+		}
+		di->diffcode.diffcode = DIFFCODE::FILE | DIFFCODE::BOTH | DIFFCODE::TEXT | DIFFCODE::SAME;
+		ExpectTexts(*di);
+		EXPECT_EQ(1u, m_cache.GetRowCount());
+		EXPECT_GE(static_cast<size_t>(m_colItems.GetColCount()), m_cache.GetTextCount());
+	}
+
+	// Texts shown by several items are stored once and freed with the last
+	TEST_F(DirViewColTextCacheTest, Invalidate)
+	{
+		std::vector<DIFFITEM *> items;
+		for (int i = 0; i < 10; ++i)
+		{
+			items.push_back(AddItem(_T("file") + string_to_str(i) + _T(".txt"), 1000));
+			ExpectTexts(*items[i]);
+		}
+		EXPECT_EQ(10u, m_cache.GetRowCount());
+		size_t nTexts = m_cache.GetTextCount();
+		EXPECT_LT(nTexts, 10u * m_colItems.GetColCount());
+
+		m_cache.Invalidate(*items[0]);
+		EXPECT_EQ(9u, m_cache.GetRowCount());
+		EXPECT_GT(nTexts, m_cache.GetTextCount());
+		// Texts shared with other items are still cached
+		ExpectTexts(*items[1]);
+		ExpectTexts(*items[0]);
+		EXPECT_EQ(nTexts, m_cache.GetTextCount());
+
+		for (size_t i = 0; i < items.size(); ++i)
+			m_cache.Invalidate(*items[i]);
+		EXPECT_EQ(0u, m_cache.GetRowCount());
+		EXPECT_EQ(0u, m_cache.GetTextCount());
+		// Invalidating an item not cached does nothing
+		m_cache.Invalidate(*items[0]);
+		ExpectTexts(*items[0]);
+	}
+
+	TEST_F(DirViewColTextCacheTest, Clear)
+	{
+		DIFFITEM *di = AddItem(_T("file.txt"), 1000);
+		ExpectTexts(*di);
+		m_cache.Clear();
+		EXPECT_EQ(0u, m_cache.GetRowCount());
+		EXPECT_EQ(0u, m_cache.GetTextCount());
+		ExpectTexts(*di);
+		EXPECT_EQ(1u, m_cache.GetRowCount());
+	}
+
+}  // namespace
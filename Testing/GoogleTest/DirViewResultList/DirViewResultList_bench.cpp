@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "DirViewResultList.h"
+#include "Benchmark.h"
+
+namespace
+{
+	/** @brief Number of rows in the folder compare view. */
+	const int nRows = 500000;
+	/** @brief Number of items updated by a file operation. */
+	const int nUpdated = 100;
+
+	// The fixture for benchmarking keeping the folder compare rows sorted
+	// after a few items are updated, e.g. copied or rescanned. Items are
+	// sorted by name like with the default sort column.
+	class DirViewResultListBench : public testing::Test
+	{
+	protected:
+		DirViewResultListBench()
+		{
+			for (int i = 0; i < nRows; ++i)
+				m_names.push_back(RandomName());
+			less = [this](uintptr_t a, uintptr_t b) { return m_names[a] < m_names[b]; };
+			std::vector<uintptr_t> keys(nRows);
+			for (int i = 0; i < nRows; ++i)
+				keys[i] = i;
+			std::stable_sort(keys.begin(), keys.end(), less);
+			m_list.Assign(keys);
+		}
+
+		std::string RandomName()
+		{
+			static const char *exts[] = { ".cpp", ".h", ".txt", ".xml", ".bin" };
+			return "src\\module" + std::to_string(m_rnd.Next(20)) + "\\file" +
+				std::to_string(m_rnd.Next() * 32768 + m_rnd.Next()) + exts[m_rnd.Next(5)];
+		}
+
+		/** @brief Give random items new names and return their keys. */
+		std::vector<uintptr_t> UpdateItems()
+		{
+			std::vector<uintptr_t> updated(nUpdated);
+			for (int i = 0; i < nUpdated; ++i)
+			{
+				updated[i] = m_rnd.Next() * 32768 + m_rnd.Next();
+				updated[i] %= nRows;
+				m_names[updated[i]] = RandomName();
+			}
+			return updated;
+		}
+
+		bench::Random m_rnd;
+		std::vector<std::string> m_names;
+		DirViewResultList m_list;
+		DirViewResultList::LessFunc less;
+	};
+
+	TEST_F(DirViewResultListBench, UpdateItems)
+	{
+		std::vector<DirViewResultList::Change> changes;
+		bench::Measure("Reposition100Of500kRows", [&]() {
+			m_list.Reposition(UpdateItems(), less, changes);
+		});
+		for (int i = 1; i < nRows; ++i)
+			ASSERT_FALSE(less(m_list.GetKeys()[i], m_list.GetKeys()[i - 1])) << "row " << i;
+
+		// Like sorting the whole list control again
+		bench::Measure("FullSort100Of500kRows", [&]() {
+			UpdateItems();
+			std::vector<uintptr_t> keys(m_list.GetKeys());
+			std::stable_sort(keys.begin(), keys.end(), less);
+			m_list.Assign(keys);
+		});
+	}
+
+}  // namespace
@@ -0,0 +1,309 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <algorithm>
+#include "DirViewResultList.h"
+
+namespace
+{
+	// The fixture for testing DirViewResultList with a simulated compare.
+	// Items are numbers, the sort key and the visibility of each item are
+	// kept in maps like the compare results in DIFFITEMs.
+	class DirViewResultListTest : public testing::Test
+	{
+	protected:
+		DirViewResultListTest()
+		{
+			isListed = [this](uintptr_t key) { return listed[key]; };
+			less = [this](uintptr_t a, uintptr_t b) { return sortKeys[a] < sortKeys[b]; };
+		}
+
+		/**
+		 * @brief Apply changes to a copy of the rows like the view applies
+		 * them to the list control.
+		 */
+		static void Apply(const std::vector<DirViewResultList::Change>& changes, std::vector<uintptr_t>& rows, int& nUpdates)
+		{
+			for (size_t i = 0; i < changes.size(); ++i)
+			{
+				const DirViewResultList::Change& change = changes[i];
+				switch (change.type)
+				{
+				case DirViewResultList::ITEM_DELETED:
+					ASSERT_LT(change.nIndex, static_cast<int>(rows.size()));
+					ASSERT_EQ(change.key, rows[change.nIndex]);
+					rows.erase(rows.begin() + change.nIndex);
+					break;
+				case DirViewResultList::ITEM_INSERTED:
+					ASSERT_LE(change.nIndex, static_cast<int>(rows.size()));
+					rows.insert(rows.begin() + change.nIndex, change.key);
+					break;
+				case DirViewResultList::ITEM_UPDATED:
+					ASSERT_LT(change.nIndex, static_cast<int>(rows.size()));
+					ASSERT_EQ(change.key, rows[change.nIndex]);
+					++nUpdates;
+					break;
+				}
+			}
+		}
+
+		/**
+		 * @brief Check that the rows are the listed completed items in order.
+		 */
+		void ExpectRows(const std::vector<uintptr_t>& rows, const std::vector<uintptr_t>& completed)
+		{
+			std::vector<uintptr_t> expected;
+			for (size_t i = 0; i < completed.size(); ++i)
+			{
+				if (listed[completed[i]])
+					expected.push_back(completed[i]);
+			}
+			std::vector<uintptr_t> sortedRows(rows);
+			std::sort(sortedRows.begin(), sortedRows.end());
+			std::sort(expected.begin(), expected.end());
+			EXPECT_EQ(expected, sortedRows);
+			for (size_t i = 1; i < rows.size(); ++i)
+				EXPECT_FALSE(less(rows[i], rows[i - 1])) << "row " << i;
+		}
+
+		std::map<uintptr_t, bool> listed;
+		std::map<uintptr_t, int> sortKeys;
+		DirViewResultList::ItemFunc isListed;
+		DirViewResultList::LessFunc less;
+	};
+
+	TEST_F(DirViewResultListTest, InsertSorted)
+	{
+		DirViewResultList list;
+		std::vector<DirViewResultList::Change> changes;
+		std::vector<uintptr_t> batch;
+		for (uintptr_t key = 1; key <= 5; ++key)
+		{
+			listed[key] = true;
+			sortKeys[key] = static_cast<int>(10 - key);
+			batch.push_back(key);
+		}
+		list.Merge(batch, isListed, less, changes);
+		ASSERT_EQ(5, changes.size());
+		for (int i = 0; i < 5; ++i)
+		{
+			EXPECT_EQ(DirViewResultList::ITEM_INSERTED, changes[i].type);
+			EXPECT_EQ(i, changes[i].nIndex);
+			EXPECT_EQ(static_cast<uintptr_t>(5 - i), changes[i].key);
+		}
+	}
+
+	TEST_F(DirViewResultListTest, UpdateInPlace)
+	{
+		DirViewResultList list;
+		std::vector<uintptr_t> keys;
+		for (uintptr_t key = 1; key <= 3; ++key)
+		{
+			listed[key] = true;
+			sortKeys[key] = static_cast<int>(key);
+			keys.push_back(key);
+		}
+		list.Assign(keys);
+		std::vector<DirViewResultList::Change> changes;
+		list.Merge(std::vector<uintptr_t>(1, 2), isListed, less, changes);
+		ASSERT_EQ(1, changes.size());
+		EXPECT_EQ(DirViewResultList::ITEM_UPDATED, changes[0].type);
+		EXPECT_EQ(1, changes[0].nIndex);
+	}
+
+	TEST_F(DirViewResultListTest, MoveAndDelete)
+	{
+		DirViewResultList list;
+		std::vector<uintptr_t> keys;
+		for (uintptr_t key = 1; key <= 4; ++key)
+		{
+			listed[key] = true;
+			sortKeys[key] = static_cast<int>(key);
+			keys.push_back(key);
+		}
+		list.Assign(keys);
+		sortKeys[1] = 10;
+		listed[3] = false;
+		std::vector<uintptr_t> batch;
+		batch.push_back(1);
+		batch.push_back(3);
+		std::vector<DirViewResultList::Change> changes;
+		list.Merge(batch, isListed, less, changes);
+		std::vector<uintptr_t> rows(keys);
+		int nUpdates = 0;
+		Apply(changes, rows, nUpdates);
+		ASSERT_EQ(3, rows.size());
+		EXPECT_EQ(2, rows[0]);
+		EXPECT_EQ(4, rows[1]);
+		EXPECT_EQ(1, rows[2]);
+		EXPECT_EQ(rows, list.GetKeys());
+	}
+
+	// Without a sort order new items are appended
+	TEST_F(DirViewResultListTest, Unsorted)
+	{
+		DirViewResultList list;
+		std::vector<DirViewResultList::Change> changes;
+		std::vector<uintptr_t> batch;
+		for (uintptr_t key = 1; key <= 3; ++key)
+		{
+			listed[key] = true;
+			sortKeys[key] = static_cast<int>(10 - key);
+			batch.push_back(key);
+		}
+		list.Merge(batch, isListed, DirViewResultList::LessFunc(), changes);
+		EXPECT_EQ(batch, list.GetKeys());
+	}
+
+	TEST_F(DirViewResultListTest, Refresh)
+	{
+		DirViewResultList list;
+		std::vector<uintptr_t> keys;
+		for (uintptr_t key = 1; key <= 4; ++key)
+			keys.push_back(key);
+		list.Assign(keys);
+		std::vector<uintptr_t> batch;
+		batch.push_back(3);
+		batch.push_back(7);
+		std::vector<DirViewResultList::Change> changes;
+		list.Refresh(batch, changes);
+		ASSERT_EQ(1, changes.size());
+		EXPECT_EQ(DirViewResultList::ITEM_UPDATED, changes[0].type);
+		EXPECT_EQ(2, changes[0].nIndex);
+		EXPECT_EQ(keys, list.GetKeys());
+	}
+
+	// Simulated compare: items are collected, then completed in random
+	// batches with their final sort keys and visibility. Some completed
+	// items are completed again, like folders after their contents.
+	TEST_F(DirViewResultListTest, SimulatedStream)
+	{
+		srand(1);
+		for (int nTest = 0; nTest < 50; ++nTest)
+		{
+			DirViewResultList list;
+			std::vector<uintptr_t> rows;
+			std::vector<uintptr_t> completed;
+			const uintptr_t nItems = 1 + rand() % 500;
+			uintptr_t nNext = 1;
+			int nUpdates = 0;
+			while (nNext <= nItems || rand() % 4)
+			{
+				std::vector<uintptr_t> batch;
+				int nBatch = rand() % 40;
+				for (int i = 0; i < nBatch; ++i)
+				{
+					uintptr_t key;
+					if (nNext <= nItems && (completed.empty() || rand() % 4))
+					{
+						key = nNext++;
+						completed.push_back(key);
+					}
+					else if (!completed.empty())
+						key = completed[rand() % completed.size()];
+					else
+						continue;
+					listed[key] = rand() % 5 != 0;
+					sortKeys[key] = rand() % 50;
+					batch.push_back(key);
+				}
+				std::vector<DirViewResultList::Change> changes;
+				list.Merge(batch, isListed, less, changes);
+				Apply(changes, rows, nUpdates);
+				ASSERT_EQ(rows, list.GetKeys());
+				ExpectRows(rows, completed);
+				if (HasFailure())
+					return;
+				if (nNext > nItems && rand() % 2)
+					break;
+			}
+		}
+	}
+
+	TEST_F(DirViewResultListTest, Reposition)
+	{
+		DirViewResultList list;
+		std::vector<uintptr_t> keys;
+		for (uintptr_t key = 1; key <= 5; ++key)
+		{
+			sortKeys[key] = static_cast<int>(key) * 10;
+			keys.push_back(key);
+		}
+		list.Assign(keys);
+		sortKeys[2] = 45;
+		sortKeys[4] = 35;
+		std::vector<uintptr_t> updated;
+		updated.push_back(2);
+		updated.push_back(4);
+		std::vector<DirViewResultList::Change> changes;
+		list.Reposition(updated, less, changes);
+		std::vector<uintptr_t> rows(keys);
+		int nUpdates = 0;
+		Apply(changes, rows, nUpdates);
+		EXPECT_EQ(rows, list.GetKeys());
+		ASSERT_EQ(5, rows.size());
+		EXPECT_EQ(1, rows[0]);
+		EXPECT_EQ(3, rows[1]);
+		EXPECT_EQ(4, rows[2]);
+		EXPECT_EQ(2, rows[3]);
+		EXPECT_EQ(5, rows[4]);
+
+		// An item still in order is only updated
+		sortKeys[3] = 31;
+		list.Reposition(std::vector<uintptr_t>(1, 3), less, changes);
+		ASSERT_EQ(1, changes.size());
+		EXPECT_EQ(DirViewResultList::ITEM_UPDATED, changes[0].type);
+		EXPECT_EQ(1, changes[0].nIndex);
+	}
+
+	// Random items of a sorted list get new sort keys. After repositioning
+	// them the rows must be in the same order as after a full sort.
+	TEST_F(DirViewResultListTest, RepositionRandomUpdates)
+	{
+		srand(2);
+		for (int nTest = 0; nTest < 50; ++nTest)
+		{
+			const uintptr_t nItems = 1 + rand() % 500;
+			std::vector<uintptr_t> rows;
+			for (uintptr_t key = 1; key <= nItems; ++key)
+			{
+				sortKeys[key] = rand() % 100;
+				rows.push_back(key);
+			}
+			std::stable_sort(rows.begin(), rows.end(), less);
+			DirViewResultList list;
+			list.Assign(rows);
+			for (int nRound = 0; nRound < 20; ++nRound)
+			{
+				std::vector<uintptr_t> updated;
+				int nUpdated = rand() % 3 ? rand() % 10 : rand() % static_cast<int>(nItems + 1);
+				for (int i = 0; i < nUpdated; ++i)
+				{
+					uintptr_t key = 1 + rand() % nItems;
+					// Some updated items keep their sort key
+					if (rand() % 2)
+						sortKeys[key] = rand() % 100;
+					updated.push_back(key);
+				}
+				std::vector<DirViewResultList::Change> changes;
+				list.Reposition(updated, less, changes);
+				int nUpdates = 0;
+				Apply(changes, rows, nUpdates);
+				ASSERT_EQ(rows, list.GetKeys());
+
+				std::vector<uintptr_t> sorted(rows);
+				std::stable_sort(sorted.begin(), sorted.end(), less);
+				for (size_t i = 0; i < rows.size(); ++i)
+					EXPECT_EQ(sortKeys[sorted[i]], sortKeys[rows[i]]) << "row " << i;
+				std::sort(sorted.begin(), sorted.end());
+				for (size_t i = 0; i < sorted.size(); ++i)
+					EXPECT_EQ(i + 1, sorted[i]);
+				EXPECT_GE(2 * updated.size(), changes.size() - nUpdates);
+				if (HasFailure())
+					return;
+			}
+		}
+	}
+
+}  // namespace
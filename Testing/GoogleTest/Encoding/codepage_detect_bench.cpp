@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "codepage_detect.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking encoding detection of files as loaded
+	// by folder compare and file compare.
+	class CodepageDetectBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Write 100 KB files of typical kinds once for all benchmarks.
+		 */
+		static void SetUpTestCase()
+		{
+			bench::Random rnd;
+			std::string body;
+			while (body.size() < 100 * 1024)
+			{
+				body += "<p>Value " + std::to_string(rnd.Next(100000)) + " is";
+				body += rnd.Next(10) == 0 ? " \xc3\xa4nderung</p>\r\n" : " changed</p>\r\n";
+			}
+			std::string latin1 = body;
+			for (size_t i = 0; i + 1 < latin1.size(); ++i)
+			{
+				if (latin1[i] == '\xc3')
+					latin1.replace(i, 2, "\xe4");
+			}
+
+			WriteFile("Utf8.txt", body);
+			WriteFile("Utf8Bom.txt", "\xEF\xBB\xBF" + body);
+			WriteFile("Cp1252.txt", latin1);
+			WriteFile("Cp1252.html", "<html><head><meta http-equiv=\"Content-Type\" content=\"text/html; charset=windows-1252\"></head>\r\n" + latin1);
+			WriteFile("Cp1252.xml", "<?xml version=\"1.0\" encoding=\"windows-1252\"?>\r\n" + latin1);
+			WriteFile("Cp1252.rc", "#pragma code_page(1252)\r\n" + latin1);
+			std::string ucs2le("\xFF\xFE", 2);
+			for (size_t i = 0; i < latin1.size(); ++i)
+			{
+				ucs2le += latin1[i];
+				ucs2le += '\0';
+			}
+			WriteFile("Ucs2le.txt", ucs2le);
+		}
+
+		static void TearDownTestCase()
+		{
+			for (size_t i = 0; i < s_files.size(); ++i)
+				remove(ucr::toUTF8(s_files[i]).c_str());
+			s_files.clear();
+		}
+
+		static void WriteFile(const std::string& name, const std::string& data)
+		{
+			String filename = ucr::toTString("CodepageDetectBench_" + name);
+			std::ofstream ostr(ucr::toUTF8(filename).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << data;
+			s_files.push_back(filename);
+		}
+
+		/**
+		 * @brief Detect the encodings of all files 10 times.
+		 * @return Number of files detected as UTF-8.
+		 */
+		static int GuessAll(int guessEncodingType)
+		{
+			int nutf8 = 0;
+			for (int n = 0; n < 10; ++n)
+			{
+				for (size_t i = 0; i < s_files.size(); ++i)
+				{
+					FileTextEncoding enc = GuessCodepageEncoding(s_files[i], guessEncodingType);
+					if (enc.m_codepage == CP_UTF8)
+						++nutf8;
+				}
+			}
+			return nutf8;
+		}
+
+		static std::vector<String> s_files;
+	};
+
+	std::vector<String> CodepageDetectBench::s_files;
+
+	TEST_F(CodepageDetectBench, GuessCodepageEncoding)
+	{
+		int nutf8 = 0;
+		bench::Measure("GuessEncodingBomOnly", [&]() { nutf8 = GuessAll(0); });
+		EXPECT_EQ(10, nutf8);
+		bench::Measure("GuessEncodingHeaders", [&]() { nutf8 = GuessAll(1); });
+		EXPECT_EQ(20, nutf8);
+		bench::Measure("GuessEncodingAutoDetect", [&]() { nutf8 = GuessAll(1 | 2 | (50001 << 16)); });
+		EXPECT_LE(20, nutf8);
+	}
+
+}  // namespace
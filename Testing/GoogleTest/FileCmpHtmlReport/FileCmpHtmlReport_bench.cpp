@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <sstream>
+#include "FileCmpHtmlReport.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// Format a two-way report of a large file
+	TEST(FileCmpHtmlReportBench, WriteRows)
+	{
+		bench::Random rnd;
+		FileCmpHtmlReport report(2);
+		FileCmpHtmlReport::Style styles[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			report.SetColor(i, RGB(i * 60, 0, 0));
+			report.SetColor(4 + i, RGB(255, 255, 255 - i * 20));
+			FileCmpHtmlReport::Style style = { i, 4 + i, i == 1, false };
+			styles[i] = style;
+		}
+		const int nRows = 200000;
+		std::vector<FileCmpHtmlReport::Cell> rows(nRows * 2);
+		for (int i = 0; i < nRows; ++i)
+		{
+			FileCmpHtmlReport::Cell *cells = &rows[i * 2];
+			for (int nBuffer = 0; nBuffer < 2; ++nBuffer)
+			{
+				FileCmpHtmlReport::Cell& cell = cells[nBuffer];
+				cell.bExists = true;
+				cell.nLineNumber = i + 1;
+				cell.style = styles[0];
+				int nWords = 4 + rnd.Next(12);
+				for (int j = 0; j < nWords; ++j)
+				{
+					FileCmpHtmlReport::Span span = { static_cast<int>(cell.sText.length()), styles[rnd.Next(4)] };
+					cell.spans.push_back(span);
+					int len = 1 + rnd.Next(8);
+					for (int k = 0; k < len; ++k)
+						cell.sText += static_cast<TCHAR>(rnd.Next(8) == 0 ? '<' : 'a' + rnd.Next(26));
+					cell.sText += _T("  ");
+				}
+			}
+		}
+
+		auto writeRows = [&](unsigned nThreads) {
+			std::ostringstream stream;
+			report.BeginRows(stream, nThreads);
+			for (int i = 0; i < nRows; ++i)
+			{
+				FileCmpHtmlReport::Cell *cells = report.AddRow();
+				cells[0] = rows[i * 2];
+				cells[1] = rows[i * 2 + 1];
+			}
+			report.EndRows();
+		};
+		bench::Measure("Serial", [&]() { writeRows(1); });
+		bench::Measure("Threaded", [&]() { writeRows(0); });
+	}
+
+}  // namespace
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <sstream>
+#include "FileCmpHtmlReport.h"
+#include "SyntaxColors.h"
+#include "unicoder.h"
+
+namespace
+{
+	// The fixture for testing FileCmpHtmlReport.
+	class FileCmpHtmlReportTest : public testing::Test
+	{
+	protected:
+		FileCmpHtmlReportTest() : m_report(2)
+		{
+			m_report.SetColor(COLORINDEX_NORMALTEXT, RGB(0, 0, 0));
+			m_report.SetColor(COLORINDEX_BKGND, RGB(255, 255, 255));
+			m_report.SetColor(COLORINDEX_KEYWORD, RGB(0, 0, 255));
+			FileCmpHtmlReport::Style normal = { COLORINDEX_NORMALTEXT, COLORINDEX_BKGND, false, false };
+			FileCmpHtmlReport::Style keyword = { COLORINDEX_KEYWORD, COLORINDEX_BKGND, true, false };
+			m_normal = normal;
+			m_keyword = keyword;
+		}
+
+		/**
+		 * @brief Set a cell to one line of text in normal style
+		 */
+		void SetLine(FileCmpHtmlReport::Cell& cell, int nLineNumber, const String& sText)
+		{
+			cell.bExists = true;
+			cell.nLineNumber = nLineNumber;
+			cell.style = m_normal;
+			cell.sText = sText;
+			FileCmpHtmlReport::Span span = { 0, m_normal };
+			cell.spans.assign(1, span);
+		}
+
+		String Format(const FileCmpHtmlReport::Cell *cells, size_t nRows) const
+		{
+			String html;
+			m_report.FormatRows(cells, nRows, html);
+			return html;
+		}
+
+		FileCmpHtmlReport m_report;
+		FileCmpHtmlReport::Style m_normal;
+		FileCmpHtmlReport::Style m_keyword;
+	};
+
+	// Each color index becomes a text and a background class
+	TEST_F(FileCmpHtmlReportTest, Styles)
+	{
+		EXPECT_EQ(String(
+			_T(".c2 {color: #ffffff;}\n")
+			_T(".c3 {color: #000000;}\n")
+			_T(".c7 {color: #0000ff;}\n")
+			_T(".b2 {background-color: #ffffff;}\n")
+			_T(".b3 {background-color: #000000;}\n")
+			_T(".b7 {background-color: #0000ff;}\n")
+			_T(".fb {font-weight: bold;}\n")
+			_T(".fi {font-style: italic;}\n")),
+			m_report.GetStyles());
+	}
+
+	// Class names stay the same when the colors change
+	TEST_F(FileCmpHtmlReportTest, StylesOfOtherColors)
+	{
+		FileCmpHtmlReport::Cell cells[2];
+		SetLine(cells[0], 1, _T("x"));
+		String html = Format(cells, 1);
+		m_report.SetColor(COLORINDEX_NORMALTEXT, RGB(255, 255, 255));
+		m_report.SetColor(COLORINDEX_BKGND, RGB(0, 0, 0));
+		EXPECT_EQ(html, Format(cells, 1));
+		EXPECT_NE(String::npos, m_report.GetStyles().find(_T(".c3 {color: #ffffff;}\n")));
+	}
+
+	// Line numbers, spans and escaping
+	TEST_F(FileCmpHtmlReportTest, Row)
+	{
+		FileCmpHtmlReport::Cell cells[2];
+		SetLine(cells[0], 1, _T("if a<b &&  c"));
+		FileCmpHtmlReport::Span span = { 2, m_normal };
+		FileCmpHtmlReport::Span keywordSpan = { 0, m_keyword };
+		cells[0].spans.clear();
+		cells[0].spans.push_back(keywordSpan);
+		cells[0].spans.push_back(span);
+		SetLine(cells[1], 12, _T("x"));
+		EXPECT_EQ(String(
+			_T("<tr>\n")
+			_T("<td class=\"ln\">1</td><td class=\"c3 b2\"><code><span class=\"c7 b2 fb\">if</span><span class=\"c3 b2\"> a&lt;b &amp;&amp; &nbsp;c</span></code></td>\n")
+			_T("<td class=\"ln\">12</td><td class=\"c3 b2\"><code><span class=\"c3 b2\">x</span></code></td>\n")
+			_T("</tr>\n")),
+			Format(cells, 1));
+	}
+
+	// Missing and empty lines, diff anchors and hidden lines
+	TEST_F(FileCmpHtmlReportTest, MissingAndHidden)
+	{
+		FileCmpHtmlReport::Cell cells[2];
+		SetLine(cells[0], 0, _T(""));
+		cells[0].nDiffAnchor = 3;
+		cells[0].bHiddenBelow = true;
+		EXPECT_EQ(String(
+			_T("<tr>\n")
+			_T("<td class=\"ln\"><a name=\"d3\" href=\"#d3\">.</a></td><td class=\"c3 b2\"><code>&nbsp;</code></td>\n")
+			_T("<td class=\"ln\"></td><td></td>\n")
+			_T("</tr>\n")
+			_T("<tr height=1><td style=\"background-color: black\"></td><td style=\"background-color: black\"></td><td></td><td></td></tr>\n")),
+			Format(cells, 1));
+	}
+
+	// Trailing blanks are kept and long words are broken at screen width
+	TEST_F(FileCmpHtmlReportTest, BlanksAndWordBreaks)
+	{
+		m_report.SetScreenChars(0, 4);
+		FileCmpHtmlReport::Cell cells[2];
+		SetLine(cells[0], 1, _T("abcdefg"));
+		SetLine(cells[1], 1, _T("  "));
+		EXPECT_EQ(String(
+			_T("<tr>\n")
+			_T("<td class=\"ln\">1</td><td class=\"c3 b2\"><code><span class=\"c3 b2\">abc<wbr>def<wbr>g</span></code></td>\n")
+			_T("<td class=\"ln\">1</td><td class=\"c3 b2\"><code><span class=\"c3 b2\"> &nbsp;</span>&nbsp;</code></td>\n")
+			_T("</tr>\n")),
+			Format(cells, 1));
+	}
+
+	// Rows written in chunks, by worker threads or not, are the same as
+	// formatted at once
+	TEST_F(FileCmpHtmlReportTest, WriteRowsInChunks)
+	{
+		const size_t nRows = FileCmpHtmlReport::RowsPerChunk * 5 + 17;
+		std::vector<FileCmpHtmlReport::Cell> rows(nRows * 2);
+		for (size_t i = 0; i < nRows; ++i)
+		{
+			FileCmpHtmlReport::Cell *cells = &rows[i * 2];
+			SetLine(cells[0], static_cast<int>(i + 1), string_format(_T("line %d <%c>"), static_cast<int>(i), static_cast<TCHAR>(0xe4)));
+			if (i % 3 != 0)
+				SetLine(cells[1], static_cast<int>(i + 1), _T("x  y"));
+			cells[0].bHiddenBelow = (i % 100 == 0);
+		}
+
+		std::string expected;
+		ucr::toUTF8(Format(rows.data(), nRows), expected);
+
+		for (unsigned nThreads = 1; nThreads <= 4; nThreads += 3)
+		{
+			std::ostringstream stream;
+			m_report.BeginRows(stream, nThreads);
+			for (size_t i = 0; i < nRows; ++i)
+			{
+				FileCmpHtmlReport::Cell *cells = m_report.AddRow();
+				cells[0] = rows[i * 2];
+				cells[1] = rows[i * 2 + 1];
+			}
+			EXPECT_TRUE(m_report.EndRows());
+			EXPECT_EQ(nRows, m_report.GetRowCount());
+			EXPECT_EQ(expected, stream.str());
+		}
+	}
+
+	// Full chunks are written before all rows have been added
+	TEST_F(FileCmpHtmlReportTest, WriteRowsEarly)
+	{
+		std::ostringstream stream;
+		m_report.BeginRows(stream, 1);
+		for (size_t i = 0; i < FileCmpHtmlReport::RowsPerChunk; ++i)
+			SetLine(m_report.AddRow()[0], 1, _T("a"));
+		EXPECT_TRUE(stream.str().empty());
+		SetLine(m_report.AddRow()[0], 1, _T("a"));
+		EXPECT_FALSE(stream.str().empty());
+		size_t nWritten = stream.str().size();
+		EXPECT_TRUE(m_report.EndRows());
+		EXPECT_EQ(nWritten * (FileCmpHtmlReport::RowsPerChunk + 1) / FileCmpHtmlReport::RowsPerChunk, stream.str().size());
+	}
+
+}  // namespace
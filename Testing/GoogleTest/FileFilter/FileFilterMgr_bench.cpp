@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "FileFilterMgr.h"
+#include "FileFilter.h"
+#include "FilterList.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	const char FilterFileName[] = "FileFilterMgrBench.flt";
+
+	// Rules of a typical loose filter of a C++ source tree
+	const char FilterFile[] =
+		"name: Benchmark filter\r\n"
+		"desc: Suppresses binaries found in source trees\r\n"
+		"def: include\r\n"
+		"f: \\.aps$ ## VC Binary version of resource file\r\n"
+		"f: \\.bsc$\r\n"
+		"f: \\.dll$\r\n"
+		"f: \\.exe$\r\n"
+		"f: ^BuildLog.htm$\r\n"
+		"f: ^vc\\d+\\.idb$\r\n"
+		"f: \\.ilk$\r\n"
+		"f: \\.lib$\r\n"
+		"f: \\.obj$\r\n"
+		"f: \\.pch$\r\n"
+		"f: \\.pdb$\r\n"
+		"f: \\.res$\r\n"
+		"f: \\.suo$\r\n"
+		"f: \\.bak$\r\n"
+		"d: \\\\\\.svn$\r\n"
+		"d: \\\\cvs$\r\n"
+		"d: \\\\\\.git$\r\n"
+		"d: \\\\\\.hg$\r\n"
+		"d: \\\\ipch$\r\n";
+
+	// The fixture for benchmarking regular expression matching of file
+	// filters and line filters.
+	class FileFilterMgrBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Generate file names, folder names and source lines once for all benchmarks.
+		 */
+		static void SetUpTestCase()
+		{
+			static const char *exts[] = { ".cpp", ".h", ".rc", ".obj", ".pdb", ".txt", ".vcxproj", "" };
+			static const char *dirs[] = { "Src", "Common", ".svn", "Release", "ipch", "Docs" };
+			bench::Random rnd;
+			for (int i = 0; i < 10000; ++i)
+			{
+				s_fileNames.push_back(ucr::toTString("File" + std::to_string(rnd.Next(100000)) + exts[rnd.Next(8)]));
+				s_dirNames.push_back(ucr::toTString(std::string("\\") + dirs[rnd.Next(6)] + (rnd.Next(2) ? "" : "Old")));
+				std::string line = rnd.Next(10) == 0 ? "// $Id: File.cpp " : "\tint value = ";
+				line += std::to_string(rnd.Next(100000)) + ";";
+				s_lines.push_back(line);
+			}
+			std::ofstream ostr(FilterFileName, std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << FilterFile;
+		}
+
+		static void TearDownTestCase()
+		{
+			remove(FilterFileName);
+			s_fileNames.clear();
+			s_dirNames.clear();
+			s_lines.clear();
+		}
+
+		static std::vector<String> s_fileNames;
+		static std::vector<String> s_dirNames;
+		static std::vector<std::string> s_lines;
+	};
+
+	std::vector<String> FileFilterMgrBench::s_fileNames;
+	std::vector<String> FileFilterMgrBench::s_dirNames;
+	std::vector<std::string> FileFilterMgrBench::s_lines;
+
+	TEST_F(FileFilterMgrBench, FilterList)
+	{
+		FilterList filterList;
+		filterList.AddRegExp("^\\s*//\\s*\\$Id:");
+		filterList.AddRegExp("^\\s*#pragma\\s+once");
+		filterList.AddRegExp("Copyright \\(c\\) [0-9]+");
+		int nmatched = 0;
+		bench::Measure("FilterListMatch10000", [&]() {
+			nmatched = 0;
+			for (size_t i = 0; i < s_lines.size(); ++i)
+			{
+				if (filterList.Match(s_lines[i]))
+					++nmatched;
+			}
+		});
+		EXPECT_GT(nmatched, 0);
+		EXPECT_LT(nmatched, static_cast<int>(s_lines.size()));
+	}
+
+	TEST_F(FileFilterMgrBench, FileFilter)
+	{
+		FileFilterMgr filterMgr;
+		ASSERT_EQ(FILTER_OK, filterMgr.AddFilter(ucr::toTString(FilterFileName)));
+		const FileFilter *pFilter = filterMgr.GetFilterByPath(ucr::toTString(FilterFileName));
+		ASSERT_TRUE(pFilter != NULL);
+
+		int nincluded = 0;
+		bench::Measure("FileFilterFiles10000", [&]() {
+			nincluded = 0;
+			for (size_t i = 0; i < s_fileNames.size(); ++i)
+			{
+				if (filterMgr.TestFileNameAgainstFilter(pFilter, s_fileNames[i]))
+					++nincluded;
+			}
+		});
+		EXPECT_GT(nincluded, 0);
+		EXPECT_LT(nincluded, static_cast<int>(s_fileNames.size()));
+
+		bench::Measure("FileFilterDirs10000", [&]() {
+			nincluded = 0;
+			for (size_t i = 0; i < s_dirNames.size(); ++i)
+			{
+				if (filterMgr.TestDirNameAgainstFilter(pFilter, s_dirNames[i]))
+					++nincluded;
+			}
+		});
+		EXPECT_GT(nincluded, 0);
+		EXPECT_LT(nincluded, static_cast<int>(s_dirNames.size()));
+	}
+
+}  // namespace
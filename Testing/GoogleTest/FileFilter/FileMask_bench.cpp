@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "FileMask.h"
+#include "FileFilterHelper.h"
+#include "FilterList.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// Gives access to the mask regular expression
+	class MaskRegExpHelper : public FileFilterHelper
+	{
+	public:
+		using FileFilterHelper::ParseExtensions;
+	};
+
+	// Matches file names of a source tree with the mask regular expression
+	// and with the compiled mask
+	class FileMaskBench : public testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			static const TCHAR *exts[] = { _T("cpp"), _T("h"), _T("rc"), _T("txt"), _T("png"), _T("obj"), _T("Designer.cs"), _T("") };
+			bench::Random rnd;
+			for (int i = 0; i < 10000; ++i)
+			{
+				String name = _T("File") + ucr::toTString(std::to_string(rnd.Next(100000)));
+				const TCHAR *ext = exts[rnd.Next(8)];
+				if (*ext)
+					name += String(_T(".")) + ext;
+				s_names.push_back(name);
+			}
+		}
+
+		static void TearDownTestCase()
+		{
+			s_names.clear();
+		}
+
+		/** @brief Match the names like FileFilterHelper did with the regular expression. */
+		static int MatchRegExp(const String& mask)
+		{
+			MaskRegExpHelper helper;
+			FilterList filterList;
+			filterList.AddRegExp(ucr::toUTF8(helper.ParseExtensions(mask)));
+			int nmatched = 0;
+			for (size_t i = 0; i < s_names.size(); ++i)
+			{
+				String strFileName = string_makelower(s_names[i]);
+				if (strFileName.empty() || strFileName[0] != '\\')
+					strFileName = _T("\\") + strFileName;
+				if (strFileName.find('.') == String::npos)
+					strFileName = strFileName + _T(".");
+				if (filterList.Match(ucr::toUTF8(strFileName)))
+					++nmatched;
+			}
+			return nmatched;
+		}
+
+		static int MatchCompiled(const String& mask)
+		{
+			FileMask fileMask;
+			fileMask.SetMask(mask);
+			int nmatched = 0;
+			for (size_t i = 0; i < s_names.size(); ++i)
+			{
+				if (fileMask.Match(s_names[i]))
+					++nmatched;
+			}
+			return nmatched;
+		}
+
+		void Compare(const std::string& name, const String& mask)
+		{
+			int nRegExp = 0, nCompiled = 0;
+			bench::Measure(name + "RegExp", [&]() { nRegExp = MatchRegExp(mask); });
+			bench::Measure(name + "Compiled", [&]() { nCompiled = MatchCompiled(mask); });
+			EXPECT_EQ(nRegExp, nCompiled);
+		}
+
+		static std::vector<String> s_names;
+	};
+
+	std::vector<String> FileMaskBench::s_names;
+
+	TEST_F(FileMaskBench, Extensions10000)
+	{
+		Compare("Extensions10000", _T("*.cpp;*.h;*.rc"));
+	}
+
+	TEST_F(FileMaskBench, Wildcards10000)
+	{
+		Compare("Wildcards10000", _T("file1*;*.designer.*;*.t?t"));
+	}
+
+}  // namespace
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "FileMask.h"
+#include "FileFilterHelper.h"
+#include "FilterList.h"
+#include "unicoder.h"
+#include "../UnitTests/RandomFileTest.h"
+
+namespace
+{
+	// Gives access to the mask regular expression
+	class MaskRegExpHelper : public FileFilterHelper
+	{
+	public:
+		using FileFilterHelper::ParseExtensions;
+	};
+
+	// The fixture for testing compiled file masks against the mask regular
+	// expression.
+	class FileMaskTest : public RandomFileTest
+	{
+	protected:
+		FileMaskTest() : RandomFileTest("FileMaskTest")
+		{
+		}
+
+		/** @brief Match the name like the mask regular expression matches it. */
+		bool MatchRegExp(const String& mask, const String& fileName)
+		{
+			FilterList filterList;
+			filterList.AddRegExp(ucr::toUTF8(m_helper.ParseExtensions(mask)));
+			String strFileName = string_makelower(fileName);
+			if (strFileName.empty() || strFileName[0] != '\\')
+				strFileName = _T("\\") + strFileName;
+			if (strFileName.find('.') == String::npos)
+				strFileName = strFileName + _T(".");
+			return filterList.Match(ucr::toUTF8(strFileName));
+		}
+
+		void CheckMask(const String& mask, const std::vector<String>& names)
+		{
+			FileMask fileMask;
+			ASSERT_TRUE(fileMask.SetMask(mask)) << ucr::toUTF8(mask);
+			for (size_t i = 0; i < names.size(); ++i)
+			{
+				EXPECT_EQ(MatchRegExp(mask, names[i]), fileMask.Match(names[i]))
+					<< ucr::toUTF8(mask) << " " << ucr::toUTF8(names[i]);
+			}
+		}
+
+		String RandomString(const TCHAR *chars, int maxLength)
+		{
+			String str;
+			int length = Next(maxLength + 1);
+			size_t nchars = _tcslen(chars);
+			for (int i = 0; i < length; ++i)
+				str += chars[Next(static_cast<int>(nchars))];
+			return str;
+		}
+
+		MaskRegExpHelper m_helper;
+	};
+
+	TEST_F(FileMaskTest, Extensions)
+	{
+		std::vector<String> names = {
+			_T("a.c"), _T("A.C"), _T("a.cpp"), _T("a.Cpp"), _T("a.cxx"), _T(".cpp"), _T("cpp"),
+			_T("a.cx"), _T("a.cpp.h"), _T("a.h.cpp"), _T("a"), _T(""), _T("a."), _T("..c"),
+			_T("dir\\a.c"), _T("\\a.c"), _T("dir.c\\a"), _T("dir.x\\a"), _T("c:\\dir\\makefile") };
+		CheckMask(_T("*.c"), names);
+		CheckMask(_T("*.c;*.cpp;*.cxx"), names);
+		CheckMask(_T("*.C *.CPP,*.h|*.rc:*.x"), names);
+		CheckMask(_T("*."), names);
+		CheckMask(_T("*.c;;*.h"), names);
+		CheckMask(_T(";*.c"), names);
+	}
+
+	TEST_F(FileMaskTest, Wildcards)
+	{
+		std::vector<String> names = {
+			_T("a.c"), _T("ab.c"), _T("abc.c"), _T("makefile"), _T("Makefile"), _T("makefile.in"),
+			_T("dir\\makefile"), _T("dir\\xmakefile"), _T("readme.txt"), _T("a"), _T(""),
+			_T("test_1.cpp"), _T("test_12.cpp"), _T("my.test_1.cpp"), _T("a(1).txt"),
+			_T("a[1].txt"), _T("$a.txt"), _T("a.b.c"), _T("\\"), _T("a\\"), _T(".") };
+		CheckMask(_T("*.*"), names);
+		CheckMask(_T("*"), names);
+		CheckMask(_T("?.c"), names);
+		CheckMask(_T("??.c;makefile"), names);
+		CheckMask(_T("makefile*"), names);
+		CheckMask(_T("?akefile"), names);
+		CheckMask(_T("test_?.cpp"), names);
+		CheckMask(_T("*test_*.*"), names);
+		CheckMask(_T("a(1).*;a[1].txt;$a.txt"), names);
+		CheckMask(_T("*.b.*"), names);
+		CheckMask(_T("*.c*"), names);
+	}
+
+	// Empty masks and masks ending with a separator match all names
+	TEST_F(FileMaskTest, MatchAll)
+	{
+		std::vector<String> names = { _T("a.c"), _T("a.cpp"), _T("a"), _T("") };
+		CheckMask(_T(""), names);
+		CheckMask(_T(";"), names);
+		CheckMask(_T("  "), names);
+		CheckMask(_T("*.c;"), names);
+		CheckMask(_T("*.c "), names);
+	}
+
+	// Random masks and names
+	TEST_F(FileMaskTest, Random)
+	{
+		static const TCHAR patternChars[] = _T("ab.*?");
+		static const TCHAR nameChars[] = _T("aAbB.\\");
+		static const TCHAR seps[] = _T(";, ");
+		for (int i = 0; i < 500; ++i)
+		{
+			String mask;
+			int nPatterns = 1 + Next(3);
+			for (int p = 0; p < nPatterns; ++p)
+			{
+				if (p > 0)
+					mask += seps[Next(3)];
+				mask += Next(2) ? _T("*.") + RandomString(_T("ab"), 3) : RandomString(patternChars, 6);
+			}
+			std::vector<String> names;
+			for (int n = 0; n < 20; ++n)
+				names.push_back(RandomString(nameChars, 8));
+			CheckMask(mask, names);
+			if (HasFailure())
+				return;
+		}
+	}
+
+	// Masks having characters of regular expressions are not compiled
+	TEST_F(FileMaskTest, RegExpChars)
+	{
+		FileMask fileMask;
+		EXPECT_FALSE(fileMask.SetMask(_T("a+.txt")));
+		EXPECT_FALSE(fileMask.SetMask(_T("*.c;dir\\*.h")));
+		EXPECT_TRUE(fileMask.SetMask(_T("*.c;*.h")));
+
+		FileFilterHelper helper;
+		helper.UseMask(true);
+		helper.SetMask(_T("*.c;a+.txt"));
+		EXPECT_EQ(true, helper.includeFile(_T("x.c")));
+		EXPECT_EQ(true, helper.includeFile(_T("aa.txt")));
+		EXPECT_EQ(false, helper.includeFile(_T("a+.txt")));
+		helper.SetMask(_T("*.c"));
+		EXPECT_EQ(true, helper.includeFile(_T("x.c")));
+		EXPECT_EQ(false, helper.includeFile(_T("aa.txt")));
+	}
+
+}  // namespace
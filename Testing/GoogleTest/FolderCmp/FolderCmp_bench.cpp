@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "FolderCmp.h"
+#include "DiffContext.h"
+#include "DiffItem.h"
+#include "DiffWrapper.h"
+#include "CompareOptions.h"
+#include "PathContext.h"
+#include "paths.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	/** @brief Number of file pairs compared by one run, like a big source tree. */
+	const int nCompares = 1000000;
+	/** @brief Number of distinct file pairs written to disk. */
+	const int nFiles = 1000;
+
+	// The fixture for benchmarking folder compare of many small files, where
+	// setting up the compare of each file takes most of the time. Writing a
+	// million files would take longer than comparing them, so the same
+	// thousand pairs are compared a thousand times.
+	class FolderCmpBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Write the small file pairs once for all benchmarks.
+		 * Every tenth pair differs.
+		 */
+		static void SetUpTestCase()
+		{
+			bench::Random rnd;
+			paths::CreateIfNeeded(ucr::toTString(s_dirs[0]));
+			paths::CreateIfNeeded(ucr::toTString(s_dirs[1]));
+			for (int i = 0; i < nFiles; ++i)
+			{
+				std::string data;
+				int nLines = 1 + rnd.Next(20);
+				for (int j = 0; j < nLines; ++j)
+					data += "value" + std::to_string(rnd.Next(1000)) + " = " + std::to_string(j) + ";\r\n";
+				std::string name = "file" + std::to_string(i) + ".txt";
+				WriteFile(s_dirs[0], name, data);
+				WriteFile(s_dirs[1], name, i % 10 == 0 ? data + "changed\r\n" : data);
+				s_names.push_back(ucr::toTString(name));
+			}
+		}
+
+		static void TearDownTestCase()
+		{
+			for (size_t i = 0; i < s_names.size(); ++i)
+				for (int j = 0; j < 2; ++j)
+					remove((std::string(s_dirs[j]) + "/" + ucr::toUTF8(s_names[i])).c_str());
+			s_names.clear();
+		}
+
+		static void WriteFile(const char *dir, const std::string& name, const std::string& data)
+		{
+			std::ofstream ostr((std::string(dir) + "/" + name).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << data;
+		}
+
+		FolderCmpBench()
+			: m_ctxt(PathContext(ucr::toTString(s_dirs[0]), ucr::toTString(s_dirs[1])), CMP_CONTENT)
+		{
+			m_ctxt.m_nQuickCompareLimit = 4 * 1024 * 1024;
+		}
+
+		void SetCompareMethod(int compareMethod)
+		{
+			DIFFOPTIONS options = {0};
+			options.nIgnoreWhitespace = WHITESPACE_IGNORE_CHANGE;
+			m_ctxt.CreateCompareOptions(compareMethod, options);
+		}
+
+		/**
+		 * @brief Compare the pairs like a folder compare thread does.
+		 * @param [in] bReuse Compare all files with same FolderCmp.
+		 * @return Number of pairs found identical.
+		 */
+		int CompareAll(bool bReuse)
+		{
+			FolderCmp sharedCmp;
+			int nsame = 0;
+			for (int i = 0; i < nCompares; ++i)
+			{
+				DIFFITEM di;
+				di.diffcode.diffcode = DIFFCODE::FILE | DIFFCODE::BOTH;
+				di.diffFileInfo[0].filename = di.diffFileInfo[1].filename = s_names[i % nFiles];
+				unsigned code;
+				if (bReuse)
+					code = sharedCmp.prepAndCompareFiles(&m_ctxt, di);
+				else
+				{
+					FolderCmp folderCmp;
+					code = folderCmp.prepAndCompareFiles(&m_ctxt, di);
+				}
+				if ((code & DIFFCODE::COMPAREFLAGS) == DIFFCODE::SAME)
+					++nsame;
+			}
+			return nsame;
+		}
+
+		CDiffContext m_ctxt;
+		static const char *const s_dirs[2];
+		static std::vector<String> s_names;
+	};
+
+	const char *const FolderCmpBench::s_dirs[2] = { "FolderCmpBench_left", "FolderCmpBench_right" };
+	std::vector<String> FolderCmpBench::s_names;
+
+	TEST_F(FolderCmpBench, Content)
+	{
+		SetCompareMethod(CMP_CONTENT);
+		int nsame = 0;
+		bench::Measure("Content1MSmallFiles", [&]() {
+			nsame = CompareAll(true);
+		}, 1, 0);
+		EXPECT_EQ(nCompares - nCompares / 10, nsame);
+
+		bench::Measure("Content1MSmallFilesNewFolderCmpPerFile", [&]() {
+			nsame = CompareAll(false);
+		}, 1, 0);
+		EXPECT_EQ(nCompares - nCompares / 10, nsame);
+	}
+
+	TEST_F(FolderCmpBench, QuickContents)
+	{
+		SetCompareMethod(CMP_QUICK_CONTENT);
+		int nsame = 0;
+		bench::Measure("QuickContents1MSmallFiles", [&]() {
+			nsame = CompareAll(true);
+		}, 1, 0);
+		EXPECT_EQ(nCompares - nCompares / 10, nsame);
+	}
+
+}  // namespace
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include <string>
+#include "LineArray.h"
+#include "Benchmark.h"
+
+namespace
+{
+	typedef std::basic_string<TCHAR> tstring;
+
+	// Pasting a large text into the middle of a file, like copying a long
+	// difference to the other side of a file compare
+	class LineArrayBench : public testing::Test
+	{
+	protected:
+		LineArrayBench()
+		{
+			bench::Random rnd;
+			for (int i = 0; i < 20000; ++i)
+			{
+				m_text.append(10 + rnd.Next(60), static_cast<TCHAR>('a' + rnd.Next(26)));
+				m_text += _T("\r\n");
+			}
+		}
+
+		static void Load(std::vector<LineInfo>& lines, int nLines)
+		{
+			for (int i = 0; i < nLines; ++i)
+			{
+				LineInfo line;
+				line.Create(_T("existing line of the file\r\n"), 27);
+				lines.push_back(line);
+			}
+			LineInfo line;
+			line.CreateEmpty();
+			lines.push_back(line);
+		}
+
+		static void Free(std::vector<LineInfo>& lines)
+		{
+			for (size_t i = 0; i < lines.size(); ++i)
+				lines[i].Clear();
+			lines.clear();
+		}
+
+		/**
+		 * @brief Insert the text one line at a time, like
+		 * CCrystalTextBuffer::InternalInsertText() did.
+		 */
+		static int InsertByLine(std::vector<LineInfo>& lines, int nLine, LPCTSTR pszText, int cchText)
+		{
+			int nCurrentLine = nLine;
+			while (cchText > 0)
+			{
+				int nTextPos = 0;
+				while (nTextPos < cchText && !LineInfo::IsEol(pszText[nTextPos]))
+					nTextPos++;
+				if (nTextPos < cchText)
+				{
+					LPCTSTR eol = &pszText[nTextPos];
+					nTextPos++;
+					if (nTextPos < cchText && LineInfo::IsDosEol(eol))
+						nTextPos++;
+				}
+				LineInfo line;
+				line.Create(pszText, nTextPos);
+				lines.insert(lines.begin() + nCurrentLine++, line);
+				pszText += nTextPos;
+				cchText -= nTextPos;
+			}
+			return nCurrentLine - nLine;
+		}
+
+		tstring m_text;
+	};
+
+	TEST_F(LineArrayBench, Paste)
+	{
+		const int nFileLines = 100000;
+		const int cchText = static_cast<int>(m_text.length());
+		std::vector<LineInfo> lines;
+
+		bench::Measure("InsertByLine", [&]() {
+			Load(lines, nFileLines);
+			EXPECT_EQ(20000, InsertByLine(lines, nFileLines / 2, m_text.c_str(), cchText));
+			Free(lines);
+		}, 1, 0);
+		bench::Measure("InsertText", [&]() {
+			Load(lines, nFileLines);
+			int nEndLine, nEndChar, nInsertedLines;
+			LineArray::InsertText(lines, nFileLines / 2, 0, m_text.c_str(), cchText, nEndLine, nEndChar, nInsertedLines);
+			EXPECT_EQ(20000, nInsertedLines);
+			Free(lines);
+		});
+		bench::Measure("DeleteText", [&]() {
+			Load(lines, nFileLines * 2);
+			LineArray::DeleteText(lines, nFileLines / 2, 0, nFileLines * 3 / 2, 0);
+			EXPECT_EQ(nFileLines + 1, static_cast<int>(lines.size()));
+			Free(lines);
+		});
+	}
+
+	// Copying a large selection with ghost lines to the clipboard
+	TEST_F(LineArrayBench, Copy)
+	{
+		const DWORD dwGhost = 0x100;
+		std::vector<LineInfo> lines;
+		bench::Random rnd;
+		for (int i = 0; i < 1000000; ++i)
+		{
+			LineInfo line;
+			if (rnd.Next(4) == 0)
+			{
+				line.CreateEmpty();
+				line.m_dwFlags = dwGhost;
+			}
+			else
+				line.Create(m_text.c_str() + rnd.Next(1000) * 2, 40);
+			lines.push_back(line);
+		}
+		const int nEndLine = static_cast<int>(lines.size()) - 1;
+		const int nEndChar = lines[nEndLine].Length();
+
+		// Upper bound sized buffer, shrunk to the text afterwards and copied
+		// to the clipboard memory, like CMergeEditView::OnEditCopy() did
+		std::vector<TCHAR> expected;
+		bench::Measure("UpperBound", [&]() {
+			size_t nBufSize = 0;
+			for (int i = 0; i <= nEndLine; ++i)
+				nBufSize += lines[i].FullLength() + 2;
+			std::vector<TCHAR> buf(nBufSize);
+			LPTSTR pszBuf = &buf[0];
+			for (int i = 0; i <= nEndLine; ++i)
+			{
+				if (lines[i].m_dwFlags & dwGhost)
+					continue;
+				int chars = (i == nEndLine) ? nEndChar : lines[i].FullLength();
+				memcpy(pszBuf, lines[i].GetLine(), chars * sizeof(TCHAR));
+				pszBuf += chars;
+			}
+			tstring text(&buf[0], pszBuf);
+			expected.assign(text.c_str(), text.c_str() + text.length() + 1);
+		});
+		// Exact size gathered straight to the clipboard memory
+		std::vector<TCHAR> data;
+		bench::Measure("ExactSize", [&]() {
+			int nLength = LineArray::GetText(lines, 0, 0, nEndLine, nEndChar, NULL, NULL, false, dwGhost);
+			data.assign(nLength + 1, 0);
+			LineArray::GetText(lines, 0, 0, nEndLine, nEndChar, &data[0], NULL, false, dwGhost);
+		});
+		EXPECT_EQ(expected, data);
+		Free(lines);
+	}
+
+}  // namespace
@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include "LineArray.h"
+
+namespace
+{
+	typedef std::basic_string<TCHAR> tstring;
+
+	// The fixture for testing LineArray against the line by line
+	// edits CCrystalTextBuffer did before.
+	class LineArrayTest : public testing::Test
+	{
+	protected:
+		~LineArrayTest()
+		{
+			Free(m_lines);
+			Free(m_expected);
+		}
+
+		static void Free(std::vector<LineInfo>& lines)
+		{
+			for (size_t i = 0; i < lines.size(); ++i)
+				lines[i].Clear();
+			lines.clear();
+		}
+
+		static void Load(std::vector<LineInfo>& lines, const tstring& text)
+		{
+			Free(lines);
+			LineInfo line;
+			line.CreateEmpty();
+			lines.push_back(line);
+			int nEndLine, nEndChar, nInsertedLines;
+			LineArray::InsertText(lines, 0, 0, text.c_str(), static_cast<int>(text.length()), nEndLine, nEndChar, nInsertedLines);
+			for (size_t i = 0; i < lines.size(); ++i)
+				lines[i].m_dwFlags = static_cast<DWORD>(i + 1);
+		}
+
+		/**
+		 * @brief Insert a line like CCrystalTextBuffer::InsertLine().
+		 */
+		static void InsertLine(std::vector<LineInfo>& lines, LPCTSTR pszLine, int nLength, int nPosition)
+		{
+			LineInfo line;
+			line.Create(pszLine, nLength);
+			lines.insert(lines.begin() + nPosition, line);
+		}
+
+		/**
+		 * @brief Insert text inserting one line at a time, like
+		 * CCrystalTextBuffer::InternalInsertText() did.
+		 */
+		static void InsertTextByLine(std::vector<LineInfo>& lines, int nLine, int nPos,
+			LPCTSTR pszText, int cchText, int &nEndLine, int &nEndChar, int &nInsertedLines)
+		{
+			int nRestCount = lines[nLine].FullLength() - nPos;
+			tstring sTail;
+			if (nRestCount > 0)
+			{
+				sTail.assign(lines[nLine].GetLine(nPos), nRestCount);
+				lines[nLine].DeleteEnd(nPos);
+			}
+
+			nInsertedLines = 0;
+			int nCurrentLine = nLine;
+			for (;;)
+			{
+				bool haseol = false;
+				int nTextPos = 0;
+				while (nTextPos < cchText && !LineInfo::IsEol(pszText[nTextPos]))
+					nTextPos++;
+				if (nTextPos < cchText)
+				{
+					haseol = true;
+					LPCTSTR eol = &pszText[nTextPos];
+					nTextPos++;
+					if (nTextPos < cchText && LineInfo::IsDosEol(eol))
+						nTextPos++;
+				}
+
+				if (nCurrentLine == nLine)
+				{
+					if (nTextPos > 0)
+						lines[nLine].Append(pszText, nTextPos);
+				}
+				else
+				{
+					InsertLine(lines, pszText, nTextPos, nCurrentLine);
+					nInsertedLines++;
+				}
+
+				if (nTextPos == cchText)
+				{
+					if (haseol)
+					{
+						nEndLine = nCurrentLine + 1;
+						nEndChar = 0;
+					}
+					else
+					{
+						nEndLine = nCurrentLine;
+						nEndChar = lines[nEndLine].Length();
+					}
+					if (!sTail.empty())
+					{
+						if (haseol)
+						{
+							InsertLine(lines, sTail.c_str(), static_cast<int>(sTail.length()), nEndLine);
+							nInsertedLines++;
+						}
+						else
+							lines[nEndLine].Append(sTail.c_str(), nRestCount);
+					}
+					if (nEndLine == static_cast<int>(lines.size()))
+					{
+						InsertLine(lines, _T(""), 0, nEndLine);
+						nInsertedLines++;
+					}
+					break;
+				}
+
+				++nCurrentLine;
+				pszText += nTextPos;
+				cchText -= nTextPos;
+			}
+		}
+
+		/**
+		 * @brief Delete text like CCrystalTextBuffer::InternalDeleteText() did.
+		 */
+		static void DeleteTextByLine(std::vector<LineInfo>& lines, int nStartLine, int nStartChar, int nEndLine, int nEndChar)
+		{
+			if (nStartLine == nEndLine)
+			{
+				lines[nStartLine].Delete(nStartChar, nEndChar);
+				return;
+			}
+			const int nRestCount = lines[nEndLine].FullLength() - nEndChar;
+			tstring sTail(lines[nEndLine].GetLine(nEndChar), nRestCount);
+			DWORD dwFlags = lines[nEndLine].m_dwFlags;
+			for (int L = nStartLine + 1; L <= nEndLine; L++)
+			{
+				lines[nStartLine + 1].Clear();
+				lines.erase(lines.begin() + nStartLine + 1);
+			}
+			lines[nStartLine].DeleteEnd(nStartChar);
+			if (nRestCount > 0)
+				lines[nStartLine].Append(sTail.c_str(), nRestCount);
+			if (nStartChar == 0)
+				lines[nStartLine].m_dwFlags = dwFlags;
+		}
+
+		static tstring RandomText(int nMaxLines)
+		{
+			static const TCHAR *eols[] = { _T("\r\n"), _T("\n"), _T("\r") };
+			tstring text;
+			int nLines = rand() % (nMaxLines + 1);
+			for (int i = 0; i < nLines; ++i)
+			{
+				text.append(rand() % 6, static_cast<TCHAR>('a' + rand() % 26));
+				text += eols[rand() % 3];
+			}
+			text.append(rand() % 3 ? rand() % 6 : 0, _T('z'));
+			return text;
+		}
+
+		void ExpectEqualLines()
+		{
+			ASSERT_EQ(m_expected.size(), m_lines.size());
+			for (size_t i = 0; i < m_lines.size(); ++i)
+			{
+				EXPECT_EQ(m_expected[i].Length(), m_lines[i].Length()) << "line " << i;
+				EXPECT_EQ(tstring(m_expected[i].GetLine(), m_expected[i].FullLength()),
+					tstring(m_lines[i].GetLine(), m_lines[i].FullLength())) << "line " << i;
+				EXPECT_EQ(m_expected[i].m_dwFlags, m_lines[i].m_dwFlags) << "line " << i;
+			}
+		}
+
+		std::vector<LineInfo> m_lines;
+		std::vector<LineInfo> m_expected;
+	};
+
+	TEST_F(LineArrayTest, InsertMultiLine)
+	{
+		Load(m_lines, _T("first\r\nsecond\r\n"));
+		tstring text(_T("A\r\nB\nC"));
+		int nEndLine, nEndChar, nInsertedLines;
+		LineArray::InsertText(m_lines, 0, 2, text.c_str(), static_cast<int>(text.length()), nEndLine, nEndChar, nInsertedLines);
+		ASSERT_EQ(5, m_lines.size());
+		EXPECT_EQ(2, nInsertedLines);
+		EXPECT_EQ(2, nEndLine);
+		EXPECT_EQ(1, nEndChar);
+		EXPECT_EQ(tstring(_T("fiA\r\n")), tstring(m_lines[0].GetLine(), m_lines[0].FullLength()));
+		EXPECT_EQ(tstring(_T("B\n")), tstring(m_lines[1].GetLine(), m_lines[1].FullLength()));
+		EXPECT_EQ(tstring(_T("Crst\r\n")), tstring(m_lines[2].GetLine(), m_lines[2].FullLength()));
+		EXPECT_EQ(1u, m_lines[0].m_dwFlags);
+		EXPECT_EQ(2u, m_lines[3].m_dwFlags);
+	}
+
+	// Text ending with EOL at the end of the buffer adds an empty last line
+	TEST_F(LineArrayTest, InsertAtEnd)
+	{
+		Load(m_lines, _T("line"));
+		tstring text(_T("\nnext\n"));
+		int nEndLine, nEndChar, nInsertedLines;
+		LineArray::InsertText(m_lines, 0, 4, text.c_str(), static_cast<int>(text.length()), nEndLine, nEndChar, nInsertedLines);
+		ASSERT_EQ(3, m_lines.size());
+		EXPECT_EQ(2, nInsertedLines);
+		EXPECT_EQ(2, nEndLine);
+		EXPECT_EQ(0, nEndChar);
+		EXPECT_EQ(0, m_lines[2].FullLength());
+	}
+
+	TEST_F(LineArrayTest, DeleteMultiLine)
+	{
+		Load(m_lines, _T("one\r\ntwo\r\nthree\r\nfour"));
+		LineArray::DeleteText(m_lines, 0, 0, 2, 2);
+		ASSERT_EQ(2, m_lines.size());
+		EXPECT_EQ(tstring(_T("ree\r\n")), tstring(m_lines[0].GetLine(), m_lines[0].FullLength()));
+		EXPECT_EQ(3u, m_lines[0].m_dwFlags);
+		LineArray::DeleteLines(m_lines, 1, 1);
+		EXPECT_EQ(1, m_lines.size());
+	}
+
+	TEST_F(LineArrayTest, GetText)
+	{
+		Load(m_lines, _T("one\r\ntwo\nthree\r\nfour"));
+		m_lines[1].m_dwFlags = 0x100;
+		int nLength = LineArray::GetText(m_lines, 0, 1, 3, 2, NULL);
+		tstring text(nLength, '?');
+		EXPECT_EQ(nLength, LineArray::GetText(m_lines, 0, 1, 3, 2, &text[0]));
+		EXPECT_EQ(tstring(_T("ne\r\ntwo\nthree\r\nfo")), text);
+
+		nLength = LineArray::GetText(m_lines, 0, 1, 3, 2, NULL, _T("\n"), false, 0x100);
+		text.assign(nLength, '?');
+		EXPECT_EQ(nLength, LineArray::GetText(m_lines, 0, 1, 3, 2, &text[0], _T("\n"), false, 0x100));
+		EXPECT_EQ(tstring(_T("ne\nthree\nfo")), text);
+
+		nLength = LineArray::GetText(m_lines, 2, 0, 2, 5, NULL, _T("\n"), true);
+		text.assign(nLength, '?');
+		LineArray::GetText(m_lines, 2, 0, 2, 5, &text[0], _T("\n"), true);
+		EXPECT_EQ(tstring(_T("three\n")), text);
+	}
+
+	// Random insertions and deletions give the same lines as the line by line edits
+	TEST_F(LineArrayTest, SameAsLineByLine)
+	{
+		srand(1);
+		for (int nTest = 0; nTest < 2000; ++nTest)
+		{
+			tstring initial = RandomText(8);
+			Load(m_lines, initial);
+			Load(m_expected, initial);
+
+			const int nLine = rand() % static_cast<int>(m_lines.size());
+			const int nPos = rand() % (m_lines[nLine].Length() + 1);
+			tstring text = RandomText(rand() % 4 ? 4 : 50);
+			int nEndLine, nEndChar, nInsertedLines;
+			int nExpectedEndLine, nExpectedEndChar, nExpectedInsertedLines;
+			LineArray::InsertText(m_lines, nLine, nPos, text.c_str(), static_cast<int>(text.length()), nEndLine, nEndChar, nInsertedLines);
+			InsertTextByLine(m_expected, nLine, nPos, text.c_str(), static_cast<int>(text.length()), nExpectedEndLine, nExpectedEndChar, nExpectedInsertedLines);
+			EXPECT_EQ(nExpectedEndLine, nEndLine);
+			EXPECT_EQ(nExpectedEndChar, nEndChar);
+			EXPECT_EQ(nExpectedInsertedLines, nInsertedLines);
+			ExpectEqualLines();
+
+			const int nStartLine = rand() % static_cast<int>(m_lines.size());
+			const int nStartChar = rand() % (m_lines[nStartLine].Length() + 1);
+			const int nLastLine = nStartLine + rand() % (static_cast<int>(m_lines.size()) - nStartLine);
+			const int nLastChar = (nLastLine == nStartLine ? nStartChar : 0) +
+				rand() % (m_lines[nLastLine].Length() - (nLastLine == nStartLine ? nStartChar : 0) + 1);
+			LineArray::DeleteText(m_lines, nStartLine, nStartChar, nLastLine, nLastChar);
+			DeleteTextByLine(m_expected, nStartLine, nStartChar, nLastLine, nLastChar);
+			ExpectEqualLines();
+			if (HasFailure())
+				return;
+		}
+	}
+
+}  // namespace
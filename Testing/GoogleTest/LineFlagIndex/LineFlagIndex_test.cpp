@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <vector>
+#include <cstdlib>
+#include "LineFlagIndex.h"
+
+namespace
+{
+	enum { BOOKMARK1 = 0x1, BOOKMARK2 = 0x2, BOOKMARKS = 0x80000, DIFF = 0x200000 };
+	const DWORD IndexedFlags = BOOKMARK1 | BOOKMARK2 | BOOKMARKS;
+
+	// The fixture for testing LineFlagIndex against scanning the lines.
+	// Lines are changed like CCrystalTextBuffer changes them and the index
+	// is told about the changes.
+	class LineFlagIndexTest : public testing::Test
+	{
+	protected:
+		LineFlagIndexTest() : m_index(IndexedFlags) {}
+
+		void SetFlags(int nLine, DWORD dwFlags)
+		{
+			m_index.SetLineFlags(nLine, m_lines[nLine].m_dwFlags, dwFlags);
+			m_lines[nLine].m_dwFlags = dwFlags;
+		}
+
+		void InsertLines(int nLine, int nCount)
+		{
+			m_lines.insert(m_lines.begin() + nLine, nCount, LineInfo());
+			m_index.InsertLines(nLine, nCount);
+		}
+
+		void DeleteLines(int nLine, int nCount)
+		{
+			m_index.DeleteLines(nLine, nCount);
+			m_lines.erase(m_lines.begin() + nLine, m_lines.begin() + nLine + nCount);
+		}
+
+		int ScanNext(DWORD dwFlag, int nLine) const
+		{
+			for (int i = nLine; i < static_cast<int>(m_lines.size()); ++i)
+			{
+				if (m_lines[i].m_dwFlags & dwFlag)
+					return i;
+			}
+			return -1;
+		}
+
+		int ScanPrev(DWORD dwFlag, int nLine) const
+		{
+			for (int i = nLine; i >= 0; --i)
+			{
+				if (m_lines[i].m_dwFlags & dwFlag)
+					return i;
+			}
+			return -1;
+		}
+
+		std::vector<LineInfo> m_lines;
+		LineFlagIndex m_index;
+	};
+
+	TEST_F(LineFlagIndexTest, IsIndexed)
+	{
+		EXPECT_TRUE(m_index.IsIndexed(BOOKMARK1));
+		EXPECT_TRUE(m_index.IsIndexed(BOOKMARK1 | BOOKMARKS));
+		EXPECT_FALSE(m_index.IsIndexed(DIFF));
+		EXPECT_FALSE(m_index.IsIndexed(BOOKMARK1 | DIFF));
+		EXPECT_FALSE(m_index.IsIndexed(0));
+	}
+
+	TEST_F(LineFlagIndexTest, Find)
+	{
+		InsertLines(0, 10);
+		SetFlags(3, BOOKMARKS | DIFF);
+		SetFlags(7, BOOKMARKS);
+		SetFlags(5, BOOKMARK2);
+		EXPECT_EQ(3, m_index.FindNextLine(m_lines, BOOKMARKS, 0));
+		EXPECT_EQ(7, m_index.FindNextLine(m_lines, BOOKMARKS, 4));
+		EXPECT_EQ(-1, m_index.FindNextLine(m_lines, BOOKMARKS, 8));
+		EXPECT_EQ(3, m_index.FindPrevLine(m_lines, BOOKMARKS, 6));
+		EXPECT_EQ(-1, m_index.FindPrevLine(m_lines, BOOKMARKS, 2));
+		EXPECT_EQ(5, m_index.FindNextLine(m_lines, BOOKMARK2 | BOOKMARK1, 0));
+		EXPECT_EQ(5, m_index.FindNextLine(m_lines, BOOKMARK2 | BOOKMARKS, 4));
+		EXPECT_EQ(5, m_index.FindPrevLine(m_lines, BOOKMARK2 | BOOKMARKS, 6));
+	}
+
+	TEST_F(LineFlagIndexTest, InsertAndDelete)
+	{
+		InsertLines(0, 10);
+		SetFlags(3, BOOKMARK1);
+		SetFlags(7, BOOKMARKS);
+		InsertLines(2, 5);
+		EXPECT_EQ(8, m_index.FindNextLine(m_lines, BOOKMARK1, 0));
+		EXPECT_EQ(12, m_index.FindNextLine(m_lines, BOOKMARKS, 0));
+		DeleteLines(6, 4);
+		EXPECT_EQ(-1, m_index.FindNextLine(m_lines, BOOKMARK1, 0));
+		EXPECT_EQ(8, m_index.FindNextLine(m_lines, BOOKMARKS, 0));
+	}
+
+	// Changes not told to the index are seen after invalidating it
+	TEST_F(LineFlagIndexTest, Invalidate)
+	{
+		InsertLines(0, 10);
+		SetFlags(3, BOOKMARK1);
+		EXPECT_EQ(3, m_index.FindNextLine(m_lines, BOOKMARK1, 0));
+		m_lines[3].m_dwFlags = 0;
+		m_lines[6].m_dwFlags = BOOKMARK1;
+		m_index.Invalidate();
+		EXPECT_EQ(6, m_index.FindNextLine(m_lines, BOOKMARK1, 0));
+		SetFlags(2, BOOKMARK1);
+		EXPECT_EQ(2, m_index.FindNextLine(m_lines, BOOKMARK1, 0));
+	}
+
+	// Random flag changes, insertions and deletions give the same lines as scanning
+	TEST_F(LineFlagIndexTest, SameAsScan)
+	{
+		static const DWORD flags[] = { BOOKMARK1, BOOKMARK2, BOOKMARKS, DIFF };
+		srand(1);
+		InsertLines(0, 100);
+		for (int nStep = 0; nStep < 5000; ++nStep)
+		{
+			int nLines = static_cast<int>(m_lines.size());
+			switch (rand() % 5)
+			{
+			case 0:
+			case 1:
+			{
+				int nLine = rand() % nLines;
+				SetFlags(nLine, m_lines[nLine].m_dwFlags ^ flags[rand() % 4]);
+				break;
+			}
+			case 2:
+				InsertLines(rand() % (nLines + 1), rand() % 5);
+				break;
+			case 3:
+				if (nLines > 50)
+				{
+					int nLine = rand() % nLines;
+					DeleteLines(nLine, rand() % (nLines - nLine));
+				}
+				break;
+			case 4:
+				if (rand() % 10 == 0)
+					m_index.Invalidate();
+				break;
+			}
+			nLines = static_cast<int>(m_lines.size());
+			DWORD dwFlag = flags[rand() % 3] | (rand() % 2 ? flags[rand() % 3] : 0);
+			int nLine = rand() % nLines;
+			ASSERT_EQ(ScanNext(dwFlag, nLine), m_index.FindNextLine(m_lines, dwFlag, nLine)) << "step " << nStep;
+			ASSERT_EQ(ScanPrev(dwFlag, nLine), m_index.FindPrevLine(m_lines, dwFlag, nLine)) << "step " << nStep;
+		}
+	}
+
+}  // namespace
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <vector>
+#include <cstdlib>
+#include <climits>
+#include "LineFlagRanges.h"
+
+namespace
+{
+	enum { BOOKMARK1 = 0x1, DIFF = 0x200000, TRIVIAL = 0x800000, SNP = 0x2000000, INVISIBLE = 0x80000000 };
+	const DWORD RangeFlags = DIFF | TRIVIAL | SNP | INVISIBLE;
+
+	// The fixture for testing LineFlagRanges against flags kept in every line.
+	// Lines are changed like CCrystalTextBuffer changes them and the ranges
+	// are told about the changes.
+	class LineFlagRangesTest : public testing::Test
+	{
+	protected:
+		LineFlagRangesTest() : m_ranges(RangeFlags) {}
+
+		void SetFlags(int nStartLine, int nEndLine, DWORD dwFlag, bool bSet)
+		{
+			for (int nLine = nStartLine; nLine <= nEndLine; ++nLine)
+			{
+				if (bSet)
+					m_lines[nLine] |= dwFlag & RangeFlags;
+				else
+					m_lines[nLine] &= ~dwFlag;
+			}
+			m_ranges.SetLineFlags(nStartLine, nEndLine, dwFlag, bSet ? dwFlag : 0);
+		}
+
+		void InsertLines(int nLine, int nCount)
+		{
+			m_lines.insert(m_lines.begin() + nLine, nCount, 0);
+			m_ranges.InsertLines(nLine, nCount);
+		}
+
+		void DeleteLines(int nLine, int nCount)
+		{
+			m_ranges.DeleteLines(nLine, nCount);
+			m_lines.erase(m_lines.begin() + nLine, m_lines.begin() + nLine + nCount);
+		}
+
+		int ScanNext(DWORD dwFlag, int nLine) const
+		{
+			for (int i = nLine; i < static_cast<int>(m_lines.size()); ++i)
+			{
+				if (m_lines[i] & dwFlag)
+					return i;
+			}
+			return -1;
+		}
+
+		/** @brief Check every line and the end of every run. */
+		void ExpectSameAsLines(int nStep) const
+		{
+			const int nLines = static_cast<int>(m_lines.size());
+			for (int nLine = 0; nLine < nLines; ++nLine)
+			{
+				ASSERT_EQ(m_lines[nLine], m_ranges.GetLineFlags(nLine)) << "step " << nStep << " line " << nLine;
+				int nRunEnd = m_ranges.GetRunEnd(nLine);
+				ASSERT_GT(nRunEnd, nLine) << "step " << nStep << " line " << nLine;
+				if (nRunEnd < nLines && nLine + 1 == nRunEnd)
+					ASSERT_NE(m_lines[nLine], m_lines[nRunEnd]) << "step " << nStep << " line " << nLine;
+			}
+			// Lines after the last one have no flags
+			ASSERT_EQ(0u, m_ranges.GetLineFlags(nLines)) << "step " << nStep;
+		}
+
+		std::vector<DWORD> m_lines;
+		LineFlagRanges m_ranges;
+	};
+
+	TEST_F(LineFlagRangesTest, SetAndClear)
+	{
+		InsertLines(0, 10);
+		SetFlags(2, 5, DIFF, true);
+		SetFlags(4, 7, INVISIBLE, true);
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(1));
+		EXPECT_EQ(DIFF, m_ranges.GetLineFlags(2));
+		EXPECT_EQ(DIFF | INVISIBLE, m_ranges.GetLineFlags(5));
+		EXPECT_EQ(INVISIBLE, m_ranges.GetLineFlags(7));
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(8));
+		EXPECT_EQ(4, m_ranges.GetRunEnd(2));
+		EXPECT_EQ(6, m_ranges.GetRunEnd(4));
+		EXPECT_EQ(INT_MAX, m_ranges.GetRunEnd(8));
+		SetFlags(0, 9, DIFF, false);
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(2));
+		EXPECT_EQ(INVISIBLE, m_ranges.GetLineFlags(4));
+		EXPECT_EQ(4, m_ranges.GetRunEnd(0));
+		m_ranges.Clear();
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(4));
+	}
+
+	// Flags not kept as ranges are ignored
+	TEST_F(LineFlagRangesTest, OtherFlags)
+	{
+		InsertLines(0, 10);
+		SetFlags(2, 5, DIFF | BOOKMARK1, true);
+		EXPECT_EQ(DIFF, m_ranges.GetLineFlags(3));
+		EXPECT_EQ(-1, m_ranges.FindNextLine(BOOKMARK1, 0));
+	}
+
+	TEST_F(LineFlagRangesTest, InsertAndDelete)
+	{
+		InsertLines(0, 10);
+		SetFlags(3, 4, DIFF, true);
+		SetFlags(7, 8, INVISIBLE, true);
+		// Inserted lines have no flags
+		InsertLines(4, 2);
+		EXPECT_EQ(DIFF, m_ranges.GetLineFlags(3));
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(4));
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(5));
+		EXPECT_EQ(DIFF, m_ranges.GetLineFlags(6));
+		EXPECT_EQ(9, m_ranges.FindNextLine(INVISIBLE, 0));
+		DeleteLines(2, 5);
+		EXPECT_EQ(0u, m_ranges.GetLineFlags(2));
+		EXPECT_EQ(4, m_ranges.FindNextLine(INVISIBLE, 0));
+		EXPECT_EQ(-1, m_ranges.FindNextLine(DIFF, 0));
+		ExpectSameAsLines(0);
+	}
+
+	// Random flag changes, insertions and deletions give the same flags as
+	// setting them in every line
+	TEST_F(LineFlagRangesTest, SameAsLineFlags)
+	{
+		static const DWORD flags[] = { DIFF, TRIVIAL, SNP, INVISIBLE, DIFF | SNP };
+		srand(1);
+		InsertLines(0, 100);
+		for (int nStep = 0; nStep < 5000; ++nStep)
+		{
+			int nLines = static_cast<int>(m_lines.size());
+			switch (rand() % 5)
+			{
+			case 0:
+			case 1:
+			{
+				int nStartLine = rand() % nLines;
+				int nEndLine = nStartLine + rand() % (nLines - nStartLine);
+				SetFlags(nStartLine, nEndLine, flags[rand() % 5], rand() % 3 != 0);
+				break;
+			}
+			case 2:
+				InsertLines(rand() % (nLines + 1), rand() % 5);
+				break;
+			case 3:
+				if (nLines > 50)
+				{
+					int nLine = rand() % nLines;
+					DeleteLines(nLine, rand() % (nLines - nLine));
+				}
+				break;
+			case 4:
+			{
+				// Single line changes, like SetLineFlag()
+				int nLine = rand() % nLines;
+				SetFlags(nLine, nLine, flags[rand() % 5], rand() % 2 != 0);
+				break;
+			}
+			}
+			ExpectSameAsLines(nStep);
+			if (HasFatalFailure())
+				return;
+			nLines = static_cast<int>(m_lines.size());
+			DWORD dwFlag = flags[rand() % 5];
+			int nLine = rand() % nLines;
+			ASSERT_EQ(ScanNext(dwFlag, nLine), m_ranges.FindNextLine(dwFlag, nLine)) << "step " << nStep;
+		}
+	}
+
+}  // namespace
@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MemoryStats.h"
+#include "diff.h"
+#include "CompareEngines/DiffUtils.h"
+#include "CompareOptions.h"
+#include "DiffFileData.h"
+#include "DiffItemList.h"
+#include "FilterCommentsManager.h"
+#include "LineInfo.h"
+#include "unicoder.h"
+
+namespace
+{
+	// Allocations of the thread are counted while this is set
+	thread_local bool bCountHeap = false;
+	// Bytes of the counted allocations not freed yet
+	std::atomic<long long> nCountedHeapBytes(0);
+	// Space before each block for its counted size, keeping the alignment
+	const size_t HeapHeaderSize = 16;
+}
+
+// The heap is replaced so the memory stats can be compared with the bytes
+// really allocated. Each block keeps its size if it was counted.
+void *operator new(size_t size)
+{
+	char *block = static_cast<char *>(malloc(size + HeapHeaderSize));
+	if (block == NULL)
+		throw std::bad_alloc();
+	size_t counted = bCountHeap ? size : 0;
+	*reinterpret_cast<size_t *>(block) = counted;
+	if (counted)
+		nCountedHeapBytes += counted;
+	return block + HeapHeaderSize;
+}
+
+void operator delete(void *p) noexcept
+{
+	if (p == NULL)
+		return;
+	char *block = static_cast<char *>(p) - HeapHeaderSize;
+	size_t counted = *reinterpret_cast<size_t *>(block);
+	if (counted)
+		nCountedHeapBytes -= counted;
+	free(block);
+}
+
+namespace
+{
+	// The fixture for testing that the memory stats of the subsystems match
+	// the memory the subsystems really allocate for synthetic workloads.
+	class MemoryStatsTest : public testing::Test
+	{
+	protected:
+		MemoryStatsTest()
+		{
+			for (int i = 0; i < MemoryStats::SUBSYSTEM_COUNT; ++i)
+				m_base[i] = MemoryStats::GetCurrent(static_cast<MemoryStats::Subsystem>(i));
+			MemoryStats::ResetPeaks();
+		}
+
+		/** @brief Return bytes the subsystem has allocated since the test started. */
+		long long Current(MemoryStats::Subsystem subsystem) const
+		{
+			return MemoryStats::GetCurrent(subsystem) - m_base[subsystem];
+		}
+
+		/** @brief Return the peak of the subsystem since the test started. */
+		long long Peak(MemoryStats::Subsystem subsystem) const
+		{
+			return MemoryStats::GetPeak(subsystem) - m_base[subsystem];
+		}
+
+		long long m_base[MemoryStats::SUBSYSTEM_COUNT];
+	};
+
+	TEST_F(MemoryStatsTest, Allocator)
+	{
+		{
+			std::vector<int, MemoryStats::Allocator<int, MemoryStats::WORDDIFF_CACHE> > v;
+			v.reserve(1000);
+			EXPECT_EQ(static_cast<long long>(1000 * sizeof(int)), Current(MemoryStats::WORDDIFF_CACHE));
+			v.reserve(3000);
+			EXPECT_EQ(static_cast<long long>(3000 * sizeof(int)), Current(MemoryStats::WORDDIFF_CACHE));
+			EXPECT_EQ(static_cast<long long>(4000 * sizeof(int)), Peak(MemoryStats::WORDDIFF_CACHE));
+		}
+		EXPECT_EQ(0, Current(MemoryStats::WORDDIFF_CACHE));
+		EXPECT_EQ(static_cast<long long>(4000 * sizeof(int)), Peak(MemoryStats::WORDDIFF_CACHE));
+		MemoryStats::ResetPeaks();
+		EXPECT_EQ(0, Peak(MemoryStats::WORDDIFF_CACHE));
+	}
+
+	TEST_F(MemoryStatsTest, DiffItems)
+	{
+		DiffItemList list;
+		for (int i = 0; i < 100; ++i)
+		{
+			DIFFITEM *folder = list.AddDiff(NULL);
+			for (int j = 0; j < 9; ++j)
+				list.AddDiff(folder);
+		}
+		EXPECT_EQ(static_cast<long long>(1000 * sizeof(DIFFITEM)), Current(MemoryStats::DIFFITEMS));
+		list.RemoveAll();
+		EXPECT_EQ(0, Current(MemoryStats::DIFFITEMS));
+		EXPECT_EQ(static_cast<long long>(1000 * sizeof(DIFFITEM)), Peak(MemoryStats::DIFFITEMS));
+	}
+
+	// Names are stored once, each distinct name takes at least a String
+	// and the hash table overhead stays below two Strings per name.
+	TEST_F(MemoryStatsTest, FileNames)
+	{
+		const int nNames = 1000;
+		{
+			DiffItemList list;
+			for (int i = 0; i < 4 * nNames; ++i)
+			{
+				DIFFITEM *di = list.AddDiff(NULL);
+				di->diffFileInfo[0].filename = ucr::toTString("MemoryStatsName" + std::to_string(i % nNames));
+				di->diffFileInfo[1].filename = di->diffFileInfo[0].filename;
+			}
+			long long bytes = Current(MemoryStats::FILENAMES);
+			EXPECT_LE(static_cast<long long>(nNames * sizeof(String)), bytes);
+			EXPECT_GE(static_cast<long long>(3 * nNames * sizeof(String)), bytes);
+		}
+		// Only the bucket array of the hash table may remain
+		EXPECT_GE(static_cast<long long>(nNames * sizeof(String)), Current(MemoryStats::FILENAMES));
+	}
+
+	// Line buffers are counted exactly as LineInfo rounds them up.
+	TEST_F(MemoryStatsTest, TextBufferLines)
+	{
+		std::vector<LineInfo> lines;
+		long long expected = 0;
+		for (int i = 0; i < 1000; ++i)
+		{
+			std::basic_string<TCHAR> text(i % 100, 'x');
+			text += _T("\r\n");
+			LineInfo line;
+			line.Create(text.c_str(), static_cast<int>(text.length()));
+			lines.push_back(line);
+			int nMax = ALIGN_BUF_SIZE(static_cast<int>(text.length()) + 1);
+			expected += nMax * sizeof(TCHAR);
+		}
+		EXPECT_EQ(expected, Current(MemoryStats::TEXTBUFFER_LINES));
+
+		// Growing lines reallocates the buffers
+		lines[0].RemoveEol();
+		lines[0].Append(std::basic_string<TCHAR>(100, 'y').c_str(), 100);
+		EXPECT_LT(expected, Current(MemoryStats::TEXTBUFFER_LINES));
+
+		for (size_t i = 0; i < lines.size(); ++i)
+			lines[i].Clear();
+		EXPECT_EQ(0, Current(MemoryStats::TEXTBUFFER_LINES));
+	}
+
+	// The line tables hold a line pointer and an equivalence code for
+	// each hashed line, and grow at most to double the size needed.
+	TEST_F(MemoryStatsTest, DiffutilsLines)
+	{
+		const int nLines = 10000;
+		const char *filenames[2] = { "MemoryStatsTest_left.txt", "MemoryStatsTest_right.txt" };
+		for (int file = 0; file < 2; ++file)
+		{
+			std::ostringstream ss;
+			for (int i = 0; i < nLines; ++i)
+			{
+				// First and last lines differ so all lines are hashed
+				if ((i == 0 || i == nLines - 1) && file == 1)
+					ss << "changed\r\n";
+				else
+					ss << "line " << i << "\r\n";
+			}
+			std::ofstream ostr(filenames[file], std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr << ss.str();
+		}
+
+		FilterCommentsManager filterCommentsManager(_T("MemoryStatsTest_NoSuchFile.ini"));
+		CompareEngines::DiffUtils engine;
+		engine.SetCompareOptions(DiffutilsOptions());
+		engine.SetFilterCommentsManager(&filterCommentsManager);
+		{
+			String left = ucr::toTString(filenames[0]);
+			String right = ucr::toTString(filenames[1]);
+			DiffFileData data;
+			data.SetDisplayFilepaths(left, right);
+			ASSERT_TRUE(data.OpenFiles(left, right));
+			engine.SetFileData(2, data.m_inf);
+			engine.diffutils_compare_files();
+
+			long long needed = 2 * (nLines + 1) * static_cast<long long>(sizeof(char *) + sizeof(int));
+			long long bytes = Current(MemoryStats::DIFFUTILS_LINES);
+			EXPECT_LE(needed, bytes);
+			EXPECT_GE(2 * needed, bytes);
+			// The hash table of equivalence classes existed while hashing
+			EXPECT_LT(bytes, Peak(MemoryStats::DIFFUTILS_LINES));
+		}
+		EXPECT_EQ(0, Current(MemoryStats::DIFFUTILS_LINES));
+
+		for (int file = 0; file < 2; ++file)
+			remove(filenames[file]);
+	}
+
+	// The counters match the bytes the subsystems really allocate from the
+	// heap, not only the sizes they compute
+	TEST_F(MemoryStatsTest, HeapAllocations)
+	{
+		std::vector<std::basic_string<TCHAR> > texts;
+		for (int i = 0; i < 1000; ++i)
+			texts.push_back(std::basic_string<TCHAR>(i % 100, 'x') + _T("\r\n"));
+		std::vector<LineInfo> lines(texts.size());
+		const long long nHeapBase = nCountedHeapBytes;
+		{
+			DiffItemList list;
+			std::vector<int, MemoryStats::Allocator<int, MemoryStats::WORDDIFF_CACHE> > cache;
+
+			bCountHeap = true;
+			for (int i = 0; i < 100; ++i)
+			{
+				DIFFITEM *folder = list.AddDiff(NULL);
+				for (int j = 0; j < 9; ++j)
+					list.AddDiff(folder);
+			}
+			for (size_t i = 0; i < lines.size(); ++i)
+				lines[i].Create(texts[i].c_str(), static_cast<int>(texts[i].length()));
+			lines[0].RemoveEol();
+			lines[0].Append(texts[1].c_str(), static_cast<int>(texts[1].length()));
+			cache.reserve(5000);
+			bCountHeap = false;
+
+			long long nCounted = 0;
+			for (int i = 0; i < MemoryStats::SUBSYSTEM_COUNT; ++i)
+				nCounted += Current(static_cast<MemoryStats::Subsystem>(i));
+			EXPECT_LT(static_cast<long long>(1000 * sizeof(DIFFITEM)), nCounted);
+			EXPECT_EQ(nCountedHeapBytes - nHeapBase, nCounted);
+			EXPECT_EQ(static_cast<long long>(5000 * sizeof(int)), Current(MemoryStats::WORDDIFF_CACHE));
+		}
+		for (size_t i = 0; i < lines.size(); ++i)
+			lines[i].Clear();
+		EXPECT_EQ(nHeapBase, nCountedHeapBytes);
+		EXPECT_EQ(0, Current(MemoryStats::DIFFITEMS));
+		EXPECT_EQ(0, Current(MemoryStats::TEXTBUFFER_LINES));
+	}
+
+	TEST_F(MemoryStatsTest, ToString)
+	{
+		String text = MemoryStats::ToString();
+		for (int i = 0; i < MemoryStats::SUBSYSTEM_COUNT; ++i)
+			EXPECT_NE(String::npos, text.find(MemoryStats::GetName(static_cast<MemoryStats::Subsystem>(i))));
+	}
+
+}  // namespace
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <Poco/File.h>
+#include "MovedFileMatcher.h"
+#include "paths.h"
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	/** @brief Unique file of the synthetic trees */
+	struct BenchFile
+	{
+		String sPath;
+		int64_t nSize;
+	};
+
+	// Matches the unique files of two restructured trees
+	class MovedFileMatcherBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Write the trees once for all benchmarks.
+		 * Every 10th left file is renamed or moved on the right side, the
+		 * other files have random content, so many files of the same size
+		 * differ only in their content.
+		 */
+		static void SetUpTestCase()
+		{
+			const int nFiles = 100000;
+			bench::Random rnd;
+			std::string data;
+			for (int i = 0; i < nFiles / 2; ++i)
+			{
+				data.resize(16 + rnd.Next(1024));
+				for (size_t j = 0; j < data.size(); ++j)
+					data[j] = static_cast<char>(rnd.Next(256));
+				String sDir = string_to_str(i % 100);
+				String sName = _T("file") + string_to_str(i) + _T(".dat");
+				WriteFile(0, paths::ConcatPath(sDir, sName), data);
+				if (i % 10 == 0)
+				{
+					String sNewDir = string_to_str((i / 10) % 100);
+					String sNewName = (i % 20 == 0) ? sName : _T("renamed") + sName;
+					WriteFile(1, paths::ConcatPath(sNewDir, sNewName), data);
+				}
+				else
+				{
+					data[data.size() - 1] ^= 1;
+					WriteFile(1, paths::ConcatPath(sDir, _T("new") + sName), data);
+				}
+			}
+		}
+
+		static void TearDownTestCase()
+		{
+			Poco::File root(ucr::toUTF8(RootPath()));
+			if (root.exists())
+				root.remove(true);
+			for (int nSide = 0; nSide < 2; ++nSide)
+				s_files[nSide].clear();
+		}
+
+		static String RootPath()
+		{
+			return _T("MovedFileMatcherBench");
+		}
+
+		static void WriteFile(int nSide, const String& sRelPath, const std::string& data)
+		{
+			String sPath = paths::ConcatPath(paths::ConcatPath(RootPath(), nSide == 0 ? _T("left") : _T("right")), sRelPath);
+			Poco::File(ucr::toUTF8(paths::GetParentPath(sPath))).createDirectories();
+			std::ofstream ostr(ucr::toUTF8(sPath).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr.write(data.data(), data.size());
+			BenchFile file = { sPath, static_cast<int64_t>(data.size()) };
+			s_files[nSide].push_back(file);
+		}
+
+		static void FindMatches(const std::string& name, unsigned nThreads)
+		{
+			size_t nMatches = 0;
+			bench::Measure(name, [&]() {
+				MovedFileMatcher matcher;
+				for (int nSide = 0; nSide < 2; ++nSide)
+				{
+					for (size_t i = 0; i < s_files[nSide].size(); ++i)
+						matcher.AddFile(nSide, s_files[nSide][i].sPath, s_files[nSide][i].nSize);
+				}
+				nMatches = matcher.FindMatches(nThreads).size();
+			}, 1);
+			EXPECT_EQ(s_files[0].size() / 10, nMatches);
+		}
+
+		static std::vector<BenchFile> s_files[2];
+	};
+
+	std::vector<BenchFile> MovedFileMatcherBench::s_files[2];
+
+	TEST_F(MovedFileMatcherBench, FindMatches100k)
+	{
+		FindMatches("FindMatches100k", 0);
+	}
+
+	TEST_F(MovedFileMatcherBench, FindMatches100kOneThread)
+	{
+		FindMatches("FindMatches100kOneThread", 1);
+	}
+
+}  // namespace
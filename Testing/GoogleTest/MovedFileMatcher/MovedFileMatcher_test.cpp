@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <Poco/File.h>
+#include "MovedFileMatcher.h"
+#include "DiffItem.h"
+#include "IAbortable.h"
+#include "paths.h"
+#include "unicoder.h"
+
+namespace
+{
+	/** @brief Aborts immediately */
+	class Aborted : public IAbortable
+	{
+	public:
+		virtual bool ShouldAbort() const { return true; }
+	};
+
+	// The fixture for testing MovedFileMatcher with synthetic trees.
+	class MovedFileMatcherTest : public testing::Test
+	{
+	protected:
+		MovedFileMatcherTest() : m_sRoot(_T("MovedFileMatcherTest")) {}
+
+		virtual void TearDown()
+		{
+			Poco::File root(ucr::toUTF8(m_sRoot));
+			if (root.exists())
+				root.remove(true);
+		}
+
+		/**
+		 * @brief Write a file into the tree of one side and add it to the matcher
+		 * @return Index of the file on its side.
+		 */
+		size_t AddFile(MovedFileMatcher& matcher, int nSide, const String& sRelPath, const std::string& data)
+		{
+			String sPath = paths::ConcatPath(paths::ConcatPath(m_sRoot, nSide == 0 ? _T("left") : _T("right")), sRelPath);
+			Poco::File(ucr::toUTF8(paths::GetParentPath(sPath))).createDirectories();
+			std::ofstream ostr(ucr::toUTF8(sPath).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+			ostr.write(data.data(), data.size());
+			ostr.close();
+			return matcher.AddFile(nSide, sPath, static_cast<int64_t>(data.size()));
+		}
+
+		String m_sRoot;
+	};
+
+	TEST_F(MovedFileMatcherTest, RenamedAndMoved)
+	{
+		MovedFileMatcher matcher;
+		size_t a = AddFile(matcher, 0, _T("a.txt"), "alpha");
+		size_t b = AddFile(matcher, 0, _T("sub\\b.txt"), "bravo\nbravo");
+		AddFile(matcher, 0, _T("c.txt"), "charlie");
+		AddFile(matcher, 0, _T("d.txt"), "delta delta delta");
+		AddFile(matcher, 0, _T("empty.txt"), "");
+		size_t a2 = AddFile(matcher, 1, _T("a_renamed.txt"), "alpha");
+		AddFile(matcher, 1, _T("x.txt"), "charliX");
+		size_t b2 = AddFile(matcher, 1, _T("other\\b.txt"), "bravo\nbravo");
+		AddFile(matcher, 1, _T("e.txt"), "echo");
+		AddFile(matcher, 1, _T("empty2.txt"), "");
+
+		std::vector<MovedFileMatcher::Match> matches = matcher.FindMatches();
+		ASSERT_EQ(2u, matches.size());
+		EXPECT_EQ(MovedFileMatcher::Match(a, a2), matches[0]);
+		EXPECT_EQ(MovedFileMatcher::Match(b, b2), matches[1]);
+		// a, c, b and their counterparts have sizes found on both sides
+		EXPECT_EQ(6u, matcher.GetSampledCount());
+		// small files are covered by the samples
+		EXPECT_EQ(0u, matcher.GetHashedCount());
+	}
+
+	// Big files differing outside the sampled blocks are hashed fully
+	TEST_F(MovedFileMatcherTest, DifferOutsideSamples)
+	{
+		MovedFileMatcher matcher;
+		std::string data(100000, 'x');
+		for (size_t i = 0; i < data.size(); ++i)
+			data[i] = static_cast<char>('a' + i % 26);
+		std::string changed = data;
+		changed[20000] = '!';
+		AddFile(matcher, 0, _T("big.bin"), data);
+		AddFile(matcher, 1, _T("big.bin"), changed);
+		size_t same = AddFile(matcher, 0, _T("same.bin"), data + "!");
+		size_t same2 = AddFile(matcher, 1, _T("dir\\same2.bin"), data + "!");
+
+		std::vector<MovedFileMatcher::Match> matches = matcher.FindMatches();
+		ASSERT_EQ(1u, matches.size());
+		EXPECT_EQ(MovedFileMatcher::Match(same, same2), matches[0]);
+		EXPECT_EQ(4u, matcher.GetSampledCount());
+		EXPECT_EQ(4u, matcher.GetHashedCount());
+	}
+
+	// Big files differing in a sampled block are not hashed fully
+	TEST_F(MovedFileMatcherTest, DifferInSamples)
+	{
+		MovedFileMatcher matcher;
+		std::string data(100000, 'x');
+		std::string changed = data;
+		changed[data.size() - 1] = '!';
+		AddFile(matcher, 0, _T("big.bin"), data);
+		AddFile(matcher, 1, _T("big.bin"), changed);
+
+		EXPECT_TRUE(matcher.FindMatches().empty());
+		EXPECT_EQ(2u, matcher.GetSampledCount());
+		EXPECT_EQ(0u, matcher.GetHashedCount());
+	}
+
+	// Copies of the same content are paired by name first
+	TEST_F(MovedFileMatcherTest, SameNameFirst)
+	{
+		MovedFileMatcher matcher;
+		size_t x = AddFile(matcher, 0, _T("dir1\\x.txt"), "same");
+		size_t y = AddFile(matcher, 0, _T("dir1\\y.txt"), "same");
+		size_t w = AddFile(matcher, 0, _T("dir1\\w.txt"), "same");
+		size_t y2 = AddFile(matcher, 1, _T("dir2\\Y.TXT"), "same");
+		size_t z2 = AddFile(matcher, 1, _T("dir2\\z.txt"), "same");
+
+		std::vector<MovedFileMatcher::Match> matches = matcher.FindMatches();
+		// x is left over, the rest is paired in name order
+		ASSERT_EQ(2u, matches.size());
+		EXPECT_EQ(MovedFileMatcher::Match(y, y2), matches[0]);
+		EXPECT_EQ(MovedFileMatcher::Match(w, z2), matches[1]);
+		(void)x;
+	}
+
+	// Files which cannot be read are not matched
+	TEST_F(MovedFileMatcherTest, MissingFile)
+	{
+		MovedFileMatcher matcher;
+		AddFile(matcher, 0, _T("a.txt"), "alpha");
+		matcher.AddFile(1, paths::ConcatPath(m_sRoot, _T("right\\missing.txt")), 5);
+		EXPECT_TRUE(matcher.FindMatches().empty());
+	}
+
+	TEST_F(MovedFileMatcherTest, Abort)
+	{
+		Aborted aborted;
+		MovedFileMatcher matcher(&aborted);
+		AddFile(matcher, 0, _T("a.txt"), "alpha");
+		AddFile(matcher, 1, _T("b.txt"), "alpha");
+		EXPECT_TRUE(matcher.FindMatches().empty());
+	}
+
+	// A synthetic tree with many renames gives the same result with and without threads
+	TEST_F(MovedFileMatcherTest, Threads)
+	{
+		MovedFileMatcher matcher1, matcher4;
+		std::vector<MovedFileMatcher::Match> expected;
+		for (int i = 0; i < 200; ++i)
+		{
+			std::string data(static_cast<size_t>(1 + i % 7) * 5000, static_cast<char>('a' + i % 13));
+			data += std::to_string(i);
+			String sName = _T("f") + string_to_str(i) + _T(".dat");
+			String sDir = string_to_str(i % 5);
+			size_t l = AddFile(matcher1, 0, paths::ConcatPath(sDir, sName), data);
+			matcher4.AddFile(0, paths::ConcatPath(m_sRoot, _T("left\\") + paths::ConcatPath(sDir, sName)), data.size());
+			if (i % 3 == 0)
+			{
+				// renamed or moved
+				String sNewName = (i % 2) ? sName : _T("renamed") + sName;
+				size_t r = AddFile(matcher1, 1, paths::ConcatPath(string_to_str(i % 4), sNewName), data);
+				matcher4.AddFile(1, paths::ConcatPath(m_sRoot, _T("right\\") + paths::ConcatPath(string_to_str(i % 4), sNewName)), data.size());
+				expected.push_back(MovedFileMatcher::Match(l, r));
+			}
+			else
+			{
+				// modified at the end
+				data[data.size() - 1] = '#';
+				AddFile(matcher1, 1, paths::ConcatPath(sDir, _T("mod") + sName), data);
+				matcher4.AddFile(1, paths::ConcatPath(m_sRoot, _T("right\\") + paths::ConcatPath(sDir, _T("mod") + sName)), data.size());
+			}
+		}
+		EXPECT_EQ(expected, matcher1.FindMatches(1));
+		EXPECT_EQ(expected, matcher4.FindMatches(4));
+	}
+
+	// Linked items are unlinked when one of them is deleted
+	TEST_F(MovedFileMatcherTest, LinkDiffItems)
+	{
+		DIFFITEM *left = new DIFFITEM;
+		DIFFITEM *right = new DIFFITEM;
+		left->diffcode.diffcode = DIFFCODE::FILE | DIFFCODE::FIRST;
+		right->diffcode.diffcode = DIFFCODE::FILE | DIFFCODE::SECOND;
+		left->LinkMoved(right);
+		EXPECT_EQ(right, left->movedItem);
+		EXPECT_EQ(left, right->movedItem);
+		EXPECT_TRUE(left->diffcode.isMoved());
+		EXPECT_TRUE(right->diffcode.isMoved());
+		EXPECT_TRUE(left->diffcode.isSideFirstOnly());
+
+		delete left;
+		EXPECT_TRUE(right->movedItem == NULL);
+		EXPECT_FALSE(right->diffcode.isMoved());
+		EXPECT_TRUE(right->diffcode.isSideSecondOnly());
+		delete right;
+	}
+
+}  // namespace
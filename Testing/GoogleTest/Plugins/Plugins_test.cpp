@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 #include <tchar.h>
 #include <vector>
+#include <memory>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Mutex.h>
+#include <Poco/Timestamp.h>
 #include "FileTransform.h"
 #include "PluginManager.h"
 #include "Plugins.h"
@@ -46,6 +51,115 @@ namespace
 		// Objects declared here can be used by all tests in the test case for Foo.
 	};
 
+	/**
+	 * @brief Count how many threads are inside a plugin call at the same time.
+	 * Each call waits a while for other threads to enter the same plugin, so
+	 * calls which are not serialized are sure to overlap.
+	 */
+	class PluginCaller : public Poco::Runnable
+	{
+	public:
+		PluginCaller(const PluginInfo & plugin, Poco::FastMutex & mutex, int & nActive, int & nMaxActive, int nThreads)
+			: m_plugin(plugin), m_mutex(mutex), m_nActive(nActive), m_nMaxActive(nMaxActive), m_nThreads(nThreads)
+		{
+		}
+
+		void run()
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				PluginCallLock lock(m_plugin);
+				{
+					Poco::FastMutex::ScopedLock lockCount(m_mutex);
+					if (++m_nActive > m_nMaxActive)
+						m_nMaxActive = m_nActive;
+				}
+				Poco::Timestamp start;
+				while (!start.isElapsed(100000) && GetActive() < m_nThreads)
+					Poco::Thread::sleep(1);
+				{
+					Poco::FastMutex::ScopedLock lockCount(m_mutex);
+					--m_nActive;
+				}
+			}
+		}
+
+	private:
+		int GetActive()
+		{
+			Poco::FastMutex::ScopedLock lockCount(m_mutex);
+			return m_nActive;
+		}
+
+		const PluginInfo & m_plugin;
+		Poco::FastMutex & m_mutex;
+		int & m_nActive;
+		int & m_nMaxActive;
+		int m_nThreads;
+	};
+
+	/// Call the plugins concurrently, one thread per plugin, and return the maximum overlap
+	int CallConcurrently(const std::vector<const PluginInfo *> & plugins)
+	{
+		Poco::FastMutex mutex;
+		int nActive = 0;
+		int nMaxActive = 0;
+		int nThreads = static_cast<int>(plugins.size());
+		std::vector<std::unique_ptr<PluginCaller>> callers;
+		std::vector<std::unique_ptr<Poco::Thread>> threads;
+		for (int i = 0; i < nThreads; ++i)
+		{
+			callers.emplace_back(new PluginCaller(*plugins[i], mutex, nActive, nMaxActive, nThreads));
+			threads.emplace_back(new Poco::Thread);
+			threads[i]->start(*callers[i]);
+		}
+		for (int i = 0; i < nThreads; ++i)
+			threads[i]->join();
+		EXPECT_EQ(0, nActive);
+		return nMaxActive;
+	}
+
+	TEST_F(PluginsTest, CallLockSerializesPlugin)
+	{
+		PluginInfo plugin;
+		plugin.m_filepath = _T("c:/plugins/NotThreadSafe.sct");
+		std::vector<const PluginInfo *> plugins(4, &plugin);
+		EXPECT_EQ(1, CallConcurrently(plugins));
+	}
+
+	TEST_F(PluginsTest, CallLockSerializesInstancesOfPlugin)
+	{
+		// every worker thread has its own instance of the same plugin file
+		PluginInfo plugin1, plugin2, plugin3;
+		plugin1.m_filepath = plugin2.m_filepath = plugin3.m_filepath = _T("c:/plugins/Instances.sct");
+		std::vector<const PluginInfo *> plugins;
+		plugins.push_back(&plugin1);
+		plugins.push_back(&plugin2);
+		plugins.push_back(&plugin3);
+		EXPECT_EQ(1, CallConcurrently(plugins));
+	}
+
+	TEST_F(PluginsTest, CallLockThreadSafePlugin)
+	{
+		PluginInfo plugin;
+		plugin.m_filepath = _T("c:/plugins/ThreadSafe.dll");
+		plugin.m_bThreadSafe = true;
+		std::vector<const PluginInfo *> plugins(4, &plugin);
+		EXPECT_EQ(4, CallConcurrently(plugins));
+	}
+
+	TEST_F(PluginsTest, CallLockDifferentPlugins)
+	{
+		// plugins which are not thread-safe do not block each other
+		PluginInfo plugin1, plugin2;
+		plugin1.m_filepath = _T("c:/plugins/First.sct");
+		plugin2.m_filepath = _T("c:/plugins/Second.sct");
+		std::vector<const PluginInfo *> plugins;
+		plugins.push_back(&plugin1);
+		plugins.push_back(&plugin2);
+		EXPECT_EQ(2, CallConcurrently(plugins));
+	}
+
 	TEST_F(PluginsTest, Unpack)
 	{
 		String oldModulePath = env::GetProgPath();
@@ -0,0 +1,415 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <Poco/Event.h>
+#include <Poco/Thread.h>
+#include <Poco/AtomicCounter.h>
+#include "RescanThread.h"
+#include "IAbortable.h"
+#include "MergeDocRescanJob.h"
+#include "DiffTextLines.h"
+#include "UniFile.h"
+
+namespace
+{
+	typedef std::vector<std::string> Lines;
+
+	/**
+	 * @brief Compare the lines at the same positions.
+	 * Stands for the diff of a rescan, returns the differing lines.
+	 */
+	std::vector<int> CompareLines(const Lines& left, const Lines& right)
+	{
+		std::vector<int> diffs;
+		size_t nLines = (std::max)(left.size(), right.size());
+		for (size_t i = 0; i < nLines; ++i)
+		{
+			if (i >= left.size() || i >= right.size() || left[i] != right[i])
+				diffs.push_back(static_cast<int>(i));
+		}
+		return diffs;
+	}
+
+	/**
+	 * @brief Compares a snapshot of the lines slowly, checking for abort
+	 * like the stages of a file compare.
+	 */
+	class LinesJob : public RescanJob
+	{
+	public:
+		LinesJob(unsigned nRevision, const Lines& left, const Lines& right, int nStages, Poco::Event *pStarted = NULL)
+			: RescanJob(nRevision), m_left(left), m_right(right), m_nStages(nStages), m_pStarted(pStarted), m_bAborted(false) {}
+
+		virtual void Run(const IAbortable& abortable)
+		{
+			if (m_pStarted)
+				m_pStarted->set();
+			for (int i = 0; i < m_nStages; ++i)
+			{
+				if (abortable.ShouldAbort())
+				{
+					m_bAborted = true;
+					return;
+				}
+				Poco::Thread::sleep(1);
+			}
+			m_diffs = CompareLines(m_left, m_right);
+		}
+
+		Lines m_left;
+		Lines m_right;
+		int m_nStages;
+		Poco::Event *m_pStarted;
+		bool m_bAborted;
+		std::vector<int> m_diffs;
+	};
+
+	// The fixture for testing CRescanThread with a simulated document.
+	class RescanThreadTest : public testing::Test
+	{
+	protected:
+		RescanThreadTest() : m_nRevision(0)
+		{
+			for (int i = 0; i < 50; ++i)
+			{
+				m_left.push_back("line" + std::to_string(i));
+				m_right.push_back("line" + std::to_string(i));
+			}
+			m_thread.AddListener(this, &RescanThreadTest::OnCompleted);
+		}
+
+		virtual ~RescanThreadTest()
+		{
+			m_thread.RemoveListener(this, &RescanThreadTest::OnCompleted);
+		}
+
+		void OnCompleted(unsigned& nRevision)
+		{
+			++m_nNotified;
+			m_completed.set();
+		}
+
+		/** @brief Edit a random line like typing in one of the panes. */
+		void Edit()
+		{
+			Lines& lines = (rand() % 2) ? m_left : m_right;
+			int nLine = rand() % static_cast<int>(lines.size());
+			switch (rand() % 3)
+			{
+			case 0: lines[nLine] += static_cast<char>('a' + rand() % 26); break;
+			case 1: lines.insert(lines.begin() + nLine, "new"); break;
+			case 2: if (lines.size() > 1) lines.erase(lines.begin() + nLine); break;
+			}
+			++m_nRevision;
+		}
+
+		void StartRescan(int nStages)
+		{
+			m_thread.Start(new LinesJob(m_nRevision, m_left, m_right, nStages));
+		}
+
+		Lines m_left;
+		Lines m_right;
+		unsigned m_nRevision;
+		CRescanThread m_thread;
+		Poco::Event m_completed;
+		Poco::AtomicCounter m_nNotified;
+	};
+
+	TEST_F(RescanThreadTest, Result)
+	{
+		m_right[3] = "changed";
+		StartRescan(1);
+		ASSERT_TRUE(m_completed.tryWait(10000));
+		std::unique_ptr<RescanJob> pJob = m_thread.TakeResult(m_nRevision);
+		ASSERT_TRUE(pJob != nullptr);
+		EXPECT_EQ(std::vector<int>(1, 3), static_cast<LinesJob *>(pJob.get())->m_diffs);
+		EXPECT_TRUE(m_thread.TakeResult(m_nRevision) == nullptr);
+		EXPECT_FALSE(m_thread.IsBusy());
+	}
+
+	// A result compared before the last edit is not taken
+	TEST_F(RescanThreadTest, OutdatedResult)
+	{
+		StartRescan(1);
+		ASSERT_TRUE(m_completed.tryWait(10000));
+		Edit();
+		EXPECT_TRUE(m_thread.TakeResult(m_nRevision) == nullptr);
+	}
+
+	// A cancelled rescan does not notify
+	TEST_F(RescanThreadTest, Cancel)
+	{
+		Poco::Event started;
+		m_thread.Start(new LinesJob(m_nRevision, m_left, m_right, 100000, &started));
+		ASSERT_TRUE(started.tryWait(10000));
+		m_thread.Cancel();
+		EXPECT_TRUE(m_thread.ShouldAbort());
+		while (m_thread.IsBusy())
+			Poco::Thread::sleep(1);
+		EXPECT_EQ(0, m_nNotified.value());
+		EXPECT_TRUE(m_thread.TakeResult(m_nRevision) == nullptr);
+	}
+
+	// Rapid edits restarting the rescan end with the diff of a synchronous rescan
+	TEST_F(RescanThreadTest, RapidEdits)
+	{
+		srand(1);
+		for (int i = 0; i < 500; ++i)
+		{
+			Edit();
+			if (rand() % 4 == 0)
+				m_thread.Cancel();
+			if (rand() % 2 == 0)
+				StartRescan(rand() % 5);
+			if (m_completed.tryWait(0))
+			{
+				// like the UI thread getting the completed message while editing
+				std::unique_ptr<RescanJob> pJob = m_thread.TakeResult(m_nRevision);
+				if (pJob)
+				{
+					EXPECT_EQ(m_nRevision, pJob->GetRevision());
+					EXPECT_EQ(CompareLines(m_left, m_right), static_cast<LinesJob *>(pJob.get())->m_diffs);
+				}
+			}
+		}
+
+		StartRescan(3);
+		std::unique_ptr<RescanJob> pJob;
+		while (!pJob)
+		{
+			ASSERT_TRUE(m_completed.tryWait(10000));
+			pJob = m_thread.TakeResult(m_nRevision);
+		}
+		LinesJob *pLinesJob = static_cast<LinesJob *>(pJob.get());
+		EXPECT_FALSE(pLinesJob->m_bAborted);
+		EXPECT_EQ(CompareLines(m_left, m_right), pLinesJob->m_diffs);
+	}
+
+	/**
+	 * @brief A buffer line: text and EOL, the last line has no EOL.
+	 */
+	struct BufferLine
+	{
+		String text;
+		String eol;
+	};
+	typedef std::vector<BufferLine> BufferLines;
+
+	/**
+	 * @brief Get the text of the lines as CDiffTextBuffer::GetTextForTempFile()
+	 * gives it, with the stats it counts.
+	 * The lines are put in a buffer's line array, where the last line has
+	 * no EOL, and written out the same way.
+	 */
+	String GetTextForTempFile(const BufferLines& lines, FileTextStats& stats)
+	{
+		std::vector<LineInfo> aLines(lines.size());
+		for (size_t i = 0; i < lines.size(); ++i)
+		{
+			String line = lines[i].text;
+			if (i + 1 < lines.size())
+				line += lines[i].eol;
+			aLines[i].Create(line.c_str(), static_cast<int>(line.length()));
+		}
+		String text;
+		stats.clear();
+		DiffTextLines::WriteRealLines(aLines, 0, static_cast<int>(aLines.size()),
+			static_cast<int>(aLines.size()) - 1, 0, NULL, &stats,
+			[&text](const String& sLine) { text += sLine; });
+		for (size_t i = 0; i < aLines.size(); ++i)
+			aLines[i].FreeBuffer();
+		return text;
+	}
+
+	/**
+	 * @brief Write the text to the file like CDiffTextBuffer::SaveToFile()
+	 * writes a temp file in UTF-8.
+	 */
+	void WriteTempFile(const String& path, const String& text)
+	{
+		UniStdioFile file;
+		file.SetUnicoding(ucr::UTF8);
+		file.SetCodepage(CP_UTF8);
+		file.SetBom(false);
+		ASSERT_TRUE(file.OpenCreate(path));
+		file.WriteBom();
+		file.WriteString(text);
+		file.Close();
+	}
+
+	// The fixture for testing MergeDocRescanJob on CRescanThread with the
+	// diffutils compare.
+	class MergeDocRescanJobTest : public testing::Test
+	{
+	protected:
+		MergeDocRescanJobTest() : m_nRevision(0)
+		{
+			for (int i = 0; i < 200; ++i)
+			{
+				BufferLine line = { string_format(_T("line %d"), i), (i % 7 == 0) ? _T("\r\n") : _T("\n") };
+				m_lines[0].push_back(line);
+				m_lines[1].push_back(line);
+			}
+			m_thread.AddListener(this, &MergeDocRescanJobTest::OnCompleted);
+		}
+
+		virtual ~MergeDocRescanJobTest()
+		{
+			m_thread.RemoveListener(this, &MergeDocRescanJobTest::OnCompleted);
+		}
+
+		void OnCompleted(unsigned& nRevision)
+		{
+			m_completed.set();
+		}
+
+		/** @brief Edit a random line like typing in one of the panes. */
+		void Edit()
+		{
+			BufferLines& lines = m_lines[rand() % 2];
+			int nLine = rand() % static_cast<int>(lines.size());
+			BufferLine line = { _T("new"), _T("\n") };
+			switch (rand() % 4)
+			{
+			case 0: lines[nLine].text += static_cast<TCHAR>('a' + rand() % 26); break;
+			case 1: lines.insert(lines.begin() + nLine, line); break;
+			case 2: if (lines.size() > 1) lines.erase(lines.begin() + nLine); break;
+			case 3: lines[nLine].eol = (lines[nLine].eol == _T("\n")) ? _T("\r\n") : _T("\n"); break;
+			}
+			++m_nRevision;
+		}
+
+		/**
+		 * @brief Start a rescan of a snapshot of the lines like
+		 * CMergeDoc::StartBackgroundRescan() does.
+		 */
+		void StartRescan()
+		{
+			std::unique_ptr<MergeDocRescanJob> pJob(new MergeDocRescanJob(m_nRevision, 2));
+			LPCTSTR tnames[] = {_T("t0_wmbg"), _T("t1_wmbg")};
+			for (int nBuffer = 0; nBuffer < 2; nBuffer++)
+			{
+				ASSERT_FALSE(pJob->m_tempFiles[nBuffer].Create(tnames[nBuffer]).empty());
+				pJob->m_encoding[nBuffer].SetUnicoding(ucr::UTF8);
+				pJob->m_encoding[nBuffer].SetCodepage(CP_UTF8);
+				pJob->m_encoding[nBuffer].m_bom = false;
+				pJob->m_text[nBuffer] = GetTextForTempFile(m_lines[nBuffer], pJob->m_textStats[nBuffer]);
+				pJob->m_nLineCount[nBuffer] = static_cast<int>(m_lines[nBuffer].size());
+			}
+			pJob->m_diffWrapper.GetOptions(&pJob->m_diffOptions);
+			pJob->m_diffWrapper.SetPaths(PathContext(pJob->m_tempFiles[0].GetPath(), pJob->m_tempFiles[1].GetPath()), true);
+			pJob->m_diffWrapper.SetCodepage(CP_UTF8);
+			m_thread.Start(pJob.release());
+		}
+
+		/**
+		 * @brief Compare the lines on this thread like CMergeDoc::Rescan()
+		 * does, letting diffutils count the EOLs.
+		 */
+		void Rescan(DiffList& diffList, DIFFSTATUS& status)
+		{
+			TempFile tempFiles[2];
+			int nLineCount[2];
+			for (int nBuffer = 0; nBuffer < 2; nBuffer++)
+			{
+				FileTextStats stats;
+				tempFiles[nBuffer].Create(_T("t_wmsync"));
+				WriteTempFile(tempFiles[nBuffer].GetPath(), GetTextForTempFile(m_lines[nBuffer], stats));
+				nLineCount[nBuffer] = static_cast<int>(m_lines[nBuffer].size());
+			}
+			CDiffWrapper diffWrapper;
+			DIFFOPTIONS diffOptions = {0};
+			diffWrapper.GetOptions(&diffOptions);
+			diffWrapper.SetPaths(PathContext(tempFiles[0].GetPath(), tempFiles[1].GetPath()), true);
+			diffWrapper.SetCodepage(CP_UTF8);
+			diffWrapper.SetCreateDiffList(&diffList);
+			EXPECT_TRUE(diffWrapper.RunFileDiff());
+			diffWrapper.GetDiffStatus(&status);
+			FixMissingEOL(diffWrapper, diffOptions, status, 2, nLineCount);
+		}
+
+		/** @brief Check the result of the job against a synchronous rescan. */
+		void ExpectSameAsRescan(const MergeDocRescanJob& job)
+		{
+			DiffList diffList;
+			DIFFSTATUS status;
+			Rescan(diffList, status);
+			EXPECT_TRUE(job.m_bDiffSuccess);
+			EXPECT_EQ(status.Identical, job.m_status.Identical);
+			ASSERT_EQ(diffList.GetSize(), job.m_diffList.GetSize());
+			for (int nDiff = 0; nDiff < diffList.GetSize(); ++nDiff)
+			{
+				const DIFFRANGE *pExpected = diffList.DiffRangeAt(nDiff);
+				const DIFFRANGE *pActual = job.m_diffList.DiffRangeAt(nDiff);
+				EXPECT_EQ(pExpected->begin[0], pActual->begin[0]);
+				EXPECT_EQ(pExpected->end[0], pActual->end[0]);
+				EXPECT_EQ(pExpected->begin[1], pActual->begin[1]);
+				EXPECT_EQ(pExpected->end[1], pActual->end[1]);
+				EXPECT_EQ(pExpected->op, pActual->op);
+			}
+		}
+
+		/** @brief Wait for the result of the last rescan started. */
+		std::unique_ptr<RescanJob> WaitResult()
+		{
+			std::unique_ptr<RescanJob> pJob;
+			while (!pJob)
+			{
+				if (!m_completed.tryWait(10000))
+					break;
+				pJob = m_thread.TakeResult(m_nRevision);
+			}
+			return pJob;
+		}
+
+		BufferLines m_lines[2];
+		unsigned m_nRevision;
+		CRescanThread m_thread;
+		Poco::Event m_completed;
+	};
+
+	// A snapshot compared on the thread gives the diffs of a synchronous
+	// rescan, also with mixed EOLs and an EOL missing at the end of one file
+	TEST_F(MergeDocRescanJobTest, SameAsRescan)
+	{
+		m_lines[0][3].text = _T("changed");
+		m_lines[1].erase(m_lines[1].begin() + 50, m_lines[1].begin() + 55);
+		m_lines[1][100].eol = _T("\r");
+		BufferLine last = { _T(""), _T("") };
+		m_lines[1].back().eol = _T("\n");
+		m_lines[1].push_back(last);
+		StartRescan();
+		std::unique_ptr<RescanJob> pJob = WaitResult();
+		ASSERT_TRUE(pJob != nullptr);
+		const MergeDocRescanJob& job = *static_cast<MergeDocRescanJob *>(pJob.get());
+		EXPECT_LT(0, job.m_diffList.GetSize());
+		ExpectSameAsRescan(job);
+	}
+
+	// Edits restarting the rescan end with the diffs of a synchronous rescan
+	TEST_F(MergeDocRescanJobTest, RapidEdits)
+	{
+		srand(2);
+		for (int i = 0; i < 50; ++i)
+		{
+			Edit();
+			if (rand() % 3 == 0)
+				StartRescan();
+			if (m_completed.tryWait(0))
+			{
+				std::unique_ptr<RescanJob> pJob = m_thread.TakeResult(m_nRevision);
+				if (pJob)
+					ExpectSameAsRescan(*static_cast<MergeDocRescanJob *>(pJob.get()));
+			}
+		}
+
+		StartRescan();
+		std::unique_ptr<RescanJob> pJob = WaitResult();
+		ASSERT_TRUE(pJob != nullptr);
+		ExpectSameAsRescan(*static_cast<MergeDocRescanJob *>(pJob.get()));
+	}
+
+}  // namespace
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "stringdiffs.h"
+#include "Benchmark.h"
+
+namespace
+{
+	// The fixture for benchmarking stringdiffs.
+	class StringDiffsBench : public testing::Test
+	{
+	protected:
+		StringDiffsBench()
+		{
+			sd_Init();
+			sd_SetBreakChars(_T(".,;:()[]{}!@#\"$%^&*~+-=<>\'/\\|"));
+		}
+
+		virtual ~StringDiffsBench()
+		{
+			sd_Close();
+		}
+
+		/**
+		 * @brief Build a code-like line of identifiers and punctuation
+		 */
+		static String MakeLine(bench::Random& rnd, int nwords)
+		{
+			static const TCHAR *punct[] = { _T(" "), _T(", "), _T("("), _T(") "), _T(" = "), _T(";") };
+			String line;
+			for (int i = 0; i < nwords; ++i)
+			{
+				int len = 3 + rnd.Next(10);
+				for (int j = 0; j < len; ++j)
+					line += static_cast<TCHAR>(j > 0 && rnd.Next(4) == 0 ? '_' : 'a' + rnd.Next(26));
+				line += punct[rnd.Next(6)];
+			}
+			return line;
+		}
+
+		/**
+		 * @brief Copy a line with many small edits inside words
+		 */
+		static String EditLine(bench::Random& rnd, const String& line, int nedits)
+		{
+			String edited(line);
+			for (int i = 0; i < nedits; ++i)
+			{
+				size_t pos = rnd.Next(static_cast<int>(edited.length()));
+				switch (rnd.Next(3))
+				{
+				case 0: edited[pos] = static_cast<TCHAR>('A' + rnd.Next(26)); break;
+				case 1: edited.insert(pos, 1, static_cast<TCHAR>('0' + rnd.Next(10))); break;
+				default: edited.erase(pos, 1); break;
+				}
+			}
+			return edited;
+		}
+	};
+
+	TEST_F(StringDiffsBench, TwoWay)
+	{
+		bench::Random rnd;
+		std::vector<String> lines1, lines2;
+		for (int i = 0; i < 1000; ++i)
+		{
+			lines1.push_back(MakeLine(rnd, 20));
+			lines2.push_back(EditLine(rnd, lines1.back(), 10));
+		}
+
+		std::vector<wdiff> diffs;
+		bench::Measure("WordLevel", [&]() {
+			for (size_t i = 0; i < lines1.size(); ++i)
+			{
+				diffs.clear();
+				sd_ComputeWordDiffs(lines1[i], lines2[i], true, 0, 1, false, &diffs);
+			}
+		});
+		bench::Measure("CharLevel", [&]() {
+			for (size_t i = 0; i < lines1.size(); ++i)
+			{
+				diffs.clear();
+				sd_ComputeWordDiffs(lines1[i], lines2[i], true, 0, 1, true, &diffs);
+			}
+		});
+	}
+
+	TEST_F(StringDiffsBench, ThreeWay)
+	{
+		bench::Random rnd;
+		std::vector<String> lines;
+		for (int i = 0; i < 1000; ++i)
+		{
+			String base = MakeLine(rnd, 20);
+			lines.push_back(EditLine(rnd, base, 5));
+			lines.push_back(base);
+			lines.push_back(EditLine(rnd, base, 5));
+		}
+
+		std::vector<wdiff> diffs;
+		bench::Measure("CharLevel3Way", [&]() {
+			for (size_t i = 0; i < lines.size(); i += 3)
+			{
+				diffs.clear();
+				sd_ComputeWordDiffs(3, &lines[i], true, 0, 1, true, &diffs);
+			}
+		});
+	}
+
+}  // namespace
@@ -642,7 +642,7 @@ namespace
 	}
 
 	// Identical strings, case sensitivity, no whitespace, words, byte-level
-	// NOTE NOTE: This is questionable?
+	// The single unchanged "c" between "B" and "D" is joined into one diff
 	TEST_F(StringDiffsTest, ByteLevel5)
 	{
 		std::vector<wdiff> diffs;
@@ -659,7 +659,7 @@ namespace
 	}
 
 	// Identical strings, case sensitivity, no whitespace, words, byte-level
-	// NOTE NOTE: This is questionable?
+	// "B" changed on the left and "D" on the right give one diff over "Bcd"/"bcD"
 	TEST_F(StringDiffsTest, ByteLevel6)
 	{
 		std::vector<wdiff> diffs;
@@ -676,37 +676,47 @@ namespace
 	}
 
 	// Identical strings, case sensitivity, no whitespace, words, byte-level
-	// NOTE NOTE: This is questionable?
+	// The unchanged "cd" between "B" and "E" splits the diff in two
 	TEST_F(StringDiffsTest, ByteLevel7)
 	{
 		std::vector<wdiff> diffs;
 		sd_ComputeWordDiffs(_T("aBcdE"), _T("abcde"), true, 0, 0, true, &diffs);
-		EXPECT_EQ(1, diffs.size());
+		EXPECT_EQ(2, diffs.size());
 		wdiff *pDiff;
-		if (diffs.size() == 1 )
+		if (diffs.size() == 2)
 		{
 			pDiff = &diffs[0];
 			EXPECT_EQ(1, pDiff->begin[0]);
-			EXPECT_EQ(4, pDiff->end[0]);
+			EXPECT_EQ(1, pDiff->end[0]);
 			EXPECT_EQ(1, pDiff->begin[1]);
+			EXPECT_EQ(1, pDiff->end[1]);
+			pDiff = &diffs[1];
+			EXPECT_EQ(4, pDiff->begin[0]);
+			EXPECT_EQ(4, pDiff->end[0]);
+			EXPECT_EQ(4, pDiff->begin[1]);
 			EXPECT_EQ(4, pDiff->end[1]);
 		}
 	}
 
 	// Identical strings, case sensitivity, no whitespace, words, byte-level
-	// NOTE NOTE: This is questionable?
+	// "B" changed on the left and "E" on the right stay two diffs around "cd"
 	TEST_F(StringDiffsTest, ByteLevel8)
 	{
 		std::vector<wdiff> diffs;
 		sd_ComputeWordDiffs(_T("aBcde"), _T("abcdE"), true, 0, 0, true, &diffs);
-		EXPECT_EQ(1, diffs.size());
+		EXPECT_EQ(2, diffs.size());
 		wdiff *pDiff;
-		if (diffs.size() == 1)
+		if (diffs.size() == 2)
 		{
-            pDiff = &diffs[0];
+			pDiff = &diffs[0];
 			EXPECT_EQ(1, pDiff->begin[0]);
-			EXPECT_EQ(4, pDiff->end[0]);
+			EXPECT_EQ(1, pDiff->end[0]);
 			EXPECT_EQ(1, pDiff->begin[1]);
+			EXPECT_EQ(1, pDiff->end[1]);
+			pDiff = &diffs[1];
+			EXPECT_EQ(4, pDiff->begin[0]);
+			EXPECT_EQ(4, pDiff->end[0]);
+			EXPECT_EQ(4, pDiff->begin[1]);
 			EXPECT_EQ(4, pDiff->end[1]);
 		}
 	}
@@ -318,13 +318,18 @@ namespace
 			_T("(sizeof *new);"),
 			_T("sizeof(*newob));"),
 				false, 1, 0, true, &diffs);
-		EXPECT_EQ(1, diffs.size());
+		EXPECT_EQ(2, diffs.size());
 		wdiff *pDiff;
-		if (diffs.size() == 1)
+		if (diffs.size() == 2)
 		{
 			pDiff = &diffs[0];
 			EXPECT_EQ(0, pDiff->begin[0]);
 			EXPECT_EQ(0, pDiff->begin[1]);
+			EXPECT_EQ(7, pDiff->end[0]);
+			EXPECT_EQ(6, pDiff->end[1]);
+			pDiff = &diffs[1];
+			EXPECT_EQ(12, pDiff->begin[0]);
+			EXPECT_EQ(11, pDiff->begin[1]);
 			EXPECT_EQ(11, pDiff->end[0]);
 			EXPECT_EQ(13, pDiff->end[1]);
 		}
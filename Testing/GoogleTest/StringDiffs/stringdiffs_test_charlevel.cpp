@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "stringdiffs.h"
+
+using std::vector;
+
+namespace
+{
+	// The fixture for testing character level refinement of stringdiffs.
+	class StringDiffsTestChar : public testing::Test
+	{
+	protected:
+		StringDiffsTestChar()
+		{
+			sd_Init();
+		}
+
+		virtual ~StringDiffsTestChar()
+		{
+			sd_Close();
+		}
+
+		static void ExpectDiff(const wdiff& diff, int b0, int e0, int b1, int e1)
+		{
+			EXPECT_EQ(b0, diff.begin[0]);
+			EXPECT_EQ(e0, diff.end[0]);
+			EXPECT_EQ(b1, diff.begin[1]);
+			EXPECT_EQ(e1, diff.end[1]);
+		}
+	};
+
+	// sd_ComputeWordDiffs() parameters are:
+	// String & str1 - the first string to compare
+	// String & str2 - the second string to compare
+	// bool case_sensitive - is the compare case-sensitive?
+	// int whitespace - do we ignore whitespace and how
+	// int breakType - Space (0) or punctuations (1) break
+	// bool byte_level - are we word (false) or byte-level (true) diffing
+	// std::vector<wdiff> * pDiffs - resultting diff list
+
+	// Two separate changes inside one word
+	TEST_F(StringDiffsTestChar, TwoChangesInWord)
+	{
+		std::vector<wdiff> diffs;
+		sd_ComputeWordDiffs(
+			//  0123456789012
+			_T("foo_bar_baz"),
+			_T("fooXbar_bazY"),
+			true, 0, 0, true, &diffs);
+		EXPECT_EQ(2, diffs.size());
+		if (diffs.size() == 2)
+		{
+			ExpectDiff(diffs[0], 3, 3, 3, 3);
+			ExpectDiff(diffs[1], 11, 10, 11, 11);
+		}
+	}
+
+	// A single matching character between changes does not split the diff
+	TEST_F(StringDiffsTestChar, SingleCharMatchNotSplit)
+	{
+		std::vector<wdiff> diffs;
+		sd_ComputeWordDiffs(_T("qaz"), _T("waq"), true, 0, 0, true, &diffs);
+		EXPECT_EQ(1, diffs.size());
+		if (diffs.size() == 1)
+			ExpectDiff(diffs[0], 0, 2, 0, 2);
+	}
+
+	// Case-sensitive compare finds the changed capitals
+	TEST_F(StringDiffsTestChar, CaseSensitive)
+	{
+		std::vector<wdiff> diffs;
+		sd_ComputeWordDiffs(
+			//  012345678901
+			_T("HelloWorld"),
+			_T("helloXworld"),
+			true, 0, 0, true, &diffs);
+		EXPECT_EQ(2, diffs.size());
+		if (diffs.size() == 2)
+		{
+			ExpectDiff(diffs[0], 0, 0, 0, 0);
+			ExpectDiff(diffs[1], 5, 5, 5, 6);
+		}
+	}
+
+	// Case-insensitive compare leaves only the inserted character
+	TEST_F(StringDiffsTestChar, CaseInsensitive)
+	{
+		std::vector<wdiff> diffs;
+		sd_ComputeWordDiffs(_T("HelloWorld"), _T("helloXworld"),
+			false, 0, 0, true, &diffs);
+		EXPECT_EQ(1, diffs.size());
+		if (diffs.size() == 1)
+			ExpectDiff(diffs[0], 5, 4, 5, 5);
+	}
+
+	// Ranges longer than the refinement limit are only trimmed
+	TEST_F(StringDiffsTestChar, LongRangeNotRefined)
+	{
+		std::vector<wdiff> diffs;
+		String str1(300, 'a');
+		String str2(str1);
+		str2[50] = 'b';
+		str2[250] = 'c';
+		sd_ComputeWordDiffs(str1, str2, true, 0, 0, true, &diffs);
+		EXPECT_EQ(1, diffs.size());
+		if (diffs.size() == 1)
+			ExpectDiff(diffs[0], 50, 250, 50, 250);
+	}
+
+	// Ranges up to the limit are refined
+	TEST_F(StringDiffsTestChar, ShortRangeRefined)
+	{
+		std::vector<wdiff> diffs;
+		String str1(100, 'a');
+		String str2(str1);
+		str2[20] = 'b';
+		str2[80] = 'c';
+		sd_ComputeWordDiffs(str1, str2, true, 0, 0, true, &diffs);
+		EXPECT_EQ(2, diffs.size());
+	}
+
+	// Word level diffs are not affected
+	TEST_F(StringDiffsTestChar, WordLevelUnchanged)
+	{
+		std::vector<wdiff> diffs;
+		sd_ComputeWordDiffs(_T("foo_bar_baz"), _T("fooXbar_bazY"),
+			true, 0, 0, false, &diffs);
+		EXPECT_EQ(1, diffs.size());
+		if (diffs.size() == 1)
+			ExpectDiff(diffs[0], 0, 10, 0, 11);
+	}
+
+	// 3-way: each pairing with the middle string is refined
+	TEST_F(StringDiffsTestChar, ThreeWay)
+	{
+		std::vector<wdiff> diffs;
+		String strs[3] = {
+			//  01234567890123
+			_T("counter_value"),
+			_T("count_value"),
+			_T("counter_values") };
+		sd_ComputeWordDiffs(3, strs, true, 0, 0, true, &diffs);
+		EXPECT_EQ(2, diffs.size());
+		if (diffs.size() == 2)
+		{
+			ExpectDiff(diffs[0], 5, 6, 5, 4);
+			EXPECT_EQ(5, diffs[0].begin[2]);
+			EXPECT_EQ(6, diffs[0].end[2]);
+			ExpectDiff(diffs[1], 13, 12, 11, 10);
+			EXPECT_EQ(13, diffs[1].begin[2]);
+			EXPECT_EQ(13, diffs[1].end[2]);
+		}
+	}
+
+	// 3-way: same change on both sides of the middle string
+	TEST_F(StringDiffsTestChar, ThreeWaySameChange)
+	{
+		std::vector<wdiff> diffs;
+		String strs[3] = { _T("abcdef"), _T("abXdef"), _T("abcdef") };
+		sd_ComputeWordDiffs(3, strs, true, 0, 0, true, &diffs);
+		EXPECT_EQ(1, diffs.size());
+		if (diffs.size() == 1)
+		{
+			ExpectDiff(diffs[0], 2, 2, 2, 2);
+			EXPECT_EQ(2, diffs[0].begin[2]);
+			EXPECT_EQ(2, diffs[0].end[2]);
+		}
+	}
+
+}  // namespace
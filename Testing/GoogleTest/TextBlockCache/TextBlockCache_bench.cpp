@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <vector>
+#include "UnicodeString.h"
+#include "TextBlockCache.h"
+#include "SyntaxColors.h"
+#include "Benchmark.h"
+
+namespace
+{
+	typedef TextBlockCache::TEXTBLOCK TEXTBLOCK;
+
+	// Prepares the text blocks of lines like CCrystalTextView::DrawSingleLine() does
+	class TextBlockCacheBench : public testing::Test
+	{
+	protected:
+		TextBlockCacheBench()
+		{
+			bench::Random rnd;
+			for (int i = 0; i < 20000; ++i)
+				m_lines.push_back(MakeLine(rnd));
+		}
+
+		/**
+		 * @brief Build a code-like line with keywords, numbers, strings and comments
+		 */
+		static String MakeLine(bench::Random& rnd)
+		{
+			static const TCHAR *words[] = { _T("if"), _T("return"), _T("value"), _T("count"), _T("42"), _T("\"text\""), _T("m_nIndex"), _T("0x1f") };
+			String line(rnd.Next(4) * 4, ' ');
+			int nWords = 3 + rnd.Next(12);
+			for (int i = 0; i < nWords; ++i)
+			{
+				line += words[rnd.Next(8)];
+				line += rnd.Next(3) == 0 ? _T("(") : _T(" ");
+			}
+			if (rnd.Next(5) == 0)
+				line += _T("// comment");
+			return line;
+		}
+
+		/**
+		 * @brief Simple syntax parser producing a block for each token
+		 */
+		static DWORD ParseLine(DWORD dwCookie, const String& line, TEXTBLOCK *pBuf, int &nBlocks)
+		{
+			size_t i = 0;
+			while (i < line.length())
+			{
+				size_t begin = i;
+				int nColorIndex = COLORINDEX_NORMALTEXT;
+				TCHAR ch = line[i];
+				if (ch == '/' && i + 1 < line.length() && line[i + 1] == '/')
+				{
+					i = line.length();
+					nColorIndex = COLORINDEX_COMMENT;
+				}
+				else if (ch == '"')
+				{
+					i = line.find('"', i + 1);
+					i = (i == String::npos) ? line.length() : i + 1;
+					nColorIndex = COLORINDEX_STRING;
+				}
+				else if (_istdigit(ch))
+				{
+					while (i < line.length() && _istalnum(line[i]))
+						++i;
+					nColorIndex = COLORINDEX_NUMBER;
+				}
+				else if (_istalpha(ch) || ch == '_')
+				{
+					while (i < line.length() && (_istalnum(line[i]) || line[i] == '_'))
+						++i;
+					String word = line.substr(begin, i - begin);
+					if (word == _T("if") || word == _T("return"))
+						nColorIndex = COLORINDEX_KEYWORD;
+				}
+				else
+				{
+					++i;
+					nColorIndex = COLORINDEX_OPERATOR;
+				}
+				pBuf[nBlocks].m_nCharPos = static_cast<int>(begin);
+				pBuf[nBlocks].m_nColorIndex = nColorIndex;
+				pBuf[nBlocks].m_nBgColorIndex = COLORINDEX_BKGND;
+				++nBlocks;
+			}
+			return dwCookie;
+		}
+
+		/**
+		 * @brief Word difference blocks on every third line
+		 */
+		static int GetAdditionalTextBlocks(int nLineIndex, const String& line, TEXTBLOCK *&pBuf)
+		{
+			pBuf = NULL;
+			if (nLineIndex % 3 != 0 || line.length() < 8)
+				return 0;
+			pBuf = new TEXTBLOCK[5];
+			int nLength = static_cast<int>(line.length());
+			int pos[4] = { 0, nLength / 4, nLength / 2, nLength * 3 / 4 };
+			pBuf[0].m_nCharPos = 0;
+			pBuf[0].m_nColorIndex = COLORINDEX_NONE;
+			pBuf[0].m_nBgColorIndex = COLORINDEX_NONE;
+			for (int i = 1; i < 5; ++i)
+			{
+				pBuf[i].m_nCharPos = pos[i - 1] + 1;
+				pBuf[i].m_nColorIndex = COLORINDEX_NONE;
+				pBuf[i].m_nBgColorIndex = (i % 2) ? COLORINDEX_HIGHLIGHTBKGND1 : COLORINDEX_NONE;
+			}
+			return 5;
+		}
+
+		/**
+		 * @brief Prepare blocks allocating new buffers for every line, like before caching
+		 */
+		std::vector<TEXTBLOCK> PrepareUncached(int nLineIndex)
+		{
+			const String& line = m_lines[nLineIndex];
+			TEXTBLOCK *pBuf = new TEXTBLOCK[(line.length() + 1) * 3];
+			int nBlocks = 0;
+			pBuf[0].m_nCharPos = 0;
+			pBuf[0].m_nColorIndex = COLORINDEX_NORMALTEXT;
+			pBuf[0].m_nBgColorIndex = COLORINDEX_BKGND;
+			nBlocks++;
+			ParseLine(0, line, pBuf, nBlocks);
+			TEXTBLOCK *pAddedBuf;
+			int nAddedBlocks = GetAdditionalTextBlocks(nLineIndex, line, pAddedBuf);
+			TEXTBLOCK *pMergedBuf = new TEXTBLOCK[nBlocks + nAddedBlocks];
+			int nMergedBlocks = TextBlockCache::MergeTextBlocks(pBuf, nBlocks, pAddedBuf, nAddedBlocks, pMergedBuf);
+			delete[] pBuf;
+			delete[] pAddedBuf;
+			std::vector<TEXTBLOCK> blocks(pMergedBuf, pMergedBuf + nMergedBlocks);
+			delete[] pMergedBuf;
+			return blocks;
+		}
+
+		/**
+		 * @brief Prepare blocks through the cache, like CCrystalTextView::GetTextBlocks()
+		 */
+		const TEXTBLOCK *PrepareCached(TextBlockCache& cache, int nLineIndex, int &nBlocks)
+		{
+			DWORD dwNextCookie;
+			const TEXTBLOCK *pCached = cache.Lookup(nLineIndex, 0, 0, nBlocks, dwNextCookie);
+			if (pCached)
+				return pCached;
+			const String& line = m_lines[nLineIndex];
+			TEXTBLOCK *pBuf = cache.GetBuffer(0, static_cast<int>(line.length() + 1) * 3);
+			nBlocks = 0;
+			pBuf[0].m_nCharPos = 0;
+			pBuf[0].m_nColorIndex = COLORINDEX_NORMALTEXT;
+			pBuf[0].m_nBgColorIndex = COLORINDEX_BKGND;
+			nBlocks++;
+			dwNextCookie = ParseLine(0, line, pBuf, nBlocks);
+			TEXTBLOCK *pAddedBuf;
+			int nAddedBlocks = GetAdditionalTextBlocks(nLineIndex, line, pAddedBuf);
+			TEXTBLOCK *pMergedBuf = cache.GetBuffer(1, nBlocks + nAddedBlocks);
+			nBlocks = TextBlockCache::MergeTextBlocks(pBuf, nBlocks, pAddedBuf, nAddedBlocks, pMergedBuf);
+			delete[] pAddedBuf;
+			return cache.Store(nLineIndex, 0, 0, dwNextCookie, pMergedBuf, nBlocks);
+		}
+
+		std::vector<String> m_lines;
+	};
+
+	// Scrolling a page of 60 lines through the file three lines at a time
+	TEST_F(TextBlockCacheBench, Scroll)
+	{
+		const int nPageLines = 60;
+		const int nLines = static_cast<int>(m_lines.size());
+		TextBlockCache cache;
+
+		for (int nLineIndex = 0; nLineIndex < 1000; ++nLineIndex)
+		{
+			int nBlocks;
+			const TEXTBLOCK *pBuf = PrepareCached(cache, nLineIndex, nBlocks);
+			std::vector<TEXTBLOCK> expected = PrepareUncached(nLineIndex);
+			ASSERT_EQ(expected.size(), static_cast<size_t>(nBlocks));
+			for (int i = 0; i < nBlocks; ++i)
+			{
+				EXPECT_EQ(expected[i].m_nCharPos, pBuf[i].m_nCharPos);
+				EXPECT_EQ(expected[i].m_nColorIndex, pBuf[i].m_nColorIndex);
+				EXPECT_EQ(expected[i].m_nBgColorIndex, pBuf[i].m_nBgColorIndex);
+			}
+		}
+
+		size_t nTotal = 0;
+		bench::Measure("Uncached", [&]() {
+			for (int nTop = 0; nTop + nPageLines <= nLines; nTop += 3)
+				for (int nLineIndex = nTop; nLineIndex < nTop + nPageLines; ++nLineIndex)
+					nTotal += PrepareUncached(nLineIndex).size();
+		});
+		bench::Measure("Cached", [&]() {
+			cache.InvalidateAll();
+			for (int nTop = 0; nTop + nPageLines <= nLines; nTop += 3)
+				for (int nLineIndex = nTop; nLineIndex < nTop + nPageLines; ++nLineIndex)
+				{
+					int nBlocks;
+					PrepareCached(cache, nLineIndex, nBlocks);
+					nTotal += nBlocks;
+				}
+		});
+		EXPECT_GT(nTotal, 0u);
+	}
+
+	// Invalidated lines are prepared again
+	TEST_F(TextBlockCacheBench, Invalidate)
+	{
+		TextBlockCache cache(64);
+		TEXTBLOCK block = { 0, COLORINDEX_NORMALTEXT, COLORINDEX_BKGND };
+		int nBlocks;
+		DWORD dwNextCookie;
+		for (int i = 0; i < 64; ++i)
+			cache.Store(i, 0, 0, 7, &block, 1);
+		EXPECT_TRUE(cache.Lookup(10, 0, 0, nBlocks, dwNextCookie) != NULL);
+		EXPECT_EQ(7, dwNextCookie);
+		EXPECT_TRUE(cache.Lookup(10, 1, 0, nBlocks, dwNextCookie) == NULL);
+		EXPECT_TRUE(cache.Lookup(10, 0, 1, nBlocks, dwNextCookie) == NULL);
+		cache.Invalidate(10, 10);
+		EXPECT_TRUE(cache.Lookup(10, 0, 0, nBlocks, dwNextCookie) == NULL);
+		EXPECT_TRUE(cache.Lookup(11, 0, 0, nBlocks, dwNextCookie) != NULL);
+		cache.Invalidate(30, -1);
+		EXPECT_TRUE(cache.Lookup(29, 0, 0, nBlocks, dwNextCookie) != NULL);
+		EXPECT_TRUE(cache.Lookup(63, 0, 0, nBlocks, dwNextCookie) == NULL);
+		cache.InvalidateAll();
+		EXPECT_TRUE(cache.Lookup(0, 0, 0, nBlocks, dwNextCookie) == NULL);
+		cache.Store(64, 0, 0, 7, &block, 1);
+		EXPECT_TRUE(cache.Lookup(0, 0, 0, nBlocks, dwNextCookie) == NULL);
+		EXPECT_TRUE(cache.Lookup(64, 0, 0, nBlocks, dwNextCookie) != NULL);
+	}
+
+}  // namespace
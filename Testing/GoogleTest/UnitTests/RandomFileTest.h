@@ -0,0 +1,65 @@
+/**
+ * @file  RandomFileTest.h
+ *
+ * @brief Fixture for tests checking random inputs, written to files.
+ */
+#pragma once
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "UnicodeString.h"
+#include "unicoder.h"
+
+/**
+ * @brief Base fixture making random inputs and writing them to files.
+ *
+ * The generator has a fixed seed, so every run checks the same inputs.
+ * Files are written in the current folder, named by the prefix of the
+ * test, and removed after the test.
+ */
+class RandomFileTest : public testing::Test
+{
+protected:
+	explicit RandomFileTest(const std::string& sPrefix) : m_rnd(20161018), m_sPrefix(sPrefix)
+	{
+	}
+
+	virtual ~RandomFileTest()
+	{
+		for (size_t i = 0; i < m_files.size(); ++i)
+			remove(ucr::toUTF8(m_files[i]).c_str());
+	}
+
+	/** @brief Return a random number from 0 to n - 1. */
+	int Next(int n)
+	{
+		return std::uniform_int_distribution<int>(0, n - 1)(m_rnd);
+	}
+
+	/** @brief Write the data to a file, return its name. */
+	String WriteFile(const std::string& name, const std::string& data)
+	{
+		String filename = ucr::toTString(m_sPrefix + "_" + name + ".txt");
+		std::ofstream ostr(ucr::toUTF8(filename).c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+		ostr << data;
+		m_files.push_back(filename);
+		return filename;
+	}
+
+	/** @brief Write the lines to a file, each one followed by the EOL. */
+	String WriteLines(const std::string& name, const std::vector<std::string>& lines, const char *eol)
+	{
+		std::string data;
+		for (size_t i = 0; i < lines.size(); ++i)
+			data += lines[i] + eol;
+		return WriteFile(name, data);
+	}
+
+	std::mt19937 m_rnd;
+	std::string m_sPrefix; /**< Start of the names of the files */
+	std::vector<String> m_files; /**< Files to remove after the test */
+};
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <tchar.h>
+#include <string>
+#include "unicoder.h"
+#include "Benchmark.h"
+
+namespace
+{
+	/** @brief An encoding of the benchmark text */
+	struct Encoding
+	{
+		const char *name;
+		ucr::UNICODESET unicoding;
+		int codepage;
+	};
+
+	const Encoding encodings[] = {
+		{ "Cp1252", ucr::NONE, 1252 },
+		{ "Utf8", ucr::UTF8, CP_UTF8 },
+		{ "Ucs2le", ucr::UCS2LE, 1200 },
+		{ "Ucs2be", ucr::UCS2BE, 1201 },
+	};
+
+	// The fixture for benchmarking conversions between the encodings of
+	// loaded and saved files.
+	class UnicoderBench : public testing::Test
+	{
+	protected:
+		/**
+		 * @brief Make 1 MB of text in each encoding.
+		 * The text has only characters of codepage 1252, so all conversions
+		 * are lossless.
+		 */
+		static void SetUpTestCase()
+		{
+			bench::Random rnd;
+			std::string text;
+			while (text.size() < 1024 * 1024)
+			{
+				int c = rnd.Next(20) == 0 ? 0xC0 + rnd.Next(64) : ' ' + rnd.Next(95);
+				text += static_cast<char>(c);
+				if (rnd.Next(60) == 0)
+					text += "\r\n";
+			}
+			ucr::buffer buf(text.size() * 2);
+			for (int i = 0; i < 4; ++i)
+			{
+				ucr::convert(ucr::NONE, 1252, reinterpret_cast<const unsigned char *>(text.c_str()), text.size(),
+					encodings[i].unicoding, encodings[i].codepage, &buf);
+				s_texts[i].assign(reinterpret_cast<const char *>(buf.ptr), buf.size);
+			}
+		}
+
+		static void TearDownTestCase()
+		{
+			for (int i = 0; i < 4; ++i)
+				s_texts[i].clear();
+		}
+
+		static std::string s_texts[4];
+	};
+
+	std::string UnicoderBench::s_texts[4];
+
+	// Every ordered pair of encodings
+	TEST_F(UnicoderBench, Convert1MB)
+	{
+		ucr::buffer buf(1024);
+		for (int from = 0; from < 4; ++from)
+		{
+			for (int to = 0; to < 4; ++to)
+			{
+				const std::string& src = s_texts[from];
+				bool bConverted = false;
+				bench::Measure(std::string("Convert1MB") + encodings[from].name + "To" + encodings[to].name, [&]() {
+					bConverted = ucr::convert(encodings[from].unicoding, encodings[from].codepage,
+						reinterpret_cast<const unsigned char *>(src.c_str()), src.size(),
+						encodings[to].unicoding, encodings[to].codepage, &buf);
+				});
+				EXPECT_TRUE(bConverted);
+				EXPECT_EQ(s_texts[to], std::string(reinterpret_cast<const char *>(buf.ptr), buf.size))
+					<< encodings[from].name << " " << encodings[to].name;
+			}
+		}
+	}
+
+}  // namespace
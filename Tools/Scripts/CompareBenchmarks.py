@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+# Compares the results of two runs of Benchmarks.exe.
+#
+# Run the benchmarks of both builds with XML output:
+#   Benchmarks.exe --gtest_output=xml:base.xml
+#   Benchmarks.exe --gtest_output=xml:new.xml
+# and compare the results:
+#   python CompareBenchmarks.py base.xml new.xml
+#
+# Each benchmark measurement is a test property having nanoseconds per
+# iteration as its value. The script lists the measurements of both runs
+# and their change, and exits with 1 if any measurement got slower than
+# the threshold allows.
+
+from __future__ import print_function
+
+import csv
+import getopt
+import sys
+import xml.etree.ElementTree as ET
+
+# Attributes of <testcase> elements written by Google Test itself
+TESTCASE_ATTRIBUTES = set(['name', 'status', 'time', 'classname', 'result',
+    'timestamp', 'file', 'line', 'type_param', 'value_param'])
+
+def read_results(filename):
+    """Read measurements from a Google Test XML file.
+
+    Returns a dictionary of nanoseconds per iteration keyed by
+    'TestCase.Test/measurement'.
+    """
+    results = {}
+    root = ET.parse(filename).getroot()
+    for testcase in root.iter('testcase'):
+        prefix = testcase.get('classname') + '.' + testcase.get('name') + '/'
+        # Older Google Test writes properties as attributes, newer as
+        # <property> elements
+        properties = [(name, value) for name, value in testcase.attrib.items()
+            if name not in TESTCASE_ATTRIBUTES]
+        for prop in testcase.iter('property'):
+            properties.append((prop.get('name'), prop.get('value')))
+        for name, value in properties:
+            try:
+                results[prefix + name] = float(value)
+            except ValueError:
+                pass
+    return results
+
+def compare(base, new, threshold, csvfile):
+    """Print measurements of both runs and return number of regressions."""
+    names = sorted(set(base.keys()) | set(new.keys()))
+    regressions = 0
+    writer = csv.writer(csvfile) if csvfile else None
+    if writer:
+        writer.writerow(['benchmark', 'base_ns', 'new_ns', 'change_percent'])
+    else:
+        print('%-70s %14s %14s %9s' % ('Benchmark', 'Base ns', 'New ns', 'Change'))
+    for name in names:
+        b = base.get(name)
+        n = new.get(name)
+        change = None
+        if b and n is not None:
+            change = (n - b) * 100.0 / b
+        mark = ''
+        if change is not None and change > threshold:
+            regressions += 1
+            mark = ' SLOWER'
+        if writer:
+            writer.writerow([name, '' if b is None else '%.0f' % b,
+                '' if n is None else '%.0f' % n,
+                '' if change is None else '%.1f' % change])
+        else:
+            print('%-70s %14s %14s %9s%s' % (name,
+                '-' if b is None else '%.0f' % b,
+                '-' if n is None else '%.0f' % n,
+                '-' if change is None else '%+.1f%%' % change, mark))
+    return regressions
+
+def usage():
+    print('Usage: CompareBenchmarks.py [-h] [-t <percent>] [-c] <base.xml> <new.xml>')
+    print('  where:')
+    print('    -h, --help                 print this help')
+    print('    -t, --threshold <percent>  slowdown reported as regression (default 10)')
+    print('    -c, --csv                  print results as CSV')
+
+def main(argv):
+    threshold = 10.0
+    csvoutput = False
+    try:
+        opts, args = getopt.getopt(argv, 'ht:c', ['help', 'threshold=', 'csv'])
+    except getopt.GetoptError:
+        usage()
+        return 2
+    for opt, arg in opts:
+        if opt in ('-h', '--help'):
+            usage()
+            return 0
+        if opt in ('-t', '--threshold'):
+            threshold = float(arg)
+        if opt in ('-c', '--csv'):
+            csvoutput = True
+    if len(args) != 2:
+        usage()
+        return 2
+
+    base = read_results(args[0])
+    new = read_results(args[1])
+    regressions = compare(base, new, threshold, sys.stdout if csvoutput else None)
+    if regressions and not csvoutput:
+        print('%d benchmark(s) slower by more than %g%%' % (regressions, threshold))
+    return 1 if regressions else 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))